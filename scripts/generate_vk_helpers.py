@@ -78,6 +78,7 @@ def get_device_cmds():
         Cmd("vkCmdPushConstants"),
         Cmd("vkEndCommandBuffer"),
         Cmd("vkFreeCommandBuffers"),
+        Cmd("vkResetCommandBuffer"),
         None,
         Cmd("vkCreateRenderPass"),
         Cmd("vkDestroyRenderPass"),
@@ -87,6 +88,7 @@ def get_device_cmds():
         None,
         Cmd("vkCreatePipelineCache"),
         Cmd("vkDestroyPipelineCache"),
+        Cmd("vkGetPipelineCacheData"),
         None,
         Cmd("vkResetDescriptorPool"),
         Cmd("vkCreateDescriptorPool"),
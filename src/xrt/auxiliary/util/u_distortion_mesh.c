@@ -12,28 +12,163 @@
 #include "util/u_frame.h"
 #include "util/u_debug.h"
 #include "util/u_format.h"
+#include "util/u_worker.h"
+#include "util/u_logging.h"
 #include "util/u_distortion_mesh.h"
 
 #include "math/m_vec2.h"
 #include "math/m_api.h"
 
+#include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
 
 DEBUG_GET_ONCE_NUM_OPTION(mesh_size, "XRT_MESH_SIZE", 64)
+DEBUG_GET_ONCE_NUM_OPTION(mesh_threads, "XRT_MESH_THREADS", 4)
+
+//! Meshes smaller than this many vertices are not worth starting threads for.
+#define MESH_PARALLEL_MIN_VERTICES (4096)
+
+//! How many bands of rows each view is split into for the worker threads.
+#define MESH_ROW_BANDS (16)
+
+#define LANES U_DISTORTION_BATCH_LANES
 
 
 typedef bool (*func_calc)(struct xrt_device *xdev, uint32_t view, float u, float v, struct xrt_uv_triplet *result);
 
+typedef bool (*func_calc_batch)(struct xrt_device *xdev,
+                                uint32_t view,
+                                uint32_t count,
+                                const struct xrt_vec2 *uvs,
+                                struct xrt_uv_triplet *results);
+
+/*!
+ * One band of vertex rows of one view, run on the worker threads.
+ */
+struct mesh_rows_task
+{
+	struct xrt_device *xdev;
+	func_calc calc;
+	func_calc_batch calc_batch;
+
+	uint32_t view;
+	uint32_t row_start;
+	uint32_t row_count;
+
+	uint32_t cells_cols;
+	uint32_t cells_rows;
+	uint32_t stride_in_floats;
+
+	//! First vertex of the view.
+	float *verts;
+
+	bool ok;
+};
+
 static int
 index_for(int row, int col, uint32_t stride, uint32_t offset)
 {
 	return row * stride + col + offset;
 }
 
+static bool
+calc_row(struct mesh_rows_task *task, uint32_t count, const struct xrt_vec2 *uvs, struct xrt_uv_triplet *results)
+{
+	if (task->calc_batch != NULL) {
+		return task->calc_batch(task->xdev, task->view, count, uvs, results);
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (!task->calc(task->xdev, task->view, uvs[i].x, uvs[i].y, &results[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 static void
-run_func(struct xrt_device *xdev, func_calc calc, int view_count, struct xrt_hmd_parts *target, uint32_t num)
+run_rows(void *ptr)
+{
+	struct mesh_rows_task *task = (struct mesh_rows_task *)ptr;
+
+	uint32_t vert_cols = task->cells_cols + 1;
+	struct xrt_vec2 *uvs = U_TYPED_ARRAY_CALLOC(struct xrt_vec2, vert_cols);
+	struct xrt_uv_triplet *results = U_TYPED_ARRAY_CALLOC(struct xrt_uv_triplet, vert_cols);
+	bool ok = true;
+
+	for (uint32_t r = task->row_start; ok && r < task->row_start + task->row_count; r++) {
+		// This goes from 0 to 1.0 inclusive.
+		float v = (float)r / (float)task->cells_rows;
+
+		for (uint32_t c = 0; c < vert_cols; c++) {
+			// This goes from 0 to 1.0 inclusive.
+			uvs[c].x = (float)c / (float)task->cells_cols;
+			uvs[c].y = v;
+		}
+
+		ok = calc_row(task, vert_cols, uvs, results);
+		if (!ok) {
+			break;
+		}
+
+		for (uint32_t c = 0; c < vert_cols; c++) {
+			float *vert = &task->verts[(r * vert_cols + c) * task->stride_in_floats];
+
+			// Make the position in the range of [-1, 1]
+			vert[0] = uvs[c].x * 2.0f - 1.0f;
+			vert[1] = uvs[c].y * 2.0f - 1.0f;
+
+			memcpy(&vert[2], &results[c], sizeof(results[c]));
+		}
+	}
+
+	free(uvs);
+	free(results);
+
+	task->ok = ok;
+}
+
+static void
+run_tasks(struct xrt_device *xdev, struct mesh_rows_task *tasks, uint32_t task_count, uint32_t vertex_count)
+{
+	struct u_worker_thread_pool *pool = NULL;
+	if (xdev->compute_distortion_thread_safe && vertex_count >= MESH_PARALLEL_MIN_VERTICES) {
+		// The calling thread helps out while waiting.
+		pool = u_worker_thread_pool_create_helped(debug_get_num_option_mesh_threads(), "Mesh");
+	}
+
+	if (pool == NULL) {
+		for (uint32_t i = 0; i < task_count; i++) {
+			run_rows(&tasks[i]);
+		}
+		return;
+	}
+
+	struct u_worker_group *group = u_worker_group_create(pool);
+	for (uint32_t i = 0; i < task_count; i++) {
+		u_worker_group_push(group, run_rows, &tasks[i]);
+	}
+	u_worker_group_wait_all(group);
+
+	u_worker_group_reference(&group, NULL);
+	u_worker_thread_pool_reference(&pool, NULL);
+}
+
+/*!
+ * Returns false if any vertex failed to compute, then the target is left as
+ * it was.
+ */
+static bool
+run_func(struct xrt_device *xdev,
+         func_calc calc,
+         func_calc_batch calc_batch,
+         int view_count,
+         struct xrt_hmd_parts *target,
+         uint32_t num)
 {
 	assert(calc != NULL);
 	assert(view_count == 2);
@@ -56,32 +191,44 @@ run_func(struct xrt_device *xdev, func_calc calc, int view_count, struct xrt_hmd
 
 	float *verts = U_TYPED_ARRAY_CALLOC(float, float_count);
 
-	// Setup the vertices for all views.
-	uint32_t i = 0;
-	for (int view = 0; view < view_count; view++) {
-		vertex_offsets[view] = i / stride_in_floats;
+	// Setup the vertices for all views, in bands of rows.
+	uint32_t band_count = vert_rows < MESH_ROW_BANDS ? vert_rows : MESH_ROW_BANDS;
+	uint32_t task_count = band_count * view_count;
+	struct mesh_rows_task *tasks = U_TYPED_ARRAY_CALLOC(struct mesh_rows_task, task_count);
 
-		for (uint32_t r = 0; r < vert_rows; r++) {
-			// This goes from 0 to 1.0 inclusive.
-			float v = (float)r / (float)cells_rows;
+	for (int view = 0; view < view_count; view++) {
+		vertex_offsets[view] = vertex_count_per_view * view;
+
+		for (uint32_t band = 0; band < band_count; band++) {
+			uint32_t row_start = vert_rows * band / band_count;
+			uint32_t row_end = vert_rows * (band + 1) / band_count;
+
+			struct mesh_rows_task *task = &tasks[view * band_count + band];
+			task->xdev = xdev;
+			task->calc = calc;
+			task->calc_batch = calc_batch;
+			task->view = view;
+			task->row_start = row_start;
+			task->row_count = row_end - row_start;
+			task->cells_cols = cells_cols;
+			task->cells_rows = cells_rows;
+			task->stride_in_floats = stride_in_floats;
+			task->verts = &verts[vertex_offsets[view] * stride_in_floats];
+		}
+	}
 
-			for (uint32_t c = 0; c < vert_cols; c++) {
-				// This goes from 0 to 1.0 inclusive.
-				float u = (float)c / (float)cells_cols;
+	run_tasks(xdev, tasks, task_count, vertex_count);
 
-				// Make the position in the range of [-1, 1]
-				verts[i + 0] = u * 2.0f - 1.0f;
-				verts[i + 1] = v * 2.0f - 1.0f;
+	bool ok = true;
+	for (uint32_t i = 0; i < task_count; i++) {
+		ok = ok && tasks[i].ok;
+	}
 
-				if (!calc(xdev, view, u, v, (struct xrt_uv_triplet *)&verts[i + 2])) {
-					// bail on error, without updating
-					// distortion.preferred
-					return;
-				}
+	free(tasks);
 
-				i += stride_in_floats;
-			}
-		}
+	if (!ok) {
+		free(verts);
+		return false;
 	}
 
 	uint32_t index_count_per_view = cells_rows * (vert_cols * 2 + 2);
@@ -89,7 +236,7 @@ run_func(struct xrt_device *xdev, func_calc calc, int view_count, struct xrt_hmd
 	int *indices = U_TYPED_ARRAY_CALLOC(int, index_count_total);
 
 	// Set up indices for all views.
-	i = 0;
+	uint32_t i = 0;
 	for (int view = 0; view < view_count; view++) {
 		index_offsets[view] = i;
 
@@ -121,8 +268,68 @@ run_func(struct xrt_device *xdev, func_calc calc, int view_count, struct xrt_hmd
 	target->distortion.mesh.index_offsets[0] = index_offsets[0];
 	target->distortion.mesh.index_offsets[1] = index_offsets[1];
 	target->distortion.mesh.index_count_total = index_count_total;
+
+	return true;
+}
+
+
+/*
+ *
+ * Batch helpers.
+ *
+ */
+
+/*!
+ * The points of a batch split into lanes, so the same operation is done on
+ * all of the lanes at once.
+ */
+struct lanes_vec2
+{
+	float x[LANES];
+	float y[LANES];
+};
+
+/*!
+ * Lanes past the end of the array repeat the last point, so all lanes always
+ * do the same work and no branches are needed in the maths.
+ */
+static inline void
+load_lanes(const struct xrt_vec2 *uvs, uint32_t count, uint32_t base, struct lanes_vec2 *out)
+{
+	for (uint32_t l = 0; l < LANES; l++) {
+		uint32_t i = base + l < count ? base + l : count - 1;
+		out->x[l] = uvs[i].x;
+		out->y[l] = uvs[i].y;
+	}
+}
+
+static inline void
+store_lanes(struct xrt_uv_triplet *results,
+            uint32_t count,
+            uint32_t base,
+            const struct lanes_vec2 *r,
+            const struct lanes_vec2 *g,
+            const struct lanes_vec2 *b)
+{
+	uint32_t n = count - base < LANES ? count - base : LANES;
+
+	for (uint32_t l = 0; l < n; l++) {
+		results[base + l].r.x = r->x[l];
+		results[base + l].r.y = r->y[l];
+		results[base + l].g.x = g->x[l];
+		results[base + l].g.y = g->y[l];
+		results[base + l].b.x = b->x[l];
+		results[base + l].b.y = b->y[l];
+	}
 }
 
+
+/*
+ *
+ * Distortion functions.
+ *
+ */
+
 bool
 u_compute_distortion_vive(struct u_vive_values *values, float u, float v, struct xrt_uv_triplet *result)
 {
@@ -184,6 +391,57 @@ u_compute_distortion_vive(struct u_vive_values *values, float u, float v, struct
 	return true;
 }
 
+bool
+u_compute_distortion_vive_batch(struct u_vive_values *values,
+                                uint32_t count,
+                                const struct xrt_vec2 *uvs,
+                                struct xrt_uv_triplet *results)
+{
+	const struct u_vive_values val = *values;
+
+	const float common_factor_value = 0.5f / (1.0f + val.grow_for_undistort);
+	const float factor_x = common_factor_value;
+	const float factor_y = common_factor_value * val.aspect_x_over_y;
+
+	for (uint32_t base = 0; base < count; base += LANES) {
+		struct lanes_vec2 in;
+		load_lanes(uvs, count, base, &in);
+
+		// Results r/g/b.
+		struct lanes_vec2 tc[3];
+
+		for (int i = 0; i < 3; i++) {
+			const float center_x = val.center[i].x;
+			const float center_y = val.center[i].y;
+			const float k1 = val.coefficients[i][0];
+			const float k2 = val.coefficients[i][1];
+			const float k3 = val.coefficients[i][2];
+			const float k4 = val.coefficients[i][3];
+
+			// Same maths as u_compute_distortion_vive.
+			for (uint32_t l = 0; l < LANES; l++) {
+				float x = 2.f * in.x[l] - 1.f;
+				float y = 2.f * in.y[l] - 1.f;
+
+				y /= val.aspect_x_over_y;
+				x -= center_x;
+				y -= center_y;
+
+				float r2 = x * x + y * y;
+				float bottom = 1.f + r2 * (k1 + r2 * (k2 + r2 * k3));
+				float d = (1.f / bottom) + k4;
+
+				tc[i].x[l] = 0.5f + (x * d + center_x) * factor_x;
+				tc[i].y[l] = 0.5f + (y * d + center_y) * factor_y;
+			}
+		}
+
+		store_lanes(results, count, base, &tc[0], &tc[1], &tc[2]);
+	}
+
+	return true;
+}
+
 
 #define mul m_vec2_mul
 #define mul_scalar m_vec2_mul_scalar
@@ -232,6 +490,51 @@ u_compute_distortion_panotools(struct u_panotools_values *values, float u, float
 	return true;
 }
 
+bool
+u_compute_distortion_panotools_batch(struct u_panotools_values *values,
+                                     uint32_t count,
+                                     const struct xrt_vec2 *uvs,
+                                     struct xrt_uv_triplet *results)
+{
+	const struct u_panotools_values val = *values;
+
+	for (uint32_t base = 0; base < count; base += LANES) {
+		struct lanes_vec2 in;
+		load_lanes(uvs, count, base, &in);
+
+		struct lanes_vec2 dist;
+
+		// Same maths as u_compute_distortion_panotools.
+		for (uint32_t l = 0; l < LANES; l++) {
+			float x = (in.x[l] * val.viewport_size.x - val.lens_center.x) / val.scale;
+			float y = (in.y[l] * val.viewport_size.y - val.lens_center.y) / val.scale;
+
+			float r_mag = sqrtf(x * x + y * y);
+			r_mag = val.distortion_k[0] +                                // r^1
+			        val.distortion_k[1] * r_mag +                        // r^2
+			        val.distortion_k[2] * r_mag * r_mag +                // r^3
+			        val.distortion_k[3] * r_mag * r_mag * r_mag +        // r^4
+			        val.distortion_k[4] * r_mag * r_mag * r_mag * r_mag; // r^5
+
+			dist.x[l] = x * r_mag * val.scale;
+			dist.y[l] = y * r_mag * val.scale;
+		}
+
+		struct lanes_vec2 uv[3];
+
+		for (int i = 0; i < 3; i++) {
+			for (uint32_t l = 0; l < LANES; l++) {
+				uv[i].x[l] = (dist.x[l] * val.aberration_k[i] + val.lens_center.x) / val.viewport_size.x;
+				uv[i].y[l] = (dist.y[l] * val.aberration_k[i] + val.lens_center.y) / val.viewport_size.y;
+			}
+		}
+
+		store_lanes(results, count, base, &uv[0], &uv[1], &uv[2]);
+	}
+
+	return true;
+}
+
 bool
 u_compute_distortion_cardboard(struct u_cardboard_distortion_values *values,
                                float u,
@@ -268,6 +571,49 @@ u_compute_distortion_cardboard(struct u_cardboard_distortion_values *values,
 	return true;
 }
 
+bool
+u_compute_distortion_cardboard_batch(struct u_cardboard_distortion_values *values,
+                                     uint32_t count,
+                                     const struct xrt_vec2 *uvs,
+                                     struct xrt_uv_triplet *results)
+{
+	const struct u_cardboard_distortion_values val = *values;
+
+	for (uint32_t base = 0; base < count; base += LANES) {
+		struct lanes_vec2 in;
+		load_lanes(uvs, count, base, &in);
+
+		struct lanes_vec2 uv;
+
+		// Same maths as u_compute_distortion_cardboard.
+		for (uint32_t l = 0; l < LANES; l++) {
+			float x = in.x[l] * val.screen.size.x - val.screen.offset.x;
+			float y = in.y[l] * val.screen.size.y - val.screen.offset.y;
+
+			float sqrd = x * x + y * y;
+			float r = 1.0f;
+			float fact = 1.0f;
+			r *= sqrd;
+			fact += val.distortion_k[0] * r;
+			r *= sqrd;
+			fact += val.distortion_k[1] * r;
+			r *= sqrd;
+			fact += val.distortion_k[2] * r;
+			r *= sqrd;
+			fact += val.distortion_k[3] * r;
+			r *= sqrd;
+			fact += val.distortion_k[4] * r;
+
+			uv.x[l] = (x * fact + val.texture.offset.x) / val.texture.size.x;
+			uv.y[l] = (y * fact + val.texture.offset.y) / val.texture.size.y;
+		}
+
+		store_lanes(results, count, base, &uv, &uv, &uv);
+	}
+
+	return true;
+}
+
 /*
  *
  * North Star "2D Polynomial" distortion
@@ -436,8 +782,8 @@ u_distortion_mesh_fill_in_none(struct xrt_device *xdev)
 {
 	struct xrt_hmd_parts *target = xdev->hmd;
 
-	// Do the generation.
-	run_func(xdev, u_distortion_mesh_none, 2, target, 1);
+	// Do the generation, can't fail.
+	run_func(xdev, u_distortion_mesh_none, NULL, 2, target, 1);
 
 	// Make the target mostly usable.
 	target->distortion.models |= XRT_DISTORTION_MODEL_NONE;
@@ -457,6 +803,8 @@ u_distortion_mesh_set_none(struct xrt_device *xdev)
 
 	// Make sure that the xdev implements the compute_distortion function.
 	xdev->compute_distortion = u_distortion_mesh_none;
+	xdev->compute_distortion_batch = NULL;
+	xdev->compute_distortion_thread_safe = true;
 
 	// Make the target completely usable.
 	target->distortion.models |= XRT_DISTORTION_MODEL_COMPUTE;
@@ -481,5 +829,10 @@ u_distortion_mesh_fill_in_compute(struct xrt_device *xdev)
 	struct xrt_hmd_parts *target = xdev->hmd;
 
 	uint32_t num = (uint32_t)debug_get_num_option_mesh_size();
-	run_func(xdev, calc, 2, target, num);
+	if (!run_func(xdev, calc, xdev->compute_distortion_batch, 2, target, num)) {
+		U_LOG_E("Failed to compute the distortion mesh, using no distortion!");
+
+		// Compute distortion must match the mesh.
+		u_distortion_mesh_set_none(xdev);
+	}
 }
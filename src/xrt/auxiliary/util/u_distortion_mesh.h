@@ -21,6 +21,16 @@ extern "C" {
 #endif
 
 
+/*!
+ * The batched distortion functions work on this many points at a time. They
+ * are plain C loops over the lanes with no branches between the points, there
+ * are no intrinsics, it is up to the compiler to auto-vectorize them.
+ *
+ * @ingroup aux_distortion
+ */
+#define U_DISTORTION_BATCH_LANES (8)
+
+
 /*
  *
  * Panotools distortion
@@ -54,6 +64,18 @@ struct u_panotools_values
 bool
 u_compute_distortion_panotools(struct u_panotools_values *values, float u, float v, struct xrt_uv_triplet *result);
 
+/*!
+ * Batched version of @ref u_compute_distortion_panotools, evaluated
+ * @ref U_DISTORTION_BATCH_LANES points at a time.
+ *
+ * @ingroup aux_distortion
+ */
+bool
+u_compute_distortion_panotools_batch(struct u_panotools_values *values,
+                                     uint32_t count,
+                                     const struct xrt_vec2 *uvs,
+                                     struct xrt_uv_triplet *results);
+
 
 /*
  *
@@ -89,6 +111,18 @@ struct u_vive_values
 bool
 u_compute_distortion_vive(struct u_vive_values *values, float u, float v, struct xrt_uv_triplet *result);
 
+/*!
+ * Batched version of @ref u_compute_distortion_vive, evaluated
+ * @ref U_DISTORTION_BATCH_LANES points at a time.
+ *
+ * @ingroup aux_distortion
+ */
+bool
+u_compute_distortion_vive_batch(struct u_vive_values *values,
+                                uint32_t count,
+                                const struct xrt_vec2 *uvs,
+                                struct xrt_uv_triplet *results);
+
 
 /*
  *
@@ -107,6 +141,18 @@ u_compute_distortion_cardboard(struct u_cardboard_distortion_values *values,
                                float v,
                                struct xrt_uv_triplet *result);
 
+/*!
+ * Batched version of @ref u_compute_distortion_cardboard, evaluated
+ * @ref U_DISTORTION_BATCH_LANES points at a time.
+ *
+ * @ingroup aux_distortion
+ */
+bool
+u_compute_distortion_cardboard_batch(struct u_cardboard_distortion_values *values,
+                                     uint32_t count,
+                                     const struct xrt_vec2 *uvs,
+                                     struct xrt_uv_triplet *results);
+
 
 /*
  *
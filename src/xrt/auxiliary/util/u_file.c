@@ -191,6 +191,57 @@ u_file_get_hand_tracking_models_dir(char *out_path, size_t out_path_size)
 	return -1;
 }
 
+ssize_t
+u_file_get_cache_dir(char *out_path, size_t out_path_size)
+{
+	const char *xdg_cache = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+	if (xdg_cache != NULL) {
+		return snprintf(out_path, out_path_size, "%s/monado", xdg_cache);
+	}
+	if (home != NULL) {
+		return snprintf(out_path, out_path_size, "%s/.cache/monado", home);
+	}
+	return -1;
+}
+
+FILE *
+u_file_open_file_in_cache_dir_subpath(const char *subpath, const char *filename, const char *mode)
+{
+	char tmp[PATH_MAX];
+	int i = u_file_get_cache_dir(tmp, sizeof(tmp));
+	if (i < 0 || i >= (int)sizeof(tmp)) {
+		return NULL;
+	}
+
+	char fullpath[PATH_MAX];
+	i = snprintf(fullpath, sizeof(fullpath), "%s/%s", tmp, subpath);
+	if (i < 0 || i >= (int)sizeof(fullpath)) {
+		return NULL;
+	}
+
+	char file_str[PATH_MAX + 15];
+	i = snprintf(file_str, sizeof(file_str), "%s/%s", fullpath, filename);
+	if (i < 0 || i >= (int)sizeof(file_str)) {
+		return NULL;
+	}
+
+	FILE *file = fopen(file_str, mode);
+	if (file != NULL) {
+		return file;
+	}
+
+	// Only create the path when writing, a missing file is normal for a cache.
+	if (mode[0] == 'r') {
+		return NULL;
+	}
+
+	mkpath(fullpath);
+
+	// Do not report error.
+	return fopen(file_str, mode);
+}
+
 #endif /* XRT_OS_LINUX */
 
 ssize_t
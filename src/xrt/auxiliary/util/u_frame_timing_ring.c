@@ -0,0 +1,274 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Lock-free ring of per-frame compositor timing records.
+ * @ingroup aux_pacing
+ */
+
+#include "util/u_misc.h"
+#include "util/u_time.h"
+#include "util/u_frame_timing_ring.h"
+
+#include <assert.h>
+
+
+/*
+ *
+ * Defines and helpers.
+ *
+ */
+
+/*!
+ * How many times a reader tries to get a consistent copy of a slot, the writer
+ * only holds a slot for a few stores so this is plenty.
+ */
+#define MAX_READ_TRIES 8
+
+static struct u_frame_timing_ring global_ring;
+
+static inline int32_t
+seq_load_acquire(const xrt_atomic_s32_t *p)
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#else
+	// Full barrier, never changes the value.
+	return xrt_atomic_s32_cmpxchg((xrt_atomic_s32_t *)p, 0, 0);
+#endif
+}
+
+static inline void
+fence_acquire(void)
+{
+#if defined(__GNUC__)
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+	MemoryBarrier();
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline struct u_frame_timing_slot *
+get_slot(struct u_frame_timing_ring *uftr, int64_t frame_id)
+{
+	return &uftr->slots[(uint64_t)frame_id % U_FRAME_TIMING_RING_SIZE];
+}
+
+/*!
+ * Returns the slot to write the frame's record to, resetting it if it holds
+ * an older frame, or NULL if the frame has already been overwritten.
+ */
+static struct u_frame_timing_slot *
+begin_write(struct u_frame_timing_ring *uftr, int64_t frame_id)
+{
+	if (frame_id < 0) {
+		return NULL;
+	}
+
+	struct u_frame_timing_slot *slot = get_slot(uftr, frame_id);
+
+	// Only the writer changes the record, so no need to be careful here.
+	bool fresh = slot->seq == 0 || slot->record.frame_id < frame_id;
+	if (!fresh && slot->record.frame_id != frame_id) {
+		return NULL;
+	}
+
+	// Full barrier, odd while writing.
+	xrt_atomic_s32_inc_return(&slot->seq);
+
+	if (fresh) {
+		U_ZERO(&slot->record);
+		slot->record.frame_id = frame_id;
+	}
+
+	return slot;
+}
+
+static inline void
+end_write(struct u_frame_timing_slot *slot)
+{
+	// Full barrier, even again.
+	xrt_atomic_s32_inc_return(&slot->seq);
+}
+
+//! Returns false if the slot is empty or no consistent copy could be made.
+static bool
+read_slot(const struct u_frame_timing_slot *slot, struct u_frame_timing_record *out_record)
+{
+	for (uint32_t tries = 0; tries < MAX_READ_TRIES; tries++) {
+		int32_t before = seq_load_acquire(&slot->seq);
+		if (before == 0) {
+			return false; // Never written.
+		}
+		if ((before & 1) != 0) {
+			continue; // Writer is writing.
+		}
+
+		*out_record = slot->record;
+
+		fence_acquire();
+		if (seq_load_acquire(&slot->seq) == before) {
+			return out_record->frame_id >= 0;
+		}
+	}
+
+	return false;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+struct u_frame_timing_ring *
+u_frame_timing_ring_get_global(void)
+{
+	return &global_ring;
+}
+
+void
+u_frame_timing_ring_reset(struct u_frame_timing_ring *uftr)
+{
+	for (uint32_t i = 0; i < U_FRAME_TIMING_RING_SIZE; i++) {
+		struct u_frame_timing_slot *slot = &uftr->slots[i];
+		if (slot->seq == 0) {
+			continue;
+		}
+
+		xrt_atomic_s32_inc_return(&slot->seq);
+		U_ZERO(&slot->record);
+		slot->record.frame_id = -1;
+		end_write(slot);
+	}
+}
+
+void
+u_frame_timing_ring_predicted(struct u_frame_timing_ring *uftr,
+                              int64_t frame_id,
+                              uint64_t desired_present_time_ns,
+                              uint64_t predicted_display_time_ns)
+{
+	struct u_frame_timing_slot *slot = begin_write(uftr, frame_id);
+	if (slot == NULL) {
+		return;
+	}
+
+	slot->record.desired_present_time_ns = desired_present_time_ns;
+	slot->record.predicted_display_time_ns = predicted_display_time_ns;
+
+	end_write(slot);
+}
+
+void
+u_frame_timing_ring_mark_point(struct u_frame_timing_ring *uftr,
+                               enum u_timing_point point,
+                               int64_t frame_id,
+                               uint64_t when_ns)
+{
+	struct u_frame_timing_slot *slot = begin_write(uftr, frame_id);
+	if (slot == NULL) {
+		return;
+	}
+
+	switch (point) {
+	case U_TIMING_POINT_WAKE_UP: slot->record.when_woke_ns = when_ns; break;
+	case U_TIMING_POINT_BEGIN: slot->record.when_began_ns = when_ns; break;
+	case U_TIMING_POINT_SUBMIT: slot->record.when_submitted_ns = when_ns; break;
+	default: assert(false);
+	}
+
+	end_write(slot);
+}
+
+void
+u_frame_timing_ring_gpu(struct u_frame_timing_ring *uftr,
+                        int64_t frame_id,
+                        uint64_t gpu_start_ns,
+                        uint64_t gpu_end_ns)
+{
+	struct u_frame_timing_slot *slot = begin_write(uftr, frame_id);
+	if (slot == NULL) {
+		return;
+	}
+
+	slot->record.gpu_start_ns = gpu_start_ns;
+	slot->record.gpu_end_ns = gpu_end_ns;
+
+	end_write(slot);
+}
+
+void
+u_frame_timing_ring_present(struct u_frame_timing_ring *uftr,
+                            int64_t frame_id,
+                            uint64_t actual_present_time_ns,
+                            uint64_t actual_display_time_ns)
+{
+	struct u_frame_timing_slot *slot = begin_write(uftr, frame_id);
+	if (slot == NULL) {
+		return;
+	}
+
+	struct u_frame_timing_record *rec = &slot->record;
+	rec->actual_present_time_ns = actual_present_time_ns;
+	rec->actual_display_time_ns = actual_display_time_ns;
+	rec->flags |= U_FRAME_TIMING_PRESENT_INFO;
+
+	if (rec->desired_present_time_ns != 0 &&
+	    actual_present_time_ns > rec->desired_present_time_ns + U_TIME_HALF_MS_IN_NS) {
+		rec->flags |= U_FRAME_TIMING_MISSED;
+	}
+
+	end_write(slot);
+}
+
+uint32_t
+u_frame_timing_ring_read(struct u_frame_timing_ring *uftr,
+                         int64_t from_frame_id,
+                         struct u_frame_timing_record *out_records,
+                         uint32_t max_count,
+                         int64_t *out_next_frame_id)
+{
+	struct u_frame_timing_record rec;
+
+	// Frame ids are not stored anywhere else, so look for the newest one.
+	int64_t latest_frame_id = -1;
+	for (uint32_t i = 0; i < U_FRAME_TIMING_RING_SIZE; i++) {
+		if (read_slot(&uftr->slots[i], &rec) && rec.frame_id > latest_frame_id) {
+			latest_frame_id = rec.frame_id;
+		}
+	}
+
+	/*
+	 * A reader never gets ahead of the newest frame, if it is then the ring
+	 * was reset and frame ids started over, so restart the reader.
+	 */
+	if (from_frame_id > latest_frame_id + 1) {
+		from_frame_id = 0;
+	}
+
+	int64_t last_frame_id = latest_frame_id - U_FRAME_TIMING_RING_SETTLE_FRAMES;
+	int64_t oldest_frame_id = latest_frame_id - U_FRAME_TIMING_RING_SIZE + 1;
+
+	int64_t frame_id = from_frame_id > oldest_frame_id ? from_frame_id : oldest_frame_id;
+	if (latest_frame_id < 0 || frame_id > last_frame_id) {
+		*out_next_frame_id = from_frame_id;
+		return 0;
+	}
+
+	uint32_t count = 0;
+	for (; frame_id <= last_frame_id && count < max_count; frame_id++) {
+		if (!read_slot(get_slot(uftr, frame_id), &rec) || rec.frame_id != frame_id) {
+			continue; // Overwritten, skipped or being written.
+		}
+
+		out_records[count++] = rec;
+	}
+
+	*out_next_frame_id = frame_id;
+
+	return count;
+}
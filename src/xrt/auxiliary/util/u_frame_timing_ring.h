@@ -0,0 +1,195 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Lock-free ring of per-frame compositor timing records.
+ * @ingroup aux_pacing
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#include "util/u_pacing.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Number of frames kept in the ring, a bit over two seconds at 120Hz.
+ *
+ * @ingroup aux_pacing
+ */
+#define U_FRAME_TIMING_RING_SIZE 256
+
+/*!
+ * Frames newer than this many frames behind the latest frame are not returned
+ * by @ref u_frame_timing_ring_read, the information from the display about
+ * when they were presented might still be coming in.
+ *
+ * @ingroup aux_pacing
+ */
+#define U_FRAME_TIMING_RING_SETTLE_FRAMES 8
+
+/*!
+ * Flags for @ref u_frame_timing_record.
+ *
+ * @ingroup aux_pacing
+ */
+enum u_frame_timing_flags
+{
+	//! The actual present and display times come from the display.
+	U_FRAME_TIMING_PRESENT_INFO = (1u << 0u),
+	//! The frame was presented after the desired present time.
+	U_FRAME_TIMING_MISSED = (1u << 1u),
+};
+
+/*!
+ * Timing of one compositor frame, times that are not known are zero.
+ *
+ * @ingroup aux_pacing
+ */
+struct u_frame_timing_record
+{
+	int64_t frame_id;
+
+	//! Bitmask of @ref u_frame_timing_flags.
+	uint32_t flags;
+	uint32_t _padding;
+
+	uint64_t desired_present_time_ns;
+	uint64_t predicted_display_time_ns;
+
+	uint64_t when_woke_ns;
+	uint64_t when_began_ns;
+	uint64_t when_submitted_ns;
+
+	uint64_t gpu_start_ns;
+	uint64_t gpu_end_ns;
+
+	uint64_t actual_present_time_ns;
+	uint64_t actual_display_time_ns;
+};
+
+/*!
+ * One slot of the ring, @p seq is odd while the record is being written and
+ * zero if it has never been written.
+ *
+ * @ingroup aux_pacing
+ */
+struct u_frame_timing_slot
+{
+	xrt_atomic_s32_t seq;
+	struct u_frame_timing_record record;
+};
+
+/*!
+ * Ring of per-frame compositor timing records, indexed by frame id. The parts
+ * of a record are filled in as the compositor pacing gets them, so the record
+ * is built up over a couple of frames.
+ *
+ * There is a single writer, the thread driving the compositor pacing, which
+ * never waits for readers. Readers on any thread get consistent copies of the
+ * records or skip them. A zero initialised ring is empty and ready for use.
+ *
+ * @ingroup aux_pacing
+ */
+struct u_frame_timing_ring
+{
+	struct u_frame_timing_slot slots[U_FRAME_TIMING_RING_SIZE];
+};
+
+/*!
+ * The ring written to by the compositor pacing helpers of this process.
+ *
+ * @ingroup aux_pacing
+ */
+struct u_frame_timing_ring *
+u_frame_timing_ring_get_global(void);
+
+/*!
+ * Drop all records, used when a new pacing helper starts over with frame ids.
+ * Writer only.
+ *
+ * @public @memberof u_frame_timing_ring
+ */
+void
+u_frame_timing_ring_reset(struct u_frame_timing_ring *uftr);
+
+/*!
+ * Record the prediction for a frame. Writer only.
+ *
+ * @public @memberof u_frame_timing_ring
+ */
+void
+u_frame_timing_ring_predicted(struct u_frame_timing_ring *uftr,
+                              int64_t frame_id,
+                              uint64_t desired_present_time_ns,
+                              uint64_t predicted_display_time_ns);
+
+/*!
+ * Record a point in the frame's CPU side lifetime. Writer only.
+ *
+ * @public @memberof u_frame_timing_ring
+ */
+void
+u_frame_timing_ring_mark_point(struct u_frame_timing_ring *uftr,
+                               enum u_timing_point point,
+                               int64_t frame_id,
+                               uint64_t when_ns);
+
+/*!
+ * Record when the GPU started and finished the frame. Writer only.
+ *
+ * @public @memberof u_frame_timing_ring
+ */
+void
+u_frame_timing_ring_gpu(struct u_frame_timing_ring *uftr,
+                        int64_t frame_id,
+                        uint64_t gpu_start_ns,
+                        uint64_t gpu_end_ns);
+
+/*!
+ * Record when the frame was actually presented and displayed, the frame is
+ * flagged as missed if it was presented more than half a millisecond after
+ * the desired present time. Writer only.
+ *
+ * @public @memberof u_frame_timing_ring
+ */
+void
+u_frame_timing_ring_present(struct u_frame_timing_ring *uftr,
+                            int64_t frame_id,
+                            uint64_t actual_present_time_ns,
+                            uint64_t actual_display_time_ns);
+
+/*!
+ * Copy out the settled records with a frame id of at least @p from_frame_id,
+ * in frame id order. Records that have been overwritten or that are being
+ * written to are skipped. If @p from_frame_id is past the newest frame the
+ * ring has been reset since it was returned, reading restarts from the oldest
+ * record. Can be called from any thread.
+ *
+ * @param      uftr              The ring.
+ * @param      from_frame_id     First frame id to return.
+ * @param[out] out_records       Array to copy the records to.
+ * @param      max_count         Size of @p out_records.
+ * @param[out] out_next_frame_id The frame id to start from on the next call.
+ *
+ * @return The number of records copied.
+ *
+ * @public @memberof u_frame_timing_ring
+ */
+uint32_t
+u_frame_timing_ring_read(struct u_frame_timing_ring *uftr,
+                         int64_t from_frame_id,
+                         struct u_frame_timing_record *out_records,
+                         uint32_t max_count,
+                         int64_t *out_next_frame_id);
+
+
+#ifdef __cplusplus
+}
+#endif
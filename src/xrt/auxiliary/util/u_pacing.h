@@ -448,6 +448,17 @@ struct u_pacing_app
 	             uint64_t predicted_display_period_ns,
 	             uint64_t extra_ns);
 
+	/*!
+	 * Tell the pacer if its app is the primary one, the app that the user
+	 * is focused on. Pacers created by the same factory share the GPU, so
+	 * when the primary app is about to miss its GPU deadline the other apps
+	 * get a longer display period to free up GPU time for it.
+	 *
+	 * @param upa     Self pointer
+	 * @param primary Is this the primary app.
+	 */
+	void (*set_primary)(struct u_pacing_app *upa, bool primary);
+
 	/*!
 	 * Destroy this u_pacing_app.
 	 */
@@ -547,6 +558,20 @@ u_pa_info(struct u_pacing_app *upa,
 	upa->info(upa, predicted_display_time_ns, predicted_display_period_ns, extra_ns);
 }
 
+/*!
+ * @copydoc u_pacing_app::set_primary
+ *
+ * Helper for calling through the function pointer.
+ *
+ * @public @memberof u_pacing_app
+ * @ingroup aux_pacing
+ */
+static inline void
+u_pa_set_primary(struct u_pacing_app *upa, bool primary)
+{
+	upa->set_primary(upa, primary);
+}
+
 /*!
  * @copydoc u_pacing_app::latched
  *
@@ -739,6 +764,10 @@ u_pc_fake_create(uint64_t estimated_frame_period_ns, uint64_t now_ns, struct u_p
 /*!
  * Creates a new application pacing factory helper.
  *
+ * The pacers it creates account the GPU time of their apps, when the primary
+ * app's GPU work starts to eat into its margin the heaviest of the other apps
+ * is throttled to a lower frame rate, see @ref u_pacing_app::set_primary.
+ *
  * @ingroup aux_pacing
  * @see u_pacing_app
  */
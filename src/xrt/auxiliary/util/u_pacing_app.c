@@ -8,6 +8,7 @@
  */
 
 #include "os/os_time.h"
+#include "os/os_threading.h"
 
 #include "util/u_var.h"
 #include "util/u_time.h"
@@ -25,6 +26,7 @@
 DEBUG_GET_ONCE_LOG_OPTION(log_level, "U_PACING_APP_LOG", U_LOGGING_WARN)
 DEBUG_GET_ONCE_FLOAT_OPTION(min_app_time_ms, "U_PACING_APP_MIN_TIME_MS", 1.0f)
 DEBUG_GET_ONCE_FLOAT_OPTION(min_margin_ms, "U_PACING_APP_MIN_MARGIN_MS", 2.0f)
+DEBUG_GET_ONCE_BOOL_OPTION(fair_throttle, "U_PACING_APP_FAIR_THROTTLE", true)
 
 #define UPA_LOG_T(...) U_LOG_IFL_T(debug_get_log_option_log_level(), __VA_ARGS__)
 #define UPA_LOG_D(...) U_LOG_IFL_D(debug_get_log_option_log_level(), __VA_ARGS__)
@@ -53,6 +55,24 @@ DEBUG_GET_ONCE_FLOAT_OPTION(min_margin_ms, "U_PACING_APP_MIN_MARGIN_MS", 2.0f)
  */
 #define FRAME_COUNT (128)
 
+/*!
+ * Max number of extra display periods a non-primary app is throttled by, one
+ * extra period halves its frame rate.
+ */
+#define MAX_THROTTLE (3)
+
+/*!
+ * Number of primary app frames to wait after changing a throttle before
+ * throttling again, gives the change time to show up in the GPU timings.
+ */
+#define THROTTLE_COOLDOWN_FRAMES (8)
+
+/*!
+ * Number of primary app frames in a row that need to be on time before a
+ * throttle is released again.
+ */
+#define RELEASE_AFTER_FRAMES (90)
+
 enum u_pa_state
 {
 	U_PA_READY,
@@ -101,6 +121,8 @@ struct u_pa_frame
 	enum u_pa_state state;
 };
 
+struct pacing_app_factory;
+
 struct pacing_app
 {
 	struct u_pacing_app base;
@@ -108,6 +130,28 @@ struct pacing_app
 	//! Id for this session.
 	int64_t session_id;
 
+	//! The factory that created this pacer, protects @ref fair.
+	struct pacing_app_factory *paf;
+
+	//! Next pacer created by the same factory.
+	struct pacing_app *next;
+
+	//! Sharing of the GPU with the other apps, protected by the factory's mutex.
+	struct
+	{
+		//! Is this the app the user is focused on.
+		bool primary;
+
+		//! Extra display periods added to the period of this app.
+		uint32_t throttle;
+
+		//! Filtered GPU time of this app, copy of @ref app.
+		uint64_t gpu_time_ns;
+
+		//! GPU time of all frames of this app.
+		uint64_t gpu_total_ns;
+	} fair;
+
 	struct u_pa_frame frames[FRAME_COUNT];
 	uint32_t current_frame;
 	uint32_t next_frame;
@@ -160,6 +204,30 @@ struct pacing_app
 	uint64_t last_returned_ns;
 };
 
+/*!
+ * Keeps track of all pacers it has created, so that the other apps can be
+ * throttled when the primary app is short on GPU time.
+ */
+struct pacing_app_factory
+{
+	struct u_pacing_app_factory base;
+
+	//! Protects the list and the fair members of the pacers.
+	struct os_mutex mutex;
+
+	//! All live pacers created by this factory.
+	struct pacing_app *list;
+
+	//! Is throttling of non-primary apps enabled.
+	bool fair_throttle;
+
+	//! Primary app frames since a throttle was last changed.
+	uint32_t frames_since_change;
+
+	//! Primary app frames in a row that completed on time.
+	uint32_t frames_on_time;
+};
+
 
 /*
  *
@@ -274,7 +342,7 @@ total_app_and_compositor_time_ns(const struct pacing_app *pa)
 }
 
 static uint64_t
-calc_period(const struct pacing_app *pa)
+calc_period(const struct pacing_app *pa, uint32_t throttle)
 {
 	// Error checking.
 	uint64_t base_period_ns = min_period(pa);
@@ -297,6 +365,9 @@ calc_period(const struct pacing_app *pa)
 		period_ns += base_period_ns;
 	}
 
+	// Give up frames to the primary app.
+	period_ns += base_period_ns * throttle;
+
 	return period_ns;
 }
 
@@ -326,6 +397,125 @@ predict_display_time(const struct pacing_app *pa, uint64_t now_ns, uint64_t peri
 }
 
 
+/*
+ *
+ * Sharing the GPU between apps.
+ *
+ */
+
+static uint32_t
+get_throttle(struct pacing_app *pa)
+{
+	os_mutex_lock(&pa->paf->mutex);
+	uint32_t throttle = pa->fair.throttle;
+	os_mutex_unlock(&pa->paf->mutex);
+
+	return throttle;
+}
+
+//! Throttle the non-primary app using the most GPU time, returns false if none could be.
+static bool
+throttle_heaviest_locked(struct pacing_app_factory *paf)
+{
+	struct pacing_app *heaviest = NULL;
+	for (struct pacing_app *it = paf->list; it != NULL; it = it->next) {
+		if (it->fair.primary || it->fair.throttle >= MAX_THROTTLE) {
+			continue;
+		}
+		if (heaviest == NULL || it->fair.gpu_time_ns > heaviest->fair.gpu_time_ns) {
+			heaviest = it;
+		}
+	}
+
+	if (heaviest == NULL) {
+		return false;
+	}
+
+	heaviest->fair.throttle++;
+
+	UPA_LOG_I("Throttling session %" PRIi64 " to %u extra period(s), GPU time %.2fms", heaviest->session_id,
+	          heaviest->fair.throttle, time_ns_to_ms_f(heaviest->fair.gpu_time_ns));
+
+	return true;
+}
+
+//! Release one step from the throttled app using the least GPU time, returns false if none is throttled.
+static bool
+release_lightest_locked(struct pacing_app_factory *paf)
+{
+	struct pacing_app *lightest = NULL;
+	for (struct pacing_app *it = paf->list; it != NULL; it = it->next) {
+		if (it->fair.throttle == 0) {
+			continue;
+		}
+		if (lightest == NULL || it->fair.gpu_time_ns < lightest->fair.gpu_time_ns) {
+			lightest = it;
+		}
+	}
+
+	if (lightest == NULL) {
+		return false;
+	}
+
+	lightest->fair.throttle--;
+
+	UPA_LOG_I("Releasing session %" PRIi64 " to %u extra period(s)", lightest->session_id, lightest->fair.throttle);
+
+	return true;
+}
+
+//! If there is no primary app there is nobody to give up GPU time for, so release everybody.
+static void
+release_all_if_no_primary_locked(struct pacing_app_factory *paf)
+{
+	for (struct pacing_app *it = paf->list; it != NULL; it = it->next) {
+		if (it->fair.primary) {
+			return;
+		}
+	}
+
+	for (struct pacing_app *it = paf->list; it != NULL; it = it->next) {
+		it->fair.throttle = 0;
+	}
+}
+
+/*!
+ * Account the GPU time of a completed frame, and for the primary app adjust
+ * the throttling of the other apps depending on if it was on time.
+ */
+static void
+fair_gpu_done(struct pacing_app *pa, uint64_t gpu_ns, bool late)
+{
+	struct pacing_app_factory *paf = pa->paf;
+
+	os_mutex_lock(&paf->mutex);
+
+	pa->fair.gpu_time_ns = pa->app.gpu_time_ns;
+	pa->fair.gpu_total_ns += gpu_ns;
+
+	if (!pa->fair.primary || !paf->fair_throttle) {
+		os_mutex_unlock(&paf->mutex);
+		return;
+	}
+
+	paf->frames_since_change++;
+	paf->frames_on_time = late ? 0 : paf->frames_on_time + 1;
+
+	if (late && paf->frames_since_change >= THROTTLE_COOLDOWN_FRAMES) {
+		if (throttle_heaviest_locked(paf)) {
+			paf->frames_since_change = 0;
+		}
+	} else if (paf->frames_on_time >= RELEASE_AFTER_FRAMES) {
+		if (release_lightest_locked(paf)) {
+			paf->frames_since_change = 0;
+		}
+		paf->frames_on_time = 0;
+	}
+
+	os_mutex_unlock(&paf->mutex);
+}
+
+
 /*
  *
  * Metrics and tracing.
@@ -444,7 +634,7 @@ pa_predict(struct u_pacing_app *upa,
 
 	DEBUG_PRINT_ID(frame_id);
 
-	uint64_t period_ns = calc_period(pa);
+	uint64_t period_ns = calc_period(pa, get_throttle(pa));
 	uint64_t predict_ns = predict_display_time(pa, now_ns, period_ns);
 	// How long we think the frame should take.
 	uint64_t frame_time_ns = total_app_time_ns(pa);
@@ -601,6 +791,9 @@ pa_mark_gpu_done(struct u_pacing_app *upa, int64_t frame_id, uint64_t when_ns)
 	do_iir_filter(&pa->app.draw_time_ns, IIR_ALPHA_LT, IIR_ALPHA_GT, diff_draw_ns);
 	do_iir_filter(&pa->app.gpu_time_ns, IIR_ALPHA_LT, IIR_ALPHA_GT, diff_gpu_ns);
 
+	// Share the GPU time with the other apps.
+	fair_gpu_done(pa, diff_gpu_ns, late);
+
 	// Write out metrics and tracing data.
 	do_metrics(pa, f, false);
 	do_tracing(pa, f);
@@ -670,16 +863,57 @@ pa_info(struct u_pacing_app *upa,
 	pa->last_input.extra_ns = extra_ns;
 }
 
+static void
+pa_set_primary(struct u_pacing_app *upa, bool primary)
+{
+	struct pacing_app *pa = pacing_app(upa);
+	struct pacing_app_factory *paf = pa->paf;
+
+	os_mutex_lock(&paf->mutex);
+
+	pa->fair.primary = primary;
+	if (primary) {
+		pa->fair.throttle = 0;
+	}
+
+	release_all_if_no_primary_locked(paf);
+
+	paf->frames_since_change = 0;
+	paf->frames_on_time = 0;
+
+	os_mutex_unlock(&paf->mutex);
+}
+
 static void
 pa_destroy(struct u_pacing_app *upa)
 {
+	struct pacing_app *pa = pacing_app(upa);
+	struct pacing_app_factory *paf = pa->paf;
+
 	u_var_remove_root(upa);
 
+	os_mutex_lock(&paf->mutex);
+	for (struct pacing_app **it = &paf->list; *it != NULL; it = &(*it)->next) {
+		if (*it == pa) {
+			*it = pa->next;
+			break;
+		}
+	}
+
+	// Same as the primary app stepping down.
+	if (pa->fair.primary) {
+		release_all_if_no_primary_locked(paf);
+
+		paf->frames_since_change = 0;
+		paf->frames_on_time = 0;
+	}
+	os_mutex_unlock(&paf->mutex);
+
 	free(upa);
 }
 
 static xrt_result_t
-pa_create(int64_t session_id, struct u_pacing_app **out_upa)
+pa_create(struct pacing_app_factory *paf, int64_t session_id, struct u_pacing_app **out_upa)
 {
 	struct pacing_app *pa = U_TYPED_CALLOC(struct pacing_app);
 	pa->base.predict = pa_predict;
@@ -690,8 +924,10 @@ pa_create(int64_t session_id, struct u_pacing_app **out_upa)
 	pa->base.latched = pa_latched;
 	pa->base.retired = pa_retired;
 	pa->base.info = pa_info;
+	pa->base.set_primary = pa_set_primary;
 	pa->base.destroy = pa_destroy;
 	pa->session_id = session_id;
+	pa->paf = paf;
 	pa->app.cpu_time_ns = U_TIME_1MS_IN_NS * 2;
 	pa->app.draw_time_ns = U_TIME_1MS_IN_NS * 2;
 
@@ -721,6 +957,13 @@ pa_create(int64_t session_id, struct u_pacing_app **out_upa)
 	u_var_add_ro_u64(pa, &pa->app.cpu_time_ns, "CPU time(ns)");
 	u_var_add_ro_u64(pa, &pa->app.draw_time_ns, "Draw time(ns)");
 	u_var_add_ro_u64(pa, &pa->app.gpu_time_ns, "GPU time(ns)");
+	u_var_add_ro_u64(pa, &pa->fair.gpu_total_ns, "GPU time total(ns)");
+	u_var_add_ro_u32(pa, &pa->fair.throttle, "Throttle(extra periods)");
+
+	os_mutex_lock(&paf->mutex);
+	pa->next = paf->list;
+	paf->list = pa;
+	os_mutex_unlock(&paf->mutex);
 
 	*out_upa = &pa->base;
 
@@ -734,18 +977,31 @@ pa_create(int64_t session_id, struct u_pacing_app **out_upa)
  *
  */
 
+static inline struct pacing_app_factory *
+pacing_app_factory(struct u_pacing_app_factory *upaf)
+{
+	return (struct pacing_app_factory *)upaf;
+}
+
 static xrt_result_t
 paf_create(struct u_pacing_app_factory *upaf, struct u_pacing_app **out_upa)
 {
 	static int64_t session_id_gen = 0; // For now until global session id is introduced.
 
-	return pa_create(session_id_gen++, out_upa);
+	return pa_create(pacing_app_factory(upaf), session_id_gen++, out_upa);
 }
 
 static void
 paf_destroy(struct u_pacing_app_factory *upaf)
 {
-	free(upaf);
+	struct pacing_app_factory *paf = pacing_app_factory(upaf);
+
+	// All pacers must have been destroyed before the factory.
+	assert(paf->list == NULL);
+
+	os_mutex_destroy(&paf->mutex);
+
+	free(paf);
 }
 
 
@@ -758,11 +1014,19 @@ paf_destroy(struct u_pacing_app_factory *upaf)
 xrt_result_t
 u_pa_factory_create(struct u_pacing_app_factory **out_upaf)
 {
-	struct u_pacing_app_factory *upaf = U_TYPED_CALLOC(struct u_pacing_app_factory);
-	upaf->create = paf_create;
-	upaf->destroy = paf_destroy;
+	struct pacing_app_factory *paf = U_TYPED_CALLOC(struct pacing_app_factory);
+	paf->base.create = paf_create;
+	paf->base.destroy = paf_destroy;
+	paf->fair_throttle = debug_get_bool_option_fair_throttle();
+
+	int ret = os_mutex_init(&paf->mutex);
+	if (ret != 0) {
+		UPA_LOG_E("Failed to init mutex: %i", ret);
+		free(paf);
+		return XRT_ERROR_THREADING_INIT_FAILURE;
+	}
 
-	*out_upaf = upaf;
+	*out_upaf = &paf->base;
 
 	return XRT_SUCCESS;
 }
@@ -16,6 +16,7 @@
 #include "util/u_metrics.h"
 #include "util/u_logging.h"
 #include "util/u_trace_marker.h"
+#include "util/u_frame_timing_ring.h"
 
 #include <stdio.h>
 #include <assert.h>
@@ -581,6 +582,9 @@ pc_predict(struct u_pacing_compositor *upc,
 	*out_predicted_display_time_ns = predicted_display_time_ns;
 	*out_predicted_display_period_ns = predicted_display_period_ns;
 	*out_min_display_period_ns = min_display_period_ns;
+
+	u_frame_timing_ring_predicted(u_frame_timing_ring_get_global(), f->frame_id, desired_present_time_ns,
+	                              predicted_display_time_ns);
 }
 
 static void
@@ -615,6 +619,8 @@ pc_mark_point(struct u_pacing_compositor *upc, enum u_timing_point point, int64_
 		break;
 	default: assert(false);
 	}
+
+	u_frame_timing_ring_mark_point(u_frame_timing_ring_get_global(), point, frame_id, when_ns);
 }
 
 static void
@@ -689,6 +695,12 @@ pc_info(struct u_pacing_compositor *upc,
 	// Write out metrics and tracing data.
 	do_metrics(pc, f);
 	do_tracing(pc, f);
+
+	// Same offset as used for the prediction.
+	uint64_t actual_display_time_ns =
+	    actual_present_time_ns + (f->predicted_display_time_ns - f->desired_present_time_ns);
+	u_frame_timing_ring_present(u_frame_timing_ring_get_global(), frame_id, actual_present_time_ns,
+	                            actual_display_time_ns);
 }
 
 static void
@@ -705,6 +717,8 @@ pc_info_gpu(
 
 		u_metrics_write_system_gpu_info(&umgi);
 	}
+
+	u_frame_timing_ring_gpu(u_frame_timing_ring_get_global(), frame_id, gpu_start_ns, gpu_end_ns);
 }
 
 static void
@@ -777,6 +791,9 @@ u_pc_display_timing_create(uint64_t estimated_frame_period_ns,
 	// Extra margin that is added to compositor time.
 	pc->margin_ns = config->margin_ns;
 
+	// Frame ids start over.
+	u_frame_timing_ring_reset(u_frame_timing_ring_get_global());
+
 	*out_upc = &pc->base;
 
 	double estimated_frame_period_ms = ns_to_ms(estimated_frame_period_ns);
@@ -17,6 +17,7 @@
 #include "util/u_metrics.h"
 #include "util/u_logging.h"
 #include "util/u_trace_marker.h"
+#include "util/u_frame_timing_ring.h"
 
 #include <stdio.h>
 #include <assert.h>
@@ -143,6 +144,9 @@ pc_predict(struct u_pacing_compositor *upc,
 	*out_predicted_display_period_ns = predicted_display_period_ns;
 	*out_min_display_period_ns = min_display_period_ns;
 
+	u_frame_timing_ring_predicted(u_frame_timing_ring_get_global(), frame_id, desired_present_time_ns,
+	                              predicted_display_time_ns);
+
 	if (!u_metrics_is_active()) {
 		return;
 	}
@@ -169,6 +173,8 @@ pc_mark_point(struct u_pacing_compositor *upc, enum u_timing_point point, int64_
 	case U_TIMING_POINT_SUBMIT: break;
 	default: assert(false);
 	}
+
+	u_frame_timing_ring_mark_point(u_frame_timing_ring_get_global(), point, frame_id, when_ns);
 }
 
 static void
@@ -180,10 +186,16 @@ pc_info(struct u_pacing_compositor *upc,
         uint64_t present_margin_ns,
         uint64_t when_ns)
 {
+	struct fake_timing *ft = fake_timing(upc);
+
 	/*
 	 * The compositor might call this function because it selected the
-	 * fake timing code even tho displaying timing is available.
+	 * fake timing code even tho displaying timing is available, the
+	 * timing is not adjusted but still recorded.
 	 */
+	uint64_t present_to_display_offset_ns = time_ms_f_to_ns(ft->present_to_display_offset_ms.val);
+	u_frame_timing_ring_present(u_frame_timing_ring_get_global(), frame_id, actual_present_time_ns,
+	                            actual_present_time_ns + present_to_display_offset_ns);
 }
 
 static void
@@ -201,6 +213,8 @@ pc_info_gpu(
 		u_metrics_write_system_gpu_info(&umgi);
 	}
 
+	u_frame_timing_ring_gpu(u_frame_timing_ring_get_global(), frame_id, gpu_start_ns, gpu_end_ns);
+
 #ifdef U_TRACE_PERCETTO // Uses Percetto specific things.
 	if (U_TRACE_CATEGORY_IS_ENABLED(timing)) {
 #define TE_BEG(TRACK, TIME, NAME) U_TRACE_EVENT_BEGIN_ON_TRACK_DATA(timing, TRACK, TIME, NAME, PERCETTO_I(frame_id))
@@ -276,6 +290,9 @@ u_pc_fake_create(uint64_t estimated_frame_period_ns, uint64_t now_ns, struct u_p
 	// To make sure the code can start from a non-zero frame id.
 	ft->frame_id_generator = 5;
 
+	// Frame ids start over.
+	u_frame_timing_ring_reset(u_frame_timing_ring_get_global());
+
 	// An arbitrary guess, that happens to be based on Index.
 	float present_to_display_offset_ms = debug_get_float_option_present_to_display_offset_ms();
 
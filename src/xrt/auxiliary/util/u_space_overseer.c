@@ -12,9 +12,12 @@
 #include "xrt/xrt_device.h"
 #include "xrt/xrt_tracking.h"
 
+#include "os/os_time.h"
+
 #include "math/m_space.h"
 
 #include "util/u_misc.h"
+#include "util/u_debug.h"
 #include "util/u_hashmap.h"
 #include "util/u_logging.h"
 #include "util/u_space_overseer.h"
@@ -29,6 +32,11 @@
  *
  */
 
+//! Enough for the head and the inputs of a few controllers.
+#define POSE_CACHE_SIZE 32
+
+DEBUG_GET_ONCE_NUM_OPTION(pose_cache_us, "U_SPACE_OVERSEER_POSE_CACHE_US", 2000)
+
 /*!
  * Keeps track of what kind of space it is.
  */
@@ -72,6 +80,24 @@ struct u_space
 	};
 };
 
+/*!
+ * A device pose fetched at a given timestamp.
+ */
+struct u_space_pose_cache_entry
+{
+	struct xrt_device *xdev;
+	enum xrt_input_name xname;
+	uint64_t at_timestamp_ns;
+
+	//! When the pose was fetched from the device.
+	uint64_t fetched_ns;
+
+	//! Only valid if it matches the epoch of the cache.
+	uint64_t epoch;
+
+	struct xrt_space_relation relation;
+};
+
 /*!
  * Default implementation of the xrt_space_overseer object.
  */
@@ -84,6 +110,23 @@ struct u_space_overseer
 
 	//! Map from xdev to space, each entry holds a reference.
 	struct u_hashmap_int *xdev_map;
+
+	//! Device poses, has its own lock as it is written to when locating.
+	struct
+	{
+		pthread_mutex_t mutex;
+
+		struct u_space_pose_cache_entry entries[POSE_CACHE_SIZE];
+
+		//! Entry to replace next, oldest first.
+		uint32_t next;
+
+		//! Bumped to invalidate all entries, starts at one so zeroed entries never match.
+		uint64_t epoch;
+
+		//! Zero disables the cache.
+		uint64_t max_age_ns;
+	} pose_cache;
 };
 
 
@@ -157,6 +200,109 @@ find_xdev_space_read_locked(struct u_space_overseer *uso, struct xrt_device *xde
 }
 
 
+/*
+ *
+ * Pose cache functions.
+ *
+ */
+
+static void
+invalidate_pose_cache(struct u_space_overseer *uso)
+{
+	pthread_mutex_lock(&uso->pose_cache.mutex);
+	uso->pose_cache.epoch++;
+	pthread_mutex_unlock(&uso->pose_cache.mutex);
+}
+
+/*!
+ * Returns true and the pose if the device has been asked about this input at
+ * this timestamp recently.
+ */
+static bool
+find_pose_cache_locked(struct u_space_overseer *uso,
+                       struct u_space *space,
+                       uint64_t at_timestamp_ns,
+                       uint64_t now_ns,
+                       struct xrt_space_relation *out_relation)
+{
+	for (uint32_t i = 0; i < POSE_CACHE_SIZE; i++) {
+		const struct u_space_pose_cache_entry *e = &uso->pose_cache.entries[i];
+
+		if (e->epoch != uso->pose_cache.epoch ||          //
+		    e->xdev != space->pose.xdev ||                //
+		    e->xname != space->pose.xname ||              //
+		    e->at_timestamp_ns != at_timestamp_ns ||      //
+		    now_ns - e->fetched_ns > uso->pose_cache.max_age_ns) {
+			continue;
+		}
+
+		*out_relation = e->relation;
+		return true;
+	}
+
+	return false;
+}
+
+static void
+insert_pose_cache_locked(struct u_space_overseer *uso,
+                         struct u_space *space,
+                         uint64_t at_timestamp_ns,
+                         uint64_t fetched_ns,
+                         const struct xrt_space_relation *relation)
+{
+	struct u_space_pose_cache_entry *e = &uso->pose_cache.entries[uso->pose_cache.next];
+	uso->pose_cache.next = (uso->pose_cache.next + 1) % POSE_CACHE_SIZE;
+
+	e->xdev = space->pose.xdev;
+	e->xname = space->pose.xname;
+	e->at_timestamp_ns = at_timestamp_ns;
+	e->fetched_ns = fetched_ns;
+	e->epoch = uso->pose_cache.epoch;
+	e->relation = *relation;
+}
+
+/*!
+ * Gets the pose of a pose space, only asking the device if it has not been
+ * asked about the same input and timestamp recently.
+ */
+static void
+get_tracked_pose_cached(struct u_space_overseer *uso,
+                        struct u_space *space,
+                        uint64_t at_timestamp_ns,
+                        struct xrt_space_relation *out_relation)
+{
+	assert(space->type == U_SPACE_TYPE_POSE);
+	assert(space->pose.xdev != NULL);
+	assert(space->pose.xname != 0);
+
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	pthread_mutex_lock(&uso->pose_cache.mutex);
+	bool enabled = uso->pose_cache.max_age_ns != 0;
+	bool found = enabled && find_pose_cache_locked(uso, space, at_timestamp_ns, now_ns, out_relation);
+	uint64_t epoch = uso->pose_cache.epoch;
+	pthread_mutex_unlock(&uso->pose_cache.mutex);
+
+	if (found) {
+		return;
+	}
+
+	// Don't hold the lock while calling into the driver.
+	xrt_device_get_tracked_pose(space->pose.xdev, space->pose.xname, at_timestamp_ns, out_relation);
+
+	if (!enabled) {
+		return;
+	}
+
+	pthread_mutex_lock(&uso->pose_cache.mutex);
+	// Don't add a pose fetched before the cache was invalidated.
+	if (epoch == uso->pose_cache.epoch) {
+		insert_pose_cache_locked(uso, space, at_timestamp_ns, now_ns, out_relation);
+	}
+	pthread_mutex_unlock(&uso->pose_cache.mutex);
+}
+
+
 /*
  *
  * Graph traversing functions.
@@ -170,16 +316,16 @@ find_xdev_space_read_locked(struct u_space_overseer *uso, struct xrt_device *xde
  * order.
  */
 static void
-push_then_traverse(struct xrt_relation_chain *xrc, struct u_space *space, uint64_t at_timestamp_ns)
+push_then_traverse(struct u_space_overseer *uso,
+                   struct xrt_relation_chain *xrc,
+                   struct u_space *space,
+                   uint64_t at_timestamp_ns)
 {
 	switch (space->type) {
 	case U_SPACE_TYPE_NULL: break; // No-op
 	case U_SPACE_TYPE_POSE: {
-		assert(space->pose.xdev != NULL);
-		assert(space->pose.xname != 0);
-
 		struct xrt_space_relation xsr;
-		xrt_device_get_tracked_pose(space->pose.xdev, space->pose.xname, at_timestamp_ns, &xsr);
+		get_tracked_pose_cached(uso, space, at_timestamp_ns, &xsr);
 		m_relation_chain_push_relation(xrc, &xsr);
 	} break;
 	case U_SPACE_TYPE_OFFSET: m_relation_chain_push_pose_if_not_identity(xrc, &space->offset.pose); break;
@@ -188,7 +334,7 @@ push_then_traverse(struct xrt_relation_chain *xrc, struct u_space *space, uint64
 
 	// Please tail-call optimise this miss compiler.
 	assert(space->next != NULL);
-	push_then_traverse(xrc, space->next, at_timestamp_ns);
+	push_then_traverse(uso, xrc, space->next, at_timestamp_ns);
 }
 
 /*!
@@ -198,7 +344,10 @@ push_then_traverse(struct xrt_relation_chain *xrc, struct u_space *space, uint64
  * the reversed order.
  */
 static void
-traverse_then_push_inverse(struct xrt_relation_chain *xrc, struct u_space *space, uint64_t at_timestamp_ns)
+traverse_then_push_inverse(struct u_space_overseer *uso,
+                           struct xrt_relation_chain *xrc,
+                           struct u_space *space,
+                           uint64_t at_timestamp_ns)
 {
 	// Done traversing.
 	switch (space->type) {
@@ -210,16 +359,13 @@ traverse_then_push_inverse(struct xrt_relation_chain *xrc, struct u_space *space
 
 	// Can't tail-call optimise this one :(
 	assert(space->next != NULL);
-	traverse_then_push_inverse(xrc, space->next, at_timestamp_ns);
+	traverse_then_push_inverse(uso, xrc, space->next, at_timestamp_ns);
 
 	switch (space->type) {
 	case U_SPACE_TYPE_NULL: break; // No-op
 	case U_SPACE_TYPE_POSE: {
-		assert(space->pose.xdev != NULL);
-		assert(space->pose.xname != 0);
-
 		struct xrt_space_relation xsr;
-		xrt_device_get_tracked_pose(space->pose.xdev, space->pose.xname, at_timestamp_ns, &xsr);
+		get_tracked_pose_cached(uso, space, at_timestamp_ns, &xsr);
 		m_relation_chain_push_inverted_relation(xrc, &xsr);
 	} break;
 	case U_SPACE_TYPE_OFFSET: m_relation_chain_push_inverted_pose_if_not_identity(xrc, &space->offset.pose); break;
@@ -238,8 +384,8 @@ build_relation_chain_read_locked(struct u_space_overseer *uso,
 	assert(base != NULL);
 	assert(target != NULL);
 
-	push_then_traverse(xrc, target, at_timestamp_ns);
-	traverse_then_push_inverse(xrc, base, at_timestamp_ns);
+	push_then_traverse(uso, xrc, target, at_timestamp_ns);
+	traverse_then_push_inverse(uso, xrc, base, at_timestamp_ns);
 }
 
 static void
@@ -405,6 +551,41 @@ locate_space(struct xrt_space_overseer *xso,
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+locate_spaces(struct xrt_space_overseer *xso,
+              struct xrt_space *base_space,
+              const struct xrt_pose *base_offset,
+              uint64_t at_timestamp_ns,
+              struct xrt_space **spaces,
+              uint32_t space_count,
+              const struct xrt_pose *offsets,
+              struct xrt_space_relation *out_relations)
+{
+	struct u_space_overseer *uso = u_space_overseer(xso);
+
+	struct u_space *ubase_space = u_space(base_space);
+
+	// Only need the read lock, and only once for all of the spaces.
+	pthread_rwlock_rdlock(&uso->lock);
+
+	for (uint32_t i = 0; i < space_count; i++) {
+		struct u_space *uspace = u_space(spaces[i]);
+
+		struct xrt_relation_chain xrc = {0};
+
+		m_relation_chain_push_pose_if_not_identity(&xrc, &offsets[i]);
+		build_relation_chain_read_locked(uso, &xrc, ubase_space, uspace, at_timestamp_ns);
+		m_relation_chain_push_inverted_pose_if_not_identity(&xrc, base_offset);
+
+		// For base_space =~= space (approx equals).
+		special_resolve(&xrc, &out_relations[i]);
+	}
+
+	pthread_rwlock_unlock(&uso->lock);
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 locate_device(struct xrt_space_overseer *xso,
               struct xrt_space *base_space,
@@ -450,6 +631,7 @@ destroy(struct xrt_space_overseer *xso)
 	u_hashmap_int_clear_and_call_for_each(uso->xdev_map, hashmap_unreference_space_items, uso);
 	u_hashmap_int_destroy(&uso->xdev_map);
 
+	pthread_mutex_destroy(&uso->pose_cache.mutex);
 	pthread_rwlock_destroy(&uso->lock);
 
 	free(uso);
@@ -469,6 +651,7 @@ u_space_overseer_create(void)
 	uso->base.create_offset_space = create_offset_space;
 	uso->base.create_pose_space = create_pose_space;
 	uso->base.locate_space = locate_space;
+	uso->base.locate_spaces = locate_spaces;
 	uso->base.locate_device = locate_device;
 	uso->base.destroy = destroy;
 
@@ -477,6 +660,13 @@ u_space_overseer_create(void)
 	ret = pthread_rwlock_init(&uso->lock, NULL);
 	assert(ret == 0);
 
+	ret = pthread_mutex_init(&uso->pose_cache.mutex, NULL);
+	assert(ret == 0);
+
+	int64_t max_age_us = debug_get_num_option_pose_cache_us();
+	uso->pose_cache.epoch = 1;
+	uso->pose_cache.max_age_ns = max_age_us > 0 ? (uint64_t)max_age_us * 1000 : 0;
+
 	ret = u_hashmap_int_create(&uso->xdev_map);
 	assert(ret == 0);
 
@@ -569,7 +759,19 @@ u_space_overseer_link_space_to_device(struct u_space_overseer *uso, struct xrt_s
 
 	pthread_rwlock_unlock(&uso->lock);
 
+	// The device might have been in another space before.
+	invalidate_pose_cache(uso);
+
 	// Dereferrence old space outside of lock.
 	struct xrt_space *old_space = (struct xrt_space *)ptr;
 	xrt_space_reference(&old_space, NULL);
 }
+
+void
+u_space_overseer_set_pose_cache_max_age(struct u_space_overseer *uso, uint64_t max_age_ns)
+{
+	pthread_mutex_lock(&uso->pose_cache.mutex);
+	uso->pose_cache.max_age_ns = max_age_ns;
+	uso->pose_cache.epoch++;
+	pthread_mutex_unlock(&uso->pose_cache.mutex);
+}
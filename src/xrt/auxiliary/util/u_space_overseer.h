@@ -70,6 +70,20 @@ u_space_overseer_create_null_space(struct u_space_overseer *uso,
 void
 u_space_overseer_link_space_to_device(struct u_space_overseer *uso, struct xrt_space *xs, struct xrt_device *xdev);
 
+/*!
+ * Device poses are cached per (device, input, timestamp) so that locating
+ * many spaces at the same time only asks each device once. Cached poses are
+ * only used for @p max_age_ns after they were fetched, as a device may give a
+ * better prediction once newer tracking data has arrived, this is what keeps
+ * the cache from going stale as devices don't say when they get new tracking
+ * data. Zero disables the cache, the default is set by the
+ * `U_SPACE_OVERSEER_POSE_CACHE_US` environment variable.
+ *
+ * @ingroup aux_util
+ */
+void
+u_space_overseer_set_pose_cache_max_age(struct u_space_overseer *uso, uint64_t max_age_ns);
+
 
 /*
  *
@@ -16,7 +16,7 @@
 
 
 #define MAX_TASK_COUNT (64)
-#define MAX_THREAD_COUNT (16)
+#define MAX_THREAD_COUNT (U_WORKER_THREAD_POOL_MAX_THREADS)
 
 struct group;
 struct pool;
@@ -447,6 +447,22 @@ err_alloc:
 	return NULL;
 }
 
+struct u_worker_thread_pool *
+u_worker_thread_pool_create_helped(long thread_count, const char *prefix)
+{
+	if (thread_count > MAX_THREAD_COUNT) {
+		U_LOG_W("%s: %ld threads asked for, using the max of %d.", prefix, thread_count, MAX_THREAD_COUNT);
+		thread_count = MAX_THREAD_COUNT;
+	}
+
+	if (thread_count <= 1) {
+		return NULL;
+	}
+
+	// The calling thread is the one extra worker.
+	return u_worker_thread_pool_create((uint32_t)thread_count - 1, (uint32_t)thread_count, prefix);
+}
+
 void
 u_worker_thread_pool_destroy(struct u_worker_thread_pool *uwtp)
 {
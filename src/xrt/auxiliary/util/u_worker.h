@@ -24,6 +24,13 @@ extern "C" {
  *
  */
 
+/*!
+ * Max number of threads a pool can have, see @ref u_worker_thread_pool_create.
+ *
+ * @ingroup aux_util
+ */
+#define U_WORKER_THREAD_POOL_MAX_THREADS (16)
+
 /*!
  * A worker pool, can shared between multiple groups worker pool.
  *
@@ -41,7 +48,8 @@ struct u_worker_thread_pool
  *                              same time without any "donated" threads.
  * @param thread_count          The number of threads to be created in total,
  *                              this is the maximum threads that can be in
- *                              flight at the same time.
+ *                              flight at the same time, at most
+ *                              @ref U_WORKER_THREAD_POOL_MAX_THREADS.
  * @param prefix                Prefix to used when naming threads, used for
  *                              tracing and debugging.
  *
@@ -50,6 +58,17 @@ struct u_worker_thread_pool
 struct u_worker_thread_pool *
 u_worker_thread_pool_create(uint32_t starting_worker_count, uint32_t thread_count, const char *prefix);
 
+/*!
+ * Creates a pool for a batch of tasks that the calling thread helps out with
+ * while it waits on them. The @p thread_count includes the calling thread and
+ * is clamped to @ref U_WORKER_THREAD_POOL_MAX_THREADS. Returns NULL if
+ * @p thread_count is one or less, the tasks should then be run directly.
+ *
+ * @ingroup aux_util
+ */
+struct u_worker_thread_pool *
+u_worker_thread_pool_create_helped(long thread_count, const char *prefix);
+
 /*!
  * Internal function, only called by reference.
  *
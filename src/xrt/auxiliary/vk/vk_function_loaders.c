@@ -214,6 +214,7 @@ vk_get_device_functions(struct vk_bundle *vk)
 	vk->vkCmdPushConstants                          = GET_DEV_PROC(vk, vkCmdPushConstants);
 	vk->vkEndCommandBuffer                          = GET_DEV_PROC(vk, vkEndCommandBuffer);
 	vk->vkFreeCommandBuffers                        = GET_DEV_PROC(vk, vkFreeCommandBuffers);
+	vk->vkResetCommandBuffer                        = GET_DEV_PROC(vk, vkResetCommandBuffer);
 
 	vk->vkCreateRenderPass                          = GET_DEV_PROC(vk, vkCreateRenderPass);
 	vk->vkDestroyRenderPass                         = GET_DEV_PROC(vk, vkDestroyRenderPass);
@@ -223,6 +224,7 @@ vk_get_device_functions(struct vk_bundle *vk)
 
 	vk->vkCreatePipelineCache                       = GET_DEV_PROC(vk, vkCreatePipelineCache);
 	vk->vkDestroyPipelineCache                      = GET_DEV_PROC(vk, vkDestroyPipelineCache);
+	vk->vkGetPipelineCacheData                      = GET_DEV_PROC(vk, vkGetPipelineCacheData);
 
 	vk->vkResetDescriptorPool                       = GET_DEV_PROC(vk, vkResetDescriptorPool);
 	vk->vkCreateDescriptorPool                      = GET_DEV_PROC(vk, vkCreateDescriptorPool);
@@ -60,6 +60,13 @@ struct vk_bundle
 
 	struct os_mutex queue_mutex;
 
+	/*!
+	 * Pipeline cache shared by all pipelines created on this device, kept on
+	 * disk between runs, see @ref vk_init_pipeline_cache. Might be
+	 * VK_NULL_HANDLE, which is valid to pass when creating pipelines.
+	 */
+	VkPipelineCache pipeline_cache;
+
 	struct
 	{
 #if defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_WIN32_HANDLE)
@@ -321,6 +328,7 @@ struct vk_bundle
 	PFN_vkCmdPushConstants vkCmdPushConstants;
 	PFN_vkEndCommandBuffer vkEndCommandBuffer;
 	PFN_vkFreeCommandBuffers vkFreeCommandBuffers;
+	PFN_vkResetCommandBuffer vkResetCommandBuffer;
 
 	PFN_vkCreateRenderPass vkCreateRenderPass;
 	PFN_vkDestroyRenderPass vkDestroyRenderPass;
@@ -330,6 +338,7 @@ struct vk_bundle
 
 	PFN_vkCreatePipelineCache vkCreatePipelineCache;
 	PFN_vkDestroyPipelineCache vkDestroyPipelineCache;
+	PFN_vkGetPipelineCacheData vkGetPipelineCacheData;
 
 	PFN_vkResetDescriptorPool vkResetDescriptorPool;
 	PFN_vkCreateDescriptorPool vkCreateDescriptorPool;
@@ -1494,6 +1503,45 @@ vk_create_timeline_semaphore_from_native(struct vk_bundle *vk, xrt_graphics_sync
 #endif
 
 
+/*
+ *
+ * Pipeline cache persistence, in the vk_pipeline_cache.c file.
+ *
+ */
+
+/*!
+ * Create @ref vk_bundle::pipeline_cache, seeding it with the data last saved by
+ * @ref vk_save_pipeline_cache. The saved data is only used if it was written
+ * by the same device with the same driver version and pipeline cache UUID,
+ * otherwise the cache starts out empty. Requires the device to be created.
+ *
+ * Does error logging.
+ *
+ * @ingroup aux_vk
+ */
+VkResult
+vk_init_pipeline_cache(struct vk_bundle *vk);
+
+/*!
+ * Write the contents of @ref vk_bundle::pipeline_cache to the cache directory,
+ * does nothing if there is no pipeline cache. Failing to save is not an error,
+ * the pipelines will just be compiled again on the next start.
+ *
+ * @ingroup aux_vk
+ */
+void
+vk_save_pipeline_cache(struct vk_bundle *vk);
+
+/*!
+ * Destroy @ref vk_bundle::pipeline_cache without saving it, safe to call if
+ * there is no pipeline cache.
+ *
+ * @ingroup aux_vk
+ */
+void
+vk_deinit_pipeline_cache(struct vk_bundle *vk);
+
+
 /*
  *
  * Time function(s), in the vk_time.c file.
@@ -0,0 +1,319 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Pipeline cache that is kept on disk between runs.
+ * @ingroup aux_vk
+ */
+
+#include "xrt/xrt_config_os.h"
+
+#include "util/u_file.h"
+#include "util/u_misc.h"
+
+#include "vk/vk_helpers.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef XRT_OS_LINUX
+#include <linux/limits.h>
+#endif
+
+
+/*
+ *
+ * Defines and structs.
+ *
+ */
+
+//! Sub-directory of the cache directory the files are kept in.
+#define CACHE_SUBPATH "vulkan"
+
+//! 'MVPC' little endian.
+#define CACHE_MAGIC 0x4350564d
+
+//! Bump when the layout of @ref cache_file_header changes.
+#define CACHE_VERSION 1
+
+//! Way bigger than anything the compositor should produce, guards against junk.
+#define CACHE_MAX_DATA_SIZE (64 * 1024 * 1024)
+
+/*!
+ * Written in front of the data returned by vkGetPipelineCacheData, the driver
+ * also checks its own header but not all drivers are good at rejecting data
+ * from other driver versions.
+ */
+struct cache_file_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vendor_id;
+	uint32_t device_id;
+	uint32_t driver_version;
+	uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+	uint32_t _padding;
+	uint64_t data_size;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+#ifdef XRT_OS_LINUX
+
+static void
+fill_in_header(struct vk_bundle *vk, struct cache_file_header *header)
+{
+	VkPhysicalDeviceProperties pdp;
+	vk->vkGetPhysicalDeviceProperties(vk->physical_device, &pdp);
+
+	U_ZERO(header);
+	header->magic = CACHE_MAGIC;
+	header->version = CACHE_VERSION;
+	header->vendor_id = pdp.vendorID;
+	header->device_id = pdp.deviceID;
+	header->driver_version = pdp.driverVersion;
+	memcpy(header->pipeline_cache_uuid, pdp.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+//! One file per device, so that switching GPU does not throw the cache away.
+static bool
+get_filename(const struct cache_file_header *header, const char *suffix, char *out_name, size_t out_name_size)
+{
+	int ret = snprintf(out_name, out_name_size, "pipeline_cache_%04x_%04x.bin%s", header->vendor_id,
+	                   header->device_id, suffix);
+
+	return ret > 0 && ret < (int)out_name_size;
+}
+
+static bool
+get_path(const char *filename, char *out_path, size_t out_path_size)
+{
+	char dir[PATH_MAX];
+	ssize_t ret = u_file_get_cache_dir(dir, sizeof(dir));
+	if (ret <= 0 || ret >= (ssize_t)sizeof(dir)) {
+		return false;
+	}
+
+	ret = snprintf(out_path, out_path_size, "%s/%s/%s", dir, CACHE_SUBPATH, filename);
+
+	return ret > 0 && ret < (ssize_t)out_path_size;
+}
+
+/*!
+ * Returns the cache data from disk if it matches the device, the caller must
+ * free the returned data.
+ */
+static void *
+load_data(struct vk_bundle *vk, size_t *out_size)
+{
+	struct cache_file_header expected;
+	fill_in_header(vk, &expected);
+
+	char filename[64];
+	if (!get_filename(&expected, "", filename, sizeof(filename))) {
+		return NULL;
+	}
+
+	FILE *file = u_file_open_file_in_cache_dir_subpath(CACHE_SUBPATH, filename, "rb");
+	if (file == NULL) {
+		VK_DEBUG(vk, "No saved pipeline cache '%s'", filename);
+		return NULL;
+	}
+
+	struct cache_file_header header;
+	void *data = NULL;
+
+	if (fread(&header, sizeof(header), 1, file) != 1) {
+		VK_WARN(vk, "Pipeline cache '%s' is truncated, ignoring", filename);
+		goto out;
+	}
+
+	expected.data_size = header.data_size;
+	if (memcmp(&header, &expected, sizeof(header)) != 0) {
+		VK_INFO(vk, "Pipeline cache '%s' is from another driver, ignoring", filename);
+		goto out;
+	}
+
+	if (header.data_size == 0 || header.data_size > CACHE_MAX_DATA_SIZE) {
+		VK_WARN(vk, "Pipeline cache '%s' has bad size %" PRIu64 ", ignoring", filename, header.data_size);
+		goto out;
+	}
+
+	data = malloc(header.data_size);
+	if (data == NULL) {
+		goto out;
+	}
+
+	if (fread(data, header.data_size, 1, file) != 1) {
+		VK_WARN(vk, "Pipeline cache '%s' is truncated, ignoring", filename);
+		free(data);
+		data = NULL;
+		goto out;
+	}
+
+	*out_size = (size_t)header.data_size;
+
+out:
+	fclose(file);
+
+	return data;
+}
+
+/*!
+ * Write to a temporary file and rename it over the old one, so that a crash or
+ * another process never sees a half written cache.
+ */
+static bool
+save_data(struct vk_bundle *vk, const void *data, size_t size)
+{
+	struct cache_file_header header;
+	fill_in_header(vk, &header);
+	header.data_size = size;
+
+	char filename[64];
+	char tmp_filename[64];
+	if (!get_filename(&header, "", filename, sizeof(filename)) ||
+	    !get_filename(&header, ".tmp", tmp_filename, sizeof(tmp_filename))) {
+		return false;
+	}
+
+	char path[PATH_MAX + 64];
+	char tmp_path[PATH_MAX + 64];
+	if (!get_path(filename, path, sizeof(path)) || !get_path(tmp_filename, tmp_path, sizeof(tmp_path))) {
+		return false;
+	}
+
+	// Creates the directory if needed.
+	FILE *file = u_file_open_file_in_cache_dir_subpath(CACHE_SUBPATH, tmp_filename, "wb");
+	if (file == NULL) {
+		VK_WARN(vk, "Could not open '%s' for writing", tmp_path);
+		return false;
+	}
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 && //
+	               fwrite(data, size, 1, file) == 1;
+	written = (fclose(file) == 0) && written;
+
+	if (!written || rename(tmp_path, path) != 0) {
+		VK_WARN(vk, "Failed to write pipeline cache '%s'", path);
+		remove(tmp_path);
+		return false;
+	}
+
+	VK_DEBUG(vk, "Saved %zu bytes of pipeline cache to '%s'", size, path);
+
+	return true;
+}
+
+#endif /* XRT_OS_LINUX */
+
+static VkResult
+create_cache(struct vk_bundle *vk, const void *data, size_t size, VkPipelineCache *out_pipeline_cache)
+{
+	VkPipelineCacheCreateInfo pipeline_cache_info = {
+	    .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+	    .initialDataSize = size,
+	    .pInitialData = data,
+	};
+
+	return vk->vkCreatePipelineCache( //
+	    vk->device,                   // device
+	    &pipeline_cache_info,         // pCreateInfo
+	    NULL,                         // pAllocator
+	    out_pipeline_cache);          // pPipelineCache
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+VkResult
+vk_init_pipeline_cache(struct vk_bundle *vk)
+{
+	assert(vk->device != VK_NULL_HANDLE);
+	assert(vk->pipeline_cache == VK_NULL_HANDLE);
+
+	void *data = NULL;
+	size_t size = 0;
+
+#ifdef XRT_OS_LINUX
+	data = load_data(vk, &size);
+#endif
+
+	VkResult ret = VK_ERROR_INITIALIZATION_FAILED;
+	if (data != NULL) {
+		ret = create_cache(vk, data, size, &vk->pipeline_cache);
+		if (ret == VK_SUCCESS) {
+			VK_INFO(vk, "Loaded %zu bytes of pipeline cache", size);
+		} else {
+			VK_WARN(vk, "Driver rejected saved pipeline cache: %s", vk_result_string(ret));
+		}
+		free(data);
+	}
+
+	if (ret != VK_SUCCESS) {
+		ret = create_cache(vk, NULL, 0, &vk->pipeline_cache);
+	}
+
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkCreatePipelineCache failed: %s", vk_result_string(ret));
+		vk->pipeline_cache = VK_NULL_HANDLE;
+		return ret;
+	}
+
+	return VK_SUCCESS;
+}
+
+void
+vk_save_pipeline_cache(struct vk_bundle *vk)
+{
+	if (vk->pipeline_cache == VK_NULL_HANDLE) {
+		return;
+	}
+
+#ifdef XRT_OS_LINUX
+	size_t size = 0;
+	VkResult ret = vk->vkGetPipelineCacheData(vk->device, vk->pipeline_cache, &size, NULL);
+	if (ret != VK_SUCCESS || size == 0 || size > CACHE_MAX_DATA_SIZE) {
+		VK_DEBUG(vk, "Not saving pipeline cache, size: %zu ret: %s", size, vk_result_string(ret));
+		return;
+	}
+
+	void *data = malloc(size);
+	if (data == NULL) {
+		return;
+	}
+
+	// Can still be VK_INCOMPLETE if another thread added pipelines in between.
+	ret = vk->vkGetPipelineCacheData(vk->device, vk->pipeline_cache, &size, data);
+	if (ret == VK_SUCCESS) {
+		save_data(vk, data, size);
+	} else {
+		VK_WARN(vk, "vkGetPipelineCacheData: %s", vk_result_string(ret));
+	}
+
+	free(data);
+#endif
+}
+
+void
+vk_deinit_pipeline_cache(struct vk_bundle *vk)
+{
+	if (vk->pipeline_cache == VK_NULL_HANDLE) {
+		return;
+	}
+
+	vk->vkDestroyPipelineCache(vk->device, vk->pipeline_cache, NULL);
+	vk->pipeline_cache = VK_NULL_HANDLE;
+}
@@ -347,29 +347,6 @@ do_graphics_layers(struct comp_compositor *c)
 	}
 }
 
-/*!
- * We have a fast path for single projection layer that goes directly
- * to the distortion shader, so no need to use the layer renderer.
- */
-static bool
-can_do_one_projection_layer_fast_path(struct comp_compositor *c)
-{
-	if (c->base.slot.layer_count != 1) {
-		return false;
-	}
-
-	struct comp_layer *layer = &c->base.slot.layers[0];
-	enum xrt_layer_type type = layer->data.type;
-
-	// Handled by the distortion shader.
-	if (type != XRT_LAYER_STEREO_PROJECTION && //
-	    type != XRT_LAYER_STEREO_PROJECTION_DEPTH) {
-		return false;
-	}
-
-	return true;
-}
-
 static xrt_result_t
 compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handle_t sync_handle)
 {
@@ -380,11 +357,12 @@ compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handle_t sy
 	COMP_SPEW(c, "LAYER_COMMIT at %8.3fms", ts_ms());
 
 	/*
-	 * We have a fast path for single projection layer that goes directly
-	 * to the distortion shader, so no need to use the layer renderer.
+	 * Drops layers that can't be seen and picks how to render the rest, a
+	 * single projection layer, with compute optionally with a few quads on
+	 * top, goes directly to the distortion shader, so no need to use the
+	 * layer renderer.
 	 */
-	bool fast_path = can_do_one_projection_layer_fast_path(c) && !c->mirroring_to_debug_gui && !c->peek;
-	c->base.slot.one_projection_layer_fast_path = fast_path;
+	comp_renderer_plan_layers(c->r);
 
 
 	u_graphics_sync_unref(&sync_handle);
@@ -475,6 +453,10 @@ compositor_destroy(struct xrt_compositor *xc)
 	// As long as vk_bundle is valid it's safe to call this function.
 	render_shaders_close(&c->shaders, vk);
 
+	// Pick up any pipelines created after startup.
+	vk_save_pipeline_cache(vk);
+	vk_deinit_pipeline_cache(vk);
+
 	if (vk->device != VK_NULL_HANDLE) {
 		vk->vkDestroyDevice(vk->device, NULL);
 		vk->device = VK_NULL_HANDLE;
@@ -752,6 +734,11 @@ compositor_init_vulkan(struct comp_compositor *c)
 	c->settings.client_gpu_deviceLUID = vk_res.client_gpu_deviceLUID;
 	c->settings.client_gpu_deviceLUID_valid = vk_res.client_gpu_deviceLUID_valid;
 
+	// Not fatal, pipelines can be created without a cache.
+	if (vk_init_pipeline_cache(vk) != VK_SUCCESS) {
+		COMP_WARN(c, "Could not create pipeline cache, startup will be slower.");
+	}
+
 	// Tie the lifetimes of swapchains to Vulkan.
 	xrt_result_t xret = comp_swapchain_shared_init(&c->base.cscs, vk);
 	if (xret != XRT_SUCCESS) {
@@ -793,6 +780,7 @@ const struct comp_target_factory *ctfs[] = {
 #ifdef VK_USE_PLATFORM_DISPLAY_KHR
     &comp_target_factory_vk_display,
 #endif
+    &comp_target_factory_headless,
 };
 
 static void
@@ -1014,7 +1002,14 @@ compositor_init_renderer(struct comp_compositor *c)
 	c->peek = NULL;
 #endif
 
-	return c->r != NULL;
+	if (c->r == NULL) {
+		return false;
+	}
+
+	// All of the pipelines have been created now, save them for the next start.
+	vk_save_pipeline_cache(get_vk(c));
+
+	return true;
 }
 
 xrt_result_t
@@ -1167,6 +1162,10 @@ comp_main_create_system_compositor(struct xrt_device *xdev,
 	u_var_add_ro_f32(c, &c->compositor_frame_times.fps, "FPS (Compositor)");
 	u_var_add_bool(c, &c->debug.atw_off, "Debug: ATW OFF");
 	u_var_add_f32_timing(c, c->compositor_frame_times.debug_var, "Frame Times (Compositor)");
+	u_var_add_ro_u32(c, &c->base.cscs.recycle.entry_count, "Swapchain pool entries");
+	u_var_add_ro_u64(c, &c->base.cscs.recycle.size, "Swapchain pool size (bytes)");
+	u_var_add_ro_u64(c, &c->base.cscs.recycle.hits, "Swapchains created from pool");
+	u_var_add_ro_u64(c, &c->base.cscs.recycle.misses, "Swapchains allocated");
 
 
 	//! @todo: Query all supported refresh rates of the current mode
@@ -110,22 +110,6 @@ _init_pipeline_layout(struct comp_layer_renderer *self)
 	return true;
 }
 
-static bool
-_init_pipeline_cache(struct comp_layer_renderer *self)
-{
-	struct vk_bundle *vk = self->vk;
-
-	VkPipelineCacheCreateInfo info = {
-	    .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
-	};
-
-	VkResult res = vk->vkCreatePipelineCache(vk->device, &info, NULL, &self->pipeline_cache);
-
-	vk_check_error("vkCreatePipelineCache", res, false);
-
-	return true;
-}
-
 // These are MSVC-style pragmas, but supported by GCC since early in the 4
 // series.
 #pragma pack(push, 1)
@@ -268,7 +252,7 @@ _init_graphics_pipeline(struct comp_layer_renderer *self,
 	};
 
 	VkResult res;
-	res = vk->vkCreateGraphicsPipelines(vk->device, self->pipeline_cache, 1, &pipeline_info, NULL, pipeline);
+	res = vk->vkCreateGraphicsPipelines(vk->device, vk->pipeline_cache, 1, &pipeline_info, NULL, pipeline);
 
 	vk_check_error("vkCreateGraphicsPipelines", res, false);
 
@@ -411,8 +395,6 @@ _init(struct comp_layer_renderer *self,
 		return false;
 	if (!_init_pipeline_layout(self))
 		return false;
-	if (!_init_pipeline_cache(self))
-		return false;
 
 
 	if (!_init_graphics_pipeline(self, s->layer_vert, s->layer_frag, false, &self->pipeline_premultiplied_alpha)) {
@@ -589,8 +571,6 @@ comp_layer_renderer_destroy(struct comp_layer_renderer **ptr_clr)
 
 	vk_buffer_destroy(&self->vertex_buffer, vk);
 
-	vk->vkDestroyPipelineCache(vk->device, self->pipeline_cache, NULL);
-
 	free(self);
 	*ptr_clr = NULL;
 }
@@ -33,7 +33,6 @@ struct comp_layer_renderer
 	VkDescriptorSetLayout descriptor_set_layout_equirect;
 
 	VkPipelineLayout pipeline_layout;
-	VkPipelineCache pipeline_cache;
 
 	struct xrt_matrix_4x4 mat_world_view[2];
 	struct xrt_matrix_4x4 mat_eye_view[2];
@@ -248,6 +248,151 @@ calc_dispatch_dims(const VkExtent2D extent, uint32_t *out_w, uint32_t *out_h)
 	*out_h = h;
 }
 
+/*!
+ * Use a single timeline semaphore for all readbacks if available, otherwise
+ * one fence per slot.
+ */
+static VkResult
+create_readback_sync(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk)
+{
+	VkResult ret;
+
+#ifdef VK_KHR_timeline_semaphore
+	if (vk->features.timeline_semaphore) {
+		VkSemaphoreTypeCreateInfo type_info = {
+		    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+		    .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+		    .initialValue = 0,
+		};
+
+		VkSemaphoreCreateInfo semaphore_info = {
+		    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+		    .pNext = &type_info,
+		};
+
+		ret = vk->vkCreateSemaphore( //
+		    vk->device,              // device
+		    &semaphore_info,         // pCreateInfo
+		    NULL,                    // pAllocator
+		    &m->readback.timeline);  // pSemaphore
+		if (ret != VK_SUCCESS) {
+			VK_ERROR(vk, "vkCreateSemaphore: %s", vk_result_string(ret));
+			return ret;
+		}
+
+		VK_NAME_OBJECT(vk, SEMAPHORE, m->readback.timeline, "comp_mirror readback timeline");
+
+		return VK_SUCCESS;
+	}
+#endif
+
+	VkFenceCreateInfo fence_info = {
+	    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+	};
+
+	for (uint32_t i = 0; i < COMP_MIRROR_READBACK_COUNT; i++) {
+		ret = vk->vkCreateFence(vk->device, &fence_info, NULL, &m->readback.slots[i].fence);
+		if (ret != VK_SUCCESS) {
+			VK_ERROR(vk, "vkCreateFence: %s", vk_result_string(ret));
+			return ret;
+		}
+
+		VK_NAME_OBJECT(vk, FENCE, m->readback.slots[i].fence, "comp_mirror readback fence");
+	}
+
+	return VK_SUCCESS;
+}
+
+//! Has the GPU finished the readback, never blocks.
+static bool
+is_readback_done(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk, struct comp_mirror_readback *rb)
+{
+#ifdef VK_KHR_timeline_semaphore
+	if (m->readback.timeline != VK_NULL_HANDLE) {
+		uint64_t value = 0;
+		VkResult ret = vk->vkGetSemaphoreCounterValue(vk->device, m->readback.timeline, &value);
+		if (ret != VK_SUCCESS) {
+			VK_ERROR(vk, "vkGetSemaphoreCounterValue: %s", vk_result_string(ret));
+			return false;
+		}
+
+		return value >= rb->timeline_value;
+	}
+#endif
+
+	return vk->vkGetFenceStatus(vk->device, rb->fence) == VK_SUCCESS;
+}
+
+//! Only used when tearing down, gives up after a second.
+static void
+wait_readback(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk, struct comp_mirror_readback *rb)
+{
+	VkResult ret;
+
+#ifdef VK_KHR_timeline_semaphore
+	if (m->readback.timeline != VK_NULL_HANDLE) {
+		VkSemaphoreWaitInfo wait_info = {
+		    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+		    .semaphoreCount = 1,
+		    .pSemaphores = &m->readback.timeline,
+		    .pValues = &rb->timeline_value,
+		};
+
+		ret = vk->vkWaitSemaphores(vk->device, &wait_info, U_TIME_1S_IN_NS);
+		if (ret != VK_SUCCESS) {
+			VK_ERROR(vk, "vkWaitSemaphores: %s", vk_result_string(ret));
+		}
+		return;
+	}
+#endif
+
+	ret = vk->vkWaitForFences(vk->device, 1, &rb->fence, VK_TRUE, U_TIME_1S_IN_NS);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkWaitForFences: %s", vk_result_string(ret));
+	}
+}
+
+/*!
+ * Frees the command buffer and releases the frame, pushing it to the sink
+ * first if @p push is set.
+ */
+static void
+retire_readback(struct comp_mirror_to_debug_gui *m,
+                struct vk_bundle *vk,
+                struct comp_mirror_readback *rb,
+                bool push)
+{
+	struct vk_cmd_pool *pool = &m->cmd_pool;
+
+	if (rb->cmd != VK_NULL_HANDLE) {
+		vk_cmd_pool_lock(pool);
+		vk->vkFreeCommandBuffers(vk->device, pool->pool, 1, &rb->cmd);
+		vk_cmd_pool_unlock(pool);
+		rb->cmd = VK_NULL_HANDLE;
+	}
+
+	struct xrt_frame *frame = &rb->wrap->base_frame;
+	rb->wrap = NULL;
+
+	if (push) {
+		u_sink_debug_push_frame(&m->debug_sink, frame);
+		u_frame_times_widget_push_sample(&m->push_frame_times, rb->predicted_display_time_ns);
+	}
+
+	xrt_frame_reference(&frame, NULL);
+}
+
+static struct comp_mirror_readback *
+get_oldest_readback(struct comp_mirror_to_debug_gui *m)
+{
+	assert(m->readback.count > 0);
+
+	uint32_t index = (m->readback.next + COMP_MIRROR_READBACK_COUNT - m->readback.count) %
+	                 COMP_MIRROR_READBACK_COUNT;
+
+	return &m->readback.slots[index];
+}
+
 
 /*
  *
@@ -302,7 +447,7 @@ comp_mirror_init(struct comp_mirror_to_debug_gui *m,
 	    .sampler_per_descriptor_count = 1,
 	    .storage_image_per_descriptor_count = 1,
 	    .storage_buffer_per_descriptor_count = 0,
-	    .descriptor_count = 1,
+	    .descriptor_count = COMP_MIRROR_READBACK_COUNT,
 	    .freeable = false,
 	};
 
@@ -312,10 +457,18 @@ comp_mirror_init(struct comp_mirror_to_debug_gui *m,
 	    &m->blit.descriptor_pool)); // out_descriptor_pool
 
 
-	C(vk_create_pipeline_cache(vk, &m->blit.pipeline_cache));
-
 	C(create_blit_descriptor_set_layout(vk, &m->blit.descriptor_set_layout));
 
+	for (uint32_t i = 0; i < COMP_MIRROR_READBACK_COUNT; i++) {
+		C(vk_create_descriptor_set(                 //
+		    vk,                                     // vk_bundle
+		    m->blit.descriptor_pool,                // descriptor_pool
+		    m->blit.descriptor_set_layout,          // descriptor_set_layout
+		    &m->readback.slots[i].descriptor_set)); // descriptor_set
+	}
+
+	C(create_readback_sync(m, vk));
+
 	C(create_blit_pipeline_layout(     //
 	    vk,                            // vk_bundle
 	    m->blit.descriptor_set_layout, // descriptor_set_layout
@@ -323,7 +476,7 @@ comp_mirror_init(struct comp_mirror_to_debug_gui *m,
 
 	C(vk_create_compute_pipeline( //
 	    vk,                       // vk_bundle
-	    m->blit.pipeline_cache,   // pipeline_cache
+	    vk->pipeline_cache,       // pipeline_cache
 	    shaders->blit_comp,       // shader
 	    m->blit.pipeline_layout,  // pipeline_layout
 	    NULL,                     // specialization_info
@@ -347,6 +500,7 @@ comp_mirror_add_debug_vars(struct comp_mirror_to_debug_gui *m, struct comp_compo
 
 	u_var_add_bool(m, &c->mirroring_to_debug_gui, "Readback left eye to debug GUI");
 	u_var_add_i32(m, &m->push_every_frame_out_of_X, "Push 1 frame out of every X frames");
+	u_var_add_ro_u64(m, &m->readback.dropped, "Frames dropped, readbacks in flight");
 
 	u_var_add_ro_f32(m, &m->push_frame_times.fps, "FPS (Readback)");
 	u_var_add_f32_timing(m, m->push_frame_times.debug_var, "Frame Times (Readback)");
@@ -396,6 +550,23 @@ comp_mirror_is_ready_and_active(struct comp_mirror_to_debug_gui *m,
 	return true;
 }
 
+void
+comp_mirror_poll(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk)
+{
+	COMP_TRACE_MARKER();
+
+	// Retire in order, so that frames are pushed in the order they were rendered.
+	while (m->readback.count > 0) {
+		struct comp_mirror_readback *rb = get_oldest_readback(m);
+		if (!is_readback_done(m, vk, rb)) {
+			break;
+		}
+
+		retire_readback(m, vk, rb, true);
+		m->readback.count--;
+	}
+}
+
 void
 comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
                     struct vk_bundle *vk,
@@ -411,9 +582,12 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 
 	VkResult ret;
 
-	struct vk_image_readback_to_xf *wrap = NULL;
+	// Makes room in the ring if the GPU is done with older readbacks.
+	comp_mirror_poll(m, vk);
 
-	if (!vk_image_readback_to_xf_pool_get_unused_frame(vk, m->pool, &wrap)) {
+	// Never wait on the GPU here, skip the frame instead.
+	if (m->readback.count >= COMP_MIRROR_READBACK_COUNT) {
+		m->readback.dropped++;
 		return;
 	}
 
@@ -421,17 +595,18 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 		return;
 	}
 
-	VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
-	ret = vk_create_descriptor_set(    //
-	    vk,                            //
-	    m->blit.descriptor_pool,       // descriptor_pool
-	    m->blit.descriptor_set_layout, // descriptor_set_layout
-	    &descriptor_set);              // descriptor_set
-	if (ret != VK_SUCCESS) {
-		VK_ERROR(vk, "vk_create_descriptor_set: %s", vk_result_string(ret));
+	struct vk_image_readback_to_xf *wrap = NULL;
+
+	if (!vk_image_readback_to_xf_pool_get_unused_frame(vk, m->pool, &wrap)) {
 		return;
 	}
 
+	struct comp_mirror_readback *rb = &m->readback.slots[m->readback.next];
+	assert(rb->wrap == NULL && rb->cmd == VK_NULL_HANDLE);
+
+	// Free slots are not in use by the GPU, so safe to update.
+	VkDescriptorSet descriptor_set = rb->descriptor_set;
+
 	struct vk_cmd_pool *pool = &m->cmd_pool;
 
 	// For writing and submitting commands.
@@ -440,8 +615,9 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 	VkCommandBuffer cmd;
 	ret = vk_cmd_pool_create_and_begin_cmd_buffer_locked(vk, pool, 0, &cmd);
 	if (ret != VK_SUCCESS) {
-		vk->vkResetDescriptorPool(vk->device, m->blit.descriptor_pool, 0);
 		vk_cmd_pool_unlock(pool);
+		struct xrt_frame *frame = &wrap->base_frame;
+		xrt_frame_reference(&frame, NULL);
 		return;
 	}
 
@@ -603,38 +779,70 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 	    VK_PIPELINE_STAGE_HOST_BIT,           // dstStageMask
 	    first_color_level_subresource_range); // subresourceRange
 
-	// This takes a long time so make sure to trace it.
-	COMP_TRACE_BEGIN(submit_and_wait);
+	wrap->base_frame.source_timestamp = wrap->base_frame.timestamp = predicted_display_time_ns;
+	wrap->base_frame.source_sequence = frame_id;
 
-	// Done writing commands, submit to queue, waits for command to finish.
-	ret = vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked(vk, pool, cmd);
+	rb->wrap = wrap;
+	rb->cmd = cmd;
+	rb->predicted_display_time_ns = predicted_display_time_ns;
+	wrap = NULL;
 
-	// Stop this block.
-	COMP_TRACE_END(submit_and_wait);
+	// Next pointer for VkSubmitInfo
+	const void *next = NULL;
+	VkFence fence = VK_NULL_HANDLE;
 
-	// Done with everything, can unlock the pool now.
-	vk_cmd_pool_unlock(pool);
+#ifdef VK_KHR_timeline_semaphore
+	uint64_t signal_value = m->readback.timeline_value + 1;
 
-	// Check results from submit.
-	if (ret != VK_SUCCESS) {
-		//! @todo Better handling of error?
-		VK_ERROR(vk, "vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked: %s", vk_result_string(ret));
+	VkTimelineSemaphoreSubmitInfoKHR timeline_info = {
+	    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
+	    .signalSemaphoreValueCount = 1,
+	    .pSignalSemaphoreValues = &signal_value,
+	};
+
+	if (m->readback.timeline != VK_NULL_HANDLE) {
+		next = &timeline_info;
 	}
+#endif
 
-	wrap->base_frame.source_timestamp = wrap->base_frame.timestamp = predicted_display_time_ns;
-	wrap->base_frame.source_sequence = frame_id;
+	if (m->readback.timeline == VK_NULL_HANDLE) {
+		fence = rb->fence;
+		vk->vkResetFences(vk->device, 1, &fence);
+	}
 
-	struct xrt_frame *frame = &wrap->base_frame;
-	wrap = NULL;
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .pNext = next,
+	    .commandBufferCount = 1,
+	    .pCommandBuffers = &cmd,
+	    .signalSemaphoreCount = m->readback.timeline != VK_NULL_HANDLE ? 1 : 0,
+	    .pSignalSemaphores = &m->readback.timeline,
+	};
 
-	u_sink_debug_push_frame(&m->debug_sink, frame);
+	// Done writing commands, submit to queue, completion is checked in comp_mirror_poll.
+	ret = vk->vkEndCommandBuffer(cmd);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkEndCommandBuffer: %s", vk_result_string(ret));
+	} else {
+		ret = vk_cmd_submit_locked(vk, 1, &submit_info, fence);
+	}
 
-	u_frame_times_widget_push_sample(&m->push_frame_times, predicted_display_time_ns);
+	// Done with everything, can unlock the pool now.
+	vk_cmd_pool_unlock(pool);
 
-	xrt_frame_reference(&frame, NULL);
+	if (ret != VK_SUCCESS) {
+		// Nothing was submitted, release without pushing.
+		retire_readback(m, vk, rb, false);
+		return;
+	}
+
+#ifdef VK_KHR_timeline_semaphore
+	m->readback.timeline_value = signal_value;
+	rb->timeline_value = signal_value;
+#endif
 
-	// Tidies the descriptor we created.
-	vk->vkResetDescriptorPool(vk->device, m->blit.descriptor_pool, 0);
+	m->readback.next = (m->readback.next + 1) % COMP_MIRROR_READBACK_COUNT;
+	m->readback.count++;
 }
 
 void
@@ -643,6 +851,19 @@ comp_mirror_fini(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk)
 	// Remove u_var root as early as possible.
 	u_var_remove_root(m);
 
+	// Release the frames of readbacks still in flight, no use pushing them now.
+	while (m->readback.count > 0) {
+		struct comp_mirror_readback *rb = get_oldest_readback(m);
+		wait_readback(m, vk, rb);
+		retire_readback(m, vk, rb, false);
+		m->readback.count--;
+	}
+
+	for (uint32_t i = 0; i < COMP_MIRROR_READBACK_COUNT; i++) {
+		D(Fence, m->readback.slots[i].fence);
+	}
+	D(Semaphore, m->readback.timeline);
+
 	// Left eye readback
 	vk_image_readback_to_xf_pool_destroy(vk, &m->pool);
 
@@ -657,7 +878,6 @@ comp_mirror_fini(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk)
 	// Destroy blit shader Vulkan resources.
 	D(Pipeline, m->blit.pipeline);
 	D(PipelineLayout, m->blit.pipeline_layout);
-	D(PipelineCache, m->blit.pipeline_cache);
 	D(DescriptorPool, m->blit.descriptor_pool);
 	D(DescriptorSetLayout, m->blit.descriptor_set_layout);
 
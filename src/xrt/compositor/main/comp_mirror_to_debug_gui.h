@@ -19,6 +19,35 @@ extern "C" {
 #endif
 
 
+//! How many readbacks can be in flight on the GPU at the same time.
+#define COMP_MIRROR_READBACK_COUNT 3
+
+/*!
+ * One readback submitted to the GPU, the frame is pushed to the sink once the
+ * GPU is done with it.
+ *
+ * @ingroup comp_main
+ */
+struct comp_mirror_readback
+{
+	//! Frame being written to, NULL if the slot is free.
+	struct vk_image_readback_to_xf *wrap;
+
+	//! Allocated once, only updated when the slot is free.
+	VkDescriptorSet descriptor_set;
+
+	//! Freed when the readback is retired.
+	VkCommandBuffer cmd;
+
+	//! Signalled when done, only used if timeline semaphores are not available.
+	VkFence fence;
+
+	//! The value the timeline semaphore reaches when this readback is done.
+	uint64_t timeline_value;
+
+	uint64_t predicted_display_time_ns;
+};
+
 /*!
  * Helper struct for mirroring the compositors rendering to the debug ui,
  * which also enables recording. Currently embedded in @ref comp_renderer.
@@ -44,6 +73,30 @@ struct comp_mirror_to_debug_gui
 
 	struct vk_image_readback_to_xf_pool *pool;
 
+	/*!
+	 * Ring of readbacks in flight, they are retired in submission order
+	 * without ever waiting on the GPU.
+	 */
+	struct
+	{
+		struct comp_mirror_readback slots[COMP_MIRROR_READBACK_COUNT];
+
+		//! Index of the slot to use for the next readback.
+		uint32_t next;
+
+		//! Number of readbacks in flight.
+		uint32_t count;
+
+		//! Signalled by all readbacks, VK_NULL_HANDLE if not supported.
+		VkSemaphore timeline;
+
+		//! Last value used to signal the timeline semaphore.
+		uint64_t timeline_value;
+
+		//! Frames skipped because all slots were in flight.
+		uint64_t dropped;
+	} readback;
+
 	struct
 	{
 		VkImage image;
@@ -53,9 +106,6 @@ struct comp_mirror_to_debug_gui
 
 	struct
 	{
-		//! Private here for now.
-		VkPipelineCache pipeline_cache;
-
 		//! Descriptor pool for blit.
 		VkDescriptorPool descriptor_pool;
 
@@ -111,7 +161,18 @@ comp_mirror_is_ready_and_active(struct comp_mirror_to_debug_gui *m,
                                 uint64_t predicted_display_time_ns);
 
 /*!
- * Do the blit.
+ * Push the frames of all finished readbacks to the sink, never waits on the
+ * GPU. Should be called every frame, even when no blit is done.
+ *
+ * @public @memberof comp_mirror_to_debug_gui
+ */
+void
+comp_mirror_poll(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk);
+
+/*!
+ * Do the blit and readback, the commands are only submitted and the frame is
+ * pushed by a later call to @ref comp_mirror_poll. If too many readbacks are
+ * already in flight the frame is skipped.
  *
  * @public @memberof comp_mirror_to_debug_gui
  */
@@ -70,6 +70,53 @@
  *
  */
 
+/*!
+ * How many recorded compute command buffers to keep per target image, the
+ * target and app swapchains cycle at their own pace so one is not enough.
+ */
+#define COMPUTE_CACHE_WAYS (4)
+
+/*!
+ * What a recorded fast path compute command buffer depends on, besides the
+ * target image. Compared with memcmp, so always zero it before filling it in.
+ */
+struct compute_cache_key
+{
+	//! From @ref comp_swapchain_shared, a changed count means views may have been reused.
+	uint64_t swapchains_destroyed;
+
+	//! From @ref render_resources, the distortion images are bound in the command buffer.
+	uint64_t distortion_generation;
+
+	VkImageView src_image_views[2];
+	struct render_viewport_data views[2];
+	bool do_timewarp;
+
+	//! The layer is reprojected with its depth, which uses another pipeline and binds the depth images.
+	bool depth;
+	VkImageView depth_image_views[2];
+
+	//! The fovea centers only go into the UBO, but its size changes the dispatch.
+	uint32_t foveation_tile_size;
+	float foveation_fraction;
+};
+
+/*!
+ * A compute command buffer recorded for one target image.
+ */
+struct compute_cache_entry
+{
+	bool valid;
+
+	//! For picking which entry to replace.
+	uint64_t last_used;
+
+	struct compute_cache_key key;
+
+	//! Initialised with @ref render_compute_init_reusable.
+	struct render_compute crc;
+};
+
 /*!
  * Holds associated vulkan objects and state to render with a distortion.
  *
@@ -96,6 +143,60 @@ struct comp_renderer
 	//! Targets for rendering to the scratch buffer.
 	struct render_gfx_target_resources scratch_targets[2];
 
+	//! Re-sampling of the head pose just before submit, see @ref comp_settings::late_latch.
+	struct
+	{
+		bool enabled;
+
+		//! When the head pose was first sampled this frame.
+		uint64_t first_sample_ns;
+
+		//! How much later the late sample was, for the debug UI.
+		float gain_ms;
+	} late_latch;
+
+	//! Replaying of recorded compute command buffers, see @ref comp_settings::reuse_compute_cmd.
+	struct
+	{
+		bool enabled;
+
+		//! Bumped every use, for @ref compute_cache_entry::last_used.
+		uint64_t use_count;
+
+		uint64_t hits;
+		uint64_t misses;
+	} compute_reuse;
+
+	//! Per frame choice of how to render the layers, see @ref comp_renderer_plan_layers.
+	struct
+	{
+		//! Drop layers that can not be seen before picking the plan, off by default.
+		bool cull;
+
+		//! Always squash the layers, for comparing against the other plans.
+		bool force_squash;
+
+		//! The @ref comp_renderer_plan picked for the last frame.
+		uint32_t last;
+
+		//! How many layers were dropped from the last frame.
+		uint32_t culled;
+
+		//! Number of frames rendered with each @ref comp_renderer_plan.
+		uint64_t counts[COMP_RENDERER_PLAN_COUNT];
+	} plan;
+
+	//! Foveated distortion, see @ref comp_settings::foveation.
+	struct
+	{
+		struct render_compute_foveation params;
+
+		bool use_eye_gaze;
+
+		//! Does the head device have an eye gaze input.
+		bool has_eye_gaze;
+	} foveation;
+
 	//! @}
 
 	//! @name Image-dependent members
@@ -125,6 +226,12 @@ struct comp_renderer
 	 */
 	VkFence *fences;
 
+	/*!
+	 * Array of recorded compute command buffers, @ref COMPUTE_CACHE_WAYS
+	 * for each comp_target image. Only allocated when reusing them.
+	 */
+	struct compute_cache_entry *compute_cache;
+
 	/*!
 	 * The number of renderings/fences we've created: set from comp_target when we use that data.
 	 */
@@ -394,6 +501,20 @@ renderer_create_renderings_and_fences(struct comp_renderer *r)
 		}
 	}
 
+	if (use_compute && r->settings->reuse_compute_cmd) {
+		uint32_t count = r->buffer_count * COMPUTE_CACHE_WAYS;
+		r->compute_cache = U_TYPED_ARRAY_CALLOC(struct compute_cache_entry, count);
+
+		for (uint32_t i = 0; i < count; i++) {
+			struct render_compute *crc = &r->compute_cache[i].crc;
+			if (!render_compute_init_reusable(crc, &r->c->nr)) {
+				// Without its render_compute the entry is never used.
+				COMP_ERROR(r->c, "render_compute_init_reusable: false");
+				render_compute_close(crc);
+			}
+		}
+	}
+
 	r->fences = U_TYPED_ARRAY_CALLOC(VkFence, r->buffer_count);
 
 	for (uint32_t i = 0; i < r->buffer_count; i++) {
@@ -434,6 +555,17 @@ renderer_close_renderings_and_fences(struct comp_renderer *r)
 		r->rtr_array = NULL;
 	}
 
+	// Recorded compute command buffers
+	if (r->buffer_count > 0 && r->compute_cache != NULL) {
+		for (uint32_t i = 0; i < r->buffer_count * COMPUTE_CACHE_WAYS; i++) {
+			if (r->compute_cache[i].crc.r != NULL) {
+				render_compute_close(&r->compute_cache[i].crc);
+			}
+		}
+		free(r->compute_cache);
+		r->compute_cache = NULL;
+	}
+
 	// Fences
 	if (r->buffer_count > 0 && r->fences != NULL) {
 		for (uint32_t i = 0; i < r->buffer_count; i++) {
@@ -564,6 +696,18 @@ renderer_init(struct comp_renderer *r, struct comp_compositor *c, VkExtent2D scr
 	r->acquired_buffer = -1;
 	r->fenced_buffer = -1;
 	r->rtr_array = NULL;
+	r->late_latch.enabled = c->settings.late_latch;
+	r->compute_reuse.enabled = c->settings.reuse_compute_cmd;
+	r->plan.cull = false;
+	r->foveation.params.tile_size = c->settings.foveation.tile_size;
+	r->foveation.params.full_rate_fraction = c->settings.foveation.full_rate_fraction;
+	r->foveation.use_eye_gaze = c->settings.foveation.use_eye_gaze;
+
+	for (uint32_t i = 0; i < c->xdev->input_count; i++) {
+		if (c->xdev->inputs[i].name == XRT_INPUT_GENERIC_EYE_GAZE_POSE) {
+			r->foveation.has_eye_gaze = true;
+		}
+	}
 
 	bool bret = render_scratch_images_ensure(&c->nr, &r->scratch, scratch_extent);
 	if (!bret) {
@@ -938,7 +1082,7 @@ dispatch_graphics(struct comp_renderer *r, struct render_gfx *rr)
 	render_gfx_begin(rr);
 
 
-	if (fast_path && layer->data.type == XRT_LAYER_STEREO_PROJECTION_DEPTH) {
+	if (fast_path && layer->data.type == XRT_LAYER_STEREO_PROJECTION) {
 		// Fast path.
 		const struct xrt_layer_stereo_projection_data *stereo = &layer->data.stereo;
 		const struct xrt_layer_projection_view_data *lvd = &stereo->l;
@@ -1051,7 +1195,254 @@ get_view_poses(struct comp_renderer *r, struct xrt_pose out_world[2], struct xrt
 }
 
 /*!
- * @pre render_compute_init(crc, &c->nr)
+ * Sample the head pose again, as close to submitting as possible, and redo
+ * the timewarp with it. The UBO is shared with the previous frame, so that
+ * has to finish first, the submit would have waited for it anyways.
+ */
+static void
+do_late_latch(struct comp_renderer *r, struct render_compute *crc)
+{
+	COMP_TRACE_MARKER();
+
+	// Only the fast path timewarps the projection layer in the distortion pass.
+	if (!crc->timewarp.recorded) {
+		return;
+	}
+
+	renderer_wait_for_last_fence(r);
+
+	struct xrt_pose world_poses[2];
+	struct xrt_pose eye_poses[2]; // New eye poses, for view space quads.
+	get_view_poses(r, world_poses, eye_poses);
+
+	// Quads composited by the distortion pass move along with the new poses.
+	const struct comp_layer_slot *slot = &r->c->base.slot;
+	struct render_compute_overlays overlays;
+	const struct render_compute_overlays *overlays_ptr = NULL;
+	if (slot->one_projection_layer_fast_path && slot->layer_count > 1) {
+		comp_render_calc_overlays( //
+		    crc->r,                // r
+		    world_poses,           // world_poses
+		    eye_poses,             // eye_poses
+		    &slot->layers[1],      // layers
+		    slot->layer_count - 1, // layer_count
+		    &overlays);            // out_overlays
+		overlays_ptr = &overlays;
+	}
+
+	render_compute_projection_timewarp_update(crc, world_poses, overlays_ptr);
+
+	uint64_t now_ns = os_monotonic_get_ns();
+	r->late_latch.gain_ms = (float)time_ns_to_ms_f(now_ns - r->late_latch.first_sample_ns);
+}
+
+/*!
+ * Where the line of sight through the center of the fov hits the view, in
+ * normalized view coordinates, used when there is no eye gaze.
+ */
+static struct xrt_vec2
+calc_fov_center(const struct xrt_fov *fov)
+{
+	float tan_left = tanf(fov->angle_left);
+	float tan_right = tanf(fov->angle_right);
+	float tan_up = tanf(fov->angle_up);
+	float tan_down = tanf(fov->angle_down);
+
+	struct xrt_vec2 center = {
+	    -tan_left / (tan_right - tan_left),
+	    tan_up / (tan_up - tan_down),
+	};
+
+	return center;
+}
+
+/*!
+ * Projects the eye gaze into each view, it's treated as coming from between
+ * the eyes which is close enough for picking the full rate area.
+ */
+static bool
+calc_gaze_centers(struct comp_renderer *r, struct xrt_vec2 out_centers[2])
+{
+	struct xrt_device *xdev = r->c->xdev;
+	uint64_t at_timestamp_ns = r->c->frame.rendering.predicted_display_time_ns;
+
+	struct xrt_space_relation head = XRT_SPACE_RELATION_ZERO;
+	struct xrt_space_relation gaze = XRT_SPACE_RELATION_ZERO;
+	xrt_device_get_tracked_pose(xdev, XRT_INPUT_GENERIC_HEAD_POSE, at_timestamp_ns, &head);
+	xrt_device_get_tracked_pose(xdev, XRT_INPUT_GENERIC_EYE_GAZE_POSE, at_timestamp_ns, &gaze);
+
+	if ((gaze.relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT) == 0) {
+		return false;
+	}
+
+	// The gaze relative to the head.
+	struct xrt_quat head_inv;
+	struct xrt_quat rel;
+	math_quat_invert(&head.pose.orientation, &head_inv);
+	math_quat_rotate(&head_inv, &gaze.pose.orientation, &rel);
+
+	struct xrt_vec3 forward = {0.0f, 0.0f, -1.0f};
+	struct xrt_vec3 dir;
+	math_quat_rotate_vec3(&rel, &forward, &dir);
+
+	// Looking backwards or sideways, nothing sensible to do.
+	if (dir.z > -0.01f) {
+		return false;
+	}
+
+	float tan_x = dir.x / -dir.z;
+	float tan_y = dir.y / -dir.z;
+
+	for (uint32_t i = 0; i < 2; i++) {
+		const struct xrt_fov *fov = &r->c->base.slot.fovs[i];
+		float tan_left = tanf(fov->angle_left);
+		float tan_right = tanf(fov->angle_right);
+		float tan_up = tanf(fov->angle_up);
+		float tan_down = tanf(fov->angle_down);
+
+		out_centers[i].x = (tan_x - tan_left) / (tan_right - tan_left);
+		out_centers[i].y = (tan_up - tan_y) / (tan_up - tan_down);
+	}
+
+	return true;
+}
+
+/*!
+ * Updates the fovea centers for this frame, returns NULL if foveation is off.
+ */
+static const struct render_compute_foveation *
+get_foveation(struct comp_renderer *r)
+{
+	struct render_compute_foveation *params = &r->foveation.params;
+
+	if (params->tile_size < 2) {
+		return NULL;
+	}
+
+	bool gaze_valid = false;
+	if (r->foveation.use_eye_gaze && r->foveation.has_eye_gaze) {
+		gaze_valid = calc_gaze_centers(r, params->centers);
+	}
+
+	if (!gaze_valid) {
+		for (uint32_t i = 0; i < 2; i++) {
+			params->centers[i] = calc_fov_center(&r->c->base.slot.fovs[i]);
+		}
+	}
+
+	return params;
+}
+
+/*!
+ * Same check as the compute dispatch uses to pick the depth reprojection
+ * pipeline, which also falls back if the depth info can't be used.
+ */
+static bool
+is_depth_reprojected(const struct comp_layer *layer)
+{
+	const struct xrt_layer_data *data = &layer->data;
+	if (data->type != XRT_LAYER_STEREO_PROJECTION_DEPTH ||
+	    (data->flags & XRT_LAYER_COMPOSITION_DEPTH_REPROJECTION_BIT) == 0) {
+		return false;
+	}
+
+	struct render_depth_params params;
+	return render_calc_depth_params(&data->stereo_depth.l_d, &params) &&
+	       render_calc_depth_params(&data->stereo_depth.r_d, &params);
+}
+
+/*!
+ * Find the recorded command buffer for this frame's target image and fast
+ * path layer, or the entry to record it in. Returns NULL if the frame can't
+ * be replayed, then the shared command buffer is used.
+ */
+static struct compute_cache_entry *
+get_compute_cache_entry(struct comp_renderer *r,
+                        const struct comp_layer *layer,
+                        const struct render_viewport_data views[2],
+                        bool do_timewarp,
+                        bool *out_hit)
+{
+	const struct xrt_layer_projection_view_data *lvd = NULL;
+	const struct xrt_layer_projection_view_data *rvd = NULL;
+
+	switch (layer->data.type) {
+	case XRT_LAYER_STEREO_PROJECTION:
+		lvd = &layer->data.stereo.l;
+		rvd = &layer->data.stereo.r;
+		break;
+	case XRT_LAYER_STEREO_PROJECTION_DEPTH:
+		lvd = &layer->data.stereo_depth.l;
+		rvd = &layer->data.stereo_depth.r;
+		break;
+	default: return NULL;
+	}
+
+	const struct comp_swapchain_image *left = &layer->sc_array[0]->images[lvd->sub.image_index];
+	const struct comp_swapchain_image *right = &layer->sc_array[1]->images[rvd->sub.image_index];
+
+	struct compute_cache_key key;
+	U_ZERO(&key);
+	key.swapchains_destroyed = r->c->base.cscs.destroyed_count;
+	key.distortion_generation = r->c->nr.distortion.generation;
+	key.src_image_views[0] = get_image_view(left, layer->data.flags, lvd->sub.array_index);
+	key.src_image_views[1] = get_image_view(right, layer->data.flags, rvd->sub.array_index);
+	key.views[0] = views[0];
+	key.views[1] = views[1];
+	key.do_timewarp = do_timewarp;
+	key.depth = do_timewarp && is_depth_reprojected(layer);
+	if (key.depth) {
+		const struct xrt_layer_depth_data *ldvd = &layer->data.stereo_depth.l_d;
+		const struct xrt_layer_depth_data *rdvd = &layer->data.stereo_depth.r_d;
+		const struct comp_swapchain_image *l_depth = &layer->sc_array[2]->images[ldvd->sub.image_index];
+		const struct comp_swapchain_image *r_depth = &layer->sc_array[3]->images[rdvd->sub.image_index];
+		key.depth_image_views[0] = get_image_view(l_depth, layer->data.flags, ldvd->sub.array_index);
+		key.depth_image_views[1] = get_image_view(r_depth, layer->data.flags, rdvd->sub.array_index);
+	}
+	key.foveation_tile_size = r->foveation.params.tile_size;
+	key.foveation_fraction = r->foveation.params.full_rate_fraction;
+
+	struct compute_cache_entry *entries = &r->compute_cache[r->acquired_buffer * COMPUTE_CACHE_WAYS];
+	struct compute_cache_entry *found = NULL;
+	bool hit = false;
+
+	for (uint32_t i = 0; i < COMPUTE_CACHE_WAYS; i++) {
+		struct compute_cache_entry *entry = &entries[i];
+
+		// Failed to init, never used.
+		if (entry->crc.r == NULL) {
+			continue;
+		}
+
+		if (entry->valid && memcmp(&entry->key, &key, sizeof(key)) == 0) {
+			found = entry;
+			hit = true;
+			break;
+		}
+
+		// Replace invalid entries first, then the least recently used.
+		if (found == NULL || (found->valid && (!entry->valid || entry->last_used < found->last_used))) {
+			found = entry;
+		}
+	}
+
+	if (found == NULL) {
+		return NULL;
+	}
+
+	if (!hit) {
+		found->key = key;
+	}
+
+	found->last_used = ++r->compute_reuse.use_count;
+	*out_hit = hit;
+
+	return found;
+}
+
+/*!
+ * @p crc is used if the frame can't use a recorded command buffer, it is
+ * initialised here in that case.
  */
 static void
 dispatch_compute(struct comp_renderer *r, struct render_compute *crc)
@@ -1069,8 +1460,9 @@ dispatch_compute(struct comp_renderer *r, struct render_compute *crc)
 
 	// Device view information.
 	struct xrt_pose world_poses[2];
-	struct xrt_pose eye_poses[2]; // New eye poses, unused.
+	struct xrt_pose eye_poses[2]; // New eye poses, for view space quads.
 	get_view_poses(r, world_poses, eye_poses);
+	r->late_latch.first_sample_ns = os_monotonic_get_ns();
 
 	// Target Vulkan resources..
 	VkImage target_image = r->c->target->images[r->acquired_buffer].handle;
@@ -1080,8 +1472,34 @@ dispatch_compute(struct comp_renderer *r, struct render_compute *crc)
 	struct render_viewport_data views[2];
 	calc_viewport_data(r, &views[0], &views[1]);
 
-	// Start the compute pipeline.
-	render_compute_begin(crc);
+	const struct render_compute_foveation *foveation = get_foveation(r);
+
+	/*
+	 * Only the fast path is cached, the layer squasher writes its own UBOs
+	 * while recording. Overlays bind new quad images most frames.
+	 */
+	struct compute_cache_entry *entry = NULL;
+	bool hit = false;
+	if (fast_path && layer_count == 1 && r->compute_reuse.enabled && r->compute_cache != NULL) {
+		entry = get_compute_cache_entry(r, &layers[0], views, do_timewarp, &hit);
+	}
+
+	if (entry != NULL) {
+		crc = &entry->crc;
+	} else {
+		render_compute_init(crc, &c->nr);
+	}
+
+	// Start the compute pipeline, or only update the UBOs of the recorded one.
+	if (hit) {
+		render_compute_begin_replay(crc);
+		r->compute_reuse.hits++;
+	} else {
+		render_compute_begin(crc);
+		if (entry != NULL) {
+			r->compute_reuse.misses++;
+		}
+	}
 
 	comp_render_dispatch_compute( //
 	    crc,                      // crc
@@ -1093,14 +1511,154 @@ dispatch_compute(struct comp_renderer *r, struct render_compute *crc)
 	    target_image,             // target_image
 	    target_image_view,        // target_image_view
 	    views,                    // views
+	    foveation,                // foveation
 	    fast_path,                // fast_path
 	    do_timewarp);             // do_timewarp
 
-	render_compute_end(crc);
+	bool bret = render_compute_end(crc);
+	if (entry != NULL) {
+		entry->valid = bret;
+	}
+
+	if (r->late_latch.enabled) {
+		do_late_latch(r, crc);
+	}
 
 	comp_target_mark_submit(ct, c->frame.rendering.id, os_monotonic_get_ns());
 
-	renderer_submit_queue(r, crc->r->cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	renderer_submit_queue(r, crc->cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+}
+
+/*
+ *
+ * Layer planning.
+ *
+ */
+
+static bool
+is_projection_layer(const struct xrt_layer_data *data)
+{
+	return data->type == XRT_LAYER_STEREO_PROJECTION || //
+	       data->type == XRT_LAYER_STEREO_PROJECTION_DEPTH;
+}
+
+//! Is all of the swapchain image used, anything outside of the sub image is sampled as transparent black.
+static bool
+is_sub_image_whole(const struct xrt_layer_projection_view_data *vd)
+{
+	const struct xrt_normalized_rect *rect = &vd->sub.norm_rect;
+
+	return rect->x <= 0.0f && rect->y <= 0.0f && //
+	       rect->x + rect->w >= 1.0f && rect->y + rect->h >= 1.0f;
+}
+
+//! Does the fov of the view reach at least as far as the target fov in all directions.
+static bool
+is_fov_covering(const struct xrt_layer_projection_view_data *vd, const struct xrt_fov *target)
+{
+	const struct xrt_fov *fov = &vd->fov;
+
+	return fov->angle_left <= target->angle_left && fov->angle_right >= target->angle_right && //
+	       fov->angle_up >= target->angle_up && fov->angle_down <= target->angle_down;
+}
+
+/*!
+ * Without source alpha blending the alpha channel is ignored when sampling a
+ * projection layer, so it hides all layers below it where it has been drawn.
+ * Only that is all of the target views if both of its views use the whole
+ * image and have a fov that covers the target fov.
+ */
+static bool
+is_opaque_projection_layer(const struct xrt_layer_data *data, const struct xrt_fov target_fovs[2])
+{
+	if (!is_projection_layer(data) || (data->flags & XRT_LAYER_COMPOSITION_BLEND_TEXTURE_SOURCE_ALPHA_BIT) != 0) {
+		return false;
+	}
+
+	// Same layout for both projection layer types.
+	const struct xrt_layer_projection_view_data *vds[2] = {&data->stereo.l, &data->stereo.r};
+	if (data->type == XRT_LAYER_STEREO_PROJECTION_DEPTH) {
+		vds[0] = &data->stereo_depth.l;
+		vds[1] = &data->stereo_depth.r;
+	}
+
+	for (uint32_t i = 0; i < 2; i++) {
+		if (!is_sub_image_whole(vds[i]) || !is_fov_covering(vds[i], &target_fovs[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//! Is the layer visible to neither eye, or without any area.
+static bool
+is_layer_hidden(const struct xrt_layer_data *data)
+{
+	switch (data->type) {
+	case XRT_LAYER_STEREO_PROJECTION:
+	case XRT_LAYER_STEREO_PROJECTION_DEPTH: return false;
+	case XRT_LAYER_QUAD:
+		return data->quad.visibility == XRT_LAYER_EYE_VISIBILITY_NONE || //
+		       data->quad.size.x <= 0.0f ||                              //
+		       data->quad.size.y <= 0.0f;
+	case XRT_LAYER_CUBE: return data->cube.visibility == XRT_LAYER_EYE_VISIBILITY_NONE;
+	case XRT_LAYER_CYLINDER: return data->cylinder.visibility == XRT_LAYER_EYE_VISIBILITY_NONE;
+	case XRT_LAYER_EQUIRECT1: return data->equirect1.visibility == XRT_LAYER_EYE_VISIBILITY_NONE;
+	case XRT_LAYER_EQUIRECT2: return data->equirect2.visibility == XRT_LAYER_EYE_VISIBILITY_NONE;
+	default: return false;
+	}
+}
+
+/*!
+ * Drop the layers that can not be seen from the slot, keeping the order of the
+ * rest. Returns the number of layers dropped.
+ */
+static uint32_t
+cull_layers(struct comp_layer_slot *slot, const struct xrt_fov target_fovs[2])
+{
+	uint32_t layer_count = slot->layer_count;
+
+	// Everything below the top-most opaque projection layer is covered by it.
+	uint32_t first = 0;
+	for (uint32_t i = layer_count; i > 0; i--) {
+		if (is_opaque_projection_layer(&slot->layers[i - 1].data, target_fovs)) {
+			first = i - 1;
+			break;
+		}
+	}
+
+	uint32_t count = 0;
+	for (uint32_t i = first; i < layer_count; i++) {
+		if (is_layer_hidden(&slot->layers[i].data)) {
+			continue;
+		}
+		if (count != i) {
+			slot->layers[count] = slot->layers[i];
+		}
+		count++;
+	}
+
+	slot->layer_count = count;
+
+	return layer_count - count;
+}
+
+//! Can the distortion shader composite all layers but the first itself.
+static bool
+are_overlays_supported(const struct comp_layer_slot *slot)
+{
+	if (slot->layer_count - 1 > RENDER_MAX_OVERLAYS) {
+		return false;
+	}
+
+	for (uint32_t i = 1; i < slot->layer_count; i++) {
+		if (slot->layers[i].data.type != XRT_LAYER_QUAD) {
+			return false;
+		}
+	}
+
+	return true;
 }
 
 
@@ -1415,7 +1973,6 @@ comp_renderer_draw(struct comp_renderer *r)
 	struct render_gfx rr = {0};
 	struct render_compute crc = {0};
 	if (use_compute) {
-		render_compute_init(&crc, &c->nr);
 		dispatch_compute(r, &crc);
 	} else {
 		render_gfx_init(&rr, &c->nr);
@@ -1459,6 +2016,9 @@ comp_renderer_draw(struct comp_renderer *r)
 	// Clear the rendered frame.
 	comp_frame_clear_locked(&c->frame.rendering);
 
+	// Push readbacks from earlier frames the GPU is done with.
+	comp_mirror_poll(&r->mirror_to_debug_gui, &c->base.vk);
+
 	comp_mirror_fixup_ui_state(&r->mirror_to_debug_gui, c);
 	if (comp_mirror_is_ready_and_active(&r->mirror_to_debug_gui, c, predicted_display_time_ns)) {
 
@@ -1485,9 +2045,22 @@ comp_renderer_draw(struct comp_renderer *r)
 	 * command buffer has completed and all resources referred by it can
 	 * now be manipulated.
 	 *
+	 * Only wait for our own fence, waiting for the queue would also wait
+	 * for the mirror readback submitted above and stop it from overlapping
+	 * with the next frame. The peek window reuses its command buffer
+	 * without a fence, so it still needs the whole queue to be idle.
+	 *
 	 * This is done after a swap so isn't time critical.
 	 */
-	renderer_wait_queue_idle(r);
+	bool wait_queue_idle = false;
+#ifdef XRT_FEATURE_WINDOW_PEEK
+	wait_queue_idle = c->peek != NULL;
+#endif
+	if (wait_queue_idle) {
+		renderer_wait_queue_idle(r);
+	} else {
+		renderer_wait_for_last_fence(r);
+	}
 
 
 	/*
@@ -1506,7 +2079,10 @@ comp_renderer_draw(struct comp_renderer *r)
 	 */
 
 	if (use_compute) {
-		render_compute_close(&crc);
+		// Not initialised if a recorded command buffer was used.
+		if (crc.r != NULL) {
+			render_compute_close(&crc);
+		}
 	} else {
 		render_gfx_close(&rr);
 	}
@@ -1544,6 +2120,40 @@ comp_renderer_draw(struct comp_renderer *r)
 	comp_target_update_timings(ct);
 }
 
+enum comp_renderer_plan
+comp_renderer_plan_layers(struct comp_renderer *r)
+{
+	COMP_TRACE_MARKER();
+
+	struct comp_compositor *c = r->c;
+	struct comp_layer_slot *slot = &c->base.slot;
+
+	r->plan.culled = r->plan.cull ? cull_layers(slot, c->xdev->hmd->distortion.fov) : 0;
+
+	// Mirroring and peeking read the scratch images, so they need the squash.
+	bool allow_direct = !r->plan.force_squash && !c->mirroring_to_debug_gui && !c->peek;
+	allow_direct = allow_direct && slot->layer_count > 0 && is_projection_layer(&slot->layers[0].data);
+
+	enum comp_renderer_plan plan;
+	if (slot->layer_count == 0) {
+		plan = COMP_RENDERER_PLAN_CLEAR;
+	} else if (allow_direct && slot->layer_count == 1) {
+		plan = COMP_RENDERER_PLAN_DIRECT;
+	} else if (allow_direct && r->settings->use_compute && are_overlays_supported(slot)) {
+		plan = COMP_RENDERER_PLAN_DIRECT_OVERLAYS;
+	} else {
+		plan = COMP_RENDERER_PLAN_SQUASH;
+	}
+
+	slot->one_projection_layer_fast_path =
+	    plan == COMP_RENDERER_PLAN_DIRECT || plan == COMP_RENDERER_PLAN_DIRECT_OVERLAYS;
+
+	r->plan.last = plan;
+	r->plan.counts[plan]++;
+
+	return plan;
+}
+
 void
 comp_renderer_allocate_layers(struct comp_renderer *self, uint32_t layer_count)
 {
@@ -1594,4 +2204,21 @@ comp_renderer_add_debug_vars(struct comp_renderer *self)
 	struct comp_renderer *r = self;
 
 	comp_mirror_add_debug_vars(&r->mirror_to_debug_gui, r->c);
+
+	u_var_add_bool(r->c, &r->late_latch.enabled, "Late latch head pose");
+	u_var_add_ro_f32(r->c, &r->late_latch.gain_ms, "Late latch gain (ms)");
+	u_var_add_bool(r->c, &r->compute_reuse.enabled, "Reuse compute command buffers");
+	u_var_add_ro_u64(r->c, &r->compute_reuse.hits, "Reused compute command buffers");
+	u_var_add_ro_u64(r->c, &r->compute_reuse.misses, "Recorded compute command buffers");
+	u_var_add_bool(r->c, &r->plan.cull, "Cull hidden layers");
+	u_var_add_bool(r->c, &r->plan.force_squash, "Force layer squash");
+	u_var_add_ro_u32(r->c, &r->plan.last, "Layer plan (0 clear, 1 direct, 2 direct with overlays, 3 squash)");
+	u_var_add_ro_u32(r->c, &r->plan.culled, "Culled layers");
+	u_var_add_ro_u64(r->c, &r->plan.counts[COMP_RENDERER_PLAN_CLEAR], "Frames cleared");
+	u_var_add_ro_u64(r->c, &r->plan.counts[COMP_RENDERER_PLAN_DIRECT], "Frames direct to distortion");
+	u_var_add_ro_u64(r->c, &r->plan.counts[COMP_RENDERER_PLAN_DIRECT_OVERLAYS], "Frames direct with overlays");
+	u_var_add_ro_u64(r->c, &r->plan.counts[COMP_RENDERER_PLAN_SQUASH], "Frames with layer squash");
+	u_var_add_ro_u32(r->c, &r->foveation.params.tile_size, "Foveation tile size");
+	u_var_add_f32(r->c, &r->foveation.params.full_rate_fraction, "Foveation full rate fraction");
+	u_var_add_bool(r->c, &r->foveation.use_eye_gaze, "Foveation follows eye gaze");
 }
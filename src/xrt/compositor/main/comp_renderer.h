@@ -27,6 +27,26 @@ struct comp_swapchain_image;
  */
 struct comp_renderer;
 
+/*!
+ * How the layers of a frame are rendered, picked per frame by
+ * @ref comp_renderer_plan_layers.
+ *
+ * @ingroup comp_main
+ */
+enum comp_renderer_plan
+{
+	//! No visible layers, the target is only cleared.
+	COMP_RENDERER_PLAN_CLEAR,
+	//! A single projection layer goes straight to the distortion pass.
+	COMP_RENDERER_PLAN_DIRECT,
+	//! Like direct, but the distortion pass also composites quad layers on top, compute only.
+	COMP_RENDERER_PLAN_DIRECT_OVERLAYS,
+	//! The layers are squashed into the scratch images before distortion.
+	COMP_RENDERER_PLAN_SQUASH,
+
+	COMP_RENDERER_PLAN_COUNT,
+};
+
 /*!
  * Called by the main compositor code to create the renderer.
  *
@@ -60,6 +80,24 @@ comp_renderer_destroy(struct comp_renderer **ptr_r);
 void
 comp_renderer_draw(struct comp_renderer *r);
 
+/*!
+ * Pick the cheapest way to render the layers submitted this frame. If culling
+ * is turned on, layers that can not be seen are dropped from the compositor's
+ * layer slot: layers that are visible to neither eye, and everything below the
+ * top-most opaque projection layer that covers all of the views. If only one
+ * projection layer is left it goes straight to distortion, with compute a few
+ * quad layers on top of it may come along, setting
+ * @ref comp_layer_slot::one_projection_layer_fast_path.
+ *
+ * Must be called after all layers have been submitted and before
+ * @ref comp_renderer_draw or handing the layers to the layer renderer.
+ *
+ * @public @memberof comp_renderer
+ * @ingroup comp_main
+ */
+enum comp_renderer_plan
+comp_renderer_plan_layers(struct comp_renderer *r);
+
 /*!
  * @public @memberof comp_renderer
  * @ingroup comp_main
@@ -20,6 +20,7 @@ DEBUG_GET_ONCE_OPTION(nvidia_display, "XRT_COMPOSITOR_FORCE_NVIDIA_DISPLAY", NUL
 DEBUG_GET_ONCE_NUM_OPTION(vk_display, "XRT_COMPOSITOR_FORCE_VK_DISPLAY", -1)
 DEBUG_GET_ONCE_BOOL_OPTION(force_xcb, "XRT_COMPOSITOR_FORCE_XCB", false)
 DEBUG_GET_ONCE_BOOL_OPTION(force_wayland, "XRT_COMPOSITOR_FORCE_WAYLAND", false)
+DEBUG_GET_ONCE_BOOL_OPTION(force_headless, "XRT_COMPOSITOR_FORCE_HEADLESS", false)
 DEBUG_GET_ONCE_NUM_OPTION(force_gpu_index, "XRT_COMPOSITOR_FORCE_GPU_INDEX", -1)
 DEBUG_GET_ONCE_NUM_OPTION(force_client_gpu_index, "XRT_COMPOSITOR_FORCE_CLIENT_GPU_INDEX", -1)
 DEBUG_GET_ONCE_NUM_OPTION(desired_mode, "XRT_COMPOSITOR_DESIRED_MODE", -1)
@@ -28,6 +29,11 @@ DEBUG_GET_ONCE_BOOL_OPTION(xcb_fullscreen, "XRT_COMPOSITOR_XCB_FULLSCREEN", fals
 DEBUG_GET_ONCE_NUM_OPTION(xcb_display, "XRT_COMPOSITOR_XCB_DISPLAY", -1)
 DEBUG_GET_ONCE_NUM_OPTION(default_framerate, "XRT_COMPOSITOR_DEFAULT_FRAMERATE", 60)
 DEBUG_GET_ONCE_BOOL_OPTION(compute, "XRT_COMPOSITOR_COMPUTE", false)
+DEBUG_GET_ONCE_BOOL_OPTION(late_latch, "XRT_COMPOSITOR_LATE_LATCH", false)
+DEBUG_GET_ONCE_BOOL_OPTION(reuse_compute_cmd, "XRT_COMPOSITOR_REUSE_COMPUTE_CMD", true)
+DEBUG_GET_ONCE_NUM_OPTION(foveation_tile_size, "XRT_COMPOSITOR_FOVEATION_TILE_SIZE", 0)
+DEBUG_GET_ONCE_FLOAT_OPTION(foveation_size, "XRT_COMPOSITOR_FOVEATION_SIZE", 0.4f)
+DEBUG_GET_ONCE_BOOL_OPTION(foveation_gaze, "XRT_COMPOSITOR_FOVEATION_GAZE", true)
 // clang-format on
 
 void
@@ -41,6 +47,13 @@ comp_settings_init(struct comp_settings *s, struct xrt_device *xdev)
 	}
 
 	s->use_compute = debug_get_bool_option_compute();
+	s->late_latch = debug_get_bool_option_late_latch();
+	s->reuse_compute_cmd = debug_get_bool_option_reuse_compute_cmd();
+
+	int foveation_tile_size = debug_get_num_option_foveation_tile_size();
+	s->foveation.tile_size = foveation_tile_size > 0 ? (uint32_t)foveation_tile_size : 0;
+	s->foveation.full_rate_fraction = debug_get_float_option_foveation_size();
+	s->foveation.use_eye_gaze = debug_get_bool_option_foveation_gaze();
 
 	if (s->use_compute) {
 		s->color_format = VK_FORMAT_B8G8R8A8_UNORM;
@@ -112,4 +125,7 @@ comp_settings_init(struct comp_settings *s, struct xrt_device *xdev)
 		s->preferred.width /= 2;
 		s->preferred.height /= 2;
 	}
+	if (debug_get_bool_option_force_headless()) {
+		s->target_identifier = "headless";
+	}
 }
@@ -50,6 +50,25 @@ struct comp_settings
 
 	bool use_compute;
 
+	//! Re-sample the head pose just before submitting and redo the timewarp with it, compute only.
+	bool late_latch;
+
+	//! Replay the recorded compute command buffer for unchanged fast path frames, compute only.
+	bool reuse_compute_cmd;
+
+	//! Foveated distortion of the views, compute only.
+	struct
+	{
+		//! Size in pixels of the periphery tiles, zero turns foveation off.
+		uint32_t tile_size;
+
+		//! Fraction of the view width and height that is distorted at full rate.
+		float full_rate_fraction;
+
+		//! Follow the eye gaze of the head device if it has one, else a fixed center.
+		bool use_eye_gaze;
+	} foveation;
+
 	VkFormat color_format;
 	VkColorSpaceKHR color_space;
 	VkPresentModeKHR present_mode;
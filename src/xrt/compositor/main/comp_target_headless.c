@@ -0,0 +1,536 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Headless target that renders into offscreen images.
+ * @ingroup comp_main
+ */
+
+#include "os/os_time.h"
+
+#include "util/u_misc.h"
+#include "util/u_debug.h"
+#include "util/u_pacing.h"
+#include "util/u_time.h"
+
+#include "main/comp_compositor.h"
+#include "main/comp_window.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+
+/*
+ *
+ * Types, defines and data.
+ *
+ */
+
+DEBUG_GET_ONCE_NUM_OPTION(headless_framerate, "XRT_COMPOSITOR_HEADLESS_FRAMERATE", 0)
+
+/*!
+ * Calls `vkDestroy##TYPE` on `THING` if it is not `VK_NULL_HANDLE`, sets it to
+ * `VK_NULL_HANDLE` afterwards.
+ */
+#define D(TYPE, THING)                                                                                                 \
+	if (THING != VK_NULL_HANDLE) {                                                                                 \
+		vk->vkDestroy##TYPE(vk->device, THING, NULL);                                                          \
+		THING = VK_NULL_HANDLE;                                                                                \
+	}
+
+/*!
+ * Calls `vkFree##TYPE` on `THING` if it is not `VK_NULL_HANDLE`, sets it to
+ * `VK_NULL_HANDLE` afterwards.
+ */
+#define DF(TYPE, THING)                                                                                                \
+	if (THING != VK_NULL_HANDLE) {                                                                                 \
+		vk->vkFree##TYPE(vk->device, THING, NULL);                                                             \
+		THING = VK_NULL_HANDLE;                                                                                \
+	}
+
+//! Same as a typical swapchain.
+#define HEADLESS_IMAGE_COUNT 3
+
+//! Frames waiting for their GPU timing, more than enough for the renderer.
+#define HEADLESS_FRAME_COUNT 8
+
+/*!
+ * A target that renders into images that are never shown, with vblanks at a
+ * fixed rate made up by the target. Runs the full renderer, so it can be used
+ * to benchmark the compositor without any display or window system.
+ *
+ * @ingroup comp_main
+ * @implements comp_target
+ */
+struct comp_target_headless
+{
+	//! Base target.
+	struct comp_target base;
+
+	//! Compositor frame pacing helper.
+	struct u_pacing_compositor *upc;
+
+	//! Also works as a frame index.
+	int64_t current_frame_id;
+
+	//! Index of the last acquired image.
+	uint32_t index;
+
+	//! Images, views and memory.
+	struct comp_target_image images[HEADLESS_IMAGE_COUNT];
+	VkDeviceMemory memories[HEADLESS_IMAGE_COUNT];
+
+	struct
+	{
+		//! Time of the first synthetic vblank.
+		uint64_t origin_ns;
+
+		//! Time between synthetic vblanks.
+		uint64_t period_ns;
+	} vblank;
+
+	//! Presented frames, indexed by frame id.
+	struct
+	{
+		int64_t frame_id;
+		uint64_t desired_present_time_ns;
+		uint64_t present_slop_ns;
+	} frames[HEADLESS_FRAME_COUNT];
+};
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static inline struct comp_target_headless *
+comp_target_headless(struct comp_target *ct)
+{
+	return (struct comp_target_headless *)ct;
+}
+
+static inline struct vk_bundle *
+get_vk(struct comp_target_headless *cth)
+{
+	return &cth->base.c->base.vk;
+}
+
+//! The first synthetic vblank at or after the given time.
+static uint64_t
+vblank_at_or_after(struct comp_target_headless *cth, uint64_t time_ns)
+{
+	uint64_t origin_ns = cth->vblank.origin_ns;
+	uint64_t period_ns = cth->vblank.period_ns;
+
+	if (time_ns <= origin_ns) {
+		return origin_ns;
+	}
+
+	uint64_t count = (time_ns - origin_ns + period_ns - 1) / period_ns;
+	return origin_ns + count * period_ns;
+}
+
+//! The last synthetic vblank at or before the given time.
+static uint64_t
+vblank_at_or_before(struct comp_target_headless *cth, uint64_t time_ns)
+{
+	uint64_t origin_ns = cth->vblank.origin_ns;
+	uint64_t period_ns = cth->vblank.period_ns;
+
+	if (time_ns <= origin_ns) {
+		return origin_ns;
+	}
+
+	return origin_ns + ((time_ns - origin_ns) / period_ns) * period_ns;
+}
+
+static void
+destroy_images(struct comp_target_headless *cth)
+{
+	struct vk_bundle *vk = get_vk(cth);
+
+	for (uint32_t i = 0; i < HEADLESS_IMAGE_COUNT; i++) {
+		D(ImageView, cth->images[i].view);
+		D(Image, cth->images[i].handle);
+		DF(Memory, cth->memories[i]);
+	}
+
+	cth->base.images = NULL;
+	cth->base.image_count = 0;
+}
+
+static void
+destroy_semaphores(struct comp_target_headless *cth)
+{
+	struct vk_bundle *vk = get_vk(cth);
+
+	D(Semaphore, cth->base.semaphores.render_complete);
+}
+
+
+/*
+ *
+ * Member functions.
+ *
+ */
+
+static bool
+target_init_pre_vulkan(struct comp_target *ct)
+{
+	return true;
+}
+
+static bool
+target_init_post_vulkan(struct comp_target *ct, uint32_t preferred_width, uint32_t preferred_height)
+{
+	struct comp_target_headless *cth = comp_target_headless(ct);
+	struct vk_bundle *vk = get_vk(cth);
+
+	VkSemaphoreCreateInfo info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+	};
+
+	// There is no present to wait on this, we do it ourselves.
+	cth->base.semaphores.render_complete_is_timeline = false;
+	VkResult ret = vk->vkCreateSemaphore(vk->device, &info, NULL, &cth->base.semaphores.render_complete);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(ct->c, "vkCreateSemaphore: %s", vk_result_string(ret));
+		return false;
+	}
+
+	return true;
+}
+
+static bool
+target_check_ready(struct comp_target *ct)
+{
+	return true;
+}
+
+static void
+target_create_images(struct comp_target *ct,
+                     uint32_t preferred_width,
+                     uint32_t preferred_height,
+                     VkFormat color_format,
+                     VkColorSpaceKHR color_space,
+                     VkImageUsageFlags image_usage,
+                     VkPresentModeKHR present_mode)
+{
+	struct comp_target_headless *cth = comp_target_headless(ct);
+	struct vk_bundle *vk = get_vk(cth);
+	VkResult ret;
+
+	uint64_t now_ns = os_monotonic_get_ns();
+	if (cth->upc == NULL) {
+		cth->vblank.origin_ns = now_ns;
+		cth->vblank.period_ns = ct->c->settings.nominal_frame_interval_ns;
+		u_pc_fake_create(cth->vblank.period_ns, now_ns, &cth->upc);
+	}
+
+	// Make sure the old images are not in use.
+	vk->vkDeviceWaitIdle(vk->device);
+	destroy_images(cth);
+
+	VkExtent2D extent = {preferred_width, preferred_height};
+
+	// So the result can be read back, when benchmarking.
+	VkImageUsageFlags usage = image_usage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	for (uint32_t i = 0; i < HEADLESS_IMAGE_COUNT; i++) {
+		ret = vk_create_image_simple(vk, extent, color_format, usage, &cth->memories[i],
+		                             &cth->images[i].handle);
+		if (ret != VK_SUCCESS) {
+			COMP_ERROR(ct->c, "vk_create_image_simple: %s", vk_result_string(ret));
+			destroy_images(cth);
+			return;
+		}
+
+		ret = vk_create_view(vk, cth->images[i].handle, VK_IMAGE_VIEW_TYPE_2D, color_format, subresource_range,
+		                     &cth->images[i].view);
+		if (ret != VK_SUCCESS) {
+			COMP_ERROR(ct->c, "vk_create_view: %s", vk_result_string(ret));
+			destroy_images(cth);
+			return;
+		}
+	}
+
+	ct->width = preferred_width;
+	ct->height = preferred_height;
+	ct->format = color_format;
+	ct->surface_transform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+	ct->images = cth->images;
+	ct->image_count = HEADLESS_IMAGE_COUNT;
+	cth->index = HEADLESS_IMAGE_COUNT - 1;
+
+	COMP_DEBUG(ct->c, "Created %u headless images %ux%u, vblank every %.2fms", HEADLESS_IMAGE_COUNT,
+	           preferred_width, preferred_height, time_ns_to_ms_f(cth->vblank.period_ns));
+}
+
+static bool
+target_has_images(struct comp_target *ct)
+{
+	return ct->images != NULL;
+}
+
+static VkResult
+target_acquire(struct comp_target *ct, uint32_t *out_index)
+{
+	struct comp_target_headless *cth = comp_target_headless(ct);
+
+	if (!target_has_images(ct)) {
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
+
+	// The renderer waits for the image's previous use to finish.
+	cth->index = (cth->index + 1) % HEADLESS_IMAGE_COUNT;
+	*out_index = cth->index;
+
+	return VK_SUCCESS;
+}
+
+static VkResult
+target_present(struct comp_target *ct,
+               VkQueue queue,
+               uint32_t index,
+               uint64_t timeline_semaphore_value,
+               uint64_t desired_present_time_ns,
+               uint64_t present_slop_ns)
+{
+	struct comp_target_headless *cth = comp_target_headless(ct);
+	struct vk_bundle *vk = get_vk(cth);
+
+	assert(cth->current_frame_id >= 0);
+
+	// Remember when the frame wanted to be shown, used when the GPU timing arrives.
+	uint32_t slot = (uint32_t)(cth->current_frame_id % HEADLESS_FRAME_COUNT);
+	cth->frames[slot].frame_id = cth->current_frame_id;
+	cth->frames[slot].desired_present_time_ns = desired_present_time_ns;
+	cth->frames[slot].present_slop_ns = present_slop_ns;
+
+	// Nothing presents the image, so consume the binary semaphore here.
+	VkPipelineStageFlags stage_flags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .waitSemaphoreCount = 1,
+	    .pWaitSemaphores = &cth->base.semaphores.render_complete,
+	    .pWaitDstStageMask = &stage_flags,
+	};
+
+	return vk_cmd_submit_locked(vk, 1, &submit_info, VK_NULL_HANDLE);
+}
+
+static void
+target_flush(struct comp_target *ct)
+{
+	// No-op
+}
+
+static void
+target_calc_frame_pacing(struct comp_target *ct,
+                         int64_t *out_frame_id,
+                         uint64_t *out_wake_up_time_ns,
+                         uint64_t *out_desired_present_time_ns,
+                         uint64_t *out_present_slop_ns,
+                         uint64_t *out_predicted_display_time_ns)
+{
+	struct comp_target_headless *cth = comp_target_headless(ct);
+
+	int64_t frame_id = -1;
+	uint64_t wake_up_time_ns = 0;
+	uint64_t desired_present_time_ns = 0;
+	uint64_t present_slop_ns = 0;
+	uint64_t predicted_display_time_ns = 0;
+	uint64_t predicted_display_period_ns = 0;
+	uint64_t min_display_period_ns = 0;
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	u_pc_predict(cth->upc,                     //
+	             now_ns,                       //
+	             &frame_id,                    //
+	             &wake_up_time_ns,             //
+	             &desired_present_time_ns,     //
+	             &present_slop_ns,             //
+	             &predicted_display_time_ns,   //
+	             &predicted_display_period_ns, //
+	             &min_display_period_ns);      //
+
+	cth->current_frame_id = frame_id;
+
+	*out_frame_id = frame_id;
+	*out_wake_up_time_ns = wake_up_time_ns;
+	*out_desired_present_time_ns = desired_present_time_ns;
+	*out_predicted_display_time_ns = predicted_display_time_ns;
+	*out_present_slop_ns = present_slop_ns;
+}
+
+static void
+target_mark_timing_point(struct comp_target *ct,
+                         enum comp_target_timing_point point,
+                         int64_t frame_id,
+                         uint64_t when_ns)
+{
+	struct comp_target_headless *cth = comp_target_headless(ct);
+	assert(frame_id == cth->current_frame_id);
+
+	switch (point) {
+	case COMP_TARGET_TIMING_POINT_WAKE_UP:
+		u_pc_mark_point(cth->upc, U_TIMING_POINT_WAKE_UP, frame_id, when_ns);
+		break;
+	case COMP_TARGET_TIMING_POINT_BEGIN:
+		u_pc_mark_point(cth->upc, U_TIMING_POINT_BEGIN, frame_id, when_ns);
+		break;
+	case COMP_TARGET_TIMING_POINT_SUBMIT:
+		u_pc_mark_point(cth->upc, U_TIMING_POINT_SUBMIT, frame_id, when_ns);
+		break;
+	default: assert(false);
+	}
+}
+
+static VkResult
+target_update_timings(struct comp_target *ct)
+{
+	struct comp_target_headless *cth = comp_target_headless(ct);
+
+	// Keep the pacing locked to the synthetic vblanks.
+	uint64_t last_vblank_ns = vblank_at_or_before(cth, os_monotonic_get_ns());
+	u_pc_update_vblank_from_display_control(cth->upc, last_vblank_ns);
+
+	return VK_SUCCESS;
+}
+
+static void
+target_info_gpu(
+    struct comp_target *ct, int64_t frame_id, uint64_t gpu_start_ns, uint64_t gpu_end_ns, uint64_t when_ns)
+{
+	struct comp_target_headless *cth = comp_target_headless(ct);
+
+	u_pc_info_gpu(cth->upc, frame_id, gpu_start_ns, gpu_end_ns, when_ns);
+
+	uint32_t slot = (uint32_t)(frame_id % HEADLESS_FRAME_COUNT);
+	if (frame_id < 0 || cth->frames[slot].frame_id != frame_id) {
+		return;
+	}
+
+	/*
+	 * The image is "presented" on the first vblank after the GPU is done,
+	 * but never before the desired present time, like FIFO would.
+	 */
+	uint64_t desired_present_time_ns = cth->frames[slot].desired_present_time_ns;
+	uint64_t present_slop_ns = cth->frames[slot].present_slop_ns;
+	uint64_t earliest_present_time_ns = vblank_at_or_after(cth, gpu_end_ns);
+	uint64_t actual_present_time_ns = vblank_at_or_after(cth, desired_present_time_ns - present_slop_ns);
+	if (actual_present_time_ns < earliest_present_time_ns) {
+		actual_present_time_ns = earliest_present_time_ns;
+	}
+	uint64_t present_margin_ns = earliest_present_time_ns - gpu_end_ns;
+
+	u_pc_info(cth->upc, frame_id, desired_present_time_ns, actual_present_time_ns, earliest_present_time_ns,
+	          present_margin_ns, when_ns);
+}
+
+static void
+target_set_title(struct comp_target *ct, const char *title)
+{
+	// No-op
+}
+
+static void
+target_destroy(struct comp_target *ct)
+{
+	struct comp_target_headless *cth = comp_target_headless(ct);
+	struct vk_bundle *vk = get_vk(cth);
+
+	if (vk->device != VK_NULL_HANDLE) {
+		vk->vkDeviceWaitIdle(vk->device);
+		destroy_images(cth);
+		destroy_semaphores(cth);
+	}
+
+	u_pc_destroy(&cth->upc);
+
+	free(cth);
+}
+
+static struct comp_target *
+headless_create(struct comp_compositor *c)
+{
+	struct comp_target_headless *cth = U_TYPED_CALLOC(struct comp_target_headless);
+
+	cth->base.name = "headless";
+	cth->base.init_pre_vulkan = target_init_pre_vulkan;
+	cth->base.init_post_vulkan = target_init_post_vulkan;
+	cth->base.check_ready = target_check_ready;
+	cth->base.create_images = target_create_images;
+	cth->base.has_images = target_has_images;
+	cth->base.acquire = target_acquire;
+	cth->base.present = target_present;
+	cth->base.flush = target_flush;
+	cth->base.calc_frame_pacing = target_calc_frame_pacing;
+	cth->base.mark_timing_point = target_mark_timing_point;
+	cth->base.update_timings = target_update_timings;
+	cth->base.info_gpu = target_info_gpu;
+	cth->base.set_title = target_set_title;
+	cth->base.destroy = target_destroy;
+	cth->base.c = c;
+	cth->current_frame_id = -1;
+
+	for (uint32_t i = 0; i < HEADLESS_FRAME_COUNT; i++) {
+		cth->frames[i].frame_id = -1;
+	}
+
+	return &cth->base;
+}
+
+
+/*
+ *
+ * Factory
+ *
+ */
+
+static bool
+detect(const struct comp_target_factory *ctf, struct comp_compositor *c)
+{
+	return false;
+}
+
+static bool
+create_target(const struct comp_target_factory *ctf, struct comp_compositor *c, struct comp_target **out_ct)
+{
+	int framerate = (int)debug_get_num_option_headless_framerate();
+	if (framerate > 0) {
+		// Before any pacing is created, the clients see this as well.
+		c->settings.nominal_frame_interval_ns = U_TIME_1S_IN_NS / (uint64_t)framerate;
+	}
+
+	struct comp_target *ct = headless_create(c);
+	if (ct == NULL) {
+		return false;
+	}
+
+	*out_ct = ct;
+
+	return true;
+}
+
+const struct comp_target_factory comp_target_factory_headless = {
+    .name = "Headless offscreen",
+    .identifier = "headless",
+    .requires_vulkan_for_create = false,
+    .is_deferred = false,
+    .required_instance_extensions = NULL,
+    .required_instance_extension_count = 0,
+    .detect = detect,
+    .create_target = create_target,
+};
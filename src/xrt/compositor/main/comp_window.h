@@ -130,6 +130,14 @@ comp_window_mswin_create(struct comp_compositor *c);
 extern const struct comp_target_factory comp_target_factory_mswin;
 #endif // XRT_OS_WINDOWS
 
+/*!
+ * Create a headless target that renders into offscreen images, at a made up
+ * vblank rate.
+ *
+ * @ingroup comp_main
+ */
+extern const struct comp_target_factory comp_target_factory_headless;
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,6 +16,7 @@
 #include "util/u_time.h"
 #include "util/u_debug.h"
 #include "util/u_handles.h"
+#include "util/u_limited_unique_id.h"
 #include "util/u_trace_marker.h"
 #include "util/u_distortion_mesh.h"
 
@@ -42,14 +43,16 @@
 
 
 /*!
- * Clear a slot, need to have the list_and_timing_lock held.
+ * Clear a slot, takes the pacing_lock to retire the frame.
  */
 static void
-slot_clear_locked(struct multi_compositor *mc, struct multi_layer_slot *slot)
+slot_clear(struct multi_compositor *mc, struct multi_layer_slot *slot)
 {
 	if (slot->active) {
 		uint64_t now_ns = os_monotonic_get_ns();
+		os_mutex_lock(&mc->pacing_lock);
 		u_pa_retired(mc->upa, slot->data.frame_id, now_ns);
+		os_mutex_unlock(&mc->pacing_lock);
 	}
 
 	for (size_t i = 0; i < slot->layer_count; i++) {
@@ -62,30 +65,46 @@ slot_clear_locked(struct multi_compositor *mc, struct multi_layer_slot *slot)
 	slot->data.frame_id = -1;
 }
 
+static int32_t
+slot_index(struct multi_compositor *mc, struct multi_layer_slot *slot)
+{
+	return (int32_t)(slot - mc->slots);
+}
+
 /*!
- * Clear a slot, need to have the list_and_timing_lock held.
+ * Swap the value of multi_compositor::scheduled, returns the old value.
  */
-static void
-slot_move_into_cleared(struct multi_layer_slot *dst, struct multi_layer_slot *src)
+static int32_t
+slot_exchange_scheduled(struct multi_compositor *mc, int32_t value)
 {
-	assert(!dst->active);
-	assert(dst->data.frame_id == -1);
-
-	// All references are kept.
-	*dst = *src;
+	int32_t old;
+	do {
+		old = mc->scheduled;
+	} while (xrt_atomic_s32_cmpxchg(&mc->scheduled, old, value) != old);
 
-	U_ZERO(src);
-	src->data.frame_id = -1;
+	return old;
 }
 
 /*!
- * Move a slot into a cleared slot, must be cleared before.
+ * Hand the progress slot over to the render thread, called from the client
+ * side. The old scheduled slot becomes the new progress slot, the render
+ * thread clears slots before handing them back so it only needs clearing if
+ * it was never picked up.
  */
 static void
-slot_move_and_clear_locked(struct multi_compositor *mc, struct multi_layer_slot *dst, struct multi_layer_slot *src)
+slot_schedule_progress(struct multi_compositor *mc)
 {
-	slot_clear_locked(mc, dst);
-	slot_move_into_cleared(dst, src);
+	uint64_t display_time_ns = mc->progress->data.display_time_ns;
+
+	int32_t value = slot_index(mc, mc->progress) | MULTI_SLOT_SCHEDULED_BIT;
+	int32_t old = slot_exchange_scheduled(mc, value);
+
+	mc->scheduled_display_time_ns = display_time_ns;
+	mc->progress = &mc->slots[old & MULTI_SLOT_INDEX_MASK];
+
+	if ((old & MULTI_SLOT_SCHEDULED_BIT) != 0) {
+		slot_clear(mc, mc->progress);
+	}
 }
 
 
@@ -211,23 +230,23 @@ wait_for_scheduled_free(struct multi_compositor *mc)
 {
 	COMP_TRACE_MARKER();
 
-	os_mutex_lock(&mc->slot_lock);
-
-	struct multi_compositor volatile *v_mc = mc;
-
-	// Block here if the scheduled slot is not clear.
-	while (v_mc->scheduled.active) {
+	// Block here if the scheduled slot has not been picked up.
+	while ((mc->scheduled & MULTI_SLOT_SCHEDULED_BIT) != 0) {
 		uint64_t now_ns = os_monotonic_get_ns();
 
+		os_mutex_lock(&mc->pacing_lock);
+		uint64_t next_frame_display = mc->slot_next_frame_display;
+		os_mutex_unlock(&mc->pacing_lock);
+
 		// This frame is for the next frame, drop the old one no matter what.
-		if (time_is_within_half_ms(mc->progress.data.display_time_ns, mc->slot_next_frame_display)) {
+		if (time_is_within_half_ms(mc->progress->data.display_time_ns, next_frame_display)) {
 			U_LOG_W("%.3fms: Dropping old missed frame in favour for completed new frame",
 			        time_ns_to_ms_f(now_ns));
 			break;
 		}
 
 		// Replace the scheduled frame if it's in the past.
-		if (v_mc->scheduled.data.display_time_ns < now_ns) {
+		if (mc->scheduled_display_time_ns < now_ns) {
 			U_LOG_T("%.3fms: Replacing frame for time in past in favour of completed new frame",
 			        time_ns_to_ms_f(now_ns));
 			break;
@@ -240,32 +259,21 @@ wait_for_scheduled_free(struct multi_compositor *mc)
 		    "\n\tprogress: %fms (%" PRIu64
 		    ")  (latest completed frame)"
 		    "\n\tscheduled: %fms (%" PRIu64 ") (oldest waiting frame)",
-		    time_ns_to_ms_f((int64_t)v_mc->slot_next_frame_display - now_ns),        //
-		    v_mc->slot_next_frame_display,                                           //
-		    time_ns_to_ms_f((int64_t)v_mc->progress.data.display_time_ns - now_ns),  //
-		    v_mc->progress.data.display_time_ns,                                     //
-		    time_ns_to_ms_f((int64_t)v_mc->scheduled.data.display_time_ns - now_ns), //
-		    v_mc->scheduled.data.display_time_ns);                                   //
-
-		os_mutex_unlock(&mc->slot_lock);
+		    time_ns_to_ms_f((int64_t)next_frame_display - now_ns),                 //
+		    next_frame_display,                                                    //
+		    time_ns_to_ms_f((int64_t)mc->progress->data.display_time_ns - now_ns), //
+		    mc->progress->data.display_time_ns,                                    //
+		    time_ns_to_ms_f((int64_t)mc->scheduled_display_time_ns - now_ns),      //
+		    mc->scheduled_display_time_ns);                                        //
 
 		os_precise_sleeper_nanosleep(&mc->scheduled_sleeper, U_TIME_1MS_IN_NS);
-
-		os_mutex_lock(&mc->slot_lock);
 	}
 
-	os_mutex_unlock(&mc->slot_lock);
-
 	/*
-	 * Need to take list_and_timing_lock before slot_lock because slot_lock
-	 * is taken in multi_compositor_deliver_any_frames with list_and_timing_lock
-	 * held to stop clients from going away.
+	 * No locks needed, the render thread only ever picks up the scheduled
+	 * slot, if it does so right now it will either get the old or the new.
 	 */
-	os_mutex_lock(&mc->msc->list_and_timing_lock);
-	os_mutex_lock(&mc->slot_lock);
-	slot_move_and_clear_locked(mc, &mc->scheduled, &mc->progress);
-	os_mutex_unlock(&mc->slot_lock);
-	os_mutex_unlock(&mc->msc->list_and_timing_lock);
+	slot_schedule_progress(mc);
 }
 
 static void *
@@ -331,9 +339,9 @@ run_func(void *ptr)
 		// Sample time outside of lock.
 		uint64_t now_ns = os_monotonic_get_ns();
 
-		os_mutex_lock(&mc->msc->list_and_timing_lock);
+		os_mutex_lock(&mc->pacing_lock);
 		u_pa_mark_gpu_done(mc->upa, frame_id, now_ns);
-		os_mutex_unlock(&mc->msc->list_and_timing_lock);
+		os_mutex_unlock(&mc->pacing_lock);
 
 		// Wait for the delivery slot.
 		wait_for_scheduled_free(mc);
@@ -457,7 +465,7 @@ multi_compositor_create_swapchain(struct xrt_compositor *xc,
 
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	return xrt_comp_create_swapchain(&mc->msc->xcn->base, info, out_xsc);
+	return xrt_comp_native_create_owned_swapchain(mc->msc->xcn, mc->swapchain_owner, info, out_xsc);
 }
 
 static xrt_result_t
@@ -543,7 +551,7 @@ multi_compositor_predict_frame(struct xrt_compositor *xc,
 
 	struct multi_compositor *mc = multi_compositor(xc);
 	uint64_t now_ns = os_monotonic_get_ns();
-	os_mutex_lock(&mc->msc->list_and_timing_lock);
+	os_mutex_lock(&mc->pacing_lock);
 
 	u_pa_predict(                         //
 	    mc->upa,                          //
@@ -553,7 +561,7 @@ multi_compositor_predict_frame(struct xrt_compositor *xc,
 	    out_predicted_display_time_ns,    //
 	    out_predicted_display_period_ns); //
 
-	os_mutex_unlock(&mc->msc->list_and_timing_lock);
+	os_mutex_unlock(&mc->pacing_lock);
 
 	*out_predicted_gpu_time_ns = 0;
 
@@ -570,13 +578,11 @@ multi_compositor_mark_frame(struct xrt_compositor *xc,
 
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	uint64_t now_ns = os_monotonic_get_ns();
-
 	switch (point) {
 	case XRT_COMPOSITOR_FRAME_POINT_WOKE:
-		os_mutex_lock(&mc->msc->list_and_timing_lock);
-		u_pa_mark_point(mc->upa, frame_id, U_TIMING_POINT_WAKE_UP, now_ns);
-		os_mutex_unlock(&mc->msc->list_and_timing_lock);
+		os_mutex_lock(&mc->pacing_lock);
+		u_pa_mark_point(mc->upa, frame_id, U_TIMING_POINT_WAKE_UP, when_ns);
+		os_mutex_unlock(&mc->pacing_lock);
 		break;
 	default: assert(false);
 	}
@@ -626,10 +632,10 @@ multi_compositor_begin_frame(struct xrt_compositor *xc, int64_t frame_id)
 
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	os_mutex_lock(&mc->msc->list_and_timing_lock);
+	os_mutex_lock(&mc->pacing_lock);
 	uint64_t now_ns = os_monotonic_get_ns();
 	u_pa_mark_point(mc->upa, frame_id, U_TIMING_POINT_BEGIN, now_ns);
-	os_mutex_unlock(&mc->msc->list_and_timing_lock);
+	os_mutex_unlock(&mc->pacing_lock);
 
 	return XRT_SUCCESS;
 }
@@ -642,9 +648,9 @@ multi_compositor_discard_frame(struct xrt_compositor *xc, int64_t frame_id)
 	struct multi_compositor *mc = multi_compositor(xc);
 	uint64_t now_ns = os_monotonic_get_ns();
 
-	os_mutex_lock(&mc->msc->list_and_timing_lock);
+	os_mutex_lock(&mc->pacing_lock);
 	u_pa_mark_discarded(mc->upa, frame_id, now_ns);
-	os_mutex_unlock(&mc->msc->list_and_timing_lock);
+	os_mutex_unlock(&mc->pacing_lock);
 
 	return XRT_SUCCESS;
 }
@@ -656,9 +662,9 @@ multi_compositor_layer_begin(struct xrt_compositor *xc, const struct xrt_layer_f
 
 	// As early as possible.
 	uint64_t now_ns = os_monotonic_get_ns();
-	os_mutex_lock(&mc->msc->list_and_timing_lock);
+	os_mutex_lock(&mc->pacing_lock);
 	u_pa_mark_delivered(mc->upa, data->frame_id, now_ns, data->display_time_ns);
-	os_mutex_unlock(&mc->msc->list_and_timing_lock);
+	os_mutex_unlock(&mc->pacing_lock);
 
 	/*
 	 * We have to block here for the waiting thread to push the last
@@ -672,11 +678,11 @@ multi_compositor_layer_begin(struct xrt_compositor *xc, const struct xrt_layer_f
 	 */
 	wait_for_wait_thread(mc);
 
-	assert(mc->progress.layer_count == 0);
-	U_ZERO(&mc->progress);
+	assert(mc->progress->layer_count == 0);
+	U_ZERO(mc->progress);
 
-	mc->progress.active = true;
-	mc->progress.data = *data;
+	mc->progress->active = true;
+	mc->progress->data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -691,11 +697,11 @@ multi_compositor_layer_stereo_projection(struct xrt_compositor *xc,
 	struct multi_compositor *mc = multi_compositor(xc);
 	(void)mc;
 
-	size_t index = mc->progress.layer_count++;
-	mc->progress.layers[index].xdev = xdev;
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[0], l_xsc);
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[1], r_xsc);
-	mc->progress.layers[index].data = *data;
+	size_t index = mc->progress->layer_count++;
+	mc->progress->layers[index].xdev = xdev;
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[0], l_xsc);
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[1], r_xsc);
+	mc->progress->layers[index].data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -711,13 +717,18 @@ multi_compositor_layer_stereo_projection_depth(struct xrt_compositor *xc,
 {
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	size_t index = mc->progress.layer_count++;
-	mc->progress.layers[index].xdev = xdev;
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[0], l_xsc);
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[1], r_xsc);
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[2], l_d_xsc);
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[3], r_d_xsc);
-	mc->progress.layers[index].data = *data;
+	size_t index = mc->progress->layer_count++;
+	mc->progress->layers[index].xdev = xdev;
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[0], l_xsc);
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[1], r_xsc);
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[2], l_d_xsc);
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[3], r_d_xsc);
+	mc->progress->layers[index].data = *data;
+
+	// Opted into per session, the main compositor only sees the layers.
+	if (mc->xsi.depth_reprojection) {
+		mc->progress->layers[index].data.flags |= XRT_LAYER_COMPOSITION_DEPTH_REPROJECTION_BIT;
+	}
 
 	return XRT_SUCCESS;
 }
@@ -730,10 +741,10 @@ multi_compositor_layer_quad(struct xrt_compositor *xc,
 {
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	size_t index = mc->progress.layer_count++;
-	mc->progress.layers[index].xdev = xdev;
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[0], xsc);
-	mc->progress.layers[index].data = *data;
+	size_t index = mc->progress->layer_count++;
+	mc->progress->layers[index].xdev = xdev;
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[0], xsc);
+	mc->progress->layers[index].data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -746,10 +757,10 @@ multi_compositor_layer_cube(struct xrt_compositor *xc,
 {
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	size_t index = mc->progress.layer_count++;
-	mc->progress.layers[index].xdev = xdev;
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[0], xsc);
-	mc->progress.layers[index].data = *data;
+	size_t index = mc->progress->layer_count++;
+	mc->progress->layers[index].xdev = xdev;
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[0], xsc);
+	mc->progress->layers[index].data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -762,10 +773,10 @@ multi_compositor_layer_cylinder(struct xrt_compositor *xc,
 {
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	size_t index = mc->progress.layer_count++;
-	mc->progress.layers[index].xdev = xdev;
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[0], xsc);
-	mc->progress.layers[index].data = *data;
+	size_t index = mc->progress->layer_count++;
+	mc->progress->layers[index].xdev = xdev;
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[0], xsc);
+	mc->progress->layers[index].data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -778,10 +789,10 @@ multi_compositor_layer_equirect1(struct xrt_compositor *xc,
 {
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	size_t index = mc->progress.layer_count++;
-	mc->progress.layers[index].xdev = xdev;
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[0], xsc);
-	mc->progress.layers[index].data = *data;
+	size_t index = mc->progress->layer_count++;
+	mc->progress->layers[index].xdev = xdev;
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[0], xsc);
+	mc->progress->layers[index].data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -794,10 +805,10 @@ multi_compositor_layer_equirect2(struct xrt_compositor *xc,
 {
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	size_t index = mc->progress.layer_count++;
-	mc->progress.layers[index].xdev = xdev;
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[0], xsc);
-	mc->progress.layers[index].data = *data;
+	size_t index = mc->progress->layer_count++;
+	mc->progress->layers[index].xdev = xdev;
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[0], xsc);
+	mc->progress->layers[index].data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -809,7 +820,7 @@ multi_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handl
 
 	struct multi_compositor *mc = multi_compositor(xc);
 	struct xrt_compositor_fence *xcf = NULL;
-	int64_t frame_id = mc->progress.data.frame_id;
+	int64_t frame_id = mc->progress->data.frame_id;
 
 	do {
 		if (!xrt_graphics_sync_handle_is_valid(sync_handle)) {
@@ -838,9 +849,9 @@ multi_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handl
 		// Assume that the app side compositor waited.
 		uint64_t now_ns = os_monotonic_get_ns();
 
-		os_mutex_lock(&mc->msc->list_and_timing_lock);
+		os_mutex_lock(&mc->pacing_lock);
 		u_pa_mark_gpu_done(mc->upa, frame_id, now_ns);
-		os_mutex_unlock(&mc->msc->list_and_timing_lock);
+		os_mutex_unlock(&mc->pacing_lock);
 
 		wait_for_scheduled_free(mc);
 	}
@@ -856,7 +867,7 @@ multi_compositor_layer_commit_with_semaphore(struct xrt_compositor *xc,
 	COMP_TRACE_MARKER();
 
 	struct multi_compositor *mc = multi_compositor(xc);
-	int64_t frame_id = mc->progress.data.frame_id;
+	int64_t frame_id = mc->progress->data.frame_id;
 
 	push_semaphore_to_wait_thread(mc, frame_id, xcsem, value);
 
@@ -911,11 +922,12 @@ multi_compositor_destroy(struct xrt_compositor *xc)
 	os_thread_helper_destroy(&mc->wait_thread.oth);
 
 	// We are now off the rendering list, clear slots for any swapchains.
-	os_mutex_lock(&mc->msc->list_and_timing_lock);
-	slot_clear_locked(mc, &mc->progress);
-	slot_clear_locked(mc, &mc->scheduled);
-	slot_clear_locked(mc, &mc->delivered);
-	os_mutex_unlock(&mc->msc->list_and_timing_lock);
+	for (size_t i = 0; i < ARRAY_SIZE(mc->slots); i++) {
+		slot_clear(mc, &mc->slots[i]);
+	}
+
+	// After the last reference to our swapchains has been dropped above.
+	xrt_comp_native_release_owner(mc->msc->xcn, mc->swapchain_owner);
 
 	// Does null checking.
 	u_pa_destroy(&mc->upa);
@@ -923,7 +935,7 @@ multi_compositor_destroy(struct xrt_compositor *xc)
 	os_precise_sleeper_deinit(&mc->frame_sleeper);
 	os_precise_sleeper_deinit(&mc->scheduled_sleeper);
 
-	os_mutex_destroy(&mc->slot_lock);
+	os_mutex_destroy(&mc->pacing_lock);
 	os_mutex_destroy(&mc->event.mutex);
 
 	free(mc);
@@ -945,35 +957,47 @@ log_frame_time_diff(uint64_t frame_time_ns, uint64_t display_time_ns)
 void
 multi_compositor_deliver_any_frames(struct multi_compositor *mc, uint64_t display_time_ns)
 {
-	os_mutex_lock(&mc->slot_lock);
+	int32_t scheduled = mc->scheduled;
+	if ((scheduled & MULTI_SLOT_SCHEDULED_BIT) == 0) {
+		return;
+	}
 
-	if (!mc->scheduled.active) {
-		os_mutex_unlock(&mc->slot_lock);
+	/*
+	 * The client side might replace the frame between this check and the
+	 * exchange below, it only does that when the newer frame should be
+	 * shown instead so just pick up whichever frame is there.
+	 */
+	struct multi_layer_slot volatile *v_slot = &mc->slots[scheduled & MULTI_SLOT_INDEX_MASK];
+	if (!time_is_greater_then_or_within_half_ms(display_time_ns, v_slot->data.display_time_ns)) {
 		return;
 	}
 
-	if (time_is_greater_then_or_within_half_ms(display_time_ns, mc->scheduled.data.display_time_ns)) {
-		slot_move_and_clear_locked(mc, &mc->delivered, &mc->scheduled);
+	// The client side gets this slot, it must be cleared before handing it over.
+	slot_clear(mc, mc->delivered);
 
-		uint64_t frame_time_ns = mc->delivered.data.display_time_ns;
-		if (!time_is_within_half_ms(frame_time_ns, display_time_ns)) {
-			log_frame_time_diff(frame_time_ns, display_time_ns);
-		}
-	}
+	int32_t old = slot_exchange_scheduled(mc, slot_index(mc, mc->delivered));
+	assert((old & MULTI_SLOT_SCHEDULED_BIT) != 0);
+
+	mc->delivered = &mc->slots[old & MULTI_SLOT_INDEX_MASK];
 
-	os_mutex_unlock(&mc->slot_lock);
+	uint64_t frame_time_ns = mc->delivered->data.display_time_ns;
+	if (!time_is_within_half_ms(frame_time_ns, display_time_ns)) {
+		log_frame_time_diff(frame_time_ns, display_time_ns);
+	}
 }
 
 void
 multi_compositor_latch_frame_locked(struct multi_compositor *mc, uint64_t when_ns, int64_t system_frame_id)
 {
-	u_pa_latched(mc->upa, mc->delivered.data.frame_id, when_ns, system_frame_id);
+	os_mutex_lock(&mc->pacing_lock);
+	u_pa_latched(mc->upa, mc->delivered->data.frame_id, when_ns, system_frame_id);
+	os_mutex_unlock(&mc->pacing_lock);
 }
 
 void
 multi_compositor_retire_delivered_locked(struct multi_compositor *mc, uint64_t when_ns)
 {
-	slot_clear_locked(mc, &mc->delivered);
+	slot_clear(mc, mc->delivered);
 }
 
 xrt_result_t
@@ -1012,9 +1036,15 @@ multi_compositor_create(struct multi_system_compositor *msc,
 	mc->base.base.set_thread_hint = multi_compositor_set_thread_hint;
 	mc->msc = msc;
 	mc->xsi = *xsi;
+	mc->swapchain_owner = u_limited_unique_id_get().data;
 
 	os_mutex_init(&mc->event.mutex);
-	os_mutex_init(&mc->slot_lock);
+	os_mutex_init(&mc->pacing_lock);
+
+	// Each slot starts out owned by one of the three users.
+	mc->progress = &mc->slots[0];
+	mc->scheduled = 1;
+	mc->delivered = &mc->slots[2];
 	os_thread_helper_init(&mc->wait_thread.oth);
 
 	// Passthrough our formats from the native compositor to the client.
@@ -26,6 +26,12 @@ extern "C" {
 #define MULTI_MAX_CLIENTS 64
 #define MULTI_MAX_LAYERS 16
 
+//! Set in multi_compositor::scheduled while it holds a frame the render thread hasn't picked up.
+#define MULTI_SLOT_SCHEDULED_BIT (0x4)
+
+//! Mask for the index into multi_compositor::slots in multi_compositor::scheduled.
+#define MULTI_SLOT_INDEX_MASK (0x3)
+
 
 /*
  *
@@ -98,6 +104,12 @@ struct multi_compositor
 	// Client info.
 	struct xrt_session_info xsi;
 
+	/*!
+	 * Unique per session, swapchains are created for it so that their images
+	 * are never reused by another client.
+	 */
+	uint64_t swapchain_owner;
+
 	//! Owning system compositor.
 	struct multi_system_compositor *msc;
 
@@ -155,28 +167,47 @@ struct multi_compositor
 		bool blocked;
 	} wait_thread;
 
-	//! Lock for all of the slots.
-	struct os_mutex slot_lock;
+	/*!
+	 * Protects @ref upa and @ref slot_next_frame_display, per client so
+	 * that clients don't contend with each other or the render thread.
+	 */
+	struct os_mutex pacing_lock;
 
 	/*!
 	 * The next which the next frames to be picked up will be displayed.
 	 */
 	uint64_t slot_next_frame_display;
 
+	/*!
+	 * Storage for the slots, they are handed between the client side and
+	 * the render thread without locking: @ref progress is owned by the
+	 * client side, @ref delivered by the render thread, and the one in
+	 * @ref scheduled is swapped atomically by both.
+	 */
+	struct multi_layer_slot slots[3];
+
 	/*!
 	 * Currently being transferred or waited on.
-	 * Not protected by the slot lock as it is only touched by the client thread.
+	 * Only touched by the client thread and the wait thread.
+	 */
+	struct multi_layer_slot *progress;
+
+	/*!
+	 * Index into @ref slots of the scheduled frame for a future timepoint,
+	 * with @ref MULTI_SLOT_SCHEDULED_BIT set until the render thread has
+	 * picked it up. Only the client side sets the bit and only the render
+	 * thread clears it.
 	 */
-	struct multi_layer_slot progress;
+	xrt_atomic_s32_t scheduled;
 
-	//! Scheduled frames for a future timepoint.
-	struct multi_layer_slot scheduled;
+	//! Display time of the last scheduled frame, only touched by the client side.
+	uint64_t scheduled_display_time_ns;
 
 	/*!
 	 * Fully ready to be used.
-	 * Not protected by the slot lock as it is only touched by the main render loop thread.
+	 * Only touched by the main render loop thread.
 	 */
-	struct multi_layer_slot delivered;
+	struct multi_layer_slot *delivered;
 
 	struct u_pacing_app *upa;
 };
@@ -208,7 +239,7 @@ multi_compositor_push_event(struct multi_compositor *mc, const union xrt_composi
 
 /*!
  * Deliver any scheduled frames at that is to be display at or after the given @p display_time_ns. Called by the render
- * thread and copies data from multi_compositor::scheduled to multi_compositor::delivered while holding the slot_lock.
+ * thread and swaps multi_compositor::scheduled with multi_compositor::delivered without taking any locks.
  *
  * @ingroup comp_multi
  * @private @memberof multi_compositor
@@ -218,7 +249,8 @@ multi_compositor_deliver_any_frames(struct multi_compositor *mc, uint64_t displa
 
 /*!
  * Makes the current delivered frame as latched, called by the render thread.
- * The list_and_timing_lock is held when this function is called.
+ * The list_and_timing_lock is held when this function is called, it takes the
+ * client's pacing_lock.
  *
  * @ingroup comp_multi
  * @private @memberof multi_compositor
@@ -228,7 +260,8 @@ multi_compositor_latch_frame_locked(struct multi_compositor *mc, uint64_t when_n
 
 /*!
  * Clears and retires the delivered frame, called by the render thread.
- * The list_and_timing_lock is held when this function is called.
+ * The list_and_timing_lock is held when this function is called, it takes the
+ * client's pacing_lock.
  *
  * @ingroup comp_multi
  * @private @memberof multi_compositor
@@ -330,8 +363,9 @@ struct multi_system_compositor
 	} sessions;
 
 	/*!
-	 * This mutex protects the list of client compositor
-	 * and the rendering timings on it.
+	 * This mutex protects the list of client compositor and
+	 * @ref last_timings, the per client timings are protected by
+	 * multi_compositor::pacing_lock.
 	 */
 	struct os_mutex list_and_timing_lock;
 
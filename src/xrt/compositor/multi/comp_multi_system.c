@@ -243,7 +243,7 @@ transfer_layers_locked(struct multi_system_compositor *msc, uint64_t display_tim
 		multi_compositor_deliver_any_frames(mc, display_time_ns);
 
 		// None of the data in this slot is valid, don't check access it.
-		if (!mc->delivered.active) {
+		if (!mc->delivered->active) {
 			continue;
 		}
 
@@ -277,8 +277,8 @@ transfer_layers_locked(struct multi_system_compositor *msc, uint64_t display_tim
 		struct multi_compositor *mc = array[k];
 		assert(mc != NULL);
 
-		for (uint32_t i = 0; i < mc->delivered.layer_count; i++) {
-			struct multi_layer_entry *layer = &mc->delivered.layers[i];
+		for (uint32_t i = 0; i < mc->delivered->layer_count; i++) {
+			struct multi_layer_entry *layer = &mc->delivered->layers[i];
 
 			switch (layer->data.type) {
 			case XRT_LAYER_STEREO_PROJECTION: do_projection_layer(xc, mc, layer, i); break;
@@ -307,9 +307,9 @@ broadcast_timings_to_clients(struct multi_system_compositor *msc, uint64_t predi
 			continue;
 		}
 
-		os_mutex_lock(&mc->slot_lock);
+		os_mutex_lock(&mc->pacing_lock);
 		mc->slot_next_frame_display = predicted_display_time_ns;
-		os_mutex_unlock(&mc->slot_lock);
+		os_mutex_unlock(&mc->pacing_lock);
 	}
 
 	os_mutex_unlock(&msc->list_and_timing_lock);
@@ -331,15 +331,17 @@ broadcast_timings_to_pacers(struct multi_system_compositor *msc,
 			continue;
 		}
 
+		os_mutex_lock(&mc->pacing_lock);
+
 		u_pa_info(                       //
 		    mc->upa,                     //
 		    predicted_display_time_ns,   //
 		    predicted_display_period_ns, //
 		    diff_ns);                    //
 
-		os_mutex_lock(&mc->slot_lock);
 		mc->slot_next_frame_display = predicted_display_time_ns;
-		os_mutex_unlock(&mc->slot_lock);
+
+		os_mutex_unlock(&mc->pacing_lock);
 	}
 
 	msc->last_timings.predicted_display_time_ns = predicted_display_time_ns;
@@ -558,6 +560,11 @@ system_compositor_set_state(struct xrt_system_compositor *xsc, struct xrt_compos
 		mc->state.visible = visible;
 		mc->state.focused = focused;
 
+		// Other apps give up GPU time to the focused app, but not to overlays.
+		os_mutex_lock(&mc->pacing_lock);
+		u_pa_set_primary(mc->upa, focused && !mc->xsi.is_overlay);
+		os_mutex_unlock(&mc->pacing_lock);
+
 		union xrt_compositor_event xce = XRT_STRUCT_INIT;
 		xce.type = XRT_COMPOSITOR_EVENT_STATE_CHANGE;
 		xce.state.visible = visible;
@@ -93,6 +93,79 @@ calc_dispatch_dims_2_views(const struct render_viewport_data views[2], uint32_t
 	*out_h = h;
 }
 
+static void
+update_foveation_ubo(struct render_compute_distortion_ubo_data *data,
+                     const struct render_viewport_data views[2],
+                     const struct render_compute_foveation *foveation)
+{
+	if (!render_foveation_is_enabled(foveation)) {
+		for (uint32_t i = 0; i < 2; i++) {
+			data->fovea[i] = (struct render_viewport_data){0, 0, views[i].w, views[i].h};
+		}
+		data->foveation.tile_size = 0;
+		return;
+	}
+
+	uint32_t tile_size = foveation->tile_size;
+	float fraction = foveation->full_rate_fraction;
+
+	for (uint32_t i = 0; i < 2; i++) {
+		const struct xrt_vec2 *center = &foveation->centers[i];
+		uint32_t w = render_foveation_calc_extent(views[i].w, tile_size, fraction);
+		uint32_t h = render_foveation_calc_extent(views[i].h, tile_size, fraction);
+
+		data->fovea[i].x = render_foveation_calc_offset(views[i].w, w, tile_size, center->x);
+		data->fovea[i].y = render_foveation_calc_offset(views[i].h, h, tile_size, center->y);
+		data->fovea[i].w = w;
+		data->fovea[i].h = h;
+	}
+	data->foveation.tile_size = tile_size;
+}
+
+static void
+update_overlays_ubo(struct render_compute_distortion_ubo_data *data, const struct render_compute_overlays *overlays)
+{
+	uint32_t count = overlays != NULL ? overlays->count : 0;
+	assert(count <= RENDER_MAX_OVERLAYS);
+
+	for (uint32_t i = 0; i < count; i++) {
+		data->overlays[i][0] = overlays->data[i][0];
+		data->overlays[i][1] = overlays->data[i][1];
+	}
+	data->overlay_count.value = count;
+}
+
+/*!
+ * Dispatch dimensions and view count for the distortion shader, when foveated
+ * the z dimension also covers the periphery pass with one invocation per tile.
+ */
+static void
+calc_dispatch_dims_distortion(const struct render_viewport_data views[2],
+                              const struct render_compute_foveation *foveation,
+                              uint32_t *out_w,
+                              uint32_t *out_h,
+                              uint32_t *out_d)
+{
+	if (!render_foveation_is_enabled(foveation)) {
+		calc_dispatch_dims_2_views(views, out_w, out_h);
+		*out_d = 2;
+		return;
+	}
+
+	uint32_t tile_size = foveation->tile_size;
+	float fraction = foveation->full_rate_fraction;
+	uint32_t w = 0, h = 0;
+
+	for (uint32_t i = 0; i < 2; i++) {
+		w = MAX(w, render_foveation_calc_invocations(views[i].w, tile_size, fraction));
+		h = MAX(h, render_foveation_calc_invocations(views[i].h, tile_size, fraction));
+	}
+
+	*out_w = uint_divide_and_round_up(w, 8);
+	*out_h = uint_divide_and_round_up(h, 8);
+	*out_d = 4;
+}
+
 
 /*
  *
@@ -181,6 +254,12 @@ update_compute_shared_descriptor_set(struct vk_bundle *vk,
                                      uint32_t ubo_binding,
                                      VkBuffer ubo_buffer,
                                      VkDeviceSize ubo_size,
+                                     uint32_t depth_binding,
+                                     VkSampler depth_samplers[2],
+                                     VkImageView depth_image_views[2],
+                                     uint32_t overlay_binding,
+                                     VkSampler overlay_samplers[RENDER_MAX_OVERLAYS],
+                                     VkImageView overlay_image_views[RENDER_MAX_OVERLAYS],
                                      VkDescriptorSet descriptor_set)
 {
 	VkDescriptorImageInfo src_image_info[2] = {
@@ -240,7 +319,29 @@ update_compute_shared_descriptor_set(struct vk_bundle *vk,
 	    .range = ubo_size,
 	};
 
-	VkWriteDescriptorSet write_descriptor_sets[4] = {
+	VkDescriptorImageInfo depth_image_info[2] = {
+	    {
+	        .sampler = depth_samplers[0],
+	        .imageView = depth_image_views[0],
+	        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	    },
+	    {
+	        .sampler = depth_samplers[1],
+	        .imageView = depth_image_views[1],
+	        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	    },
+	};
+
+	VkDescriptorImageInfo overlay_image_info[RENDER_MAX_OVERLAYS];
+	for (uint32_t i = 0; i < RENDER_MAX_OVERLAYS; i++) {
+		overlay_image_info[i] = (VkDescriptorImageInfo){
+		    .sampler = overlay_samplers[i],
+		    .imageView = overlay_image_views[i],
+		    .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		};
+	}
+
+	VkWriteDescriptorSet write_descriptor_sets[6] = {
 	    {
 	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
 	        .dstSet = descriptor_set,
@@ -273,6 +374,22 @@ update_compute_shared_descriptor_set(struct vk_bundle *vk,
 	        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
 	        .pBufferInfo = &buffer_info,
 	    },
+	    {
+	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+	        .dstSet = descriptor_set,
+	        .dstBinding = depth_binding,
+	        .descriptorCount = ARRAY_SIZE(depth_image_info),
+	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	        .pImageInfo = depth_image_info,
+	    },
+	    {
+	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+	        .dstSet = descriptor_set,
+	        .dstBinding = overlay_binding,
+	        .descriptorCount = ARRAY_SIZE(overlay_image_info),
+	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	        .pImageInfo = overlay_image_info,
+	    },
 	};
 
 	vk->vkUpdateDescriptorSets(            //
@@ -330,6 +447,184 @@ update_compute_discriptor_set_target(struct vk_bundle *vk,
 	    NULL);                             // pDescriptorCopies
 }
 
+static bool
+create_descriptor_sets(struct render_compute *crc, VkDescriptorPool descriptor_pool)
+{
+	struct vk_bundle *vk = vk_from_crc(crc);
+	struct render_resources *r = crc->r;
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(crc->layer_descriptor_sets); i++) {
+		C(vk_create_descriptor_set(                 //
+		    vk,                                     //
+		    descriptor_pool,                        // descriptor_pool
+		    r->compute.layer.descriptor_set_layout, // descriptor_set_layout
+		    &crc->layer_descriptor_sets[i]));       // descriptor_set
+	}
+
+	C(vk_create_descriptor_set(                      //
+	    vk,                                          //
+	    descriptor_pool,                             // descriptor_pool
+	    r->compute.distortion.descriptor_set_layout, // descriptor_set_layout
+	    &crc->shared_descriptor_set));               // descriptor_set
+
+	return true;
+}
+
+/*!
+ * The depth images are only read when reprojecting with depth, but the
+ * descriptors needs to be valid for all users of the shared descriptor set.
+ */
+static void
+get_mock_depth(struct render_resources *r, VkSampler out_samplers[2], VkImageView out_image_views[2])
+{
+	for (uint32_t i = 0; i < 2; i++) {
+		out_samplers[i] = r->samplers.mock;
+		out_image_views[i] = r->mock.color.image_view;
+	}
+}
+
+//! Like the depth images the unused overlay descriptors are filled in with the mock image.
+static void
+get_overlay_images(struct render_resources *r,
+                   const struct render_compute_overlays *overlays,
+                   VkSampler out_samplers[RENDER_MAX_OVERLAYS],
+                   VkImageView out_image_views[RENDER_MAX_OVERLAYS])
+{
+	uint32_t count = overlays != NULL ? overlays->count : 0;
+
+	for (uint32_t i = 0; i < RENDER_MAX_OVERLAYS; i++) {
+		if (i < count) {
+			out_samplers[i] = overlays->samplers[i];
+			out_image_views[i] = overlays->image_views[i];
+		} else {
+			out_samplers[i] = r->samplers.mock;
+			out_image_views[i] = r->mock.color.image_view;
+		}
+	}
+}
+
+/*!
+ * Records the distortion dispatch of the timewarp functions, the UBO must
+ * already have been filled in.
+ */
+static void
+record_projection_timewarp(struct render_compute *crc,
+                           VkPipeline pipeline,
+                           VkSampler src_samplers[2],
+                           VkImageView src_image_views[2],
+                           VkSampler depth_samplers[2],
+                           VkImageView depth_image_views[2],
+                           VkImage target_image,
+                           VkImageView target_image_view,
+                           const struct render_viewport_data views[2],
+                           const struct render_compute_foveation *foveation,
+                           const struct render_compute_overlays *overlays)
+{
+	struct vk_bundle *vk = vk_from_crc(crc);
+	struct render_resources *r = crc->r;
+
+	/*
+	 * Source, target and distortion images.
+	 */
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = VK_REMAINING_MIP_LEVELS,
+	    .baseArrayLayer = 0,
+	    .layerCount = VK_REMAINING_ARRAY_LAYERS,
+	};
+
+	vk_cmd_image_barrier_gpu_locked( //
+	    vk,                          //
+	    crc->cmd,                    //
+	    target_image,                //
+	    0,                           //
+	    VK_ACCESS_SHADER_WRITE_BIT,  //
+	    VK_IMAGE_LAYOUT_UNDEFINED,   //
+	    VK_IMAGE_LAYOUT_GENERAL,     //
+	    subresource_range);          //
+
+	VkSampler sampler = r->samplers.clamp_to_edge;
+	VkSampler distortion_samplers[6] = {
+	    sampler, sampler, sampler, sampler, sampler, sampler,
+	};
+
+	VkSampler overlay_samplers[RENDER_MAX_OVERLAYS];
+	VkImageView overlay_image_views[RENDER_MAX_OVERLAYS];
+	get_overlay_images(r, overlays, overlay_samplers, overlay_image_views);
+
+	update_compute_shared_descriptor_set( //
+	    vk,                               //
+	    r->compute.src_binding,           //
+	    src_samplers,                     //
+	    src_image_views,                  //
+	    r->compute.distortion_binding,    //
+	    distortion_samplers,              //
+	    r->distortion.image_views,        //
+	    r->compute.target_binding,        //
+	    target_image_view,                //
+	    r->compute.ubo_binding,           //
+	    r->compute.distortion.ubo.buffer, //
+	    VK_WHOLE_SIZE,                    //
+	    r->compute.depth_binding,         //
+	    depth_samplers,                   //
+	    depth_image_views,                //
+	    r->compute.overlay_binding,       //
+	    overlay_samplers,                 //
+	    overlay_image_views,              //
+	    crc->shared_descriptor_set);      //
+
+	vk->vkCmdBindPipeline(              //
+	    crc->cmd,                       // commandBuffer
+	    VK_PIPELINE_BIND_POINT_COMPUTE, // pipelineBindPoint
+	    pipeline);                      // pipeline
+
+	vk->vkCmdBindDescriptorSets(               //
+	    crc->cmd,                              // commandBuffer
+	    VK_PIPELINE_BIND_POINT_COMPUTE,        // pipelineBindPoint
+	    r->compute.distortion.pipeline_layout, // layout
+	    0,                                     // firstSet
+	    1,                                     // descriptorSetCount
+	    &crc->shared_descriptor_set,           // pDescriptorSets
+	    0,                                     // dynamicOffsetCount
+	    NULL);                                 // pDynamicOffsets
+
+
+	uint32_t w = 0, h = 0, d = 0;
+	calc_dispatch_dims_distortion(views, foveation, &w, &h, &d);
+	assert(w != 0 && h != 0);
+
+	vk->vkCmdDispatch( //
+	    crc->cmd,      // commandBuffer
+	    w,             // groupCountX
+	    h,             // groupCountY
+	    d);            // groupCountZ
+
+	VkImageMemoryBarrier memoryBarrier = {
+	    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+	    .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+	    .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+	    .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+	    .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+	    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+	    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+	    .image = target_image,
+	    .subresourceRange = subresource_range,
+	};
+
+	vk->vkCmdPipelineBarrier(                 //
+	    crc->cmd,                             //
+	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, //
+	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,    //
+	    0,                                    //
+	    0,                                    //
+	    NULL,                                 //
+	    0,                                    //
+	    NULL,                                 //
+	    1,                                    //
+	    &memoryBarrier);                      //
+}
 
 /*
  *
@@ -342,24 +637,41 @@ render_compute_init(struct render_compute *crc, struct render_resources *r)
 {
 	assert(crc->r == NULL);
 
-	struct vk_bundle *vk = r->vk;
 	crc->r = r;
+	crc->cmd = r->cmd;
 
-	for (uint32_t i = 0; i < ARRAY_SIZE(crc->layer_descriptor_sets); i++) {
-		C(vk_create_descriptor_set(                 //
-		    vk,                                     //
-		    r->compute.descriptor_pool,             // descriptor_pool
-		    r->compute.layer.descriptor_set_layout, // descriptor_set_layout
-		    &crc->layer_descriptor_sets[i]));       // descriptor_set
-	}
+	return create_descriptor_sets(crc, r->compute.descriptor_pool);
+}
 
-	C(vk_create_descriptor_set(                      //
-	    vk,                                          //
-	    r->compute.descriptor_pool,                  // descriptor_pool
-	    r->compute.distortion.descriptor_set_layout, // descriptor_set_layout
-	    &crc->shared_descriptor_set));               // descriptor_set
+bool
+render_compute_init_reusable(struct render_compute *crc, struct render_resources *r)
+{
+	assert(crc->r == NULL);
 
-	return true;
+	struct vk_bundle *vk = r->vk;
+	crc->r = r;
+	crc->reusable.enabled = true;
+
+	// Reset per command buffer, the pool is never reset as a whole.
+	C(vk_cmd_pool_init(vk, &crc->reusable.cmd_pool, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT));
+	C(vk_cmd_pool_create_cmd_buffer(vk, &crc->reusable.cmd_pool, &crc->cmd));
+
+	// Same as the shared pool in render_resources.
+	struct vk_descriptor_pool_info pool_info = {
+	    .uniform_per_descriptor_count = 1,
+	    .sampler_per_descriptor_count = r->compute.layer.image_array_size + 6 + 2 + RENDER_MAX_OVERLAYS,
+	    .storage_image_per_descriptor_count = 1,
+	    .storage_buffer_per_descriptor_count = 0,
+	    .descriptor_count = 1 + RENDER_MAX_LAYER_RUNS,
+	    .freeable = false,
+	};
+
+	C(vk_create_descriptor_pool(          //
+	    vk,                               // vk_bundle
+	    &pool_info,                       // info
+	    &crc->reusable.descriptor_pool)); // out_descriptor_pool
+
+	return create_descriptor_sets(crc, crc->reusable.descriptor_pool);
 }
 
 bool
@@ -367,25 +679,33 @@ render_compute_begin(struct render_compute *crc)
 {
 	struct vk_bundle *vk = vk_from_crc(crc);
 
-	C(vk->vkResetCommandPool(vk->device, crc->r->cmd_pool, 0));
-
 	VkCommandBufferBeginInfo begin_info = {
 	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
 	    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
 	};
 
+	if (crc->reusable.enabled) {
+		C(vk->vkResetCommandBuffer(crc->cmd, 0));
+		begin_info.flags = 0;
+	} else {
+		C(vk->vkResetCommandPool(vk->device, crc->r->cmd_pool, 0));
+	}
+
 	C(vk->vkBeginCommandBuffer( //
-	    crc->r->cmd,            // commandBuffer
+	    crc->cmd,               // commandBuffer
 	    &begin_info));          // pBeginInfo
 
+	crc->replaying = false;
+	crc->timewarp.recorded = false;
+
 	vk->vkCmdResetQueryPool( //
-	    crc->r->cmd,         // commandBuffer
+	    crc->cmd,            // commandBuffer
 	    crc->r->query_pool,  // queryPool
 	    0,                   // firstQuery
 	    2);                  // queryCount
 
 	vk->vkCmdWriteTimestamp(               //
-	    crc->r->cmd,                       // commandBuffer
+	    crc->cmd,                          // commandBuffer
 	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // pipelineStage
 	    crc->r->query_pool,                // queryPool
 	    0);                                // query
@@ -393,18 +713,40 @@ render_compute_begin(struct render_compute *crc)
 	return true;
 }
 
+bool
+render_compute_begin_replay(struct render_compute *crc)
+{
+	assert(crc->r != NULL);
+
+	if (!crc->reusable.enabled) {
+		return false;
+	}
+
+	crc->replaying = true;
+
+	// Set again by the replayed dispatch, if any.
+	crc->timewarp.recorded = false;
+
+	return true;
+}
+
 bool
 render_compute_end(struct render_compute *crc)
 {
 	struct vk_bundle *vk = vk_from_crc(crc);
 
+	if (crc->replaying) {
+		crc->replaying = false;
+		return true;
+	}
+
 	vk->vkCmdWriteTimestamp(                  //
-	    crc->r->cmd,                          // commandBuffer
+	    crc->cmd,                             // commandBuffer
 	    VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, // pipelineStage
 	    crc->r->query_pool,                   // queryPool
 	    1);                                   // query
 
-	C(vk->vkEndCommandBuffer(crc->r->cmd));
+	C(vk->vkEndCommandBuffer(crc->cmd));
 
 	return true;
 }
@@ -422,8 +764,18 @@ render_compute_close(struct render_compute *crc)
 		crc->layer_descriptor_sets[i] = VK_NULL_HANDLE;
 	}
 
-	vk->vkResetDescriptorPool(vk->device, crc->r->compute.descriptor_pool, 0);
+	if (crc->reusable.enabled) {
+		// Frees the command buffer and descriptor sets with the pools.
+		vk->vkDestroyDescriptorPool(vk->device, crc->reusable.descriptor_pool, NULL);
+		crc->reusable.descriptor_pool = VK_NULL_HANDLE;
+		vk_cmd_pool_destroy(vk, &crc->reusable.cmd_pool);
+		crc->reusable.enabled = false;
+	} else {
+		vk->vkResetDescriptorPool(vk->device, crc->r->compute.descriptor_pool, 0);
+	}
 
+	crc->cmd = VK_NULL_HANDLE;
+	crc->replaying = false;
 	crc->r = NULL;
 }
 
@@ -440,6 +792,9 @@ render_compute_layers(struct render_compute *crc,
 {
 	assert(crc->r != NULL);
 
+	// Writes the caller's UBO between the recorded commands, can't be replayed.
+	assert(!crc->replaying);
+
 	struct vk_bundle *vk = vk_from_crc(crc);
 	struct render_resources *r = crc->r;
 
@@ -463,12 +818,12 @@ render_compute_layers(struct render_compute *crc,
 
 	VkPipeline pipeline = do_timewarp ? r->compute.layer.timewarp_pipeline : r->compute.layer.non_timewarp_pipeline;
 	vk->vkCmdBindPipeline(              //
-	    crc->r->cmd,                    // commandBuffer
+	    crc->cmd,                       // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE, // pipelineBindPoint
 	    pipeline);                      // pipeline
 
 	vk->vkCmdBindDescriptorSets(          //
-	    r->cmd,                           // commandBuffer
+	    crc->cmd,                         // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,   // pipelineBindPoint
 	    r->compute.layer.pipeline_layout, // layout
 	    0,                                // firstSet
@@ -483,7 +838,7 @@ render_compute_layers(struct render_compute *crc,
 	assert(w != 0 && h != 0);
 
 	vk->vkCmdDispatch( //
-	    r->cmd,        // commandBuffer
+	    crc->cmd,      // commandBuffer
 	    w,             // groupCountX
 	    h,             // groupCountY
 	    1);            // groupCountZ
@@ -499,11 +854,12 @@ render_compute_projection_timewarp(struct render_compute *crc,
                                    const struct xrt_pose new_poses[2],
                                    VkImage target_image,
                                    VkImageView target_image_view,
-                                   const struct render_viewport_data views[2])
+                                   const struct render_viewport_data views[2],
+                                   const struct render_compute_foveation *foveation,
+                                   const struct render_compute_overlays *overlays)
 {
 	assert(crc->r != NULL);
 
-	struct vk_bundle *vk = vk_from_crc(crc);
 	struct render_resources *r = crc->r;
 
 
@@ -533,99 +889,157 @@ render_compute_projection_timewarp(struct render_compute *crc,
 	data->transforms[1] = time_warp_matrix[1];
 	data->post_transforms[0] = src_norm_rects[0];
 	data->post_transforms[1] = src_norm_rects[1];
+	update_foveation_ubo(data, views, foveation);
+	update_overlays_ubo(data, overlays);
+
+	for (uint32_t i = 0; i < 2; i++) {
+		crc->timewarp.src_poses[i] = src_poses[i];
+		crc->timewarp.src_fovs[i] = src_fovs[i];
+	}
+	crc->timewarp.recorded = true;
+	crc->timewarp.depth = false;
+
+	// Everything below is already in the command buffer.
+	if (crc->replaying) {
+		return;
+	}
+
+	VkSampler depth_samplers[2];
+	VkImageView depth_image_views[2];
+	get_mock_depth(r, depth_samplers, depth_image_views);
+
+	record_projection_timewarp(                  //
+	    crc,                                     //
+	    r->compute.distortion.timewarp_pipeline, // pipeline
+	    src_samplers,                            //
+	    src_image_views,                         //
+	    depth_samplers,                          //
+	    depth_image_views,                       //
+	    target_image,                            //
+	    target_image_view,                       //
+	    views,                                   //
+	    foveation,                               //
+	    overlays);                               //
+}
+
+void
+render_compute_projection_depth_timewarp(struct render_compute *crc,
+                                         VkSampler src_samplers[2],
+                                         VkImageView src_image_views[2],
+                                         const struct xrt_normalized_rect src_norm_rects[2],
+                                         VkImageView depth_image_views[2],
+                                         const struct xrt_normalized_rect depth_norm_rects[2],
+                                         const struct render_depth_params depth_params[2],
+                                         const struct xrt_pose src_poses[2],
+                                         const struct xrt_fov src_fovs[2],
+                                         const struct xrt_pose new_poses[2],
+                                         VkImage target_image,
+                                         VkImageView target_image_view,
+                                         const struct render_viewport_data views[2],
+                                         const struct render_compute_foveation *foveation,
+                                         const struct render_compute_overlays *overlays)
+{
+	assert(crc->r != NULL);
+
+	struct render_resources *r = crc->r;
 
 
 	/*
-	 * Source, target and distortion images.
+	 * UBO
 	 */
 
-	VkImageSubresourceRange subresource_range = {
-	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-	    .baseMipLevel = 0,
-	    .levelCount = VK_REMAINING_MIP_LEVELS,
-	    .baseArrayLayer = 0,
-	    .layerCount = VK_REMAINING_ARRAY_LAYERS,
-	};
+	struct render_compute_distortion_ubo_data *data =
+	    (struct render_compute_distortion_ubo_data *)r->compute.distortion.ubo.mapped;
 
-	vk_cmd_image_barrier_gpu_locked( //
-	    vk,                          //
-	    r->cmd,                      //
-	    target_image,                //
-	    0,                           //
-	    VK_ACCESS_SHADER_WRITE_BIT,  //
-	    VK_IMAGE_LAYOUT_UNDEFINED,   //
-	    VK_IMAGE_LAYOUT_GENERAL,     //
-	    subresource_range);          //
+	for (uint32_t i = 0; i < 2; i++) {
+		render_calc_time_warp_depth_matrices( //
+		    &src_poses[i],                    //
+		    &src_fovs[i],                     //
+		    &new_poses[i],                    //
+		    &data->transforms[i],             //
+		    &data->depth_transforms[i]);      //
+
+		data->views[i] = views[i];
+		data->pre_transforms[i] = r->distortion.uv_to_tanangle[i];
+		data->post_transforms[i] = src_norm_rects[i];
+		data->depth_post_transforms[i] = depth_norm_rects[i];
+		data->depth_params[i] = depth_params[i];
+	}
+	update_foveation_ubo(data, views, foveation);
+	update_overlays_ubo(data, overlays);
 
-	VkSampler sampler = r->samplers.clamp_to_edge;
-	VkSampler distortion_samplers[6] = {
-	    sampler, sampler, sampler, sampler, sampler, sampler,
-	};
+	for (uint32_t i = 0; i < 2; i++) {
+		crc->timewarp.src_poses[i] = src_poses[i];
+		crc->timewarp.src_fovs[i] = src_fovs[i];
+	}
+	crc->timewarp.recorded = true;
+	crc->timewarp.depth = true;
 
-	update_compute_shared_descriptor_set( //
-	    vk,                               //
-	    r->compute.src_binding,           //
-	    src_samplers,                     //
-	    src_image_views,                  //
-	    r->compute.distortion_binding,    //
-	    distortion_samplers,              //
-	    r->distortion.image_views,        //
-	    r->compute.target_binding,        //
-	    target_image_view,                //
-	    r->compute.ubo_binding,           //
-	    r->compute.distortion.ubo.buffer, //
-	    VK_WHOLE_SIZE,                    //
-	    crc->shared_descriptor_set);      //
+	// Everything below is already in the command buffer.
+	if (crc->replaying) {
+		return;
+	}
 
-	vk->vkCmdBindPipeline(                        //
-	    r->cmd,                                   // commandBuffer
-	    VK_PIPELINE_BIND_POINT_COMPUTE,           // pipelineBindPoint
-	    r->compute.distortion.timewarp_pipeline); // pipeline
+	// Depth is read with texelFetch, the sampler is only there to fill in the descriptor.
+	VkSampler depth_samplers[2] = {
+	    r->samplers.clamp_to_edge,
+	    r->samplers.clamp_to_edge,
+	};
 
-	vk->vkCmdBindDescriptorSets(               //
-	    r->cmd,                                // commandBuffer
-	    VK_PIPELINE_BIND_POINT_COMPUTE,        // pipelineBindPoint
-	    r->compute.distortion.pipeline_layout, // layout
-	    0,                                     // firstSet
-	    1,                                     // descriptorSetCount
-	    &crc->shared_descriptor_set,           // pDescriptorSets
-	    0,                                     // dynamicOffsetCount
-	    NULL);                                 // pDynamicOffsets
+	record_projection_timewarp(                        //
+	    crc,                                           //
+	    r->compute.distortion.depth_timewarp_pipeline, // pipeline
+	    src_samplers,                                  //
+	    src_image_views,                               //
+	    depth_samplers,                                //
+	    depth_image_views,                             //
+	    target_image,                                  //
+	    target_image_view,                             //
+	    views,                                         //
+	    foveation,                                     //
+	    overlays);                                     //
+}
 
+bool
+render_compute_projection_timewarp_update(struct render_compute *crc,
+                                          const struct xrt_pose new_poses[2],
+                                          const struct render_compute_overlays *overlays)
+{
+	assert(crc->r != NULL);
 
-	uint32_t w = 0, h = 0;
-	calc_dispatch_dims_2_views(views, &w, &h);
-	assert(w != 0 && h != 0);
+	if (!crc->timewarp.recorded) {
+		return false;
+	}
 
-	vk->vkCmdDispatch( //
-	    r->cmd,        // commandBuffer
-	    w,             // groupCountX
-	    h,             // groupCountY
-	    2);            // groupCountZ
+	struct render_compute_distortion_ubo_data *data =
+	    (struct render_compute_distortion_ubo_data *)crc->r->compute.distortion.ubo.mapped;
 
-	VkImageMemoryBarrier memoryBarrier = {
-	    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-	    .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
-	    .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
-	    .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
-	    .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-	    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-	    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-	    .image = target_image,
-	    .subresourceRange = subresource_range,
-	};
+	// Host coherent memory, visible to the GPU once the command buffer is submitted.
+	for (uint32_t i = 0; i < 2; i++) {
+		if (crc->timewarp.depth) {
+			render_calc_time_warp_depth_matrices( //
+			    &crc->timewarp.src_poses[i],      //
+			    &crc->timewarp.src_fovs[i],       //
+			    &new_poses[i],                    //
+			    &data->transforms[i],             //
+			    &data->depth_transforms[i]);      //
+			continue;
+		}
+
+		render_calc_time_warp_matrix(    //
+		    &crc->timewarp.src_poses[i], //
+		    &crc->timewarp.src_fovs[i],  //
+		    &new_poses[i],               //
+		    &data->transforms[i]);       //
+	}
 
-	vk->vkCmdPipelineBarrier(                 //
-	    r->cmd,                               //
-	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, //
-	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,    //
-	    0,                                    //
-	    0,                                    //
-	    NULL,                                 //
-	    0,                                    //
-	    NULL,                                 //
-	    1,                                    //
-	    &memoryBarrier);                      //
+	// The images are bound in the recorded command buffer, only the placement changes.
+	if (overlays != NULL) {
+		assert(overlays->count == data->overlay_count.value);
+		update_overlays_ubo(data, overlays);
+	}
+
+	return true;
 }
 
 void
@@ -635,7 +1049,9 @@ render_compute_projection(struct render_compute *crc,
                           const struct xrt_normalized_rect src_norm_rects[2],
                           VkImage target_image,
                           VkImageView target_image_view,
-                          const struct render_viewport_data views[2])
+                          const struct render_viewport_data views[2],
+                          const struct render_compute_foveation *foveation,
+                          const struct render_compute_overlays *overlays)
 {
 	assert(crc->r != NULL);
 
@@ -651,8 +1067,19 @@ render_compute_projection(struct render_compute *crc,
 	    (struct render_compute_distortion_ubo_data *)r->compute.distortion.ubo.mapped;
 	data->views[0] = views[0];
 	data->views[1] = views[1];
+	data->pre_transforms[0] = r->distortion.uv_to_tanangle[0]; // For the overlays.
+	data->pre_transforms[1] = r->distortion.uv_to_tanangle[1];
 	data->post_transforms[0] = src_norm_rects[0];
 	data->post_transforms[1] = src_norm_rects[1];
+	update_foveation_ubo(data, views, foveation);
+	update_overlays_ubo(data, overlays);
+
+	// Shares the UBO, no timewarp to update anymore.
+	crc->timewarp.recorded = false;
+
+	if (crc->replaying) {
+		return;
+	}
 
 
 	/*
@@ -669,7 +1096,7 @@ render_compute_projection(struct render_compute *crc,
 
 	vk_cmd_image_barrier_gpu_locked( //
 	    vk,                          //
-	    r->cmd,                      //
+	    crc->cmd,                    //
 	    target_image,                //
 	    0,                           //
 	    VK_ACCESS_SHADER_WRITE_BIT,  //
@@ -682,6 +1109,14 @@ render_compute_projection(struct render_compute *crc,
 	    sampler, sampler, sampler, sampler, sampler, sampler,
 	};
 
+	VkSampler depth_samplers[2];
+	VkImageView depth_image_views[2];
+	get_mock_depth(r, depth_samplers, depth_image_views);
+
+	VkSampler overlay_samplers[RENDER_MAX_OVERLAYS];
+	VkImageView overlay_image_views[RENDER_MAX_OVERLAYS];
+	get_overlay_images(r, overlays, overlay_samplers, overlay_image_views);
+
 	update_compute_shared_descriptor_set( //
 	    vk,                               //
 	    r->compute.src_binding,           //
@@ -695,15 +1130,21 @@ render_compute_projection(struct render_compute *crc,
 	    r->compute.ubo_binding,           //
 	    r->compute.distortion.ubo.buffer, //
 	    VK_WHOLE_SIZE,                    //
+	    r->compute.depth_binding,         //
+	    depth_samplers,                   //
+	    depth_image_views,                //
+	    r->compute.overlay_binding,       //
+	    overlay_samplers,                 //
+	    overlay_image_views,              //
 	    crc->shared_descriptor_set);      //
 
 	vk->vkCmdBindPipeline(               //
-	    r->cmd,                          // commandBuffer
+	    crc->cmd,                        // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,  // pipelineBindPoint
 	    r->compute.distortion.pipeline); // pipeline
 
 	vk->vkCmdBindDescriptorSets(               //
-	    r->cmd,                                // commandBuffer
+	    crc->cmd,                              // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,        // pipelineBindPoint
 	    r->compute.distortion.pipeline_layout, // layout
 	    0,                                     // firstSet
@@ -713,15 +1154,15 @@ render_compute_projection(struct render_compute *crc,
 	    NULL);                                 // pDynamicOffsets
 
 
-	uint32_t w = 0, h = 0;
-	calc_dispatch_dims_2_views(views, &w, &h);
+	uint32_t w = 0, h = 0, d = 0;
+	calc_dispatch_dims_distortion(views, foveation, &w, &h, &d);
 	assert(w != 0 && h != 0);
 
 	vk->vkCmdDispatch( //
-	    r->cmd,        // commandBuffer
+	    crc->cmd,      // commandBuffer
 	    w,             // groupCountX
 	    h,             // groupCountY
-	    2);            // groupCountZ
+	    d);            // groupCountZ
 
 	VkImageMemoryBarrier memoryBarrier = {
 	    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
@@ -736,7 +1177,7 @@ render_compute_projection(struct render_compute *crc,
 	};
 
 	vk->vkCmdPipelineBarrier(                 //
-	    r->cmd,                               //
+	    crc->cmd,                             //
 	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, //
 	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,    //
 	    0,                                    //
@@ -775,6 +1216,11 @@ render_compute_clear(struct render_compute *crc,                 //
 	data->views[0] = views[0];
 	data->views[1] = views[1];
 
+	if (crc->replaying) {
+		return;
+	}
+
+
 
 	/*
 	 * Source, target and distortion images.
@@ -790,7 +1236,7 @@ render_compute_clear(struct render_compute *crc,                 //
 
 	vk_cmd_image_barrier_gpu_locked( //
 	    vk,                          //
-	    r->cmd,                      //
+	    crc->cmd,                    //
 	    target_image,                //
 	    0,                           //
 	    VK_ACCESS_SHADER_WRITE_BIT,  //
@@ -803,6 +1249,14 @@ render_compute_clear(struct render_compute *crc,                 //
 	VkImageView src_image_views[2] = {r->mock.color.image_view, r->mock.color.image_view};
 	VkSampler distortion_samplers[6] = {sampler, sampler, sampler, sampler, sampler, sampler};
 
+	VkSampler depth_samplers[2];
+	VkImageView depth_image_views[2];
+	get_mock_depth(r, depth_samplers, depth_image_views);
+
+	VkSampler overlay_samplers[RENDER_MAX_OVERLAYS];
+	VkImageView overlay_image_views[RENDER_MAX_OVERLAYS];
+	get_overlay_images(r, NULL, overlay_samplers, overlay_image_views);
+
 	update_compute_shared_descriptor_set( //
 	    vk,                               // vk_bundle
 	    r->compute.src_binding,           // src_binding
@@ -816,15 +1270,21 @@ render_compute_clear(struct render_compute *crc,                 //
 	    r->compute.ubo_binding,           // ubo_binding
 	    r->compute.clear.ubo.buffer,      // ubo_buffer
 	    VK_WHOLE_SIZE,                    // ubo_size
+	    r->compute.depth_binding,         // depth_binding
+	    depth_samplers,                   // depth_samplers[2]
+	    depth_image_views,                // depth_image_views[2]
+	    r->compute.overlay_binding,       // overlay_binding
+	    overlay_samplers,                 // overlay_samplers
+	    overlay_image_views,              // overlay_image_views
 	    crc->shared_descriptor_set);      // descriptor_set
 
 	vk->vkCmdBindPipeline(              //
-	    r->cmd,                         // commandBuffer
+	    crc->cmd,                       // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE, // pipelineBindPoint
 	    r->compute.clear.pipeline);     // pipeline
 
 	vk->vkCmdBindDescriptorSets(               //
-	    r->cmd,                                // commandBuffer
+	    crc->cmd,                              // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,        // pipelineBindPoint
 	    r->compute.distortion.pipeline_layout, // layout
 	    0,                                     // firstSet
@@ -839,7 +1299,7 @@ render_compute_clear(struct render_compute *crc,                 //
 	assert(w != 0 && h != 0);
 
 	vk->vkCmdDispatch( //
-	    r->cmd,        // commandBuffer
+	    crc->cmd,      // commandBuffer
 	    w,             // groupCountX
 	    h,             // groupCountY
 	    2);            // groupCountZ
@@ -857,7 +1317,7 @@ render_compute_clear(struct render_compute *crc,                 //
 	};
 
 	vk->vkCmdPipelineBarrier(                 //
-	    r->cmd,                               //
+	    crc->cmd,                             //
 	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, //
 	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,    //
 	    0,                                    //
@@ -7,14 +7,33 @@
  * @ingroup comp_render
  */
 
+#include "xrt/xrt_config_os.h"
 #include "xrt/xrt_device.h"
 
+#include "os/os_time.h"
+
 #include "math/m_api.h"
 #include "math/m_matrix_2x2.h"
 #include "math/m_vec2.h"
 
+#include "util/u_misc.h"
+#include "util/u_file.h"
+#include "util/u_debug.h"
+#include "util/u_worker.h"
+#include "util/u_logging.h"
+#include "util/u_time.h"
+
 #include "render/render_interface.h"
 
+#include <inttypes.h>
+#include <string.h>
+
+
+DEBUG_GET_ONCE_NUM_OPTION(distortion_threads, "XRT_COMPOSITOR_DISTORTION_THREADS", 4)
+#ifdef XRT_OS_LINUX
+DEBUG_GET_ONCE_BOOL_OPTION(distortion_cache, "XRT_COMPOSITOR_DISTORTION_CACHE", true)
+#endif
+
 
 /*
  *
@@ -56,6 +75,18 @@
 		THING = VK_NULL_HANDLE;                                                                                \
 	}
 
+//! How many bands of rows each view is split into when computing the images.
+#define DISTORTION_ROW_BANDS (16)
+
+//! Samples per axis of each view the cache key is made from.
+#define DISTORTION_CACHE_PROBES (9)
+
+#define DISTORTION_CACHE_MAGIC "MNDODIST"
+#define DISTORTION_CACHE_VERSION (1)
+#define DISTORTION_CACHE_SUBPATH "distortion"
+
+static_assert(RENDER_DISTORTION_IMAGE_DIMENSIONS % DISTORTION_ROW_BANDS == 0, "Rows must split evenly into bands!");
+
 
 /*
  *
@@ -263,19 +294,9 @@ calc_uv_to_tanangle(struct xrt_device *xdev, uint32_t view, struct xrt_normalize
 	*out_rect = transform;
 }
 
-static XRT_CHECK_RESULT VkResult
-create_and_fill_in_distortion_buffer_for_view(struct vk_bundle *vk,
-                                              struct xrt_device *xdev,
-                                              struct render_buffer *r_buffer,
-                                              struct render_buffer *g_buffer,
-                                              struct render_buffer *b_buffer,
-                                              uint32_t view,
-                                              bool pre_rotate)
+static void
+calc_view_rotation(struct xrt_device *xdev, uint32_t view, bool pre_rotate, struct xrt_matrix_2x2 *out_rot)
 {
-	VkBufferUsageFlags usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-	VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-	VkResult ret;
-
 	struct xrt_matrix_2x2 rot = xdev->hmd->views[view].rot;
 
 	const struct xrt_matrix_2x2 rotation_90_cw = {{
@@ -290,29 +311,40 @@ create_and_fill_in_distortion_buffer_for_view(struct vk_bundle *vk,
 		m_mat2x2_multiply(&rot, &rotation_90_cw, &rot);
 	}
 
-	VkDeviceSize size = sizeof(struct texture);
-
-	ret = render_buffer_init(vk, r_buffer, usage_flags, properties, size);
-	CG(vk, ret, "render_buffer_init", err_buffers);
-	ret = render_buffer_init(vk, g_buffer, usage_flags, properties, size);
-	CG(vk, ret, "render_buffer_init", err_buffers);
-	ret = render_buffer_init(vk, b_buffer, usage_flags, properties, size);
-	CG(vk, ret, "render_buffer_init", err_buffers);
+	*out_rot = rot;
+}
 
-	ret = render_buffer_map(vk, r_buffer);
-	CG(vk, ret, "render_buffer_map", err_buffers);
-	ret = render_buffer_map(vk, g_buffer);
-	CG(vk, ret, "render_buffer_map", err_buffers);
-	ret = render_buffer_map(vk, b_buffer);
-	CG(vk, ret, "render_buffer_map", err_buffers);
+/*!
+ * A band of rows of one view, the device is called for every texel so this is
+ * what is spread out over the worker threads.
+ */
+struct distortion_rows_task
+{
+	struct xrt_device *xdev;
+	struct xrt_matrix_2x2 rot;
+	uint32_t view;
+	uint32_t row_start;
+	uint32_t row_count;
+
+	struct texture *r;
+	struct texture *g;
+	struct texture *b;
+};
 
-	struct texture *r = r_buffer->mapped;
-	struct texture *g = g_buffer->mapped;
-	struct texture *b = b_buffer->mapped;
+static void
+fill_in_rows(void *ptr)
+{
+	struct distortion_rows_task *task = (struct distortion_rows_task *)ptr;
+	struct texture *r = task->r;
+	struct texture *g = task->g;
+	struct texture *b = task->b;
 
 	const double dim_minus_one_f64 = RENDER_DISTORTION_IMAGE_DIMENSIONS - 1;
 
-	for (int row = 0; row < RENDER_DISTORTION_IMAGE_DIMENSIONS; row++) {
+	struct xrt_vec2 uvs[RENDER_DISTORTION_IMAGE_DIMENSIONS];
+	struct xrt_uv_triplet results[RENDER_DISTORTION_IMAGE_DIMENSIONS];
+
+	for (uint32_t row = task->row_start; row < task->row_start + task->row_count; row++) {
 		// This goes from 0 to 1.0 inclusive.
 		float v = (float)(row / dim_minus_one_f64);
 
@@ -322,31 +354,244 @@ create_and_fill_in_distortion_buffer_for_view(struct vk_bundle *vk,
 
 			// These need to go from -0.5 to 0.5 for the rotation
 			struct xrt_vec2 uv = {u - 0.5f, v - 0.5f};
-			m_mat2x2_transform_vec2(&rot, &uv, &uv);
+			m_mat2x2_transform_vec2(&task->rot, &uv, &uv);
 			uv.x += 0.5f;
 			uv.y += 0.5f;
 
-			struct xrt_uv_triplet result;
-			xrt_device_compute_distortion(xdev, view, uv.x, uv.y, &result);
+			uvs[col] = uv;
+		}
+
+		xrt_device_compute_distortion_batch(    //
+		    task->xdev,                         // xdev
+		    task->view,                         // view
+		    RENDER_DISTORTION_IMAGE_DIMENSIONS, // count
+		    uvs,                                // uvs
+		    results);                           // out_results
 
-			r->pixels[row][col] = result.r;
-			g->pixels[row][col] = result.g;
-			b->pixels[row][col] = result.b;
+		for (int col = 0; col < RENDER_DISTORTION_IMAGE_DIMENSIONS; col++) {
+			r->pixels[row][col] = results[col].r;
+			g->pixels[row][col] = results[col].g;
+			b->pixels[row][col] = results[col].b;
 		}
 	}
+}
 
-	render_buffer_unmap(vk, r_buffer);
-	render_buffer_unmap(vk, g_buffer);
-	render_buffer_unmap(vk, b_buffer);
+/*!
+ * Computes all of the distortion images, the textures are in the same order
+ * as the images: red of both views, then green and then blue.
+ */
+static void
+compute_distortion(struct xrt_device *xdev, bool pre_rotate, struct texture *textures[RENDER_DISTORTION_NUM_IMAGES])
+{
+	struct distortion_rows_task tasks[2 * DISTORTION_ROW_BANDS];
+	const uint32_t rows_per_band = RENDER_DISTORTION_IMAGE_DIMENSIONS / DISTORTION_ROW_BANDS;
+	uint32_t task_count = 0;
+
+	for (uint32_t view = 0; view < 2; view++) {
+		struct xrt_matrix_2x2 rot;
+		calc_view_rotation(xdev, view, pre_rotate, &rot);
+
+		for (uint32_t band = 0; band < DISTORTION_ROW_BANDS; band++) {
+			struct distortion_rows_task *task = &tasks[task_count++];
+			task->xdev = xdev;
+			task->rot = rot;
+			task->view = view;
+			task->row_start = band * rows_per_band;
+			task->row_count = rows_per_band;
+			task->r = textures[view + 0];
+			task->g = textures[view + 2];
+			task->b = textures[view + 4];
+		}
+	}
 
-	return VK_SUCCESS;
+	// The calling thread helps out while waiting.
+	struct u_worker_thread_pool *pool = NULL;
+	if (xdev->compute_distortion_thread_safe) {
+		pool = u_worker_thread_pool_create_helped(debug_get_num_option_distortion_threads(), "Distortion");
+	}
+
+	if (pool == NULL) {
+		for (uint32_t i = 0; i < task_count; i++) {
+			fill_in_rows(&tasks[i]);
+		}
+		return;
+	}
 
-err_buffers:
-	render_buffer_close(vk, r_buffer);
-	render_buffer_close(vk, g_buffer);
-	render_buffer_close(vk, b_buffer);
+	struct u_worker_group *group = u_worker_group_create(pool);
+	for (uint32_t i = 0; i < task_count; i++) {
+		u_worker_group_push(group, fill_in_rows, &tasks[i]);
+	}
+	u_worker_group_wait_all(group);
 
-	return ret;
+	u_worker_group_reference(&group, NULL);
+	u_worker_thread_pool_reference(&pool, NULL);
+}
+
+
+/*
+ *
+ * Disk cache.
+ *
+ */
+
+#ifdef XRT_OS_LINUX
+
+struct distortion_cache_header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t dimensions;
+	uint64_t key;
+};
+
+/*!
+ * Everything the distortion images depend on. The device doesn't expose its
+ * calibration, so it is sampled on a coarse grid, any change in it should
+ * change at least one of the samples.
+ */
+struct distortion_cache_key_data
+{
+	char str[XRT_DEVICE_NAME_LEN];
+	char serial[XRT_DEVICE_NAME_LEN];
+	uint32_t version;
+	uint32_t dimensions;
+	uint32_t pre_rotate;
+	struct xrt_fov fovs[2];
+	struct xrt_matrix_2x2 rots[2];
+	struct xrt_uv_triplet probes[2][DISTORTION_CACHE_PROBES][DISTORTION_CACHE_PROBES];
+};
+
+static uint64_t
+calc_cache_key(struct xrt_device *xdev, bool pre_rotate)
+{
+	// Zeroed so the padding and string tails hash the same every time.
+	struct distortion_cache_key_data *data = U_TYPED_CALLOC(struct distortion_cache_key_data);
+
+	snprintf(data->str, sizeof(data->str), "%s", xdev->str);
+	snprintf(data->serial, sizeof(data->serial), "%s", xdev->serial);
+	data->version = DISTORTION_CACHE_VERSION;
+	data->dimensions = RENDER_DISTORTION_IMAGE_DIMENSIONS;
+	data->pre_rotate = pre_rotate;
+
+	for (uint32_t view = 0; view < 2; view++) {
+		data->fovs[view] = xdev->hmd->distortion.fov[view];
+		calc_view_rotation(xdev, view, pre_rotate, &data->rots[view]);
+
+		for (uint32_t y = 0; y < DISTORTION_CACHE_PROBES; y++) {
+			for (uint32_t x = 0; x < DISTORTION_CACHE_PROBES; x++) {
+				float u = (float)x / (DISTORTION_CACHE_PROBES - 1);
+				float v = (float)y / (DISTORTION_CACHE_PROBES - 1);
+				xrt_device_compute_distortion(xdev, view, u, v, &data->probes[view][y][x]);
+			}
+		}
+	}
+
+	uint64_t key = (uint64_t)math_hash_string((const char *)data, sizeof(*data));
+
+	free(data);
+
+	return key;
+}
+
+static void
+get_cache_filename(uint64_t key, char *out_filename, size_t out_filename_size)
+{
+	snprintf(out_filename, out_filename_size, "%016" PRIx64 ".bin", key);
+}
+
+static bool
+read_cache(uint64_t key, struct texture *textures[RENDER_DISTORTION_NUM_IMAGES])
+{
+	char filename[32];
+	get_cache_filename(key, filename, sizeof(filename));
+
+	FILE *file = u_file_open_file_in_cache_dir_subpath(DISTORTION_CACHE_SUBPATH, filename, "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	struct distortion_cache_header header = {0};
+	bool ok = fread(&header, sizeof(header), 1, file) == 1 &&                         //
+	          memcmp(header.magic, DISTORTION_CACHE_MAGIC, sizeof(header.magic)) == 0 && //
+	          header.version == DISTORTION_CACHE_VERSION &&                            //
+	          header.dimensions == RENDER_DISTORTION_IMAGE_DIMENSIONS &&               //
+	          header.key == key;                                                       //
+
+	for (uint32_t i = 0; ok && i < RENDER_DISTORTION_NUM_IMAGES; i++) {
+		ok = fread(textures[i], sizeof(struct texture), 1, file) == 1;
+	}
+
+	fclose(file);
+
+	if (!ok) {
+		U_LOG_W("Ignoring invalid distortion cache file '%s'", filename);
+	}
+
+	return ok;
+}
+
+static void
+write_cache(uint64_t key, struct texture *textures[RENDER_DISTORTION_NUM_IMAGES])
+{
+	char filename[32];
+	get_cache_filename(key, filename, sizeof(filename));
+
+	FILE *file = u_file_open_file_in_cache_dir_subpath(DISTORTION_CACHE_SUBPATH, filename, "wb");
+	if (file == NULL) {
+		U_LOG_W("Could not open distortion cache file '%s' for writing", filename);
+		return;
+	}
+
+	struct distortion_cache_header header = {0};
+	header.version = DISTORTION_CACHE_VERSION;
+	header.dimensions = RENDER_DISTORTION_IMAGE_DIMENSIONS;
+	header.key = key;
+
+	// The magic is written last, so a partially written file is never used.
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	for (uint32_t i = 0; ok && i < RENDER_DISTORTION_NUM_IMAGES; i++) {
+		ok = fwrite(textures[i], sizeof(struct texture), 1, file) == 1;
+	}
+
+	if (ok) {
+		memcpy(header.magic, DISTORTION_CACHE_MAGIC, sizeof(header.magic));
+		ok = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+	}
+
+	if (fclose(file) != 0 || !ok) {
+		U_LOG_W("Failed to write distortion cache file '%s'", filename);
+	}
+}
+
+#endif /* XRT_OS_LINUX */
+
+static void
+fill_in_distortion(struct xrt_device *xdev, bool pre_rotate, struct texture *textures[RENDER_DISTORTION_NUM_IMAGES])
+{
+#ifdef XRT_OS_LINUX
+	bool use_cache = debug_get_bool_option_distortion_cache();
+	uint64_t key = 0;
+
+	if (use_cache) {
+		key = calc_cache_key(xdev, pre_rotate);
+		if (read_cache(key, textures)) {
+			U_LOG_D("Read distortion images from cache, key %016" PRIx64, key);
+			return;
+		}
+	}
+#endif
+
+	uint64_t start_ns = os_monotonic_get_ns();
+	compute_distortion(xdev, pre_rotate, textures);
+	uint64_t end_ns = os_monotonic_get_ns();
+
+	U_LOG_D("Computed distortion images in %.1fms", time_ns_to_ms_f(end_ns - start_ns));
+
+#ifdef XRT_OS_LINUX
+	if (use_cache) {
+		write_cache(key, textures);
+	}
+#endif
 }
 
 static bool
@@ -355,10 +600,10 @@ render_distortion_buffer_init(struct render_resources *r,
                               struct xrt_device *xdev,
                               bool pre_rotate)
 {
-	struct render_buffer bufs[RENDER_DISTORTION_NUM_IMAGES];
-	VkDeviceMemory device_memories[RENDER_DISTORTION_NUM_IMAGES];
-	VkImage images[RENDER_DISTORTION_NUM_IMAGES];
-	VkImageView image_views[RENDER_DISTORTION_NUM_IMAGES];
+	struct render_buffer bufs[RENDER_DISTORTION_NUM_IMAGES] = {0};
+	VkDeviceMemory device_memories[RENDER_DISTORTION_NUM_IMAGES] = {0};
+	VkImage images[RENDER_DISTORTION_NUM_IMAGES] = {0};
+	VkImageView image_views[RENDER_DISTORTION_NUM_IMAGES] = {0};
 	VkCommandBuffer upload_buffer = VK_NULL_HANDLE;
 	VkResult ret;
 
@@ -377,11 +622,25 @@ render_distortion_buffer_init(struct render_resources *r,
 	 * Buffers with data to upload.
 	 */
 
-	ret = create_and_fill_in_distortion_buffer_for_view(vk, xdev, &bufs[0], &bufs[2], &bufs[4], 0, pre_rotate);
-	CG(vk, ret, "create_and_fill_in_distortion_buffer_for_view", err_resources);
+	VkBufferUsageFlags usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	struct texture *textures[RENDER_DISTORTION_NUM_IMAGES];
+
+	for (uint32_t i = 0; i < RENDER_DISTORTION_NUM_IMAGES; i++) {
+		ret = render_buffer_init(vk, &bufs[i], usage_flags, properties, sizeof(struct texture));
+		CG(vk, ret, "render_buffer_init", err_resources);
+
+		ret = render_buffer_map(vk, &bufs[i]);
+		CG(vk, ret, "render_buffer_map", err_resources);
+
+		textures[i] = bufs[i].mapped;
+	}
 
-	ret = create_and_fill_in_distortion_buffer_for_view(vk, xdev, &bufs[1], &bufs[3], &bufs[5], 1, pre_rotate);
-	CG(vk, ret, "create_and_fill_in_distortion_buffer_for_view", err_resources);
+	fill_in_distortion(xdev, pre_rotate, textures);
+
+	for (uint32_t i = 0; i < RENDER_DISTORTION_NUM_IMAGES; i++) {
+		render_buffer_unmap(vk, &bufs[i]);
+	}
 
 
 	/*
@@ -417,6 +676,7 @@ render_distortion_buffer_init(struct render_resources *r,
 	 */
 
 	r->distortion.pre_rotated = pre_rotate;
+	r->distortion.generation++;
 
 	for (uint32_t i = 0; i < RENDER_DISTORTION_NUM_IMAGES; i++) {
 		r->distortion.device_memories[i] = device_memories[i];
@@ -0,0 +1,101 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Tile and fovea maths for the foveated compute distortion, kept free
+ *         of Vulkan so it can be tested on its own.
+ * @ingroup comp_render
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+#include "xrt/xrt_defines.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Parameters for foveated distortion, the area around the fovea center of each
+ * view is distorted at full rate while the periphery is sampled once per tile.
+ */
+struct render_compute_foveation
+{
+	//! Size in pixels of the periphery tiles, foveation is off if less than 2.
+	uint32_t tile_size;
+
+	//! Fraction of the view width and height that is done at full rate.
+	float full_rate_fraction;
+
+	//! Center of the fovea per view, normalized [0 .. 1] in the view.
+	struct xrt_vec2 centers[2];
+};
+
+/*!
+ * Is foveation turned on, @p foveation may be NULL.
+ *
+ * @ingroup comp_render
+ */
+static inline bool
+render_foveation_is_enabled(const struct render_compute_foveation *foveation)
+{
+	return foveation != NULL && foveation->tile_size >= 2 && foveation->full_rate_fraction < 1.0f;
+}
+
+/*!
+ * Width or height of the full rate area, only depends on the view so recorded
+ * command buffers can be replayed with a moved fovea center. Rounded up to
+ * whole tiles and capped to the view.
+ *
+ * @ingroup comp_render
+ */
+static inline uint32_t
+render_foveation_calc_extent(uint32_t view_extent, uint32_t tile_size, float fraction)
+{
+	uint32_t extent = (uint32_t)(fraction > 0.0f ? fraction * (float)view_extent : 0.0f);
+	extent = (extent + tile_size - 1) / tile_size * tile_size;
+
+	return extent < view_extent ? extent : view_extent;
+}
+
+/*!
+ * X or y of the full rate area, centered on @p center as far as the view
+ * allows and lined up with the tiles, so tiles are either fully in or out.
+ *
+ * @ingroup comp_render
+ */
+static inline uint32_t
+render_foveation_calc_offset(uint32_t view_extent, uint32_t extent, uint32_t tile_size, float center)
+{
+	float offset = center * (float)view_extent - (float)extent / 2.0f;
+	float max_offset = (float)(view_extent - extent);
+
+	offset = offset < 0.0f ? 0.0f : offset;
+	offset = offset > max_offset ? max_offset : offset;
+
+	uint32_t ret = (uint32_t)offset;
+	return ret - ret % tile_size;
+}
+
+/*!
+ * Number of invocations along one axis that a foveated view needs, enough
+ * for both the full rate area and one per periphery tile.
+ *
+ * @ingroup comp_render
+ */
+static inline uint32_t
+render_foveation_calc_invocations(uint32_t view_extent, uint32_t tile_size, float fraction)
+{
+	uint32_t tiles = (view_extent + tile_size - 1) / tile_size;
+	uint32_t fovea = render_foveation_calc_extent(view_extent, tile_size, fraction);
+
+	return tiles > fovea ? tiles : fovea;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
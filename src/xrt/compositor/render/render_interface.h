@@ -16,6 +16,8 @@
 #include "vk/vk_helpers.h"
 #include "vk/vk_cmd_pool.h"
 
+#include "render/render_foveation.h"
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -61,6 +63,12 @@ extern "C" {
  */
 #define RENDER_MAX_LAYER_RUNS (2)
 
+/*!
+ * Max number of quad layers the distortion shader can composite on top of the
+ * projection layer, see @ref render_compute_overlays.
+ */
+#define RENDER_MAX_OVERLAYS (4)
+
 //! How large in pixels the distortion image is.
 #define RENDER_DISTORTION_IMAGE_DIMENSIONS (128)
 
@@ -84,6 +92,47 @@ render_calc_time_warp_matrix(const struct xrt_pose *src_pose,
                              const struct xrt_pose *new_pose,
                              struct xrt_matrix_4x4 *matrix);
 
+/*!
+ * Like @ref render_calc_time_warp_matrix but also corrects for the difference
+ * in position, so it needs to know how far away the seen point is. The
+ * @p matrix takes a point in the new view space and gives out results in
+ * [-1, 1] space that needs a perspective divide, @p new_to_src takes the same
+ * point into the source view space.
+ */
+void
+render_calc_time_warp_depth_matrices(const struct xrt_pose *src_pose,
+                                     const struct xrt_fov *src_fov,
+                                     const struct xrt_pose *new_pose,
+                                     struct xrt_matrix_4x4 *matrix,
+                                     struct xrt_matrix_4x4 *new_to_src);
+
+/*!
+ * What is needed to turn a value sampled from a depth layer into the distance
+ * along the -Z axis of the view, see @ref render_calc_depth_params.
+ */
+struct render_depth_params
+{
+	//! Scale and offset the sampled value to [0, 1] between near and far.
+	float scale;
+	float offset;
+
+	//! 1 / near_z, zero if infinite.
+	float inv_near;
+
+	//! 1 / far_z - 1 / near_z, works for both reversed and infinite depth.
+	float inv_delta;
+};
+
+/*!
+ * Fill in @p out_params from the depth info of a projection layer, the
+ * distance for a sampled value `d` is then `1 / (inv_near + (d * scale +
+ * offset) * inv_delta)`.
+ *
+ * @return false if the depth info can not be used for reprojection.
+ */
+bool
+render_calc_depth_params(const struct xrt_layer_depth_data *depth, struct render_depth_params *out_params);
+
 
 /*
  *
@@ -239,7 +288,7 @@ struct render_resources
 	//! Pool used for distortion image uploads.
 	struct vk_cmd_pool distortion_pool;
 
-	//! Shared for all rendering.
+	//! Shared for all rendering, not owned, same as @ref vk_bundle::pipeline_cache.
 	VkPipelineCache pipeline_cache;
 
 	VkCommandPool cmd_pool;
@@ -330,6 +379,12 @@ struct render_resources
 		//! Uniform data binding.
 		uint32_t ubo_binding;
 
+		//! Depth of the source projection views, only read when reprojecting with depth.
+		uint32_t depth_binding;
+
+		//! Images of the quads composited by the distortion shader.
+		uint32_t overlay_binding;
+
 		struct
 		{
 			//! Descriptor set layout for compute.
@@ -365,6 +420,9 @@ struct render_resources
 			//! Doesn't depend on target so is static.
 			VkPipeline timewarp_pipeline;
 
+			//! Timewarp that also corrects for position using depth.
+			VkPipeline depth_timewarp_pipeline;
+
 			//! Target info.
 			struct render_buffer ubo;
 		} distortion;
@@ -397,6 +455,9 @@ struct render_resources
 
 		//! Whether distortion images have been pre-rotated 90 degrees.
 		bool pre_rotated;
+
+		//! Bumped every time the images are recreated, for anything holding on to the views.
+		uint64_t generation;
 	} distortion;
 };
 
@@ -422,7 +483,9 @@ void
 render_resources_close(struct render_resources *r);
 
 /*!
- * Creates or recreates the compute distortion textures if necessary.
+ * Creates or recreates the compute distortion textures if necessary. The
+ * contents are computed in parallel and cached on disk, keyed on the device
+ * and its distortion, so later starts only have to read them back.
  */
 bool
 render_distortion_images_ensure(struct render_resources *r,
@@ -806,6 +869,24 @@ struct render_compute
 	//! Shared resources.
 	struct render_resources *r;
 
+	//! Command buffer recorded into, @ref render_resources::cmd unless reusable.
+	VkCommandBuffer cmd;
+
+	/*!
+	 * Own command buffer and descriptor sets, created by
+	 * @ref render_compute_init_reusable so the recorded command buffer can
+	 * be submitted again on later frames.
+	 */
+	struct
+	{
+		bool enabled;
+		struct vk_cmd_pool cmd_pool;
+		VkDescriptorPool descriptor_pool;
+	} reusable;
+
+	//! Only the UBOs are written, see @ref render_compute_begin_replay.
+	bool replaying;
+
 	//! Layer descriptor set.
 	VkDescriptorSet layer_descriptor_sets[RENDER_MAX_LAYER_RUNS];
 
@@ -815,6 +896,20 @@ struct render_compute
 	 * @ref render_compute_projection and @ref render_compute_clear.
 	 */
 	VkDescriptorSet shared_descriptor_set;
+
+	/*!
+	 * What the recorded @ref render_compute_projection_timewarp used, so
+	 * the timewarp can be redone with newer poses before submitting, see
+	 * @ref render_compute_projection_timewarp_update.
+	 */
+	struct
+	{
+		bool recorded;
+		//! Recorded with @ref render_compute_projection_depth_timewarp.
+		bool depth;
+		struct xrt_pose src_poses[2];
+		struct xrt_fov src_fovs[2];
+	} timewarp;
 };
 
 /*!
@@ -894,6 +989,59 @@ struct render_compute_layer_ubo_data
 	} quad_extent[RENDER_MAX_LAYERS];
 };
 
+/*!
+ * One quad composited by the distortion shader in one view, all transforms and
+ * coordinates are in the view space of the target view. Same as the quad data
+ * in @ref render_compute_layer_ubo_data.
+ */
+struct render_compute_overlay_data
+{
+	struct xrt_matrix_4x4 inverse_quad_transform;
+
+	struct
+	{
+		struct xrt_vec3 val;
+		float padding;
+	} quad_position;
+
+	struct
+	{
+		struct xrt_vec3 val;
+		float padding;
+	} quad_normal;
+
+	//! Quad extent in world scale.
+	struct
+	{
+		struct xrt_vec2 val;
+		float padding[2];
+	} quad_extent;
+
+	//! Sub image of the quad.
+	struct xrt_normalized_rect post_transform;
+
+	//! std140 uvec4.
+	struct
+	{
+		uint32_t visible;
+		uint32_t unpremultiplied;
+		uint32_t padding[2];
+	} flags;
+};
+
+/*!
+ * Quad layers that the distortion shader composites on top of the projection
+ * layer, in order, instead of squashing them into the scratch images first.
+ * The quads are sampled along the distorted ray of each colour channel.
+ */
+struct render_compute_overlays
+{
+	uint32_t count;
+	VkSampler samplers[RENDER_MAX_OVERLAYS];
+	VkImageView image_views[RENDER_MAX_OVERLAYS];
+	struct render_compute_overlay_data data[RENDER_MAX_OVERLAYS][2];
+};
+
 /*!
  * UBO data that is sent to the compute distortion shaders.
  *
@@ -905,6 +1053,34 @@ struct render_compute_distortion_ubo_data
 	struct xrt_normalized_rect pre_transforms[2];
 	struct xrt_normalized_rect post_transforms[2];
 	struct xrt_matrix_4x4 transforms[2];
+
+	//! Full rate area of each view, relative to the view.
+	struct render_viewport_data fovea[2];
+
+	struct
+	{
+		//! Size of the tiles the periphery is sampled in, zero if off.
+		uint32_t tile_size;
+		uint32_t padding[3];
+	} foveation;
+
+	//! From the new view space to the source view space, depth reprojection only.
+	struct xrt_matrix_4x4 depth_transforms[2];
+
+	//! Sub image of the depth images, depth reprojection only.
+	struct xrt_normalized_rect depth_post_transforms[2];
+
+	//! Depth reprojection only.
+	struct render_depth_params depth_params[2];
+
+	//! Number of quads composited on top, see @ref render_compute_overlays.
+	struct
+	{
+		uint32_t value;
+		uint32_t padding[3];
+	} overlay_count;
+
+	struct render_compute_overlay_data overlays[RENDER_MAX_OVERLAYS][2];
 };
 
 /*!
@@ -915,6 +1091,18 @@ struct render_compute_distortion_ubo_data
 bool
 render_compute_init(struct render_compute *crc, struct render_resources *r);
 
+/*!
+ * Like @ref render_compute_init but with its own command buffer and
+ * descriptor pool, the command buffer is not reset by other users of
+ * @ref render_resources and can be replayed with
+ * @ref render_compute_begin_replay as long as the images it was recorded
+ * with are alive.
+ *
+ * @public @memberof render_compute
+ */
+bool
+render_compute_init_reusable(struct render_compute *crc, struct render_resources *r);
+
 /*!
  * Frees all resources held by the compute rendering, does not free the struct itself.
  *
@@ -932,6 +1120,22 @@ render_compute_close(struct render_compute *crc);
 bool
 render_compute_begin(struct render_compute *crc);
 
+/*!
+ * Begin replaying the command buffer recorded by the last
+ * @ref render_compute_begin and @ref render_compute_end pair. Must be followed
+ * by the exact same dispatch calls as the recording, they only write their
+ * UBOs, which the command buffer reads when submitted again. The caller must
+ * make sure the GPU is done with the last submit of the command buffer.
+ *
+ * Only for a render_compute created with @ref render_compute_init_reusable,
+ * and @ref render_compute_layers can not be replayed since it takes the UBO
+ * from the caller.
+ *
+ * @public @memberof render_compute
+ */
+bool
+render_compute_begin_replay(struct render_compute *crc);
+
 /*!
  * Frees any unneeded resources and ends the command buffer so it can be used,
  * also unlocks the vk_bundle's pool lock that was taken by begin.
@@ -965,6 +1169,9 @@ render_compute_layers(struct render_compute *crc,                     //
                       bool timewarp);                                 //
 
 /*!
+ * The @p foveation is optional, without it the views are distorted at full rate.
+ * The @p overlays are optional, the quads are placed with @p new_poses.
+ *
  * @public @memberof render_compute
  */
 void
@@ -977,19 +1184,75 @@ render_compute_projection_timewarp(struct render_compute *crc,
                                    const struct xrt_pose new_poses[2],
                                    VkImage target_image,
                                    VkImageView target_image_view,
-                                   const struct render_viewport_data views[2]);
+                                   const struct render_viewport_data views[2],
+                                   const struct render_compute_foveation *foveation,
+                                   const struct render_compute_overlays *overlays);
 
 /*!
+ * Redo the timewarp of the already recorded
+ * @ref render_compute_projection_timewarp with @p new_poses. The UBO is
+ * persistently mapped and read when the GPU runs the command buffer, so this
+ * can be called right up until it is submitted, but not before the GPU is
+ * done with the previous use of the UBO.
+ *
+ * The optional @p overlays must have the same count and images as the ones
+ * recorded, only the placement of the quads is updated.
+ *
+ * @return false if no timewarp has been recorded.
+ *
+ * @public @memberof render_compute
+ */
+bool
+render_compute_projection_timewarp_update(struct render_compute *crc,
+                                          const struct xrt_pose new_poses[2],
+                                          const struct render_compute_overlays *overlays);
+
+/*!
+ * Like @ref render_compute_projection_timewarp but also corrects for the
+ * position of the head using the depth of the projection layer: every pixel
+ * is reprojected to where the surface seen through it has moved to. Parts of
+ * the view that were not visible in the source are filled in by stretching
+ * the nearby pixels. The depth images are read with
+ * VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, same as the colour images.
+ *
+ * Can be redone with newer poses with
+ * @ref render_compute_projection_timewarp_update.
+ *
+ * @public @memberof render_compute
+ */
+void
+render_compute_projection_depth_timewarp(struct render_compute *crc,
+                                         VkSampler src_samplers[2],
+                                         VkImageView src_image_views[2],
+                                         const struct xrt_normalized_rect src_rects[2],
+                                         VkImageView depth_image_views[2],
+                                         const struct xrt_normalized_rect depth_rects[2],
+                                         const struct render_depth_params depth_params[2],
+                                         const struct xrt_pose src_poses[2],
+                                         const struct xrt_fov src_fovs[2],
+                                         const struct xrt_pose new_poses[2],
+                                         VkImage target_image,
+                                         VkImageView target_image_view,
+                                         const struct render_viewport_data views[2],
+                                         const struct render_compute_foveation *foveation,
+                                         const struct render_compute_overlays *overlays);
+
+/*!
+ * The @p foveation is optional, without it the views are distorted at full rate.
+ * The @p overlays are optional.
+ *
  * @public @memberof render_compute
  */
 void
-render_compute_projection(struct render_compute *crc,                    //
-                          VkSampler src_samplers[2],                     //
-                          VkImageView src_image_views[2],                //
-                          const struct xrt_normalized_rect src_rects[2], //
-                          VkImage target_image,                          //
-                          VkImageView target_image_view,                 //
-                          const struct render_viewport_data views[2]);   //
+render_compute_projection(struct render_compute *crc,                        //
+                          VkSampler src_samplers[2],                         //
+                          VkImageView src_image_views[2],                    //
+                          const struct xrt_normalized_rect src_rects[2],     //
+                          VkImage target_image,                              //
+                          VkImageView target_image_view,                     //
+                          const struct render_viewport_data views[2],        //
+                          const struct render_compute_foveation *foveation,  //
+                          const struct render_compute_overlays *overlays);   //
 
 /*!
  * @public @memberof render_compute
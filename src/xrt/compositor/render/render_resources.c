@@ -266,11 +266,13 @@ create_compute_distortion_descriptor_set_layout(struct vk_bundle *vk,
                                                 uint32_t distortion_binding,
                                                 uint32_t target_binding,
                                                 uint32_t ubo_binding,
+                                                uint32_t depth_binding,
+                                                uint32_t overlay_binding,
                                                 VkDescriptorSetLayout *out_descriptor_set_layout)
 {
 	VkResult ret;
 
-	VkDescriptorSetLayoutBinding set_layout_bindings[4] = {
+	VkDescriptorSetLayoutBinding set_layout_bindings[6] = {
 	    {
 	        .binding = src_binding,
 	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
@@ -295,6 +297,18 @@ create_compute_distortion_descriptor_set_layout(struct vk_bundle *vk,
 	        .descriptorCount = 1,
 	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
 	    },
+	    {
+	        .binding = depth_binding,
+	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	        .descriptorCount = 2,
+	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	    },
+	    {
+	        .binding = overlay_binding,
+	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	        .descriptorCount = RENDER_MAX_OVERLAYS,
+	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	    },
 	};
 
 	VkDescriptorSetLayoutCreateInfo set_layout_info = {
@@ -331,6 +345,8 @@ struct compute_distortion_params
 {
 	uint32_t distortion_texel_count;
 	VkBool32 do_timewarp;
+	VkBool32 do_depth_timewarp;
+	uint32_t max_overlays;
 };
 
 static VkResult
@@ -387,9 +403,11 @@ create_compute_distortion_pipeline(struct vk_bundle *vk,
 	    sizeof(params->FIELD),                                                                                     \
 	}
 
-	VkSpecializationMapEntry entries[2] = {
+	VkSpecializationMapEntry entries[4] = {
 	    ENTRY(0, distortion_texel_count),
 	    ENTRY(1, do_timewarp),
+	    ENTRY(2, do_depth_timewarp),
+	    ENTRY(3, max_overlays),
 	};
 #undef ENTRY
 
@@ -558,6 +576,8 @@ render_resources_init(struct render_resources *r,
 	r->compute.distortion_binding = 1;
 	r->compute.target_binding = 2;
 	r->compute.ubo_binding = 3;
+	r->compute.depth_binding = 4;
+	r->compute.overlay_binding = 5;
 
 	r->compute.layer.image_array_size = vk->features.max_per_stage_descriptor_sampled_images;
 	if (r->compute.layer.image_array_size > RENDER_MAX_IMAGES) {
@@ -657,7 +677,8 @@ render_resources_init(struct render_resources *r,
 	 * Shared
 	 */
 
-	C(vk_create_pipeline_cache(vk, &r->pipeline_cache));
+	// Owned by the bundle, which keeps it on disk between runs.
+	r->pipeline_cache = vk->pipeline_cache;
 
 	VkCommandBufferAllocateInfo cmd_buffer_info = {
 	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
@@ -733,8 +754,8 @@ render_resources_init(struct render_resources *r,
 
 	struct vk_descriptor_pool_info compute_pool_info = {
 	    .uniform_per_descriptor_count = 1,
-	    // layer images
-	    .sampler_per_descriptor_count = r->compute.layer.image_array_size + 6,
+	    // layer images, plus distortion, depth and overlay images
+	    .sampler_per_descriptor_count = r->compute.layer.image_array_size + 6 + 2 + RENDER_MAX_OVERLAYS,
 	    .storage_image_per_descriptor_count = 1,
 	    .storage_buffer_per_descriptor_count = 0,
 	    .descriptor_count = compute_descriptor_count,
@@ -819,6 +840,8 @@ render_resources_init(struct render_resources *r,
 	    r->compute.distortion_binding,                  // distortion_binding,
 	    r->compute.target_binding,                      // target_binding,
 	    r->compute.ubo_binding,                         // ubo_binding,
+	    r->compute.depth_binding,                       // depth_binding,
+	    r->compute.overlay_binding,                     // overlay_binding,
 	    &r->compute.distortion.descriptor_set_layout)); // out_descriptor_set_layout
 
 	C(vk_create_pipeline_layout(                     //
@@ -829,6 +852,8 @@ render_resources_init(struct render_resources *r,
 	struct compute_distortion_params distortion_params = {
 	    .distortion_texel_count = RENDER_DISTORTION_IMAGE_DIMENSIONS,
 	    .do_timewarp = false,
+	    .do_depth_timewarp = false,
+	    .max_overlays = RENDER_MAX_OVERLAYS,
 	};
 
 	C(create_compute_distortion_pipeline(      //
@@ -842,6 +867,8 @@ render_resources_init(struct render_resources *r,
 	struct compute_distortion_params distortion_timewarp_params = {
 	    .distortion_texel_count = RENDER_DISTORTION_IMAGE_DIMENSIONS,
 	    .do_timewarp = true,
+	    .do_depth_timewarp = false,
+	    .max_overlays = RENDER_MAX_OVERLAYS,
 	};
 
 	C(create_compute_distortion_pipeline(           //
@@ -852,6 +879,21 @@ render_resources_init(struct render_resources *r,
 	    &distortion_timewarp_params,                // params
 	    &r->compute.distortion.timewarp_pipeline)); // out_compute_pipeline
 
+	struct compute_distortion_params distortion_depth_timewarp_params = {
+	    .distortion_texel_count = RENDER_DISTORTION_IMAGE_DIMENSIONS,
+	    .do_timewarp = true,
+	    .do_depth_timewarp = true,
+	    .max_overlays = RENDER_MAX_OVERLAYS,
+	};
+
+	C(create_compute_distortion_pipeline(                 //
+	    vk,                                               // vk_bundle
+	    r->pipeline_cache,                                // pipeline_cache
+	    r->shaders->distortion_comp,                      // shader
+	    r->compute.distortion.pipeline_layout,            // pipeline_layout
+	    &distortion_depth_timewarp_params,                // params
+	    &r->compute.distortion.depth_timewarp_pipeline)); // out_compute_pipeline
+
 	size_t distortion_ubo_size = sizeof(struct render_compute_distortion_ubo_data);
 
 	C(render_buffer_init(             //
@@ -954,7 +996,6 @@ render_resources_close(struct render_resources *r)
 	DF(Memory, r->mock.color.memory);
 	D(DescriptorSetLayout, r->mesh.descriptor_set_layout);
 	D(PipelineLayout, r->mesh.pipeline_layout);
-	D(PipelineCache, r->pipeline_cache);
 	D(DescriptorPool, r->mesh.descriptor_pool);
 	D(QueryPool, r->query_pool);
 	render_buffer_close(vk, &r->mesh.vbo);
@@ -972,6 +1013,7 @@ render_resources_close(struct render_resources *r)
 	D(DescriptorSetLayout, r->compute.distortion.descriptor_set_layout);
 	D(Pipeline, r->compute.distortion.pipeline);
 	D(Pipeline, r->compute.distortion.timewarp_pipeline);
+	D(Pipeline, r->compute.distortion.depth_timewarp_pipeline);
 	D(PipelineLayout, r->compute.distortion.pipeline_layout);
 
 	D(Pipeline, r->compute.clear.pipeline);
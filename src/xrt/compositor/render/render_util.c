@@ -7,6 +7,8 @@
  * @ingroup comp_render
  */
 
+#include "xrt/xrt_compositor.h"
+
 #include "math/m_api.h"
 #include "math/m_matrix_4x4_f64.h"
 
@@ -115,3 +117,61 @@ render_calc_time_warp_matrix(const struct xrt_pose *src_pose,
 		matrix->v[i] = (float)result.v[i];
 	}
 }
+
+void
+render_calc_time_warp_depth_matrices(const struct xrt_pose *src_pose,
+                                     const struct xrt_fov *src_fov,
+                                     const struct xrt_pose *new_pose,
+                                     struct xrt_matrix_4x4 *matrix,
+                                     struct xrt_matrix_4x4 *new_to_src)
+{
+	const struct xrt_vec3 one = {1.0f, 1.0f, 1.0f};
+
+	// Src projection matrix.
+	struct xrt_matrix_4x4_f64 src_proj;
+	calc_projection(src_fov, &src_proj);
+
+	// Src view matrix, with position this time.
+	struct xrt_matrix_4x4_f64 src_model, src_view;
+	m_mat4_f64_model(src_pose, &one, &src_model);
+	m_mat4_f64_invert(&src_model, &src_view);
+
+	// New model matrix, takes points from the new view space into world.
+	struct xrt_matrix_4x4_f64 new_model;
+	m_mat4_f64_model(new_pose, &one, &new_model);
+
+	// From the new view space into the src view space.
+	struct xrt_matrix_4x4_f64 delta;
+	m_mat4_f64_multiply(&src_view, &new_model, &delta);
+
+	struct xrt_matrix_4x4_f64 result;
+	m_mat4_f64_multiply(&src_proj, &delta, &result);
+
+	// Convert from f64 to f32.
+	for (int i = 0; i < 16; i++) {
+		matrix->v[i] = (float)result.v[i];
+		new_to_src->v[i] = (float)delta.v[i];
+	}
+}
+
+bool
+render_calc_depth_params(const struct xrt_layer_depth_data *depth, struct render_depth_params *out_params)
+{
+	const float range = depth->max_depth - depth->min_depth;
+
+	// Reversed depth has near_z > far_z, either but not both may be infinite.
+	if (!(range > 0.0f) || !(depth->near_z > 0.0f) || !(depth->far_z > 0.0f) || depth->near_z == depth->far_z ||
+	    (isinf(depth->near_z) && isinf(depth->far_z))) {
+		return false;
+	}
+
+	const float inv_near = isinf(depth->near_z) ? 0.0f : 1.0f / depth->near_z;
+	const float inv_far = isinf(depth->far_z) ? 0.0f : 1.0f / depth->far_z;
+
+	out_params->scale = 1.0f / range;
+	out_params->offset = -depth->min_depth / range;
+	out_params->inv_near = inv_near;
+	out_params->inv_delta = inv_far - inv_near;
+
+	return true;
+}
@@ -57,20 +57,38 @@ base_get_swapchain_create_properties(struct xrt_compositor *xc,
 }
 
 static xrt_result_t
-base_create_swapchain(struct xrt_compositor *xc,
-                      const struct xrt_swapchain_create_info *info,
-                      struct xrt_swapchain **out_xsc)
+base_create_owned_swapchain(struct xrt_compositor_native *xcn,
+                            uint64_t owner,
+                            const struct xrt_swapchain_create_info *info,
+                            struct xrt_swapchain **out_xsc)
 {
-	struct comp_base *cb = comp_base(xc);
+	struct comp_base *cb = comp_base(&xcn->base);
 
 	/*
 	 * In case the default get properties function have been overridden
 	 * make sure to correctly dispatch the call to get the properties.
 	 */
 	struct xrt_swapchain_create_properties xsccp = {0};
-	xrt_comp_get_swapchain_create_properties(xc, info, &xsccp);
+	xrt_comp_get_swapchain_create_properties(&xcn->base, info, &xsccp);
+
+	return comp_swapchain_create(&cb->vk, &cb->cscs, owner, info, &xsccp, out_xsc);
+}
+
+static void
+base_release_owner(struct xrt_compositor_native *xcn, uint64_t owner)
+{
+	struct comp_base *cb = comp_base(&xcn->base);
 
-	return comp_swapchain_create(&cb->vk, &cb->cscs, info, &xsccp, out_xsc);
+	comp_swapchain_shared_release_owner(&cb->cscs, owner);
+}
+
+static xrt_result_t
+base_create_swapchain(struct xrt_compositor *xc,
+                      const struct xrt_swapchain_create_info *info,
+                      struct xrt_swapchain **out_xsc)
+{
+	// Not created for anybody in particular.
+	return base_create_owned_swapchain(&comp_base(xc)->base, 0, info, out_xsc);
 }
 
 static xrt_result_t
@@ -264,6 +282,8 @@ comp_base_init(struct comp_base *cb)
 	cb->base.base.layer_equirect1 = base_layer_equirect1;
 	cb->base.base.layer_equirect2 = base_layer_equirect2;
 	cb->base.base.wait_frame = base_wait_frame;
+	cb->base.create_owned_swapchain = base_create_owned_swapchain;
+	cb->base.release_owner = base_release_owner;
 
 	u_threading_stack_init(&cb->cscs.destroy_swapchains);
 
@@ -116,6 +116,13 @@ is_layer_unpremultiplied(const struct xrt_layer_data *data)
 	return (data->flags & XRT_LAYER_COMPOSITION_UNPREMULTIPLIED_ALPHA_BIT) != 0;
 }
 
+static bool
+is_layer_depth_reprojected(const struct xrt_layer_data *data)
+{
+	return data->type == XRT_LAYER_STEREO_PROJECTION_DEPTH &&
+	       (data->flags & XRT_LAYER_COMPOSITION_DEPTH_REPROJECTION_BIT) != 0;
+}
+
 static void
 set_post_transform_rect(const struct xrt_layer_data *data,
                         const struct xrt_normalized_rect *src_norm_rect,
@@ -203,6 +210,56 @@ do_projection_layer(const struct xrt_layer_data *data,
 	*out_cur_image = cur_image;
 }
 
+/*!
+ * Places the quad in the view space of @p view_mat, the result is what the
+ * shaders need to shoot rays from the eye at the quad.
+ */
+static void
+calc_quad_view_space(const struct xrt_layer_data *data,
+                     const struct xrt_matrix_4x4 *view_mat,
+                     struct xrt_vec3 *out_position,
+                     struct xrt_vec3 *out_normal,
+                     struct xrt_matrix_4x4 *out_inverse_quad_transform)
+{
+	// Transform quad pose into view space.
+	struct xrt_vec3 quad_position = XRT_STRUCT_INIT;
+	math_matrix_4x4_transform_vec3(view_mat, &data->quad.pose.position, &quad_position);
+
+	// neutral quad layer faces +z, towards the user
+	struct xrt_vec3 normal = (struct xrt_vec3){.x = 0, .y = 0, .z = 1};
+
+	// rotation of the quad normal in world space
+	struct xrt_quat rotation = data->quad.pose.orientation;
+	math_quat_rotate_vec3(&rotation, &normal, &normal);
+
+	/*
+	 * normal is a vector that originates on the plane, not on the origin.
+	 * Instead of using the inverse quad transform to transform it into view space we can
+	 * simply add up vectors:
+	 *
+	 * combined_normal [in world space] = plane_origin [in world space] + normal [in plane
+	 * space] [with plane in world space]
+	 *
+	 * Then combined_normal can be transformed to view space via view matrix and a new
+	 * normal_view_space retrieved:
+	 *
+	 * normal_view_space = combined_normal [in view space] - plane_origin [in view space]
+	 */
+	struct xrt_vec3 normal_view_space = normal;
+	math_vec3_accum(&data->quad.pose.position, &normal_view_space);
+	math_matrix_4x4_transform_vec3(view_mat, &normal_view_space, &normal_view_space);
+	math_vec3_subtract(&quad_position, &normal_view_space);
+
+	struct xrt_vec3 scale = {1.f, 1.f, 1.f};
+	struct xrt_matrix_4x4 plane_transform_view_space;
+	math_matrix_4x4_model(&data->quad.pose, &scale, &plane_transform_view_space);
+	math_matrix_4x4_multiply(view_mat, &plane_transform_view_space, &plane_transform_view_space);
+	math_matrix_4x4_inverse(&plane_transform_view_space, out_inverse_quad_transform);
+
+	*out_position = quad_position;
+	*out_normal = normal_view_space;
+}
+
 static inline void
 do_quad_layer(const struct xrt_layer_data *data,
               const struct comp_layer *layer,
@@ -238,40 +295,9 @@ do_quad_layer(const struct xrt_layer_data *data,
 	// Is this layer viewspace or not.
 	const struct xrt_matrix_4x4 *view_mat = is_layer_view_space(data) ? eye_view_mat : world_view_mat;
 
-	// Transform quad pose into view space.
-	struct xrt_vec3 quad_position = XRT_STRUCT_INIT;
-	math_matrix_4x4_transform_vec3(view_mat, &data->quad.pose.position, &quad_position);
-
-	// neutral quad layer faces +z, towards the user
-	struct xrt_vec3 normal = (struct xrt_vec3){.x = 0, .y = 0, .z = 1};
-
-	// rotation of the quad normal in world space
-	struct xrt_quat rotation = data->quad.pose.orientation;
-	math_quat_rotate_vec3(&rotation, &normal, &normal);
-
-	/*
-	 * normal is a vector that originates on the plane, not on the origin.
-	 * Instead of using the inverse quad transform to transform it into view space we can
-	 * simply add up vectors:
-	 *
-	 * combined_normal [in world space] = plane_origin [in world space] + normal [in plane
-	 * space] [with plane in world space]
-	 *
-	 * Then combined_normal can be transformed to view space via view matrix and a new
-	 * normal_view_space retrieved:
-	 *
-	 * normal_view_space = combined_normal [in view space] - plane_origin [in view space]
-	 */
-	struct xrt_vec3 normal_view_space = normal;
-	math_vec3_accum(&data->quad.pose.position, &normal_view_space);
-	math_matrix_4x4_transform_vec3(view_mat, &normal_view_space, &normal_view_space);
-	math_vec3_subtract(&quad_position, &normal_view_space);
-
-	struct xrt_vec3 scale = {1.f, 1.f, 1.f};
-	struct xrt_matrix_4x4 plane_transform_view_space, inverse_quad_transform;
-	math_matrix_4x4_model(&data->quad.pose, &scale, &plane_transform_view_space);
-	math_matrix_4x4_multiply(view_mat, &plane_transform_view_space, &plane_transform_view_space);
-	math_matrix_4x4_inverse(&plane_transform_view_space, &inverse_quad_transform);
+	struct xrt_vec3 quad_position, normal_view_space;
+	struct xrt_matrix_4x4 inverse_quad_transform;
+	calc_quad_view_space(data, view_mat, &quad_position, &normal_view_space, &inverse_quad_transform);
 
 	// Write all of the UBO data.
 	ubo_data->post_transforms[cur_layer] = post_transform;
@@ -298,7 +324,8 @@ do_distortion_for_scratch(struct render_compute *crc,
                           struct render_scratch_images *rsi,
                           VkImage target_image,
                           VkImageView target_image_view,
-                          const struct render_viewport_data views[2])
+                          const struct render_viewport_data views[2],
+                          const struct render_compute_foveation *foveation)
 {
 	VkSampler sampler = crc->r->samplers.clamp_to_border_black;
 
@@ -320,8 +347,82 @@ do_distortion_for_scratch(struct render_compute *crc,
 	    src_norm_rects,        //
 	    target_image,          //
 	    target_image_view,     //
-	    views                  //
-	);
+	    views,                 //
+	    foveation,             //
+	    NULL);                 // overlays
+}
+
+static void
+flip_norm_rects(struct xrt_normalized_rect rects[2])
+{
+	for (uint32_t i = 0; i < 2; i++) {
+		rects[i].h = -rects[i].h;
+		rects[i].y = 1 + rects[i].y;
+	}
+}
+
+/*!
+ * Reprojects a projection layer with depth for both rotation and position,
+ * returns false if the depth info of the layer can not be used.
+ */
+static bool
+do_depth_distortion_for_layer(struct render_compute *crc,
+                              const struct xrt_pose world_poses[2],
+                              const struct comp_layer *layer,
+                              VkSampler src_samplers[2],
+                              VkImageView src_image_views[2],
+                              const struct xrt_normalized_rect src_norm_rects[2],
+                              VkImage target_image,
+                              VkImageView target_image_view,
+                              const struct render_viewport_data views[2],
+                              const struct render_compute_foveation *foveation,
+                              const struct render_compute_overlays *overlays)
+{
+	const struct xrt_layer_data *data = &layer->data;
+	const struct xrt_layer_stereo_projection_depth_data *stereo = &data->stereo_depth;
+	const struct xrt_layer_projection_view_data *vds[2] = {&stereo->l, &stereo->r};
+	const struct xrt_layer_depth_data *dvds[2] = {&stereo->l_d, &stereo->r_d};
+
+	struct render_depth_params depth_params[2];
+	VkImageView depth_image_views[2];
+	struct xrt_normalized_rect depth_norm_rects[2];
+	struct xrt_pose src_poses[2];
+	struct xrt_fov src_fovs[2];
+
+	for (uint32_t i = 0; i < 2; i++) {
+		if (!render_calc_depth_params(dvds[i], &depth_params[i])) {
+			return false;
+		}
+
+		const struct comp_swapchain_image *d_image = &layer->sc_array[i + 2]->images[dvds[i]->sub.image_index];
+		depth_image_views[i] = get_image_view(d_image, data->flags, dvds[i]->sub.array_index);
+		depth_norm_rects[i] = dvds[i]->sub.norm_rect;
+		src_poses[i] = vds[i]->pose;
+		src_fovs[i] = vds[i]->fov;
+	}
+
+	if (data->flip_y) {
+		flip_norm_rects(depth_norm_rects);
+	}
+
+	render_compute_projection_depth_timewarp( //
+	    crc,                                  //
+	    src_samplers,                         //
+	    src_image_views,                      //
+	    src_norm_rects,                       //
+	    depth_image_views,                    //
+	    depth_norm_rects,                     //
+	    depth_params,                         //
+	    src_poses,                            //
+	    src_fovs,                             //
+	    world_poses,                          //
+	    target_image,                         //
+	    target_image_view,                    //
+	    views,                                //
+	    foveation,                            //
+	    overlays);                            //
+
+	return true;
 }
 
 static void
@@ -333,6 +434,8 @@ do_distortion_for_layer(struct render_compute *crc,
                         VkImage target_image,
                         VkImageView target_image_view,
                         const struct render_viewport_data views[2],
+                        const struct render_compute_foveation *foveation,
+                        const struct render_compute_overlays *overlays,
                         bool do_timewarp)
 {
 	const struct xrt_layer_data *data = &layer->data;
@@ -354,13 +457,27 @@ do_distortion_for_layer(struct render_compute *crc,
 
 	struct xrt_normalized_rect src_norm_rects[2] = {lvd->sub.norm_rect, rvd->sub.norm_rect};
 	if (data->flip_y) {
-		src_norm_rects[0].h = -src_norm_rects[0].h;
-		src_norm_rects[0].y = 1 + src_norm_rects[0].y;
-		src_norm_rects[1].h = -src_norm_rects[1].h;
-		src_norm_rects[1].y = 1 + src_norm_rects[1].y;
+		flip_norm_rects(src_norm_rects);
 	}
 
-	if (do_timewarp) {
+	// Falls back to only correcting for rotation if the depth can't be used.
+	if (do_timewarp && is_layer_depth_reprojected(data) && //
+	    do_depth_distortion_for_layer(                     //
+	        crc,                                           //
+	        world_poses,                                   //
+	        layer,                                         //
+	        src_samplers,                                  //
+	        src_image_views,                               //
+	        src_norm_rects,                                //
+	        target_image,                                  //
+	        target_image_view,                             //
+	        views,                                         //
+	        foveation,                                     //
+	        overlays)) {                                   //
+		return;
+	}
+
+	if (!do_timewarp) {
 		render_compute_projection( //
 		    crc,                   //
 		    src_samplers,          //
@@ -368,7 +485,9 @@ do_distortion_for_layer(struct render_compute *crc,
 		    src_norm_rects,        //
 		    target_image,          //
 		    target_image_view,     //
-		    views);                //
+		    views,                 //
+		    foveation,             //
+		    overlays);             //
 	} else {
 		struct xrt_pose src_poses[2] = {
 		    lvd->pose,
@@ -390,7 +509,9 @@ do_distortion_for_layer(struct render_compute *crc,
 		    world_poses,                    //
 		    target_image,                   //
 		    target_image_view,              //
-		    views);                         //
+		    views,                          //
+		    foveation,                      //
+		    overlays);                      //
 	}
 }
 
@@ -401,6 +522,64 @@ do_distortion_for_layer(struct render_compute *crc,
  *
  */
 
+void
+comp_render_calc_overlays(struct render_resources *r,
+                          const struct xrt_pose world_poses[2],
+                          const struct xrt_pose eye_poses[2],
+                          const struct comp_layer *layers,
+                          uint32_t layer_count,
+                          struct render_compute_overlays *out_overlays)
+{
+	assert(layer_count <= RENDER_MAX_OVERLAYS);
+
+	// Not the transform of the views, but the inverse: actual view matrices.
+	struct xrt_matrix_4x4 world_view_mats[2], eye_view_mats[2];
+	for (uint32_t view_index = 0; view_index < 2; view_index++) {
+		math_matrix_4x4_view_from_pose(&world_poses[view_index], &world_view_mats[view_index]);
+		math_matrix_4x4_view_from_pose(&eye_poses[view_index], &eye_view_mats[view_index]);
+	}
+
+	U_ZERO(out_overlays);
+
+	for (uint32_t i = 0; i < layer_count; i++) {
+		const struct comp_layer *layer = &layers[i];
+		const struct xrt_layer_data *data = &layer->data;
+		const struct xrt_layer_quad_data *q = &data->quad;
+		assert(data->type == XRT_LAYER_QUAD);
+
+		const struct comp_swapchain_image *image = &layer->sc_array[0]->images[q->sub.image_index];
+		out_overlays->samplers[i] = r->samplers.clamp_to_edge;
+		out_overlays->image_views[i] = get_image_view(image, data->flags, q->sub.array_index);
+
+		struct xrt_normalized_rect post_transform = XRT_STRUCT_INIT;
+		set_post_transform_rect( //
+		    data,                // data
+		    &q->sub.norm_rect,   // src_norm_rect
+		    true,                // invert_flip
+		    &post_transform);    // out_norm_rect
+
+		for (uint32_t view_index = 0; view_index < 2; view_index++) {
+			struct render_compute_overlay_data *od = &out_overlays->data[i][view_index];
+			const struct xrt_matrix_4x4 *view_mat =
+			    is_layer_view_space(data) ? &eye_view_mats[view_index] : &world_view_mats[view_index];
+
+			calc_quad_view_space(             //
+			    data,                         // data
+			    view_mat,                     // view_mat
+			    &od->quad_position.val,       // out_position
+			    &od->quad_normal.val,         // out_normal
+			    &od->inverse_quad_transform); // out_inverse_quad_transform
+
+			od->quad_extent.val = q->size;
+			od->post_transform = post_transform;
+			od->flags.visible = is_view_index_visible(view_index, q->visibility);
+			od->flags.unpremultiplied = is_layer_unpremultiplied(data);
+		}
+	}
+
+	out_overlays->count = layer_count;
+}
+
 void
 comp_render_layer(struct render_compute *crc,
                   uint32_t view_index,
@@ -567,7 +746,7 @@ comp_render_stereo_layers(struct render_compute *crc,
 
 	vk_cmd_image_barrier_gpu_locked(          //
 	    crc->r->vk,                           //
-	    crc->r->cmd,                          //
+	    crc->cmd,                             //
 	    target_images[0],                     //
 	    0,                                    //
 	    VK_ACCESS_SHADER_WRITE_BIT,           //
@@ -578,7 +757,7 @@ comp_render_stereo_layers(struct render_compute *crc,
 	if (target_images[0] != target_images[1]) {
 		vk_cmd_image_barrier_gpu_locked(          //
 		    crc->r->vk,                           //
-		    crc->r->cmd,                          //
+		    crc->cmd,                             //
 		    target_images[1],                     //
 		    0,                                    //
 		    VK_ACCESS_SHADER_WRITE_BIT,           //
@@ -604,7 +783,7 @@ comp_render_stereo_layers(struct render_compute *crc,
 
 	vk_cmd_image_barrier_locked(              //
 	    crc->r->vk,                           //
-	    crc->r->cmd,                          //
+	    crc->cmd,                             //
 	    target_images[0],                     //
 	    VK_ACCESS_SHADER_WRITE_BIT,           //
 	    VK_ACCESS_MEMORY_READ_BIT,            //
@@ -617,7 +796,7 @@ comp_render_stereo_layers(struct render_compute *crc,
 	if (target_images[0] != target_images[1]) {
 		vk_cmd_image_barrier_locked(              //
 		    crc->r->vk,                           //
-		    crc->r->cmd,                          //
+		    crc->cmd,                             //
 		    target_images[1],                     //
 		    VK_ACCESS_SHADER_WRITE_BIT,           //
 		    VK_ACCESS_MEMORY_READ_BIT,            //
@@ -679,6 +858,7 @@ comp_render_dispatch_compute(struct render_compute *crc,
                              VkImage target_image,
                              VkImageView target_image_view,
                              const struct render_viewport_data views[2],
+                             const struct render_compute_foveation *foveation,
                              bool fast_path,
                              bool do_timewarp)
 {
@@ -693,6 +873,20 @@ comp_render_dispatch_compute(struct render_compute *crc,
 	// We want to read from the images afterwards.
 	VkImageLayout transition_to = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
+	// Quads on top of the projection layer are composited by the distortion shader.
+	struct render_compute_overlays overlays;
+	const struct render_compute_overlays *fast_path_overlays = NULL;
+	if (fast_path && layer_count > 1) {
+		comp_render_calc_overlays( //
+		    crc->r,                // r
+		    world_poses,           // world_poses
+		    eye_poses,             // eye_poses
+		    &layers[1],            // layers
+		    layer_count - 1,       // layer_count
+		    &overlays);            // out_overlays
+		fast_path_overlays = &overlays;
+	}
+
 	if (fast_path && layers[0].data.type == XRT_LAYER_STEREO_PROJECTION) {
 		int i = 0;
 		const struct comp_layer *layer = &layers[i];
@@ -709,6 +903,8 @@ comp_render_dispatch_compute(struct render_compute *crc,
 		    target_image,        // target_image
 		    target_image_view,   // target_image_view
 		    views,               // views
+		    foveation,           // foveation
+		    fast_path_overlays,  // overlays
 		    do_timewarp);        // do_timewarp
 	} else if (fast_path && layers[0].data.type == XRT_LAYER_STEREO_PROJECTION_DEPTH) {
 		int i = 0;
@@ -726,6 +922,8 @@ comp_render_dispatch_compute(struct render_compute *crc,
 		    target_image,        // target_image
 		    target_image_view,   // target_image_view
 		    views,               // views
+		    foveation,           // foveation
+		    fast_path_overlays,  // overlays
 		    do_timewarp);        // do_timewarp
 	} else if (layer_count > 0) {
 		comp_render_stereo_layers_to_scratch( //
@@ -744,7 +942,8 @@ comp_render_dispatch_compute(struct render_compute *crc,
 		    rsi,                   //
 		    target_image,          //
 		    target_image_view,     //
-		    views);                //
+		    views,                 //
+		    foveation);            //
 	} else {
 		render_compute_clear(  //
 		    crc,               //
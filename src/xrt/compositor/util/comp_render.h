@@ -104,6 +104,21 @@ comp_render_stereo_layers_to_scratch(struct render_compute *crc,
                                      VkImageLayout transition_to,
                                      bool do_timewarp);
 
+/*!
+ * Fills in @p out_overlays so the distortion shader composites the given quad
+ * layers on top of the projection layer, placed with the new device poses.
+ * All of the @p layers must be quad layers, at most @ref RENDER_MAX_OVERLAYS.
+ *
+ * @ingroup comp_util
+ */
+void
+comp_render_calc_overlays(struct render_resources *r,
+                          const struct xrt_pose world_poses[2],
+                          const struct xrt_pose eye_poses[2],
+                          const struct comp_layer *layers,
+                          uint32_t layer_count,
+                          struct render_compute_overlays *out_overlays);
+
 /*!
  * Helper function that takes a set of layers, new device poses, a scratch
  * images and writes the needed commands to the @ref render_compute to do a full
@@ -111,6 +126,10 @@ comp_render_stereo_layers_to_scratch(struct render_compute *crc,
  * layers should it not be possible to do a fast_path. Will insert barriers to
  * change the scratch images and target images to the needed layout.
  *
+ * With @p fast_path the first layer is a projection layer that goes straight
+ * to the distortion shader, any layers after it are quad layers that it
+ * composites on top, see @ref comp_render_calc_overlays.
+ *
  * Expected layouts:
  * * Layer images: VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
  * * Sratch images: Any
@@ -133,6 +152,7 @@ comp_render_dispatch_compute(struct render_compute *crc,
                              VkImage target_image,
                              VkImageView target_image_view,
                              const struct render_viewport_data views[2],
+                             const struct render_compute_foveation *foveation,
                              bool fast_path,
                              bool do_timewarp);
 
@@ -11,6 +11,7 @@
 #include "xrt/xrt_config_os.h"
 
 #include "util/u_misc.h"
+#include "util/u_debug.h"
 #include "util/u_handles.h"
 #include "util/u_trace_marker.h"
 #include "util/u_limited_unique_id.h"
@@ -24,6 +25,9 @@
 #include <errno.h>
 
 
+DEBUG_GET_ONCE_NUM_OPTION(swapchain_pool_mb, "XRT_COMPOSITOR_SWAPCHAIN_POOL_MB", 256)
+
+
 /*
  *
  * Swapchain member functions.
@@ -271,9 +275,15 @@ do_post_create_vulkan_setup(struct vk_bundle *vk,
 	VkImageViewType image_view_type = info->face_count == 6 ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D;
 
 	for (uint32_t i = 0; i < image_count; i++) {
+		sc->images[i].array_size = info->array_size;
+
+		// Recycled images come with their views.
+		if (sc->images[i].views.alpha != NULL) {
+			continue;
+		}
+
 		sc->images[i].views.alpha = U_TYPED_ARRAY_CALLOC(VkImageView, info->array_size);
 		sc->images[i].views.no_alpha = U_TYPED_ARRAY_CALLOC(VkImageView, info->array_size);
-		sc->images[i].array_size = info->array_size;
 
 		for (uint32_t layer = 0; layer < info->array_size; ++layer) {
 			VkImageSubresourceRange subresource_range = {
@@ -441,6 +451,172 @@ really_destroy(struct comp_swapchain *sc)
 }
 
 
+/*
+ *
+ * Pool functions.
+ *
+ */
+
+static bool
+is_same_create_info(const struct xrt_swapchain_create_info *a, const struct xrt_swapchain_create_info *b)
+{
+	return a->create == b->create &&             //
+	       a->bits == b->bits &&                 //
+	       a->format == b->format &&             //
+	       a->sample_count == b->sample_count && //
+	       a->width == b->width &&               //
+	       a->height == b->height &&             //
+	       a->face_count == b->face_count &&     //
+	       a->array_size == b->array_size &&     //
+	       a->mip_count == b->mip_count;
+}
+
+/*!
+ * Destroys the views and images of the entries, the entries themselves are
+ * left as is. Waits for the device to be idle, so must not be called with the
+ * pool mutex held.
+ */
+static void
+pool_entries_destroy(struct vk_bundle *vk, struct comp_swapchain_pool_entry *entries, uint32_t entry_count)
+{
+	if (entry_count == 0) {
+		return;
+	}
+
+	// Same as image_cleanup, but once for all of the images.
+	os_mutex_lock(&vk->queue_mutex);
+	vk->vkDeviceWaitIdle(vk->device);
+	os_mutex_unlock(&vk->queue_mutex);
+
+	for (uint32_t k = 0; k < entry_count; k++) {
+		struct comp_swapchain_pool_entry *entry = &entries[k];
+
+		size_t array_size = entry->vkic.info.array_size;
+		for (uint32_t i = 0; i < entry->vkic.image_count; i++) {
+			clean_image_views(vk, array_size, &entry->views[i].alpha);
+			clean_image_views(vk, array_size, &entry->views[i].no_alpha);
+		}
+
+		vk_ic_destroy(vk, &entry->vkic);
+	}
+}
+
+//! Removes the entry at @p index, keeping the entries in age order. Pool mutex must be held.
+static void
+pool_remove_locked(struct comp_swapchain_shared *cscs, uint32_t index)
+{
+	cscs->recycle.size -= cscs->recycle.entries[index].size;
+	cscs->recycle.entry_count--;
+
+	for (uint32_t i = index; i < cscs->recycle.entry_count; i++) {
+		cscs->recycle.entries[i] = cscs->recycle.entries[i + 1];
+	}
+	U_ZERO(&cscs->recycle.entries[cscs->recycle.entry_count]);
+}
+
+/*!
+ * Moves the images and views of a matching entry of the swapchain's owner into
+ * the swapchain, newest entry first as its memory is most likely to still be
+ * resident.
+ */
+static bool
+pool_take(struct comp_swapchain_shared *cscs,
+          const struct xrt_swapchain_create_info *info,
+          uint32_t image_count,
+          struct comp_swapchain *sc)
+{
+	bool found = false;
+
+	os_mutex_lock(&cscs->recycle.mutex);
+
+	for (uint32_t i = cscs->recycle.entry_count; i > 0; i--) {
+		struct comp_swapchain_pool_entry *entry = &cscs->recycle.entries[i - 1];
+		if (entry->owner != sc->owner || entry->vkic.image_count != image_count ||
+		    !is_same_create_info(&entry->vkic.info, info)) {
+			continue;
+		}
+
+		sc->vkic = entry->vkic;
+		for (uint32_t k = 0; k < image_count; k++) {
+			sc->images[k].views.alpha = entry->views[k].alpha;
+			sc->images[k].views.no_alpha = entry->views[k].no_alpha;
+		}
+
+		pool_remove_locked(cscs, i - 1);
+		found = true;
+		break;
+	}
+
+	if (cscs->recycle.budget > 0) {
+		if (found) {
+			cscs->recycle.hits++;
+		} else {
+			cscs->recycle.misses++;
+		}
+	}
+
+	os_mutex_unlock(&cscs->recycle.mutex);
+
+	return found;
+}
+
+/*!
+ * Moves the images and views of the swapchain into the pool, freeing the
+ * oldest entries to stay within the budget. Returns false if the pool didn't
+ * take them, the caller then has to destroy them.
+ */
+static bool
+pool_put(struct comp_swapchain_shared *cscs, struct vk_bundle *vk, struct comp_swapchain *sc)
+{
+	// Evicted under the lock, destroyed once it has been released.
+	struct comp_swapchain_pool_entry evicted[COMP_SWAPCHAIN_POOL_MAX_ENTRIES];
+	uint32_t evicted_count = 0;
+
+	VkDeviceSize size = 0;
+	for (uint32_t i = 0; i < sc->vkic.image_count; i++) {
+		size += sc->vkic.images[i].size;
+	}
+
+	os_mutex_lock(&cscs->recycle.mutex);
+
+	if (size == 0 || size > cscs->recycle.budget) {
+		os_mutex_unlock(&cscs->recycle.mutex);
+		return false;
+	}
+
+	while (cscs->recycle.entry_count >= ARRAY_SIZE(cscs->recycle.entries) ||
+	       cscs->recycle.size + size > cscs->recycle.budget) {
+		evicted[evicted_count++] = cscs->recycle.entries[0];
+		pool_remove_locked(cscs, 0);
+	}
+
+	struct comp_swapchain_pool_entry *entry = &cscs->recycle.entries[cscs->recycle.entry_count++];
+	entry->vkic = sc->vkic;
+	entry->size = size;
+	entry->owner = sc->owner;
+	for (uint32_t i = 0; i < sc->vkic.image_count; i++) {
+		entry->views[i].alpha = sc->images[i].views.alpha;
+		entry->views[i].no_alpha = sc->images[i].views.no_alpha;
+		sc->images[i].views.alpha = NULL;
+		sc->images[i].views.no_alpha = NULL;
+	}
+	cscs->recycle.size += size;
+
+	VK_DEBUG(vk, "Recycled %" PRIu32 "x%" PRIu32 " images, pool now %" PRIu64 " MiB in %" PRIu32 " entries",  //
+	         sc->vkic.info.width, sc->vkic.info.height,                                                       //
+	         (uint64_t)(cscs->recycle.size >> 20), cscs->recycle.entry_count);
+
+	os_mutex_unlock(&cscs->recycle.mutex);
+
+	pool_entries_destroy(vk, evicted, evicted_count);
+
+	// Now owned by the pool.
+	U_ZERO(&sc->vkic);
+
+	return true;
+}
+
+
 /*
  *
  * 'Exported' parent-class functions.
@@ -452,6 +628,7 @@ comp_swapchain_create_init(struct comp_swapchain *sc,
                            comp_swapchain_destroy_func_t destroy_func,
                            struct vk_bundle *vk,
                            struct comp_swapchain_shared *cscs,
+                           uint64_t owner,
                            const struct xrt_swapchain_create_info *info,
                            const struct xrt_swapchain_create_properties *xsccp)
 {
@@ -470,17 +647,21 @@ comp_swapchain_create_init(struct comp_swapchain *sc,
 	}
 
 	set_common_fields(sc, destroy_func, vk, cscs, xsccp->image_count);
-
-	// Use the image helper to allocate the images.
-	ret = vk_ic_allocate(vk, info, xsccp->image_count, &sc->vkic);
-	if (ret == VK_ERROR_FEATURE_NOT_PRESENT) {
-		return XRT_ERROR_SWAPCHAIN_FLAG_VALID_BUT_UNSUPPORTED;
-	}
-	if (ret == VK_ERROR_FORMAT_NOT_SUPPORTED) {
-		return XRT_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
-	}
-	if (ret != VK_SUCCESS) {
-		return XRT_ERROR_VULKAN;
+	sc->recyclable = true;
+	sc->owner = owner;
+
+	// Use the images of a destroyed swapchain if possible, otherwise use the image helper to allocate them.
+	if (!pool_take(cscs, info, xsccp->image_count, sc)) {
+		ret = vk_ic_allocate(vk, info, xsccp->image_count, &sc->vkic);
+		if (ret == VK_ERROR_FEATURE_NOT_PRESENT) {
+			return XRT_ERROR_SWAPCHAIN_FLAG_VALID_BUT_UNSUPPORTED;
+		}
+		if (ret == VK_ERROR_FORMAT_NOT_SUPPORTED) {
+			return XRT_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+		}
+		if (ret != VK_SUCCESS) {
+			return XRT_ERROR_VULKAN;
+		}
 	}
 
 	xrt_graphics_buffer_handle_t handles[ARRAY_SIZE(sc->vkic.images)];
@@ -533,11 +714,15 @@ comp_swapchain_teardown(struct comp_swapchain *sc)
 
 	VK_TRACE(vk, "REALLY DESTROY");
 
+	// Images still in use must not be handed out again.
+	bool in_use = false;
+
 	for (uint32_t i = 0; i < sc->base.base.image_count; i++) {
 		// compositor ensures to garbage collect after gpu work finished
 		if (sc->images[i].use_count != 0) {
 			VK_ERROR(vk, "swapchain destroy while image %d use count %d", i, sc->images[i].use_count);
 			assert(false);
+			in_use = true;
 			continue; // leaking better than crashing?
 		}
 
@@ -545,8 +730,11 @@ comp_swapchain_teardown(struct comp_swapchain *sc)
 		pthread_cond_destroy(&sc->images[i].use_cond);
 	}
 
-	for (uint32_t i = 0; i < sc->base.base.image_count; i++) {
-		image_cleanup(vk, &sc->images[i]);
+	// Hand the images and views over to the pool, if it takes them they are no longer ours.
+	if (!sc->recyclable || in_use || !pool_put(sc->cscs, vk, sc)) {
+		for (uint32_t i = 0; i < sc->base.base.image_count; i++) {
+			image_cleanup(vk, &sc->images[i]);
+		}
 	}
 
 	for (uint32_t i = 0; i < sc->base.base.image_count; i++) {
@@ -572,12 +760,28 @@ comp_swapchain_shared_init(struct comp_swapchain_shared *cscs, struct vk_bundle
 		return XRT_ERROR_VULKAN;
 	}
 
+	int iret = os_mutex_init(&cscs->recycle.mutex);
+	if (iret != 0) {
+		VK_ERROR(vk, "os_mutex_init: %i", iret);
+		vk_cmd_pool_destroy(vk, &cscs->pool);
+		return XRT_ERROR_THREADING_INIT_FAILURE;
+	}
+
+	cscs->recycle.budget = (VkDeviceSize)debug_get_num_option_swapchain_pool_mb() << 20;
+	cscs->recycle.vk = vk;
+
 	return XRT_SUCCESS;
 }
 
 void
 comp_swapchain_shared_destroy(struct comp_swapchain_shared *cscs, struct vk_bundle *vk)
 {
+	pool_entries_destroy(vk, cscs->recycle.entries, cscs->recycle.entry_count);
+	cscs->recycle.entry_count = 0;
+	cscs->recycle.size = 0;
+
+	os_mutex_destroy(&cscs->recycle.mutex);
+
 	vk_cmd_pool_destroy(vk, &cscs->pool);
 }
 
@@ -586,9 +790,74 @@ comp_swapchain_shared_garbage_collect(struct comp_swapchain_shared *cscs)
 {
 	struct comp_swapchain *sc;
 
+	/*
+	 * Take the released owners before destroying the swapchains, any
+	 * swapchain of theirs was queued before they were released so ends up
+	 * in the pool before their entries are freed below.
+	 */
+	uint64_t owners[COMP_SWAPCHAIN_POOL_MAX_RELEASED_OWNERS];
+	uint32_t owner_count = 0;
+	bool release_all = false;
+
+	os_mutex_lock(&cscs->recycle.mutex);
+	owner_count = cscs->recycle.released_owner_count;
+	release_all = cscs->recycle.release_all;
+	for (uint32_t i = 0; i < owner_count; i++) {
+		owners[i] = cscs->recycle.released_owners[i];
+	}
+	cscs->recycle.released_owner_count = 0;
+	cscs->recycle.release_all = false;
+	os_mutex_unlock(&cscs->recycle.mutex);
+
 	while ((sc = u_threading_stack_pop(&cscs->destroy_swapchains))) {
 		sc->real_destroy(sc);
+		cscs->destroyed_count++;
+	}
+
+	if (owner_count == 0 && !release_all) {
+		return;
+	}
+
+	// Removed under the lock, destroyed once it has been released.
+	struct comp_swapchain_pool_entry released[COMP_SWAPCHAIN_POOL_MAX_ENTRIES];
+	uint32_t released_count = 0;
+
+	os_mutex_lock(&cscs->recycle.mutex);
+
+	for (uint32_t i = cscs->recycle.entry_count; i > 0; i--) {
+		bool matches = release_all;
+		for (uint32_t k = 0; k < owner_count && !matches; k++) {
+			matches = cscs->recycle.entries[i - 1].owner == owners[k];
+		}
+		if (!matches) {
+			continue;
+		}
+
+		released[released_count++] = cscs->recycle.entries[i - 1];
+		pool_remove_locked(cscs, i - 1);
 	}
+
+	os_mutex_unlock(&cscs->recycle.mutex);
+
+	pool_entries_destroy(cscs->recycle.vk, released, released_count);
+	if (released_count > 0) {
+		cscs->destroyed_count++;
+	}
+}
+
+void
+comp_swapchain_shared_release_owner(struct comp_swapchain_shared *cscs, uint64_t owner)
+{
+	os_mutex_lock(&cscs->recycle.mutex);
+
+	if (cscs->recycle.released_owner_count < ARRAY_SIZE(cscs->recycle.released_owners)) {
+		cscs->recycle.released_owners[cscs->recycle.released_owner_count++] = owner;
+	} else {
+		// Lots of owners gone at once, just free everything.
+		cscs->recycle.release_all = true;
+	}
+
+	os_mutex_unlock(&cscs->recycle.mutex);
 }
 
 
@@ -618,6 +887,7 @@ comp_swapchain_get_create_properties(const struct xrt_swapchain_create_info *inf
 xrt_result_t
 comp_swapchain_create(struct vk_bundle *vk,
                       struct comp_swapchain_shared *cscs,
+                      uint64_t owner,
                       const struct xrt_swapchain_create_info *info,
                       const struct xrt_swapchain_create_properties *xsccp,
                       struct xrt_swapchain **out_xsc)
@@ -630,6 +900,7 @@ comp_swapchain_create(struct vk_bundle *vk,
 	    really_destroy,                //
 	    vk,                            //
 	    cscs,                          //
+	    owner,                         //
 	    info,                          //
 	    xsccp);                        //
 	if (xret != XRT_SUCCESS) {
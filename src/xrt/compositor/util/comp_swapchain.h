@@ -24,6 +24,22 @@ extern "C" {
 
 struct comp_swapchain;
 
+/*!
+ * Max number of retired image sets kept in @ref comp_swapchain_shared for
+ * reuse, independent of the memory budget.
+ *
+ * @ingroup comp_util
+ */
+#define COMP_SWAPCHAIN_POOL_MAX_ENTRIES 16
+
+/*!
+ * Max number of owners released between two garbage collections that are
+ * tracked one by one, if more are released the whole pool is freed.
+ *
+ * @ingroup comp_util
+ */
+#define COMP_SWAPCHAIN_POOL_MAX_RELEASED_OWNERS 16
+
 /*!
  * Callback for implementing own destroy function, should call
  * @ref comp_swapchain_teardown and is responsible for memory.
@@ -32,6 +48,32 @@ struct comp_swapchain;
  */
 typedef void (*comp_swapchain_destroy_func_t)(struct comp_swapchain *sc);
 
+/*!
+ * The images and views of a destroyed swapchain, kept so a later swapchain
+ * with the same create info can use them instead of allocating new ones.
+ *
+ * @ingroup comp_util
+ * @see comp_swapchain_shared
+ */
+struct comp_swapchain_pool_entry
+{
+	//! The images, their create info is the key of the entry.
+	struct vk_image_collection vkic;
+
+	//! Views for each image, see @ref comp_swapchain_image::views.
+	struct
+	{
+		VkImageView *alpha;
+		VkImageView *no_alpha;
+	} views[XRT_MAX_SWAPCHAIN_IMAGES];
+
+	//! Total size of the image memory.
+	VkDeviceSize size;
+
+	//! Only swapchains of this owner may take the entry, see @ref comp_swapchain::owner.
+	uint64_t owner;
+};
+
 /*!
  * Shared resource(s) and garbage collector for swapchains. The garbage
  * collector allows to delay the destruction until it's safe to destroy them.
@@ -45,7 +87,46 @@ struct comp_swapchain_shared
 	//! Thread object for safely destroying swapchain.
 	struct u_threading_stack destroy_swapchains;
 
+	//! Number of swapchains destroyed by the garbage collector, tells users their views may be gone.
+	uint64_t destroyed_count;
+
 	struct vk_cmd_pool pool;
+
+	/*!
+	 * Images of destroyed swapchains, created swapchains only, imported
+	 * images belong to the client. Oldest entry first, the oldest entries
+	 * are freed to stay within the budget. The images have been shared with
+	 * the client that created them, so they are only reused by swapchains of
+	 * the same owner.
+	 */
+	struct
+	{
+		//! Swapchains are created on client threads, destroyed on the compositor thread.
+		struct os_mutex mutex;
+
+		struct comp_swapchain_pool_entry entries[COMP_SWAPCHAIN_POOL_MAX_ENTRIES];
+		uint32_t entry_count;
+
+		//! Memory used by all entries.
+		VkDeviceSize size;
+
+		//! Max memory used by all entries, zero disables the pool.
+		VkDeviceSize budget;
+
+		//! Swapchains created from the pool, and those that had to allocate.
+		uint64_t hits;
+		uint64_t misses;
+
+		//! Owners that have gone away, their entries are freed on garbage collection.
+		uint64_t released_owners[COMP_SWAPCHAIN_POOL_MAX_RELEASED_OWNERS];
+		uint32_t released_owner_count;
+
+		//! Too many owners went away to track, free all entries on garbage collection.
+		bool release_all;
+
+		//! Used to free entries on garbage collection, set on init.
+		struct vk_bundle *vk;
+	} recycle;
 };
 
 /*!
@@ -106,6 +187,12 @@ struct comp_swapchain
 
 	//! Virtual real destroy function.
 	comp_swapchain_destroy_func_t real_destroy;
+
+	//! The images were allocated by us, so they can go to the pool on teardown.
+	bool recyclable;
+
+	//! Who the swapchain was created for, zero if not known, keys the pool entry.
+	uint64_t owner;
 };
 
 
@@ -146,6 +233,7 @@ comp_swapchain_create_init(struct comp_swapchain *sc,
                            comp_swapchain_destroy_func_t destroy_func,
                            struct vk_bundle *vk,
                            struct comp_swapchain_shared *cscs,
+                           uint64_t owner,
                            const struct xrt_swapchain_create_info *info,
                            const struct xrt_swapchain_create_properties *xsccp);
 
@@ -189,7 +277,8 @@ XRT_CHECK_RESULT xrt_result_t
 comp_swapchain_shared_init(struct comp_swapchain_shared *cscs, struct vk_bundle *vk);
 
 /*!
- * Destroy the shared struct.
+ * Destroy the shared struct, frees all images in the pool so must be called
+ * after the last garbage collection.
  *
  * @ingroup comp_util
  */
@@ -205,6 +294,16 @@ comp_swapchain_shared_destroy(struct comp_swapchain_shared *cscs, struct vk_bund
 void
 comp_swapchain_shared_garbage_collect(struct comp_swapchain_shared *cscs);
 
+/*!
+ * Called when @p owner goes away, nothing else may take the pooled images of
+ * its swapchains. They are freed on the next garbage collection, after any of
+ * its swapchains still waiting to be destroyed. Can be called from any thread.
+ *
+ * @ingroup comp_util
+ */
+void
+comp_swapchain_shared_release_owner(struct comp_swapchain_shared *cscs, uint64_t owner);
+
 
 /*
  *
@@ -229,6 +328,7 @@ comp_swapchain_get_create_properties(const struct xrt_swapchain_create_info *inf
 xrt_result_t
 comp_swapchain_create(struct vk_bundle *vk,
                       struct comp_swapchain_shared *cscs,
+                      uint64_t owner,
                       const struct xrt_swapchain_create_info *info,
                       const struct xrt_swapchain_create_properties *xsccp,
                       struct xrt_swapchain **out_xsc);
@@ -209,6 +209,18 @@ compute_distortion(struct xrt_device *xdev, uint32_t view, float u, float v, str
 	return target->compute_distortion(target, view, u, v, result);
 }
 
+static bool
+compute_distortion_batch(struct xrt_device *xdev,
+                         uint32_t view,
+                         uint32_t count,
+                         const struct xrt_vec2 *uvs,
+                         struct xrt_uv_triplet *results)
+{
+	struct multi_device *d = (struct multi_device *)xdev;
+	struct xrt_device *target = d->tracking_override.target;
+	return xrt_device_compute_distortion_batch(target, view, count, uvs, results);
+}
+
 static void
 update_inputs(struct xrt_device *xdev)
 {
@@ -260,6 +272,8 @@ multi_create_tracking_override(enum xrt_tracking_override_type override_type,
 	d->base.set_output = set_output;
 	d->base.update_inputs = update_inputs;
 	d->base.compute_distortion = compute_distortion;
+	d->base.compute_distortion_batch = compute_distortion_batch;
+	d->base.compute_distortion_thread_safe = tracking_override_target->compute_distortion_thread_safe;
 	d->base.get_view_poses = get_view_poses;
 
 	return &d->base;
@@ -212,48 +212,42 @@ Vector2
 OpticalSystem::DisplayUVToRenderUVPreviousSeed(const Vector2 &inputUV)
 {
 	// if we don't find a point we generate it and add it to our list
-	Vector2 curDisplayUV;
+	Vector2 seed(0.5f, 0.5f);
+	int iterations = m_iniSolverIters;
+	bool found = false;
+
+	// Only the lookup and insert are locked, the solver only reads.
+	{
+		std::lock_guard<std::mutex> lock(m_requestedUVsMutex);
+
+		std::map<float, std::map<float, Vector2>>::iterator outerIter;
+		outerIter = m_requestedUVs.find(inputUV.x);
+		if (outerIter != m_requestedUVs.end()) {
+			std::map<float, Vector2>::iterator innerIter;
+			innerIter = outerIter->second.find(inputUV.y);
+
+			if (innerIter != outerIter->second.end()) {
+				// return the value we found
+				// hopefully we have remashed at least once otherwise
+				// we are giving back the same points again
+				seed = Vector2(innerIter->second.x, innerIter->second.y);
+				iterations = m_optSolverIters;
+				found = true;
+			}
+		}
+	}
 
-	std::map<float, std::map<float, Vector2>>::iterator outerIter;
-	outerIter = m_requestedUVs.find(inputUV.x);
-	if (outerIter == m_requestedUVs.end()) {
-		// if the outer value is not there we know the inner is not
-		// so we just slam both in and call it a day
-		std::map<float, Vector2> inner;
-		curDisplayUV = SolveDisplayUVToRenderUV(inputUV, Vector2(0.5f, 0.5f), m_iniSolverIters);
-
-		inner.insert(std::pair<float, Vector2>(inputUV.y, curDisplayUV));
-		m_requestedUVs.insert(std::pair<float, std::map<float, Vector2>>(inputUV.x, inner));
+	Vector2 curDisplayUV = SolveDisplayUVToRenderUV(inputUV, seed, iterations);
+
+	if (!found) {
+		std::lock_guard<std::mutex> lock(m_requestedUVsMutex);
+
+		// Another thread may have added the same point meanwhile, keep the first.
+		m_requestedUVs[inputUV.x].insert(std::pair<float, Vector2>(inputUV.y, curDisplayUV));
 		// Logger->DriverLog("NorthStar  Generated UV %g %g ",
 		// inputUV.x, inputUV.y);
-
-	} else {
-		std::map<float, Vector2>::iterator innerIter;
-		innerIter = outerIter->second.find(inputUV.y);
-
-		if (innerIter == outerIter->second.end()) {
-			// we assume there is no reason to ask for the same
-			// value so no need to check if it exists already so
-			// just add it.
-			curDisplayUV = SolveDisplayUVToRenderUV(inputUV, Vector2(0.5f, 0.5f), m_iniSolverIters);
-
-			outerIter->second.insert(std::pair<float, Vector2>(inputUV.y, curDisplayUV));
-			// Logger->DriverLog("NorthStar  Generated UV %g %g ",
-			// outerIter->first, innerIter->first);
-		} else {
-			// return the value we found
-			// hopefully we have remashed at least once otherwise
-			// we are giving back the same points again
-			// curDisplayUV.x = innerIter->second.x;
-			// curDisplayUV.y = innerIter->second.y;
-
-			curDisplayUV = SolveDisplayUVToRenderUV(
-			    inputUV, Vector2(innerIter->second.x, innerIter->second.y), m_optSolverIters);
-
-			// Logger->DriverLog("NorthStar  Found UV %g %g ",
-			// outerIter->first, innerIter->first);
-		}
 	}
+
 	return curDisplayUV;
 }
 
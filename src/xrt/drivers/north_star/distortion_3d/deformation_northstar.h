@@ -7,6 +7,7 @@
 #include "utility_northstar.h"
 #include "../ns_hmd.h"
 #include <map>
+#include <mutex>
 
 
 class OpticalSystem
@@ -104,6 +105,8 @@ private:
 	int m_iniSolverIters;
 	int m_optSolverIters;
 
+	//! Guards @ref m_requestedUVs, the distortion is computed on several threads at once.
+	std::mutex m_requestedUVsMutex;
 	std::map<float, std::map<float, Vector2> > m_requestedUVs;
 };
 
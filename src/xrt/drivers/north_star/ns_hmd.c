@@ -471,6 +471,7 @@ ns_hmd_create(const cJSON *config_json)
 
 
 	ns->base.compute_distortion = ns_mesh_calc;
+	ns->base.compute_distortion_thread_safe = true;
 	ns->base.update_inputs = ns_hmd_update_inputs;
 	ns->base.get_tracked_pose = ns_hmd_get_tracked_pose;
 	ns->base.get_view_poses = ns_hmd_get_view_poses;
@@ -1119,6 +1119,7 @@ na_hmd_create_device(struct os_hid_device *sensor_device,
 	hmd->base.get_tracked_pose = na_hmd_get_tracked_pose;
 	hmd->base.get_view_poses = na_hmd_get_view_poses;
 	hmd->base.compute_distortion = na_hmd_compute_distortion;
+	hmd->base.compute_distortion_thread_safe = true;
 	hmd->base.destroy = na_hmd_destroy;
 	hmd->base.name = XRT_DEVICE_GENERIC_HMD;
 	hmd->base.device_type = XRT_DEVICE_TYPE_HMD;
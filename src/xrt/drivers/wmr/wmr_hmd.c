@@ -2031,6 +2031,7 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
 	wh->base.hmd->distortion.models = XRT_DISTORTION_MODEL_COMPUTE;
 	wh->base.hmd->distortion.preferred = XRT_DISTORTION_MODEL_COMPUTE;
 	wh->base.compute_distortion = compute_distortion_wmr;
+	wh->base.compute_distortion_thread_safe = true;
 	u_distortion_mesh_fill_in_compute(&wh->base);
 
 	// Set initial HMD screen power state.
@@ -96,6 +96,11 @@ enum xrt_layer_composition_flags
 	 * adjusted for the IPD.
 	 */
 	XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT = 1u << 3u,
+	/*!
+	 * Use the depth of a projection layer with depth to also correct for
+	 * the position of the head when timewarping, not just the rotation.
+	 */
+	XRT_LAYER_COMPOSITION_DEPTH_REPROJECTION_BIT = 1u << 4u,
 };
 
 /*!
@@ -838,6 +843,12 @@ struct xrt_session_info
 	bool is_overlay;
 	uint64_t flags;
 	uint32_t z_order;
+
+	/*!
+	 * Projection layers with depth from this session are reprojected using
+	 * their depth, see @ref XRT_LAYER_COMPOSITION_DEPTH_REPROJECTION_BIT.
+	 */
+	bool depth_reprojection;
 };
 
 /*!
@@ -1975,6 +1986,26 @@ struct xrt_compositor_native
 {
 	//! @public Base
 	struct xrt_compositor base;
+
+	/*!
+	 * Optional, create a swapchain on behalf of @p owner. Compositors that
+	 * reuse the images of destroyed swapchains only give them to swapchains
+	 * of the same owner, used when one compositor serves several clients.
+	 *
+	 * @see xrt_comp_native_create_owned_swapchain
+	 */
+	xrt_result_t (*create_owned_swapchain)(struct xrt_compositor_native *xcn,
+	                                       uint64_t owner,
+	                                       const struct xrt_swapchain_create_info *info,
+	                                       struct xrt_swapchain **out_xsc);
+
+	/*!
+	 * Optional, @p owner will not create any more swapchains, anything
+	 * kept around for it can be freed.
+	 *
+	 * @see xrt_comp_native_release_owner
+	 */
+	void (*release_owner)(struct xrt_compositor_native *xcn, uint64_t owner);
 };
 
 /*!
@@ -2011,6 +2042,45 @@ xrt_comp_native_create_swapchain(struct xrt_compositor_native *xcn,
 	return ret;
 }
 
+/*!
+ * @copydoc xrt_compositor_native::create_owned_swapchain
+ *
+ * Helper for calling through the function pointer, falls back to
+ * @ref xrt_comp_create_swapchain if the compositor doesn't implement it.
+ *
+ * @public @memberof xrt_compositor_native
+ */
+static inline xrt_result_t
+xrt_comp_native_create_owned_swapchain(struct xrt_compositor_native *xcn,
+                                       uint64_t owner,
+                                       const struct xrt_swapchain_create_info *info,
+                                       struct xrt_swapchain **out_xsc)
+{
+	if (xcn->create_owned_swapchain == NULL) {
+		return xrt_comp_create_swapchain(&xcn->base, info, out_xsc);
+	}
+
+	return xcn->create_owned_swapchain(xcn, owner, info, out_xsc);
+}
+
+/*!
+ * @copydoc xrt_compositor_native::release_owner
+ *
+ * Helper for calling through the function pointer, does nothing if the
+ * compositor doesn't implement it.
+ *
+ * @public @memberof xrt_compositor_native
+ */
+static inline void
+xrt_comp_native_release_owner(struct xrt_compositor_native *xcn, uint64_t owner)
+{
+	if (xcn->release_owner == NULL) {
+		return;
+	}
+
+	xcn->release_owner(xcn, owner);
+}
+
 /*!
  * @copydoc xrt_compositor::destroy
  *
@@ -263,6 +263,13 @@ struct xrt_device
 	bool force_feedback_supported;
 	bool form_factor_check_supported;
 
+	/*!
+	 * Set if @ref compute_distortion and @ref compute_distortion_batch may
+	 * be called from several threads at once, otherwise they are only ever
+	 * called from one thread at a time.
+	 */
+	bool compute_distortion_thread_safe;
+
 	/*!
 	 * Update any attached inputs.
 	 *
@@ -387,6 +394,9 @@ struct xrt_device
 	 * the lookup (vertex attribute or distortion texture) used to pre-distort the image as required by the device's
 	 * optics.
 	 *
+	 * The distortion images and mesh are filled in on worker threads if the
+	 * device sets @ref compute_distortion_thread_safe.
+	 *
 	 * @param xdev            the device
 	 * @param view            the view index
 	 * @param u               horizontal texture coordinate
@@ -396,6 +406,23 @@ struct xrt_device
 	bool (*compute_distortion)(
 	    struct xrt_device *xdev, uint32_t view, float u, float v, struct xrt_uv_triplet *out_result);
 
+	/*!
+	 * Compute the distortion at many points, like @ref compute_distortion
+	 * but for a whole array of points at a time. Optional, should give the
+	 * same results as @ref compute_distortion.
+	 *
+	 * @param xdev             the device
+	 * @param view             the view index
+	 * @param count            number of points
+	 * @param uvs              @p count u,v points in screen/output space
+	 * @param[out] out_results @p count corresponding u,v pairs for all three color channels.
+	 */
+	bool (*compute_distortion_batch)(struct xrt_device *xdev,
+	                                 uint32_t view,
+	                                 uint32_t count,
+	                                 const struct xrt_vec2 *uvs,
+	                                 struct xrt_uv_triplet *out_results);
+
 	/*!
 	 * Destroy device.
 	 */
@@ -506,6 +533,35 @@ xrt_device_compute_distortion(
 	return xdev->compute_distortion(xdev, view, u, v, out_result);
 }
 
+/*!
+ * Helper function for @ref xrt_device::compute_distortion_batch, falls back
+ * to calling @ref xrt_device::compute_distortion for each point if the device
+ * doesn't implement it.
+ *
+ * @copydoc xrt_device::compute_distortion_batch
+ *
+ * @public @memberof xrt_device
+ */
+static inline bool
+xrt_device_compute_distortion_batch(struct xrt_device *xdev,
+                                    uint32_t view,
+                                    uint32_t count,
+                                    const struct xrt_vec2 *uvs,
+                                    struct xrt_uv_triplet *out_results)
+{
+	if (xdev->compute_distortion_batch != NULL) {
+		return xdev->compute_distortion_batch(xdev, view, count, uvs, out_results);
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (!xdev->compute_distortion(xdev, view, uvs[i].x, uvs[i].y, &out_results[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 /*!
  * Helper function for @ref xrt_device::destroy.
  *
@@ -158,6 +158,32 @@ struct xrt_space_overseer
 	                             const struct xrt_pose *offset,
 	                             struct xrt_space_relation *out_relation);
 
+	/*!
+	 * Locate multiple spaces in the base space at the same time, the result
+	 * is the same as calling @ref locate_space for each space but lets the
+	 * implementation do it in one go, for instance one IPC call instead of
+	 * one per space.
+	 *
+	 * @see xrt_device::get_tracked_pose.
+	 *
+	 * @param[in] xso             Owning space overseer.
+	 * @param[in] base_space      The space that we want the poses in.
+	 * @param[in] base_offset     Offset if any to the base space.
+	 * @param[in] at_timestamp_ns At which time.
+	 * @param[in] spaces          Array of spaces to be located.
+	 * @param[in] space_count     Number of spaces, offsets and relations.
+	 * @param[in] offsets         Array of offsets, one per space.
+	 * @param[out] out_relations  Array of resulting poses, one per space.
+	 */
+	xrt_result_t (*locate_spaces)(struct xrt_space_overseer *xso,
+	                              struct xrt_space *base_space,
+	                              const struct xrt_pose *base_offset,
+	                              uint64_t at_timestamp_ns,
+	                              struct xrt_space **spaces,
+	                              uint32_t space_count,
+	                              const struct xrt_pose *offsets,
+	                              struct xrt_space_relation *out_relations);
+
 	/*!
 	 * Locate a the origin of the tracking space of a device, this is not
 	 * the same as the device position. In other words, what is the position
@@ -240,6 +266,40 @@ xrt_space_overseer_locate_space(struct xrt_space_overseer *xso,
 	return xso->locate_space(xso, base_space, base_offset, at_timestamp_ns, space, offset, out_relation);
 }
 
+/*!
+ * @copydoc xrt_space_overseer::locate_spaces
+ *
+ * Helper for calling through the function pointer, falls back to calling
+ * @ref xrt_space_overseer::locate_space for each space if not implemented.
+ *
+ * @public @memberof xrt_space_overseer
+ */
+static inline xrt_result_t
+xrt_space_overseer_locate_spaces(struct xrt_space_overseer *xso,
+                                 struct xrt_space *base_space,
+                                 const struct xrt_pose *base_offset,
+                                 uint64_t at_timestamp_ns,
+                                 struct xrt_space **spaces,
+                                 uint32_t space_count,
+                                 const struct xrt_pose *offsets,
+                                 struct xrt_space_relation *out_relations)
+{
+	if (xso->locate_spaces != NULL) {
+		return xso->locate_spaces(xso, base_space, base_offset, at_timestamp_ns, spaces, space_count, offsets,
+		                          out_relations);
+	}
+
+	for (uint32_t i = 0; i < space_count; i++) {
+		xrt_result_t xret = xso->locate_space(xso, base_space, base_offset, at_timestamp_ns, spaces[i],
+		                                      &offsets[i], &out_relations[i]);
+		if (xret != XRT_SUCCESS) {
+			return xret;
+		}
+	}
+
+	return XRT_SUCCESS;
+}
+
 /*!
  * @copydoc xrt_space_overseer::locate_device
  *
@@ -52,9 +52,14 @@ struct ipc_connection
 
 	struct ipc_shared_memory *ism;
 	xrt_shmem_handle_t ism_handle;
+	//! Size of the mapping, read from the shared memory header.
+	size_t ism_size;
 
 	struct os_mutex mutex;
 
+	//! Send handles along with the command, saving a round trip.
+	bool inline_handles;
+
 #ifdef XRT_OS_ANDROID
 	struct ipc_client_android *ica;
 #endif // XRT_OS_ANDROID
@@ -75,6 +80,9 @@ struct ipc_client_xdev
 	struct ipc_connection *ipc_c;
 
 	uint32_t device_id;
+
+	//! Generation of the inputs last copied out of the shared memory, -1 if none.
+	int32_t input_generation;
 };
 
 
@@ -118,3 +126,42 @@ ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origi
 
 struct xrt_space_overseer *
 ipc_client_space_overseer_create(struct ipc_connection *ipc_c);
+
+/*!
+ * Try to get a tracked pose from the pose histories the server publishes in
+ * the shared memory, without doing a IPC call. Returns false if there is no
+ * usable history for this input and time, the caller then has to do the call.
+ *
+ * Times past the newest sample are extrapolated from it with
+ * @ref m_predict_relation, not predicted by the driver, so the result can
+ * differ from what the call would return. This is only done up to
+ * the max_prediction_ns in the shared memory past the newest sample, which
+ * covers the gap between publishes, further out the driver's own prediction
+ * is used through the call.
+ *
+ * @public @memberof ipc_client_xdev
+ */
+bool
+ipc_client_xdev_get_shared_tracked_pose(struct ipc_client_xdev *icx,
+                                        enum xrt_input_name name,
+                                        uint64_t at_timestamp_ns,
+                                        struct xrt_space_relation *out_relation);
+
+/*!
+ * Fill in the inputs from the shared memory when creating the device, the
+ * inputs must have been allocated with the device.
+ *
+ * @public @memberof ipc_client_xdev
+ */
+void
+ipc_client_xdev_init_inputs(struct ipc_client_xdev *icx);
+
+/*!
+ * Bring the inputs up to date, skips the call if the server keeps the inputs
+ * in the shared memory up to date on its own. The inputs are only copied out
+ * of the shared memory when their generation has changed.
+ *
+ * @public @memberof ipc_client_xdev
+ */
+void
+ipc_client_xdev_update_inputs(struct ipc_client_xdev *icx);
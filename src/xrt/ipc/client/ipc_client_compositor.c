@@ -17,12 +17,17 @@
 #include "os/os_time.h"
 
 #include "util/u_misc.h"
+#include "util/u_time.h"
 #include "util/u_wait.h"
+#include "util/u_debug.h"
 #include "util/u_handles.h"
 #include "util/u_trace_marker.h"
 #include "util/u_limited_unique_id.h"
 
 #include "shared/ipc_protocol.h"
+#include "shared/ipc_shared_frame_timing.h"
+#include "shared/ipc_shared_layer.h"
+#include "shared/ipc_shared_layout.h"
 #include "client/ipc_client.h"
 #include "ipc_client_generated.h"
 
@@ -50,6 +55,8 @@
 //! Define to test the loopback allocator.
 #undef IPC_USE_LOOPBACK_IMAGE_ALLOCATOR
 
+DEBUG_GET_ONCE_BOOL_OPTION(ipc_shm_frame_timing, "IPC_SHM_FRAME_TIMING", false)
+
 /*!
  * Client proxy for an xrt_compositor_native implementation over IPC.
  * @implements xrt_compositor_native
@@ -72,6 +79,18 @@ struct ipc_client_compositor
 		uint32_t slot_id;
 
 		uint32_t layer_count;
+
+		//! Layers written in full to the slot this frame.
+		uint32_t full_mask;
+
+		/*!
+		 * What the server has for each layer, the slot only carries
+		 * deltas against these. Updated as the layers are added.
+		 */
+		struct ipc_layer_entry sent[IPC_MAX_LAYERS];
+
+		//! Number of entries in @p sent the server got last frame.
+		uint32_t sent_count;
 	} layers;
 
 	//! Has the native compositor been created, only supports one for now.
@@ -80,6 +99,19 @@ struct ipc_client_compositor
 	//! To get better wake up in wait frame.
 	struct os_precise_sleeper sleeper;
 
+	/*!
+	 * Frame timing predicted by the server into the shared memory, lets
+	 * wait frame skip the predict and woke calls.
+	 */
+	struct
+	{
+		//! Slot in the shared memory, NULL if not enabled.
+		struct ipc_shared_frame_timing *isft;
+
+		//! Period of the last frame, bounds how long we wait on the slot.
+		uint64_t last_period_ns;
+	} frame_timing;
+
 #ifdef IPC_USE_LOOPBACK_IMAGE_ALLOCATOR
 	//! To test image allocator.
 	struct xrt_image_native_allocator loopback_xina;
@@ -511,6 +543,54 @@ ipc_compositor_end_session(struct xrt_compositor *xc)
 	return res;
 }
 
+/*!
+ * Try to get the frame through the shared memory, the server predicts it as
+ * soon as we ring the doorbell so no call is needed.
+ */
+static bool
+wait_frame_shared(struct ipc_client_compositor *icc,
+                  int64_t *out_frame_id,
+                  uint64_t *out_predicted_display_time,
+                  uint64_t *out_predicted_display_period)
+{
+	struct ipc_shared_frame_timing *isft = icc->frame_timing.isft;
+	struct ipc_frame_prediction prediction;
+
+	if (isft == NULL) {
+		return false;
+	}
+
+	// Another thread is already waiting on the slot.
+	if (!ipc_shared_frame_timing_request(isft, &icc->ipc_c->ism->frame_timing_doorbell)) {
+		return false;
+	}
+
+	// The server answers right away, only time out if it is stuck.
+	uint64_t timeout_ns = icc->frame_timing.last_period_ns * 2;
+	if (timeout_ns == 0) {
+		timeout_ns = U_TIME_1MS_IN_NS * 20;
+	}
+
+	if (!ipc_shared_frame_timing_wait(isft, timeout_ns, &prediction)) {
+		IPC_DEBUG(icc->ipc_c, "Timed out waiting for the frame timing, using calls for this frame.");
+		return false;
+	}
+
+	// Wait until the given wake up time.
+	u_wait_until(&icc->sleeper, prediction.wake_up_time_ns);
+
+	// Picked up by the server in begin frame, no need for a call.
+	ipc_shared_frame_timing_write_woke(isft, prediction.frame_id, os_monotonic_get_ns());
+
+	icc->frame_timing.last_period_ns = prediction.predicted_display_period_ns;
+
+	*out_frame_id = prediction.frame_id;
+	*out_predicted_display_time = prediction.predicted_display_time_ns;
+	*out_predicted_display_period = prediction.predicted_display_period_ns;
+
+	return true;
+}
+
 static xrt_result_t
 ipc_compositor_wait_frame(struct xrt_compositor *xc,
                           int64_t *out_frame_id,
@@ -520,6 +600,10 @@ ipc_compositor_wait_frame(struct xrt_compositor *xc,
 	IPC_TRACE_MARKER();
 	struct ipc_client_compositor *icc = ipc_client_compositor(xc);
 
+	if (wait_frame_shared(icc, out_frame_id, out_predicted_display_time, out_predicted_display_period)) {
+		return XRT_SUCCESS;
+	}
+
 	int64_t frame_id = -1;
 	uint64_t wake_up_time_ns = 0;
 	uint64_t predicted_display_time = 0;
@@ -538,6 +622,8 @@ ipc_compositor_wait_frame(struct xrt_compositor *xc,
 	// Signal that we woke up.
 	res = ipc_call_compositor_wait_woke(icc->ipc_c, frame_id);
 
+	icc->frame_timing.last_period_ns = predicted_display_period;
+
 	// Only write arguments once we have fully waited.
 	*out_frame_id = frame_id;
 	*out_predicted_display_time = predicted_display_time;
@@ -556,13 +642,60 @@ ipc_compositor_begin_frame(struct xrt_compositor *xc, int64_t frame_id)
 	return res;
 }
 
+/*!
+ * Write @p layer to the slot, only the per frame fields if that is all that
+ * changed since the last frame.
+ */
+static xrt_result_t
+push_layer(struct ipc_client_compositor *icc, const struct ipc_layer_entry *layer)
+{
+	uint32_t i = icc->layers.layer_count;
+	if (i >= IPC_MAX_LAYERS) {
+		IPC_ERROR(icc->ipc_c, "Too many layers, max is %u!", IPC_MAX_LAYERS);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	struct ipc_shared_memory *ism = icc->ipc_c->ism;
+	struct ipc_layer_slot *slot = ipc_shared_slot(ism, icc->layers.slot_id);
+	struct ipc_layer_entry *sent = &icc->layers.sent[i];
+
+	struct ipc_layer_update update;
+	ipc_shared_layer_get_update(layer, &update);
+
+	if (i < icc->layers.sent_count && ipc_shared_layer_try_update(sent, layer, &update)) {
+		slot->updates[i] = update;
+	} else {
+		*sent = *layer;
+		slot->layers[i] = *layer;
+		icc->layers.full_mask |= 1u << i;
+	}
+
+	// Increment the number of layers.
+	icc->layers.layer_count++;
+
+	return XRT_SUCCESS;
+}
+
+/*!
+ * Called after the sync call, on failure the server might not have the
+ * layers so send everything in full next frame.
+ */
+static void
+reset_layers(struct ipc_client_compositor *icc, xrt_result_t res)
+{
+	icc->layers.sent_count = res == XRT_SUCCESS ? icc->layers.layer_count : 0;
+
+	icc->layers.layer_count = 0;
+	icc->layers.full_mask = 0;
+}
+
 static xrt_result_t
 ipc_compositor_layer_begin(struct xrt_compositor *xc, const struct xrt_layer_frame_data *data)
 {
 	struct ipc_client_compositor *icc = ipc_client_compositor(xc);
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = ipc_shared_slot(ism, icc->layers.slot_id);
 
 	slot->data = *data;
 
@@ -580,23 +713,21 @@ ipc_compositor_layer_stereo_projection(struct xrt_compositor *xc,
 
 	assert(data->type == XRT_LAYER_STEREO_PROJECTION);
 
-	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
-	struct ipc_layer_entry *layer = &slot->layers[icc->layers.layer_count];
+	// Zeroed so padding compares the same every frame.
+	struct ipc_layer_entry layer;
+	U_ZERO(&layer);
+
 	struct ipc_client_swapchain *l = ipc_client_swapchain(l_xsc);
 	struct ipc_client_swapchain *r = ipc_client_swapchain(r_xsc);
 
-	layer->xdev_id = 0; //! @todo Real id.
-	layer->swapchain_ids[0] = l->id;
-	layer->swapchain_ids[1] = r->id;
-	layer->swapchain_ids[2] = -1;
-	layer->swapchain_ids[3] = -1;
-	layer->data = *data;
-
-	// Increment the number of layers.
-	icc->layers.layer_count++;
+	layer.xdev_id = 0; //! @todo Real id.
+	layer.swapchain_ids[0] = l->id;
+	layer.swapchain_ids[1] = r->id;
+	layer.swapchain_ids[2] = -1;
+	layer.swapchain_ids[3] = -1;
+	layer.data = *data;
 
-	return XRT_SUCCESS;
+	return push_layer(icc, &layer);
 }
 
 static xrt_result_t
@@ -612,25 +743,23 @@ ipc_compositor_layer_stereo_projection_depth(struct xrt_compositor *xc,
 
 	assert(data->type == XRT_LAYER_STEREO_PROJECTION_DEPTH);
 
-	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
-	struct ipc_layer_entry *layer = &slot->layers[icc->layers.layer_count];
+	// Zeroed so padding compares the same every frame.
+	struct ipc_layer_entry layer;
+	U_ZERO(&layer);
+
 	struct ipc_client_swapchain *l = ipc_client_swapchain(l_xsc);
 	struct ipc_client_swapchain *r = ipc_client_swapchain(r_xsc);
 	struct ipc_client_swapchain *l_d = ipc_client_swapchain(l_d_xsc);
 	struct ipc_client_swapchain *r_d = ipc_client_swapchain(r_d_xsc);
 
-	layer->xdev_id = 0; //! @todo Real id.
-	layer->swapchain_ids[0] = l->id;
-	layer->swapchain_ids[1] = r->id;
-	layer->swapchain_ids[2] = l_d->id;
-	layer->swapchain_ids[3] = r_d->id;
-	layer->data = *data;
-
-	// Increment the number of layers.
-	icc->layers.layer_count++;
+	layer.xdev_id = 0; //! @todo Real id.
+	layer.swapchain_ids[0] = l->id;
+	layer.swapchain_ids[1] = r->id;
+	layer.swapchain_ids[2] = l_d->id;
+	layer.swapchain_ids[3] = r_d->id;
+	layer.data = *data;
 
-	return XRT_SUCCESS;
+	return push_layer(icc, &layer);
 }
 
 static xrt_result_t
@@ -644,22 +773,20 @@ handle_layer(struct xrt_compositor *xc,
 
 	assert(data->type == type);
 
-	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
-	struct ipc_layer_entry *layer = &slot->layers[icc->layers.layer_count];
+	// Zeroed so padding compares the same every frame.
+	struct ipc_layer_entry layer;
+	U_ZERO(&layer);
+
 	struct ipc_client_swapchain *ics = ipc_client_swapchain(xsc);
 
-	layer->xdev_id = 0; //! @todo Real id.
-	layer->swapchain_ids[0] = ics->id;
-	layer->swapchain_ids[1] = -1;
-	layer->swapchain_ids[2] = -1;
-	layer->swapchain_ids[3] = -1;
-	layer->data = *data;
+	layer.xdev_id = 0; //! @todo Real id.
+	layer.swapchain_ids[0] = ics->id;
+	layer.swapchain_ids[1] = -1;
+	layer.swapchain_ids[2] = -1;
+	layer.swapchain_ids[3] = -1;
+	layer.data = *data;
 
-	// Increment the number of layers.
-	icc->layers.layer_count++;
-
-	return XRT_SUCCESS;
+	return push_layer(icc, &layer);
 }
 
 static xrt_result_t
@@ -715,10 +842,11 @@ ipc_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handle_
 	bool valid_sync = xrt_graphics_sync_handle_is_valid(sync_handle);
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = ipc_shared_slot(ism, icc->layers.slot_id);
 
 	// Last bit of data to put in the shared memory area.
 	slot->layer_count = icc->layers.layer_count;
+	slot->full_mask = icc->layers.full_mask;
 
 	IPC_CALL_CHK(ipc_call_compositor_layer_sync( //
 	    icc->ipc_c,                              //
@@ -728,8 +856,7 @@ ipc_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handle_
 	    &icc->layers.slot_id));                  //
 
 	// Reset.
-	icc->layers.layer_count = 0;
-
+	reset_layers(icc, res);
 	// Need to consume this handle.
 	if (valid_sync) {
 		u_graphics_sync_unref(&sync_handle);
@@ -747,10 +874,11 @@ ipc_compositor_layer_commit_with_semaphore(struct xrt_compositor *xc,
 	struct ipc_client_compositor_semaphore *iccs = ipc_client_compositor_semaphore(xcsem);
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = ipc_shared_slot(ism, icc->layers.slot_id);
 
 	// Last bit of data to put in the shared memory area.
 	slot->layer_count = icc->layers.layer_count;
+	slot->full_mask = icc->layers.full_mask;
 
 	IPC_CALL_CHK(ipc_call_compositor_layer_sync_with_semaphore( //
 	    icc->ipc_c,                                             //
@@ -760,8 +888,7 @@ ipc_compositor_layer_commit_with_semaphore(struct xrt_compositor *xc,
 	    &icc->layers.slot_id));                                 //
 
 	// Reset.
-	icc->layers.layer_count = 0;
-
+	reset_layers(icc, res);
 	return res;
 }
 
@@ -796,6 +923,8 @@ ipc_compositor_destroy(struct xrt_compositor *xc)
 
 	os_precise_sleeper_deinit(&icc->sleeper);
 
+	U_ZERO(&icc->frame_timing);
+
 	icc->compositor_created = false;
 }
 
@@ -967,6 +1096,19 @@ ipc_syscomp_create_native_compositor(struct xrt_system_compositor *xsc,
 		return res;
 	}
 
+	// Optional, falls back to the predict and woke calls if not enabled.
+	if (debug_get_bool_option_ipc_shm_frame_timing()) {
+		uint32_t slot_index = 0;
+		xrt_result_t xret = ipc_call_compositor_enable_frame_timing(icc->ipc_c, &slot_index);
+		struct ipc_shared_memory *ism = icc->ipc_c->ism;
+		uint32_t slot_count = ipc_shared_section_count(ism, IPC_SHARED_SECTION_FRAME_TIMINGS);
+		if (xret == XRT_SUCCESS && slot_index < slot_count) {
+			icc->frame_timing.isft = ipc_shared_frame_timing(ism, slot_index);
+		} else {
+			IPC_WARN(icc->ipc_c, "Could not enable shared memory frame timing, using calls.");
+		}
+	}
+
 	// Needs to be done after session create call.
 	ipc_compositor_init(icc, out_xcn);
 
@@ -27,6 +27,9 @@
 #include "util/u_system_helpers.h"
 
 #include "shared/ipc_protocol.h"
+#include "shared/ipc_call_stats.h"
+#include "shared/ipc_shmem.h"
+#include "shared/ipc_shared_layout.h"
 #include "client/ipc_client_connection.h"
 
 #include "ipc_client_generated.h"
@@ -55,6 +58,7 @@
 #endif // XRT_OS_ANDROID
 
 DEBUG_GET_ONCE_BOOL_OPTION(ipc_ignore_version, "IPC_IGNORE_VERSION", false)
+DEBUG_GET_ONCE_BOOL_OPTION(ipc_inline_handles, "IPC_INLINE_HANDLES", false)
 
 #ifdef XRT_OS_ANDROID
 
@@ -263,6 +267,7 @@ ipc_client_connection_init(struct ipc_connection *ipc_c,
 	os_mutex_init(&ipc_c->mutex);
 
 	ipc_c->log_level = log_level;
+	ipc_c->inline_handles = debug_get_bool_option_ipc_inline_handles();
 
 	if (!ipc_client_socket_connect(ipc_c)) {
 		IPC_ERROR(ipc_c,
@@ -302,22 +307,44 @@ ipc_client_connection_init(struct ipc_connection *ipc_c,
 		return xret;
 	}
 
-	const size_t size = sizeof(struct ipc_shared_memory);
+	// Only the header first, it tells us how big the whole thing is.
+	size_t size = sizeof(struct ipc_shared_memory);
 
-#ifdef XRT_OS_WINDOWS
-	ipc_c->ism = MapViewOfFile(ipc_c->ism_handle, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, size);
-#else
-	const int flags = MAP_SHARED;
-	const int access = PROT_READ | PROT_WRITE;
+	xret = ipc_shmem_map(ipc_c->ism_handle, size, (void **)&ipc_c->ism);
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(ipc_c, "Failed to mmap shm!");
+		ipc_client_connection_fini(ipc_c);
+		return XRT_ERROR_IPC_FAILURE;
+	}
 
-	ipc_c->ism = mmap(NULL, size, access, flags, ipc_c->ism_handle, 0);
-#endif
-	if (ipc_c->ism == NULL) {
+	// Can't make sense of anything else in there if this doesn't match.
+	if (ipc_c->ism->layout_version != IPC_SHARED_MEMORY_LAYOUT_VERSION) {
+		IPC_ERROR(ipc_c, "Shared memory layout version %u does not match ours %u", ipc_c->ism->layout_version,
+		          IPC_SHARED_MEMORY_LAYOUT_VERSION);
+		ipc_shmem_unmap((void **)&ipc_c->ism, size);
+		ipc_client_connection_fini(ipc_c);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	size_t total_size = (size_t)ipc_c->ism->total_size;
+	ipc_shmem_unmap((void **)&ipc_c->ism, size);
+
+	xret = ipc_shmem_map(ipc_c->ism_handle, total_size, (void **)&ipc_c->ism);
+	if (xret != XRT_SUCCESS) {
 		IPC_ERROR(ipc_c, "Failed to mmap shm!");
 		ipc_client_connection_fini(ipc_c);
 		return XRT_ERROR_IPC_FAILURE;
 	}
 
+	ipc_c->ism_size = total_size;
+
+	if (!ipc_shared_layout_validate(ipc_c->ism, ipc_c->ism_size)) {
+		IPC_ERROR(ipc_c, "Invalid shared memory layout!");
+		ipc_shmem_unmap((void **)&ipc_c->ism, ipc_c->ism_size);
+		ipc_client_connection_fini(ipc_c);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
 	if (strncmp(u_git_tag, ipc_c->ism->u_git_tag, IPC_VERSION_NAME_LEN) != 0) {
 		IPC_ERROR(ipc_c, "Monado client library version %s does not match service version %s", u_git_tag,
 		          ipc_c->ism->u_git_tag);
@@ -343,3 +370,31 @@ ipc_client_connection_fini(struct ipc_connection *ipc_c)
 	ipc_client_android_destroy(&(ipc_c->ica));
 #endif
 }
+
+xrt_result_t
+ipc_client_connection_get_call_stats(struct ipc_connection *ipc_c,
+                                     uint32_t client_id,
+                                     struct ipc_call_stats *out_stats)
+{
+	U_ZERO(out_stats);
+
+	uint32_t first_command = 0;
+	do {
+		struct ipc_call_stats_page page;
+
+		xrt_result_t xret = ipc_call_system_get_client_call_stats(ipc_c, client_id, first_command, &page);
+		if (xret != XRT_SUCCESS) {
+			return xret;
+		}
+
+		// Must always move forward, or we could loop forever.
+		if (!ipc_call_stats_put_page(out_stats, &page) ||
+		    (page.next_command != 0 && page.next_command <= first_command)) {
+			return XRT_ERROR_IPC_FAILURE;
+		}
+
+		first_command = page.next_command;
+	} while (first_command != 0);
+
+	return XRT_SUCCESS;
+}
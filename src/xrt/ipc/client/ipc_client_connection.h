@@ -38,3 +38,19 @@ ipc_client_connection_init(struct ipc_connection *ipc_c,
  */
 void
 ipc_client_connection_fini(struct ipc_connection *ipc_c);
+
+/*!
+ * Get the call stats of a client, a @p client_id of zero gets the stats of
+ * all clients together. The stats are fetched a page at a time so this may
+ * do several calls, the result can be torn if the client is running.
+ * @param ipc_c     initialized IPC connection struct
+ * @param client_id Client to get the stats for
+ * @param out_stats Stats of the commands, not called ones are zeroed
+ * @return XRT_SUCCESS on success
+ *
+ * @ingroup ipc_client
+ */
+xrt_result_t
+ipc_client_connection_get_call_stats(struct ipc_connection *ipc_c,
+                                     uint32_t client_id,
+                                     struct ipc_call_stats *out_stats);
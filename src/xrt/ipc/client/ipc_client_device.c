@@ -18,6 +18,9 @@
 #include "util/u_debug.h"
 #include "util/u_device.h"
 
+#include "shared/ipc_shared_pose.h"
+#include "shared/ipc_shared_input.h"
+#include "shared/ipc_shared_layout.h"
 #include "client/ipc_client.h"
 #include "ipc_client_generated.h"
 
@@ -65,7 +68,6 @@ ipc_client_device_destroy(struct xrt_device *xdev)
 	u_var_remove_root(icd);
 
 	// We do not own these, so don't free them.
-	icd->base.inputs = NULL;
 	icd->base.outputs = NULL;
 
 	// Free this device with the helper.
@@ -77,10 +79,7 @@ ipc_client_device_update_inputs(struct xrt_device *xdev)
 {
 	ipc_client_device_t *icd = ipc_client_device(xdev);
 
-	xrt_result_t r = ipc_call_device_update_input(icd->ipc_c, icd->device_id);
-	if (r != XRT_SUCCESS) {
-		IPC_ERROR(icd->ipc_c, "Error sending input update!");
-	}
+	ipc_client_xdev_update_inputs(icd);
 }
 
 static void
@@ -91,6 +90,10 @@ ipc_client_device_get_tracked_pose(struct xrt_device *xdev,
 {
 	ipc_client_device_t *icd = ipc_client_device(xdev);
 
+	if (ipc_client_xdev_get_shared_tracked_pose(icd, name, at_timestamp_ns, out_relation)) {
+		return;
+	}
+
 	xrt_result_t r =
 	    ipc_call_device_get_tracked_pose(icd->ipc_c, icd->device_id, name, at_timestamp_ns, out_relation);
 	if (r != XRT_SUCCESS) {
@@ -138,6 +141,104 @@ ipc_client_device_set_output(struct xrt_device *xdev, enum xrt_output_name name,
 	}
 }
 
+static bool
+read_shared_inputs(struct ipc_client_xdev *icx)
+{
+	struct ipc_shared_memory *ism = icx->ipc_c->ism;
+	struct ipc_shared_device *isdev = ipc_shared_isdev(ism, icx->device_id);
+
+	return ipc_shared_inputs_read(                       //
+	    ipc_shared_input_generation(ism, icx->device_id), //
+	    &icx->input_generation,                           //
+	    icx->base.inputs,                                 //
+	    ipc_shared_input(ism, isdev->first_input_index),  //
+	    icx->base.input_count);                           //
+}
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+ipc_client_xdev_init_inputs(struct ipc_client_xdev *icx)
+{
+	struct ipc_shared_memory *ism = icx->ipc_c->ism;
+	struct ipc_shared_device *isdev = ipc_shared_isdev(ism, icx->device_id);
+
+	// Might be torn, the first update copies them again.
+	memcpy(icx->base.inputs, ipc_shared_input(ism, isdev->first_input_index),
+	       sizeof(struct xrt_input) * icx->base.input_count);
+	icx->input_generation = -1;
+}
+
+void
+ipc_client_xdev_update_inputs(struct ipc_client_xdev *icx)
+{
+	struct ipc_shared_memory *ism = icx->ipc_c->ism;
+
+	// Server keeps them up to date, unless it has turned it off or needs to do IO checks.
+	if (ism->input_state.published != 0 && read_shared_inputs(icx)) {
+		return;
+	}
+
+	xrt_result_t r = ipc_call_device_update_input(icx->ipc_c, icx->device_id);
+	if (r != XRT_SUCCESS) {
+		IPC_ERROR(icx->ipc_c, "Error sending input update!");
+		return;
+	}
+
+	if (!read_shared_inputs(icx)) {
+		IPC_WARN(icx->ipc_c, "Inputs kept changing while being copied!");
+	}
+}
+
+bool
+ipc_client_xdev_get_shared_tracked_pose(struct ipc_client_xdev *icx,
+                                        enum xrt_input_name name,
+                                        uint64_t at_timestamp_ns,
+                                        struct xrt_space_relation *out_relation)
+{
+	struct ipc_shared_memory *ism = icx->ipc_c->ism;
+
+	// Server has turned it off, or needs to do IO checks.
+	if (ism->poses.enabled == 0) {
+		return false;
+	}
+
+	// The server reports inactive poses as errors, let it do that.
+	struct xrt_input *input = NULL;
+	for (uint32_t i = 0; i < icx->base.input_count; i++) {
+		if (icx->base.inputs[i].name == name) {
+			input = &icx->base.inputs[i];
+			break;
+		}
+	}
+
+	if (input == NULL || !input->active) {
+		return false;
+	}
+
+	uint32_t history_capacity = ipc_shared_section_count(ism, IPC_SHARED_SECTION_POSE_HISTORIES);
+	uint32_t count = MIN(ism->poses.history_count, history_capacity);
+	for (uint32_t i = 0; i < count; i++) {
+		struct ipc_shared_pose_history *isph = ipc_shared_pose_history(ism, i);
+		if (isph->device_index != icx->device_id || isph->name != name) {
+			continue;
+		}
+
+		// Fails past max_prediction_ns, the driver is better at predicting far out.
+		return ipc_shared_pose_history_get( //
+		    isph,                           //
+		    at_timestamp_ns,                //
+		    ism->poses.max_prediction_ns,   //
+		    out_relation);                  //
+	}
+
+	return false;
+}
+
 /*!
  * @public @memberof ipc_client_device
  */
@@ -146,11 +247,11 @@ ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origi
 {
 	// Helpers.
 	struct ipc_shared_memory *ism = ipc_c->ism;
-	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
+	struct ipc_shared_device *isdev = ipc_shared_isdev(ism, device_id);
 
 	// Allocate and setup the basics.
 	enum u_device_alloc_flags flags = (enum u_device_alloc_flags)(U_DEVICE_ALLOC_HMD);
-	ipc_client_device_t *icd = U_DEVICE_ALLOCATE(ipc_client_device_t, flags, 0, 0);
+	ipc_client_device_t *icd = U_DEVICE_ALLOCATE(ipc_client_device_t, flags, isdev->input_count, 0);
 	icd->ipc_c = ipc_c;
 	icd->base.update_inputs = ipc_client_device_update_inputs;
 	icd->base.get_tracked_pose = ipc_client_device_get_tracked_pose;
@@ -168,15 +269,14 @@ ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origi
 	snprintf(icd->base.str, XRT_DEVICE_NAME_LEN, "%s", isdev->str);
 	snprintf(icd->base.serial, XRT_DEVICE_NAME_LEN, "%s", isdev->serial);
 
-	// Setup inputs, by pointing directly to the shared memory.
+	// Setup inputs, copied out of the shared memory on update.
 	assert(isdev->input_count > 0);
-	icd->base.inputs = &ism->inputs[isdev->first_input_index];
-	icd->base.input_count = isdev->input_count;
+	ipc_client_xdev_init_inputs(icd);
 
 	// Setup outputs, if any point directly into the shared memory.
 	icd->base.output_count = isdev->output_count;
 	if (isdev->output_count > 0) {
-		icd->base.outputs = &ism->outputs[isdev->first_output_index];
+		icd->base.outputs = ipc_shared_output(ism, isdev->first_output_index);
 	} else {
 		icd->base.outputs = NULL;
 	}
@@ -190,15 +290,15 @@ ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origi
 	for (size_t i = 0; i < isdev->binding_profile_count; i++) {
 		struct xrt_binding_profile *xbp = &icd->base.binding_profiles[i];
 		struct ipc_shared_binding_profile *isbp =
-		    &ism->binding_profiles[isdev->first_binding_profile_index + i];
+		    ipc_shared_binding_profile(ism, isdev->first_binding_profile_index + i);
 
 		xbp->name = isbp->name;
 		if (isbp->input_count > 0) {
-			xbp->inputs = &ism->input_pairs[isbp->first_input_index];
+			xbp->inputs = ipc_shared_input_pair(ism, isbp->first_input_index);
 			xbp->input_count = isbp->input_count;
 		}
 		if (isbp->output_count > 0) {
-			xbp->outputs = &ism->output_pairs[isbp->first_output_index];
+			xbp->outputs = ipc_shared_output_pair(ism, isbp->first_output_index);
 			xbp->output_count = isbp->output_count;
 		}
 	}
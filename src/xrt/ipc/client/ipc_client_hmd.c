@@ -20,6 +20,7 @@
 #include "util/u_device.h"
 #include "util/u_distortion_mesh.h"
 
+#include "shared/ipc_shared_layout.h"
 #include "client/ipc_client.h"
 #include "ipc_client_generated.h"
 
@@ -67,7 +68,6 @@ ipc_client_hmd_destroy(struct xrt_device *xdev)
 	u_var_remove_root(ich);
 
 	// We do not own these, so don't free them.
-	ich->base.inputs = NULL;
 	ich->base.outputs = NULL;
 
 	// Free this device with the helper.
@@ -79,10 +79,7 @@ ipc_client_hmd_update_inputs(struct xrt_device *xdev)
 {
 	ipc_client_hmd_t *ich = ipc_client_hmd(xdev);
 
-	xrt_result_t r = ipc_call_device_update_input(ich->ipc_c, ich->device_id);
-	if (r != XRT_SUCCESS) {
-		IPC_ERROR(ich->ipc_c, "Error calling input update!");
-	}
+	ipc_client_xdev_update_inputs(ich);
 }
 
 static void
@@ -93,6 +90,10 @@ ipc_client_hmd_get_tracked_pose(struct xrt_device *xdev,
 {
 	ipc_client_hmd_t *ich = ipc_client_hmd(xdev);
 
+	if (ipc_client_xdev_get_shared_tracked_pose(ich, name, at_timestamp_ns, out_relation)) {
+		return;
+	}
+
 	xrt_result_t r =
 	    ipc_call_device_get_tracked_pose(ich->ipc_c, ich->device_id, name, at_timestamp_ns, out_relation);
 	if (r != XRT_SUCCESS) {
@@ -177,12 +178,12 @@ struct xrt_device *
 ipc_client_hmd_create(struct ipc_connection *ipc_c, struct xrt_tracking_origin *xtrack, uint32_t device_id)
 {
 	struct ipc_shared_memory *ism = ipc_c->ism;
-	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
+	struct ipc_shared_device *isdev = ipc_shared_isdev(ism, device_id);
 
 
 
 	enum u_device_alloc_flags flags = (enum u_device_alloc_flags)(U_DEVICE_ALLOC_HMD);
-	ipc_client_hmd_t *ich = U_DEVICE_ALLOCATE(ipc_client_hmd_t, flags, 0, 0);
+	ipc_client_hmd_t *ich = U_DEVICE_ALLOCATE(ipc_client_hmd_t, flags, isdev->input_count, 0);
 	ich->ipc_c = ipc_c;
 	ich->device_id = device_id;
 	ich->base.update_inputs = ipc_client_hmd_update_inputs;
@@ -201,10 +202,9 @@ ipc_client_hmd_create(struct ipc_connection *ipc_c, struct xrt_tracking_origin *
 	snprintf(ich->base.str, XRT_DEVICE_NAME_LEN, "%s", isdev->str);
 	snprintf(ich->base.serial, XRT_DEVICE_NAME_LEN, "%s", isdev->serial);
 
-	// Setup inputs, by pointing directly to the shared memory.
+	// Setup inputs, copied out of the shared memory on update.
 	assert(isdev->input_count > 0);
-	ich->base.inputs = &ism->inputs[isdev->first_input_index];
-	ich->base.input_count = isdev->input_count;
+	ipc_client_xdev_init_inputs(ich);
 
 #if 0
 	// Setup info.
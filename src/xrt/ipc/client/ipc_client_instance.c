@@ -26,6 +26,7 @@
 
 #include "shared/ipc_protocol.h"
 #include "shared/ipc_shmem.h"
+#include "shared/ipc_shared_layout.h"
 #include "client/ipc_client.h"
 #include "client/ipc_client_interface.h"
 #include "client/ipc_client_connection.h"
@@ -204,7 +205,7 @@ ipc_client_instance_destroy(struct xrt_instance *xinst)
 	}
 	ii->xtrack_count = 0;
 
-	ipc_shmem_destroy(&ii->ipc_c.ism_handle, (void **)&ii->ipc_c.ism, sizeof(struct ipc_shared_memory));
+	ipc_shmem_destroy(&ii->ipc_c.ism_handle, (void **)&ii->ipc_c.ism, ii->ipc_c.ism_size);
 
 	free(ii);
 }
@@ -244,10 +245,12 @@ ipc_instance_create(struct xrt_instance_info *i_info, struct xrt_instance **out_
 	for (uint32_t i = 0; i < ism->itrack_count; i++) {
 		xtrack = U_TYPED_CALLOC(struct xrt_tracking_origin);
 
-		memcpy(xtrack->name, ism->itracks[i].name, sizeof(xtrack->name));
+		struct ipc_shared_tracking_origin *itrack = ipc_shared_itrack(ism, i);
 
-		xtrack->type = ism->itracks[i].type;
-		xtrack->offset = ism->itracks[i].offset;
+		memcpy(xtrack->name, itrack->name, sizeof(xtrack->name));
+
+		xtrack->type = itrack->type;
+		xtrack->offset = itrack->offset;
 		ii->xtracks[count++] = xtrack;
 
 		u_var_add_root(xtrack, "Tracking origin", true);
@@ -260,7 +263,7 @@ ipc_instance_create(struct xrt_instance_info *i_info, struct xrt_instance **out_
 	// Query the server for how many devices it has.
 	count = 0;
 	for (uint32_t i = 0; i < ism->isdev_count; i++) {
-		struct ipc_shared_device *isdev = &ism->isdevs[i];
+		struct ipc_shared_device *isdev = ipc_shared_isdev(ism, i);
 		xtrack = ii->xtracks[isdev->tracking_origin_index];
 
 		if (isdev->name == XRT_DEVICE_GENERIC_HMD) {
@@ -9,6 +9,8 @@
 
 #include "xrt/xrt_space.h"
 
+#include "math/m_api.h"
+
 #include "ipc_client_generated.h"
 
 
@@ -149,6 +151,51 @@ locate_space(struct xrt_space_overseer *xso,
 	    out_relation);                  //
 }
 
+static xrt_result_t
+locate_spaces(struct xrt_space_overseer *xso,
+              struct xrt_space *base_space,
+              const struct xrt_pose *base_offset,
+              uint64_t at_timestamp_ns,
+              struct xrt_space **spaces,
+              uint32_t space_count,
+              const struct xrt_pose *offsets,
+              struct xrt_space_relation *out_relations)
+{
+	struct ipc_client_space_overseer *icspo = ipc_client_space_overseer(xso);
+
+	struct ipc_client_space *icsp_base_space = ipc_client_space(base_space);
+
+	// Split into as few calls as possible, each call is limited in size.
+	for (uint32_t first = 0; first < space_count; first += IPC_MAX_LOCATE_SPACES) {
+		struct ipc_space_locate_list list = {0};
+		struct ipc_space_relation_list relations = {0};
+		xrt_result_t xret;
+
+		list.space_count = MIN(space_count - first, IPC_MAX_LOCATE_SPACES);
+		for (uint32_t i = 0; i < list.space_count; i++) {
+			list.space_ids[i] = ipc_client_space(spaces[first + i])->id;
+			list.offsets[i] = offsets[first + i];
+		}
+
+		xret = ipc_call_space_locate_spaces( //
+		    icspo->ipc_c,                    //
+		    icsp_base_space->id,             //
+		    base_offset,                     //
+		    at_timestamp_ns,                 //
+		    &list,                           //
+		    &relations);                     //
+		if (xret != XRT_SUCCESS) {
+			return xret;
+		}
+
+		for (uint32_t i = 0; i < list.space_count; i++) {
+			out_relations[first + i] = relations.relations[i];
+		}
+	}
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 locate_device(struct xrt_space_overseer *xso,
               struct xrt_space *base_space,
@@ -199,6 +246,7 @@ ipc_client_space_overseer_create(struct ipc_connection *ipc_c)
 	icspo->base.create_offset_space = create_offset_space;
 	icspo->base.create_pose_space = create_pose_space;
 	icspo->base.locate_space = locate_space;
+	icspo->base.locate_spaces = locate_spaces;
 	icspo->base.locate_device = locate_device;
 	icspo->base.destroy = destroy;
 	icspo->ipc_c = ipc_c;
@@ -12,9 +12,12 @@
 #pragma once
 
 #include "xrt/xrt_compiler.h"
+#include "xrt/xrt_config_os.h"
+#include "xrt/xrt_limits.h"
 #include "xrt/xrt_system.h"
 #include "xrt/xrt_space.h"
 
+#include "util/u_var.h"
 #include "util/u_logging.h"
 
 #include "os/os_threading.h"
@@ -54,6 +57,7 @@ extern "C" {
 struct xrt_instance;
 struct xrt_compositor;
 struct xrt_compositor_native;
+struct ipc_server_worker_pool;
 
 
 /*!
@@ -102,6 +106,29 @@ struct ipc_client_state
 	//! Ptrs to the semaphores.
 	struct xrt_compositor_semaphore *xcsems[IPC_MAX_CLIENT_SEMAPHORES];
 
+	/*!
+	 * Frame timing slot in the shared memory, predictions are published
+	 * there ahead of time when the client has enabled it. Protected by
+	 * the frame timing thread's lock, see @ref ipc_server_enable_frame_timing.
+	 */
+	struct
+	{
+		bool enabled;
+		uint32_t index;
+	} frame_timing;
+
+	/*!
+	 * The layers as the client last sent them, the layer slots only carry
+	 * what changed since then, see @ref ipc_layer_slot::full_mask.
+	 */
+	struct
+	{
+		struct ipc_layer_entry entries[IPC_MAX_LAYERS];
+
+		//! Bit i set if entry i has been written in full this session.
+		uint32_t valid_mask;
+	} layers;
+
 	struct
 	{
 		uint32_t root;
@@ -119,9 +146,27 @@ struct ipc_client_state
 	//! Socket fd used for client comms
 	struct ipc_message_channel imc;
 
+#ifdef XRT_OS_UNIX
+	/*!
+	 * Handles that were sent along with the current command, consumed by
+	 * the dispatcher if the command takes handles, closed otherwise.
+	 */
+	int inline_handles[XRT_MAX_IPC_HANDLES];
+
+	//! Number of valid entries in @ref inline_handles.
+	uint32_t inline_handle_count;
+#endif
+
 	struct ipc_app_state client_state;
 
 	int server_thread_index;
+
+	/*!
+	 * Per command stats, only written by the thread handling the client
+	 * without any locking. Added to the server's retired stats and zeroed
+	 * when the client disconnects.
+	 */
+	struct ipc_call_stats call_stats;
 };
 
 enum ipc_thread_state
@@ -150,6 +195,9 @@ struct ipc_device
 
 	//! Is the IO suppressed for this device.
 	bool io_active;
+
+	//! Only one thread at a time may update the inputs of the device.
+	struct os_mutex inputs_lock;
 };
 
 /*!
@@ -327,6 +375,8 @@ struct ipc_server
 
 	struct ipc_shared_memory *ism;
 	xrt_shmem_handle_t ism_handle;
+	//! Size of the shared memory, sized to the system at startup.
+	size_t ism_size;
 
 	struct ipc_server_mainloop ml;
 
@@ -336,6 +386,15 @@ struct ipc_server
 	// Should we exit when a client disconnects.
 	bool exit_on_disconnect;
 
+	// Block in receive on the client sockets instead of going through epoll.
+	bool blocking_receive;
+
+	/*!
+	 * Services all clients from a fixed set of threads instead of one
+	 * thread per client, NULL when not used.
+	 */
+	struct ipc_server_worker_pool *worker_pool;
+
 	enum u_logging_level log_level;
 
 	struct ipc_thread threads[IPC_MAX_CLIENTS];
@@ -352,9 +411,100 @@ struct ipc_server
 
 		struct os_mutex lock;
 	} global_state;
+
+	/*!
+	 * Call stats of all clients together, clients only record into their
+	 * own @ref ipc_client_state::call_stats, these are only summed up when
+	 * asked for.
+	 */
+	struct
+	{
+		//! Protects @ref retired, nests inside the global state lock.
+		struct os_mutex lock;
+
+		//! Stats left behind by clients that have disconnected.
+		struct ipc_call_stats retired;
+
+		//! Snapshot for the debug gui, taken with @ref update_btn.
+		struct ipc_call_stats totals;
+
+		//! Derived from @ref totals when the snapshot is taken.
+		struct
+		{
+			uint64_t p50_ns;
+			uint64_t p99_ns;
+		} percentiles[IPC_CALL_STATS_MAX_COMMANDS];
+
+		struct u_var_button update_btn;
+	} call_stats;
+
+	/*!
+	 * Samples the tracked poses of all devices into the pose histories
+	 * in the shared memory, and optionally the inputs, lets clients skip
+	 * the IPC calls.
+	 */
+	struct
+	{
+		struct os_thread_helper oth;
+
+		//! Is publishing turned on at all.
+		bool enabled;
+
+		//! Are the inputs also kept up to date.
+		bool inputs_enabled;
+
+		//! How often the poses are sampled.
+		uint64_t period_ns;
+	} pose_publisher;
+
+	/*!
+	 * Predicts frames for clients that wait for them through the frame
+	 * timing slots in the shared memory, woken by the doorbell. Sleeps
+	 * until a client enables frame timing.
+	 */
+	struct
+	{
+		/*!
+		 * The lock of the thread also protects the frame timing fields
+		 * of the clients and the compositor while predicting with it.
+		 */
+		struct os_thread_helper oth;
+
+		//! Number of clients with frame timing enabled.
+		uint32_t client_count;
+	} frame_timing;
 };
 
 
+/*!
+ * Record a dispatched call in the client's and the server wide call stats,
+ * called from the generated dispatch function.
+ *
+ * @ingroup ipc_server
+ */
+void
+ipc_server_record_call(volatile struct ipc_client_state *ics, uint32_t command, uint64_t bytes, uint64_t start_ns);
+
+/*!
+ * Get the call stats of a client, a @p client_id of zero gets the stats of
+ * all clients together since the server started. The stats of running clients
+ * may be torn, they are read while being written.
+ *
+ * @ingroup ipc_server
+ */
+xrt_result_t
+ipc_server_get_client_call_stats(struct ipc_server *s, uint32_t client_id, struct ipc_call_stats *out_stats);
+
+/*!
+ * Add the call stats of a disconnecting client to the server's stats and zero
+ * them, so the slot starts fresh for the next client.
+ *
+ * @pre Hold the global state lock.
+ * @ingroup ipc_server
+ */
+void
+ipc_server_retire_client_call_stats_locked(volatile struct ipc_client_state *ics);
+
 /*!
  * Get the current state of a client.
  *
@@ -379,6 +529,14 @@ ipc_server_set_active_client(struct ipc_server *s, uint32_t client_id);
 xrt_result_t
 ipc_server_toggle_io_client(struct ipc_server *s, uint32_t client_id);
 
+/*!
+ * Toggle the io for this device.
+ *
+ * @ingroup ipc_server
+ */
+xrt_result_t
+ipc_server_toggle_io_device(struct ipc_server *s, uint32_t device_id);
+
 /*!
  * Called by client threads to set a session to active.
  *
@@ -403,6 +561,34 @@ ipc_server_deactivate_session(volatile struct ipc_client_state *ics);
 void
 ipc_server_update_state(struct ipc_server *s);
 
+/*!
+ * Updates the inputs of a device and copies any that changed into the shared
+ * memory. Called by both the pose publisher and client threads, the writes
+ * of one device are serialized as the input generation is a seqlock.
+ *
+ * @ingroup ipc_server
+ */
+void
+ipc_server_update_device_inputs(struct ipc_server *s, uint32_t device_index, bool io_active);
+
+/*!
+ * Has the frame timing thread predict frames for the client in the given slot
+ * of the shared memory, waking the thread up if it was idle.
+ *
+ * @ingroup ipc_server
+ */
+void
+ipc_server_enable_frame_timing(struct ipc_server *s, volatile struct ipc_client_state *ics, uint32_t index);
+
+/*!
+ * Stops predicting frames for the client, once this returns the frame timing
+ * thread is no longer using the client's compositor.
+ *
+ * @ingroup ipc_server
+ */
+void
+ipc_server_disable_frame_timing(struct ipc_server *s, volatile struct ipc_client_state *ics);
+
 /*!
  * Thread function for the client side dispatching.
  *
@@ -411,6 +597,35 @@ ipc_server_update_state(struct ipc_server *s);
 void *
 ipc_server_client_thread(void *_ics);
 
+#ifndef XRT_OS_WINDOWS
+/*!
+ * Handle one message from the client, used as the
+ * @ref ipc_server_worker_pool_handle_func_t when the worker pool is used.
+ *
+ * @ingroup ipc_server
+ */
+bool
+ipc_server_client_handle_message(void *ptr);
+
+/*!
+ * Release everything the client held, used as the
+ * @ref ipc_server_worker_pool_remove_func_t when the worker pool is used.
+ *
+ * @ingroup ipc_server
+ */
+void
+ipc_server_client_removed(void *ptr);
+#endif
+
+/*!
+ * Called by handlers that may block for a long time, makes sure that other
+ * clients are still serviced when the threads are shared between clients.
+ *
+ * @ingroup ipc_server
+ */
+void
+ipc_server_client_will_block(volatile struct ipc_client_state *ics);
+
 /*!
  * This destroys the native compositor for this client and any extra objects
  * created from it, like all of the swapchains.
@@ -12,10 +12,18 @@
 #include "util/u_misc.h"
 #include "util/u_handles.h"
 #include "util/u_trace_marker.h"
+#include "util/u_frame_timing_ring.h"
 
 #include "server/ipc_server.h"
+#include "shared/ipc_call_stats.h"
+#include "shared/ipc_shared_frame_timing.h"
+#include "shared/ipc_shared_input.h"
+#include "shared/ipc_shared_layer.h"
+#include "shared/ipc_shared_layout.h"
 #include "ipc_server_generated.h"
 
+#include <assert.h>
+
 #ifdef XRT_GRAPHICS_SYNC_HANDLE_IS_FD
 #include <unistd.h>
 #endif
@@ -27,6 +35,16 @@
  *
  */
 
+static struct ipc_shared_frame_timing *
+get_frame_timing(volatile struct ipc_client_state *ics)
+{
+	if (!ics->frame_timing.enabled) {
+		return NULL;
+	}
+
+	return ipc_shared_frame_timing(ics->server->ism, ics->frame_timing.index);
+}
+
 static xrt_result_t
 validate_device_id(volatile struct ipc_client_state *ics, int64_t device_id, struct xrt_device **out_device)
 {
@@ -416,6 +434,52 @@ ipc_handle_space_locate_space(volatile struct ipc_client_state *ics,
 	    out_relation);                      //
 }
 
+xrt_result_t
+ipc_handle_space_locate_spaces(volatile struct ipc_client_state *ics,
+                               uint32_t base_space_id,
+                               const struct xrt_pose *base_offset,
+                               uint64_t at_timestamp,
+                               const struct ipc_space_locate_list *spaces,
+                               struct ipc_space_relation_list *out_relations)
+{
+	IPC_TRACE_MARKER();
+
+	struct xrt_space_overseer *xso = ics->server->xso;
+	struct xrt_space *base_space = NULL;
+	struct xrt_space *xspaces[IPC_MAX_LOCATE_SPACES] = {0};
+	uint32_t space_count = spaces->space_count;
+	xrt_result_t xret;
+
+	if (space_count > IPC_MAX_LOCATE_SPACES) {
+		U_LOG_E("Too many spaces (%u > %u)!", space_count, IPC_MAX_LOCATE_SPACES);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	xret = validate_space_id(ics, base_space_id, &base_space);
+	if (xret != XRT_SUCCESS) {
+		U_LOG_E("Invalid base_space_id!");
+		return xret;
+	}
+
+	for (uint32_t i = 0; i < space_count; i++) {
+		xret = validate_space_id(ics, spaces->space_ids[i], &xspaces[i]);
+		if (xret != XRT_SUCCESS) {
+			U_LOG_E("Invalid space_id!");
+			return xret;
+		}
+	}
+
+	return xrt_space_overseer_locate_spaces( //
+	    xso,                                 //
+	    base_space,                          //
+	    base_offset,                         //
+	    at_timestamp,                        //
+	    xspaces,                             //
+	    space_count,                         //
+	    spaces->offsets,                     //
+	    out_relations->relations);           //
+}
+
 xrt_result_t
 ipc_handle_space_locate_device(volatile struct ipc_client_state *ics,
                                uint32_t base_space_id,
@@ -538,6 +602,19 @@ ipc_handle_compositor_begin_frame(volatile struct ipc_client_state *ics, int64_t
 		return XRT_ERROR_IPC_SESSION_NOT_CREATED;
 	}
 
+	// The client woke up from a published prediction without telling us.
+	struct ipc_shared_frame_timing *isft = get_frame_timing(ics);
+	int64_t woke_frame_id = -1;
+	uint64_t woke_time_ns = 0;
+	for (int i = 0; isft != NULL && i < 3; i++) {
+		if (ipc_shared_frame_timing_read_woke(isft, &woke_frame_id, &woke_time_ns)) {
+			break;
+		}
+	}
+	if (woke_frame_id == frame_id) {
+		xrt_comp_mark_frame(ics->xc, frame_id, XRT_COMPOSITOR_FRAME_POINT_WOKE, woke_time_ns);
+	}
+
 	return xrt_comp_begin_frame(ics->xc, frame_id);
 }
 
@@ -553,6 +630,29 @@ ipc_handle_compositor_discard_frame(volatile struct ipc_client_state *ics, int64
 	return xrt_comp_discard_frame(ics->xc, frame_id);
 }
 
+xrt_result_t
+ipc_handle_compositor_enable_frame_timing(volatile struct ipc_client_state *ics, uint32_t *out_slot_index)
+{
+	IPC_TRACE_MARKER();
+
+	if (ics->xc == NULL) {
+		return XRT_ERROR_IPC_SESSION_NOT_CREATED;
+	}
+
+	if (ics->server_thread_index < 0 || ics->server_thread_index >= IPC_MAX_CLIENTS) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	uint32_t index = (uint32_t)ics->server_thread_index;
+	ipc_shared_frame_timing_init(ipc_shared_frame_timing(ics->server->ism, index));
+
+	ipc_server_enable_frame_timing(ics->server, ics, index);
+
+	*out_slot_index = index;
+
+	return XRT_SUCCESS;
+}
+
 static bool
 _update_projection_layer(struct xrt_compositor *xc,
                          volatile struct ipc_client_state *ics,
@@ -761,12 +861,12 @@ _update_equirect2_layer(struct xrt_compositor *xc,
 }
 
 static bool
-_update_layers(volatile struct ipc_client_state *ics, struct xrt_compositor *xc, struct ipc_layer_slot *slot)
+_update_layers(volatile struct ipc_client_state *ics, struct xrt_compositor *xc, uint32_t layer_count)
 {
 	IPC_TRACE_MARKER();
 
-	for (uint32_t i = 0; i < slot->layer_count; i++) {
-		volatile struct ipc_layer_entry *layer = &slot->layers[i];
+	for (uint32_t i = 0; i < layer_count; i++) {
+		volatile struct ipc_layer_entry *layer = &ics->layers.entries[i];
 
 		switch (layer->data.type) {
 		case XRT_LAYER_STEREO_PROJECTION:
@@ -811,6 +911,60 @@ _update_layers(volatile struct ipc_client_state *ics, struct xrt_compositor *xc,
 	return true;
 }
 
+/*!
+ * Bring the client's layers up to date from the slot, only the layers that
+ * changed in more than the per frame fields are copied in full.
+ */
+static xrt_result_t
+_read_layer_slot(volatile struct ipc_client_state *ics,
+                 uint32_t slot_id,
+                 struct xrt_layer_frame_data *out_data,
+                 uint32_t *out_layer_count)
+{
+	struct ipc_shared_memory *ism = ics->server->ism;
+	if (slot_id >= ipc_shared_section_count(ism, IPC_SHARED_SECTION_SLOTS)) {
+		IPC_ERROR(ics->server, "Invalid slot_id %u", slot_id);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	struct ipc_layer_slot *slot = ipc_shared_slot(ism, slot_id);
+
+	// Read once, the client can write to the slot at any time.
+	uint32_t layer_count = slot->layer_count;
+	uint32_t full_mask = slot->full_mask;
+
+	if (layer_count > IPC_MAX_LAYERS) {
+		IPC_ERROR(ics->server, "Invalid layer_count %u", layer_count);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	for (uint32_t i = 0; i < layer_count; i++) {
+		uint32_t bit = 1u << i;
+
+		// Cast away volatile.
+		struct ipc_layer_entry *entry = (struct ipc_layer_entry *)&ics->layers.entries[i];
+
+		if ((full_mask & bit) != 0) {
+			*entry = slot->layers[i];
+			ics->layers.valid_mask |= bit;
+			continue;
+		}
+
+		if ((ics->layers.valid_mask & bit) == 0) {
+			IPC_ERROR(ics->server, "Layer #%u only has an update but was never sent in full", i);
+			return XRT_ERROR_IPC_FAILURE;
+		}
+
+		struct ipc_layer_update update = slot->updates[i];
+		ipc_shared_layer_apply_update(entry, &update);
+	}
+
+	*out_data = slot->data;
+	*out_layer_count = layer_count;
+
+	return XRT_SUCCESS;
+}
+
 xrt_result_t
 ipc_handle_compositor_layer_sync(volatile struct ipc_client_state *ics,
                                  uint32_t slot_id,
@@ -825,7 +979,6 @@ ipc_handle_compositor_layer_sync(volatile struct ipc_client_state *ics,
 	}
 
 	struct ipc_shared_memory *ism = ics->server->ism;
-	struct ipc_layer_slot *slot = &ism->slots[slot_id];
 	xrt_graphics_sync_handle_t sync_handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
 
 	// If we have one or more save the first handle.
@@ -840,17 +993,22 @@ ipc_handle_compositor_layer_sync(volatile struct ipc_client_state *ics,
 		u_graphics_sync_unref(&tmp);
 	}
 
-	// Copy current slot data.
-	struct ipc_layer_slot copy = *slot;
+	struct xrt_layer_frame_data data;
+	uint32_t layer_count = 0;
+	xrt_result_t xret = _read_layer_slot(ics, slot_id, &data, &layer_count);
+	if (xret != XRT_SUCCESS) {
+		u_graphics_sync_unref(&sync_handle);
+		return xret;
+	}
 
 
 	/*
 	 * Transfer data to underlying compositor.
 	 */
 
-	xrt_comp_layer_begin(ics->xc, &copy.data);
+	xrt_comp_layer_begin(ics->xc, &data);
 
-	_update_layers(ics, ics->xc, &copy);
+	_update_layers(ics, ics->xc, layer_count);
 
 	xrt_comp_layer_commit(ics->xc, sync_handle);
 
@@ -861,7 +1019,8 @@ ipc_handle_compositor_layer_sync(volatile struct ipc_client_state *ics,
 
 	os_mutex_lock(&ics->server->global_state.lock);
 
-	*out_free_slot_id = (ics->server->current_slot_index + 1) % IPC_MAX_SLOTS;
+	uint32_t slot_count = ipc_shared_section_count(ism, IPC_SHARED_SECTION_SLOTS);
+	*out_free_slot_id = (ics->server->current_slot_index + 1) % slot_count;
 	ics->server->current_slot_index = *out_free_slot_id;
 
 	os_mutex_unlock(&ics->server->global_state.lock);
@@ -893,20 +1052,22 @@ ipc_handle_compositor_layer_sync_with_semaphore(volatile struct ipc_client_state
 	struct xrt_compositor_semaphore *xcsem = ics->xcsems[semaphore_id];
 
 	struct ipc_shared_memory *ism = ics->server->ism;
-	struct ipc_layer_slot *slot = &ism->slots[slot_id];
-
-	// Copy current slot data.
-	struct ipc_layer_slot copy = *slot;
 
+	struct xrt_layer_frame_data data;
+	uint32_t layer_count = 0;
+	xrt_result_t xret = _read_layer_slot(ics, slot_id, &data, &layer_count);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
 
 
 	/*
 	 * Transfer data to underlying compositor.
 	 */
 
-	xrt_comp_layer_begin(ics->xc, &copy.data);
+	xrt_comp_layer_begin(ics->xc, &data);
 
-	_update_layers(ics, ics->xc, &copy);
+	_update_layers(ics, ics->xc, layer_count);
 
 	xrt_comp_layer_commit_with_semaphore(ics->xc, xcsem, semaphore_value);
 
@@ -917,7 +1078,8 @@ ipc_handle_compositor_layer_sync_with_semaphore(volatile struct ipc_client_state
 
 	os_mutex_lock(&ics->server->global_state.lock);
 
-	*out_free_slot_id = (ics->server->current_slot_index + 1) % IPC_MAX_SLOTS;
+	uint32_t slot_count = ipc_shared_section_count(ism, IPC_SHARED_SECTION_SLOTS);
+	*out_free_slot_id = (ics->server->current_slot_index + 1) % slot_count;
 	ics->server->current_slot_index = *out_free_slot_id;
 
 	os_mutex_unlock(&ics->server->global_state.lock);
@@ -1019,20 +1181,80 @@ ipc_handle_system_toggle_io_client(volatile struct ipc_client_state *_ics, uint3
 	return ipc_server_toggle_io_client(s, client_id);
 }
 
+static_assert(sizeof(struct ipc_system_get_client_call_stats_reply) <= IPC_BUF_SIZE,
+              "Call stats page does not fit in a reply");
+
 xrt_result_t
-ipc_handle_system_toggle_io_device(volatile struct ipc_client_state *ics, uint32_t device_id)
+ipc_handle_system_get_client_call_stats(volatile struct ipc_client_state *ics,
+                                        uint32_t id,
+                                        uint32_t first_command,
+                                        struct ipc_call_stats_page *out_page)
 {
-	if (device_id >= IPC_MAX_DEVICES) {
-		return XRT_ERROR_IPC_FAILURE;
+	struct ipc_server *s = ics->server;
+	struct ipc_call_stats stats;
+
+	xrt_result_t xret = ipc_server_get_client_call_stats(s, id, &stats);
+	if (xret != XRT_SUCCESS) {
+		return xret;
 	}
 
-	struct ipc_device *idev = &ics->server->idevs[device_id];
+	ipc_call_stats_get_page(&stats, first_command, out_page);
+
+	return XRT_SUCCESS;
+}
+
+static_assert(sizeof(struct ipc_system_get_compositor_timings_reply) <= IPC_BUF_SIZE,
+              "Compositor timings do not fit in a reply");
+
+xrt_result_t
+ipc_handle_system_get_compositor_timings(volatile struct ipc_client_state *ics,
+                                        int64_t from_frame_id,
+                                        struct ipc_compositor_timings *out_timings)
+{
+	// Written to by the compositor pacing, which lives in this process.
+	struct u_frame_timing_ring *ring = u_frame_timing_ring_get_global();
+	struct u_frame_timing_record records[IPC_MAX_COMPOSITOR_TIMINGS];
+
+	uint32_t count = u_frame_timing_ring_read(ring, from_frame_id, records, IPC_MAX_COMPOSITOR_TIMINGS,
+	                                          &out_timings->next_frame_id);
+
+	for (uint32_t i = 0; i < count; i++) {
+		const struct u_frame_timing_record *rec = &records[i];
+		struct ipc_frame_timing_record *out = &out_timings->records[i];
+
+		uint32_t flags = 0;
+		if ((rec->flags & U_FRAME_TIMING_PRESENT_INFO) != 0) {
+			flags |= IPC_FRAME_TIMING_PRESENT_INFO;
+		}
+		if ((rec->flags & U_FRAME_TIMING_MISSED) != 0) {
+			flags |= IPC_FRAME_TIMING_MISSED;
+		}
+
+		U_ZERO(out);
+		out->frame_id = rec->frame_id;
+		out->flags = flags;
+		out->desired_present_time_ns = rec->desired_present_time_ns;
+		out->predicted_display_time_ns = rec->predicted_display_time_ns;
+		out->when_woke_ns = rec->when_woke_ns;
+		out->when_began_ns = rec->when_began_ns;
+		out->when_submitted_ns = rec->when_submitted_ns;
+		out->gpu_start_ns = rec->gpu_start_ns;
+		out->gpu_end_ns = rec->gpu_end_ns;
+		out->actual_present_time_ns = rec->actual_present_time_ns;
+		out->actual_display_time_ns = rec->actual_display_time_ns;
+	}
 
-	idev->io_active = !idev->io_active;
+	out_timings->record_count = count;
 
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_handle_system_toggle_io_device(volatile struct ipc_client_state *ics, uint32_t device_id)
+{
+	return ipc_server_toggle_io_device(ics->server, device_id);
+}
+
 xrt_result_t
 ipc_handle_swapchain_get_properties(volatile struct ipc_client_state *ics,
                                     const struct xrt_swapchain_create_info *info,
@@ -1176,6 +1398,9 @@ ipc_handle_swapchain_wait_image(volatile struct ipc_client_state *ics, uint32_t
 	uint32_t sc_index = id;
 	struct xrt_swapchain *xsc = ics->xscs[sc_index];
 
+	// Waits for the compositor to be done with the image.
+	ipc_server_client_will_block(ics);
+
 	xrt_swapchain_wait_image(xsc, timeout_ns, index);
 
 	return XRT_SUCCESS;
@@ -1313,34 +1538,11 @@ ipc_handle_device_update_input(volatile struct ipc_client_state *ics, uint32_t i
 {
 	// To make the code a bit more readable.
 	uint32_t device_id = id;
-	struct ipc_shared_memory *ism = ics->server->ism;
 	struct ipc_device *idev = get_idev(ics, device_id);
-	struct xrt_device *xdev = idev->xdev;
-	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
-
-	// Update inputs.
-	xrt_device_update_inputs(xdev);
-
-	// Copy data into the shared memory.
-	struct xrt_input *src = xdev->inputs;
-	struct xrt_input *dst = &ism->inputs[isdev->first_input_index];
-	size_t size = sizeof(struct xrt_input) * isdev->input_count;
 
+	// Update inputs and copy changed ones into the shared memory.
 	bool io_active = ics->io_active && idev->io_active;
-	if (io_active) {
-		memcpy(dst, src, size);
-	} else {
-		memset(dst, 0, size);
-
-		for (uint32_t i = 0; i < isdev->input_count; i++) {
-			dst[i].name = src[i].name;
-
-			// Special case the rotation of the head.
-			if (dst[i].name == XRT_INPUT_GENERIC_HEAD_POSE) {
-				dst[i].active = src[i].active;
-			}
-		}
-	}
+	ipc_server_update_device_inputs(ics->server, device_id, io_active);
 
 	// Reply.
 	return XRT_SUCCESS;
@@ -1350,8 +1552,12 @@ static struct xrt_input *
 find_input(volatile struct ipc_client_state *ics, uint32_t device_id, enum xrt_input_name name)
 {
 	struct ipc_shared_memory *ism = ics->server->ism;
-	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
-	struct xrt_input *io = &ism->inputs[isdev->first_input_index];
+	struct ipc_shared_device *isdev = ipc_shared_isdev(ism, device_id);
+	if (isdev->input_count == 0) {
+		return NULL;
+	}
+
+	struct xrt_input *io = ipc_shared_input(ism, isdev->first_input_index);
 
 	for (uint32_t i = 0; i < isdev->input_count; i++) {
 		if (io[i].name == name) {
@@ -15,6 +15,7 @@
 #include "ipc_server_generated.h"
 
 #ifndef XRT_OS_WINDOWS
+#include "server/ipc_server_worker_pool.h"
 
 #include <unistd.h>
 #include <fcntl.h>
@@ -24,8 +25,66 @@
 #include <sys/types.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
+#include <sys/time.h>
+#endif
 
 
+/*
+ *
+ * Teardown.
+ *
+ */
+
+/*!
+ * Called once the client has gone away, releases everything it held.
+ *
+ * @param thread_state What to set the thread slot to once everything has been
+ *                     released, stopping if the slot has a thread that needs
+ *                     to be joined, otherwise ready.
+ */
+static void
+client_teardown(volatile struct ipc_client_state *ics, enum ipc_thread_state thread_state)
+{
+	struct ipc_server *s = ics->server;
+	int index = ics->server_thread_index;
+
+	// Multiple threads might be looking at these fields.
+	os_mutex_lock(&s->global_state.lock);
+
+	ipc_message_channel_close((struct ipc_message_channel *)&ics->imc);
+
+	// No longer a client, the slot is still ours until the state is set.
+	ics->server_thread_index = -1;
+	memset((void *)&ics->client_state, 0, sizeof(struct ipc_app_state));
+
+	ipc_server_retire_client_call_stats_locked(ics);
+
+	os_mutex_unlock(&s->global_state.lock);
+
+	ipc_server_client_destroy_compositor(ics);
+
+	// Make sure undestroyed spaces are unreferenced
+	for (uint32_t i = 0; i < IPC_MAX_CLIENT_SPACES; i++) {
+		// Cast away volatile.
+		xrt_space_reference((struct xrt_space **)&ics->xspcs[i], NULL);
+	}
+
+	// Should we stop the server when a client disconnects?
+	if (s->exit_on_disconnect) {
+		s->running = false;
+	}
+
+	ipc_server_deactivate_session(ics);
+
+	// The slot, and with it ics, may be handed to a new client after this.
+	os_mutex_lock(&s->global_state.lock);
+	s->threads[index].state = thread_state;
+	os_mutex_unlock(&s->global_state.lock);
+}
+
+
+#ifndef XRT_OS_WINDOWS
+
 /*
  *
  * Helper functions.
@@ -58,6 +117,89 @@ setup_epoll(volatile struct ipc_client_state *ics)
 	return epoll_fd;
 }
 
+static bool
+setup_receive_timeout(volatile struct ipc_client_state *ics, int timeout_ms)
+{
+	struct timeval tv = {
+	    .tv_sec = timeout_ms / 1000,
+	    .tv_usec = (timeout_ms % 1000) * 1000,
+	};
+
+	int ret = setsockopt(ics->imc.ipc_handle, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	if (ret < 0) {
+		IPC_ERROR(ics->server, "Error setsockopt(SO_RCVTIMEO) failed '%i'.", errno);
+		return false;
+	}
+
+	return true;
+}
+
+static void
+close_inline_handles(volatile struct ipc_client_state *ics)
+{
+	for (uint32_t i = 0; i < ics->inline_handle_count; i++) {
+		close(ics->inline_handles[i]);
+	}
+	ics->inline_handle_count = 0;
+}
+
+/*!
+ * Receive and dispatch one message.
+ *
+ * @return XRT_TIMEOUT if there was nothing to receive, XRT_SUCCESS if the
+ *         message was handled and anything else if the client should be
+ *         disconnected.
+ */
+static xrt_result_t
+handle_one_message(volatile struct ipc_client_state *ics)
+{
+	uint8_t buf[IPC_BUF_SIZE] = {0};
+
+	// Get the data that is waiting for us, and any handles sent with it.
+	size_t len = 0;
+	uint32_t handle_count = 0;
+	xrt_result_t xret = ipc_receive_with_fds(  //
+	    (struct ipc_message_channel *)&ics->imc, //
+	    buf,                                     //
+	    IPC_BUF_SIZE,                            //
+	    &len,                                    //
+	    (int *)ics->inline_handles,              //
+	    XRT_MAX_IPC_HANDLES,                     //
+	    &handle_count);                          //
+	if (xret == XRT_TIMEOUT) {
+		return XRT_TIMEOUT;
+	}
+	if (xret != XRT_SUCCESS) {
+		IPC_INFO(ics->server, "Client disconnected.");
+		return xret;
+	}
+
+	ics->inline_handle_count = handle_count;
+
+	if (len < 4) {
+		IPC_ERROR(ics->server, "Invalid packet received, disconnecting client.");
+		close_inline_handles(ics);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	// Check the first 4 bytes of the message and dispatch.
+	ipc_command_t *ipc_command = (ipc_command_t *)buf;
+
+	IPC_TRACE_BEGIN(ipc_dispatch);
+	xrt_result_t result = ipc_dispatch(ics, ipc_command);
+	IPC_TRACE_END(ipc_dispatch);
+
+	// Don't leak handles the command didn't take.
+	close_inline_handles(ics);
+
+	if (result != XRT_SUCCESS) {
+		IPC_ERROR(ics->server, "During packet handling, disconnecting client.");
+		return result;
+	}
+
+	return XRT_SUCCESS;
+}
+
 
 /*
  *
@@ -72,85 +214,101 @@ client_loop(volatile struct ipc_client_state *ics)
 
 	IPC_INFO(ics->server, "Client %u connected", ics->client_state.id);
 
-	// Claim the client fd.
-	int epoll_fd = setup_epoll(ics);
-	if (epoll_fd < 0) {
-		return;
+	const int half_a_second_ms = 500;
+	int epoll_fd = -1;
+
+	/*
+	 * Either block in receive with a timeout set on the socket, one syscall
+	 * per command, or wait on epoll first to be able to timeout.
+	 */
+	bool blocking_receive = ics->server->blocking_receive;
+	if (blocking_receive) {
+		if (!setup_receive_timeout(ics, half_a_second_ms)) {
+			return;
+		}
+	} else {
+		// Claim the client fd.
+		epoll_fd = setup_epoll(ics);
+		if (epoll_fd < 0) {
+			return;
+		}
 	}
 
-	uint8_t buf[IPC_BUF_SIZE] = {0};
-
 	while (ics->server->running) {
-		const int half_a_second_ms = 500;
-		struct epoll_event event = XRT_STRUCT_INIT;
+		if (!blocking_receive) {
+			struct epoll_event event = XRT_STRUCT_INIT;
 
-		// We use epoll here to be able to timeout.
-		int ret = epoll_wait(epoll_fd, &event, 1, half_a_second_ms);
-		if (ret < 0) {
-			IPC_ERROR(ics->server, "Failed epoll_wait '%i', disconnecting client.", ret);
-			break;
-		}
+			// We use epoll here to be able to timeout.
+			int ret = epoll_wait(epoll_fd, &event, 1, half_a_second_ms);
+			if (ret < 0) {
+				IPC_ERROR(ics->server, "Failed epoll_wait '%i', disconnecting client.", ret);
+				break;
+			}
 
-		// Timed out, loop again.
-		if (ret == 0) {
-			continue;
-		}
+			// Timed out, loop again.
+			if (ret == 0) {
+				continue;
+			}
 
-		// Detect clients disconnecting gracefully.
-		if (ret > 0 && (event.events & EPOLLHUP) != 0) {
-			IPC_INFO(ics->server, "Client disconnected.");
-			break;
+			// Detect clients disconnecting gracefully.
+			if (ret > 0 && (event.events & EPOLLHUP) != 0) {
+				IPC_INFO(ics->server, "Client disconnected.");
+				break;
+			}
 		}
 
-		// Finally get the data that is waiting for us.
-		//! @todo replace this call
-		ssize_t len = recv(ics->imc.ipc_handle, &buf, IPC_BUF_SIZE, 0);
-		if (len < 4) {
-			IPC_ERROR(ics->server, "Invalid packet received, disconnecting client.");
-			break;
+		// Finally get the data that is waiting for us and dispatch it.
+		xrt_result_t xret = handle_one_message(ics);
+		if (xret == XRT_TIMEOUT) {
+			continue;
 		}
-
-		// Check the first 4 bytes of the message and dispatch.
-		ipc_command_t *ipc_command = (ipc_command_t *)buf;
-
-		IPC_TRACE_BEGIN(ipc_dispatch);
-		xrt_result_t result = ipc_dispatch(ics, ipc_command);
-		IPC_TRACE_END(ipc_dispatch);
-
-		if (result != XRT_SUCCESS) {
-			IPC_ERROR(ics->server, "During packet handling, disconnecting client.");
+		if (xret != XRT_SUCCESS) {
 			break;
 		}
 	}
 
-	close(epoll_fd);
-	epoll_fd = -1;
+	if (epoll_fd >= 0) {
+		close(epoll_fd);
+		epoll_fd = -1;
+	}
 
-	// Multiple threads might be looking at these fields.
-	os_mutex_lock(&ics->server->global_state.lock);
+	client_teardown(ics, IPC_THREAD_STOPPING);
+}
 
-	ipc_message_channel_close((struct ipc_message_channel *)&ics->imc);
 
-	ics->server->threads[ics->server_thread_index].state = IPC_THREAD_STOPPING;
-	ics->server_thread_index = -1;
-	memset((void *)&ics->client_state, 0, sizeof(struct ipc_app_state));
+/*
+ *
+ * Worker pool functions.
+ *
+ */
 
-	os_mutex_unlock(&ics->server->global_state.lock);
+bool
+ipc_server_client_handle_message(void *ptr)
+{
+	volatile struct ipc_client_state *ics = (volatile struct ipc_client_state *)ptr;
 
-	ipc_server_client_destroy_compositor(ics);
+	// The pool only calls us when there is data, a timeout is spurious.
+	xrt_result_t xret = handle_one_message(ics);
 
-	// Make sure undestroyed spaces are unreferenced
-	for (uint32_t i = 0; i < IPC_MAX_CLIENT_SPACES; i++) {
-		// Cast away volatile.
-		xrt_space_reference((struct xrt_space **)&ics->xspcs[i], NULL);
-	}
+	return xret == XRT_SUCCESS || xret == XRT_TIMEOUT;
+}
 
-	// Should we stop the server when a client disconnects?
-	if (ics->server->exit_on_disconnect) {
-		ics->server->running = false;
-	}
+void
+ipc_server_client_removed(void *ptr)
+{
+	volatile struct ipc_client_state *ics = (volatile struct ipc_client_state *)ptr;
 
-	ipc_server_deactivate_session(ics);
+	// No thread to join, the slot can be reused straight away.
+	client_teardown(ics, IPC_THREAD_READY);
+}
+
+void
+ipc_server_client_will_block(volatile struct ipc_client_state *ics)
+{
+	// Only matters when threads are shared between clients.
+	if (ics->server->worker_pool != NULL) {
+		ipc_server_worker_pool_will_block(ics->server->worker_pool);
+	}
 }
 
 #else // XRT_OS_WINDOWS
@@ -193,31 +351,14 @@ client_loop(volatile struct ipc_client_state *ics)
 		}
 	}
 
-	// Multiple threads might be looking at these fields.
-	os_mutex_lock(&ics->server->global_state.lock);
-
-	ipc_message_channel_close((struct ipc_message_channel *)&ics->imc);
-
-	ics->server->threads[ics->server_thread_index].state = IPC_THREAD_STOPPING;
-	ics->server_thread_index = -1;
-	memset((void *)&ics->client_state, 0, sizeof(struct ipc_app_state));
-
-	os_mutex_unlock(&ics->server->global_state.lock);
-
-	ipc_server_client_destroy_compositor(ics);
-
-	// Make sure undestroyed spaces are unreferenced
-	for (uint32_t i = 0; i < IPC_MAX_CLIENT_SPACES; i++) {
-		// Cast away volatile.
-		xrt_space_reference((struct xrt_space **)&ics->xspcs[i], NULL);
-	}
-
-	// Should we stop the server when a client disconnects?
-	if (ics->server->exit_on_disconnect) {
-		ics->server->running = false;
-	}
+	client_teardown(ics, IPC_THREAD_STOPPING);
+}
 
-	ipc_server_deactivate_session(ics);
+void
+ipc_server_client_will_block(volatile struct ipc_client_state *ics)
+{
+	// Always one thread per client.
+	(void)ics;
 }
 
 #endif // XRT_OS_WINDOWS
@@ -231,9 +372,13 @@ client_loop(volatile struct ipc_client_state *ics)
 void
 ipc_server_client_destroy_compositor(volatile struct ipc_client_state *ics)
 {
+	// The frame timing thread must be done with the compositor.
+	ipc_server_disable_frame_timing(ics->server, ics);
+
 	// Multiple threads might be looking at these fields.
 	os_mutex_lock(&ics->server->global_state.lock);
 
+	ics->layers.valid_mask = 0;
 	ics->swapchain_count = 0;
 
 	// Destroy all swapchains now.
@@ -28,9 +28,20 @@
 #include "util/u_git_tag.h"
 
 #include "shared/ipc_shmem.h"
+#include "shared/ipc_call_stats.h"
+#include "shared/ipc_shared_frame_timing.h"
+#include "shared/ipc_shared_pose.h"
+#include "shared/ipc_shared_input.h"
+#include "shared/ipc_shared_layout.h"
 #include "server/ipc_server.h"
 #include "server/ipc_server_interface.h"
 
+#include "ipc_protocol_generated.h"
+
+#ifndef XRT_OS_WINDOWS
+#include "server/ipc_server_worker_pool.h"
+#endif
+
 #include <stdlib.h>
 #include <inttypes.h>
 #include <stdbool.h>
@@ -50,7 +61,19 @@
  */
 
 DEBUG_GET_ONCE_BOOL_OPTION(exit_on_disconnect, "IPC_EXIT_ON_DISCONNECT", false)
+DEBUG_GET_ONCE_BOOL_OPTION(blocking_receive, "IPC_BLOCKING_RECEIVE", false)
+DEBUG_GET_ONCE_NUM_OPTION(worker_threads, "IPC_WORKER_THREADS", 0)
 DEBUG_GET_ONCE_LOG_OPTION(ipc_log, "IPC_LOG", U_LOGGING_WARN)
+DEBUG_GET_ONCE_BOOL_OPTION(shared_poses, "IPC_SHARED_POSES", false)
+DEBUG_GET_ONCE_NUM_OPTION(shared_poses_period_us, "IPC_SHARED_POSES_PERIOD_US", 2000)
+DEBUG_GET_ONCE_NUM_OPTION(shared_poses_max_prediction_ms, "IPC_SHARED_POSES_MAX_PREDICTION_MS", 10)
+DEBUG_GET_ONCE_BOOL_OPTION(shared_inputs, "IPC_SHARED_INPUTS", false)
+
+//! How long the frame timing thread sleeps at most, bounds how long it takes to stop.
+#define FRAME_TIMING_IDLE_TIMEOUT_NS (100 * U_TIME_1MS_IN_NS)
+
+static void
+activate_session_locked(volatile struct ipc_client_state *ics);
 
 
 /*
@@ -77,20 +100,26 @@ find_xdev_index(struct ipc_server *s, struct xrt_device *xdev)
 	return -1;
 }
 
-static void
+static int
 init_idev(struct ipc_device *idev, struct xrt_device *xdev)
 {
 	if (xdev != NULL) {
 		idev->io_active = true;
 		idev->xdev = xdev;
-	} else {
-		idev->io_active = false;
+		return os_mutex_init(&idev->inputs_lock);
 	}
+
+	idev->io_active = false;
+	return 0;
 }
 
 static void
 teardown_idev(struct ipc_device *idev)
 {
+	if (idev->xdev != NULL) {
+		os_mutex_destroy(&idev->inputs_lock);
+		idev->xdev = NULL;
+	}
 	idev->io_active = false;
 }
 
@@ -103,7 +132,10 @@ init_idevs(struct ipc_server *s)
 			continue;
 		}
 
-		init_idev(&s->idevs[i], s->xsysd->xdevs[i]);
+		int ret = init_idev(&s->idevs[i], s->xsysd->xdevs[i]);
+		if (ret < 0) {
+			return ret;
+		}
 	}
 
 	return 0;
@@ -118,6 +150,426 @@ teardown_idevs(struct ipc_server *s)
 }
 
 
+/*
+ *
+ * Pose publisher functions.
+ *
+ */
+
+/*!
+ * Clients can only use the pose histories if they would get the same answer
+ * from the server, which does extra checks if IO is turned off anywhere.
+ */
+static bool
+all_io_active_locked(struct ipc_server *s)
+{
+	for (size_t i = 0; i < XRT_SYSTEM_MAX_DEVICES; i++) {
+		if (s->idevs[i].xdev != NULL && !s->idevs[i].io_active) {
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+		volatile struct ipc_client_state *ics = &s->threads[i].ics;
+
+		// Not running?
+		if (ics->server_thread_index < 0) {
+			continue;
+		}
+
+		if (!ics->io_active) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*!
+ * Called when IO is turned off somewhere, stops clients from using the shared
+ * poses and inputs right away instead of at the next publish.
+ */
+static void
+stop_sharing_locked(struct ipc_server *s)
+{
+	s->ism->poses.enabled = 0;
+	s->ism->input_state.published = 0;
+}
+
+/*!
+ * Let clients use what was just published, the IO check is done under the
+ * same lock as the toggles so a toggle can't be missed.
+ */
+static void
+update_sharing(struct ipc_server *s)
+{
+	os_mutex_lock(&s->global_state.lock);
+
+	bool io_active = all_io_active_locked(s);
+
+	if (s->pose_publisher.enabled) {
+		s->ism->poses.enabled = io_active ? 1 : 0;
+	}
+	if (s->pose_publisher.inputs_enabled) {
+		// Clients need to call in to get the per client IO checks.
+		s->ism->input_state.published = io_active ? 1 : 0;
+	}
+
+	os_mutex_unlock(&s->global_state.lock);
+}
+
+static void
+publish_poses(struct ipc_server *s)
+{
+	struct ipc_shared_memory *ism = s->ism;
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	for (uint32_t i = 0; i < ism->poses.history_count; i++) {
+		struct ipc_shared_pose_history *isph = ipc_shared_pose_history(ism, i);
+		struct xrt_device *xdev = s->idevs[isph->device_index].xdev;
+		struct xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+
+		xrt_device_get_tracked_pose(xdev, isph->name, now_ns, &relation);
+		ipc_shared_pose_history_push(isph, &relation, now_ns);
+	}
+}
+
+static void
+publish_inputs(struct ipc_server *s)
+{
+	struct ipc_shared_memory *ism = s->ism;
+
+	for (uint32_t i = 0; i < ism->isdev_count; i++) {
+		struct ipc_shared_device *isdev = ipc_shared_isdev(ism, i);
+		if (s->idevs[i].xdev == NULL || isdev->input_count == 0) {
+			continue;
+		}
+
+		ipc_server_update_device_inputs(s, i, s->idevs[i].io_active);
+	}
+}
+
+static void *
+pose_publisher_thread(void *ptr)
+{
+	struct ipc_server *s = (struct ipc_server *)ptr;
+
+	U_TRACE_SET_THREAD_NAME("IPC Pose Publisher");
+	os_thread_helper_name(&s->pose_publisher.oth, "IPC Pose Publisher");
+
+	os_thread_helper_lock(&s->pose_publisher.oth);
+
+	while (os_thread_helper_is_running_locked(&s->pose_publisher.oth)) {
+		os_thread_helper_unlock(&s->pose_publisher.oth);
+
+		if (s->pose_publisher.enabled) {
+			publish_poses(s);
+		}
+		if (s->pose_publisher.inputs_enabled) {
+			publish_inputs(s);
+		}
+
+		update_sharing(s);
+
+		os_nanosleep((int64_t)s->pose_publisher.period_ns);
+
+		// Must lock thread before check in while.
+		os_thread_helper_lock(&s->pose_publisher.oth);
+	}
+
+	os_thread_helper_unlock(&s->pose_publisher.oth);
+
+	// Make sure clients stop using stale data.
+	s->ism->poses.enabled = 0;
+	s->ism->input_state.published = 0;
+
+	return NULL;
+}
+
+static int
+init_pose_publisher(struct ipc_server *s)
+{
+	int ret = os_thread_helper_init(&s->pose_publisher.oth);
+	if (ret < 0) {
+		return ret;
+	}
+
+	s->pose_publisher.enabled = debug_get_bool_option_shared_poses() && s->ism->poses.history_count > 0;
+	s->pose_publisher.inputs_enabled = debug_get_bool_option_shared_inputs();
+	s->pose_publisher.period_ns = debug_get_num_option_shared_poses_period_us() * U_TIME_1MS_IN_NS / 1000;
+
+	if (!s->pose_publisher.enabled && !s->pose_publisher.inputs_enabled) {
+		return 0;
+	}
+
+	if (s->pose_publisher.enabled) {
+		IPC_INFO(s, "Publishing %u pose(s) to shared memory every %" PRIu64 "ns.",
+		         s->ism->poses.history_count, s->pose_publisher.period_ns);
+	}
+	if (s->pose_publisher.inputs_enabled) {
+		IPC_INFO(s, "Publishing inputs to shared memory every %" PRIu64 "ns.", s->pose_publisher.period_ns);
+	}
+
+	return os_thread_helper_start(&s->pose_publisher.oth, pose_publisher_thread, s);
+}
+
+
+/*
+ *
+ * Frame timing functions.
+ *
+ */
+
+/*!
+ * Predict a frame for the client if it has asked for one in its frame timing
+ * slot. Called with the frame timing thread's lock held, which keeps the
+ * compositor from going away, see @ref ipc_server_disable_frame_timing.
+ */
+static void
+serve_frame_timing_request_locked(struct ipc_server *s, volatile struct ipc_client_state *ics)
+{
+	if (!ics->frame_timing.enabled || ics->xc == NULL) {
+		return;
+	}
+
+	struct ipc_shared_frame_timing *isft = ipc_shared_frame_timing(s->ism, ics->frame_timing.index);
+	if (!ipc_shared_frame_timing_is_requested(isft)) {
+		return;
+	}
+
+	// Same as the predict_frame call, the session has started.
+	os_mutex_lock(&s->global_state.lock);
+	activate_session_locked(ics);
+	os_mutex_unlock(&s->global_state.lock);
+
+	struct ipc_frame_prediction prediction = {0};
+	uint64_t gpu_time_ns = 0;
+	xrt_result_t xret = xrt_comp_predict_frame(   //
+	    ics->xc,                                  //
+	    &prediction.frame_id,                     //
+	    &prediction.wake_up_time_ns,              //
+	    &gpu_time_ns,                             //
+	    &prediction.predicted_display_time_ns,    //
+	    &prediction.predicted_display_period_ns); //
+	if (xret != XRT_SUCCESS) {
+		// The client times out and falls back to the call.
+		return;
+	}
+
+	if (!ipc_shared_frame_timing_publish(isft, &prediction)) {
+		// The client gave up waiting, retire the frame so the pacer doesn't keep it around.
+		xrt_comp_mark_frame(ics->xc, prediction.frame_id, XRT_COMPOSITOR_FRAME_POINT_WOKE, os_monotonic_get_ns());
+		xrt_comp_discard_frame(ics->xc, prediction.frame_id);
+	}
+}
+
+/*!
+ * Predict a frame for every client that has asked for one in its frame timing
+ * slot, done here when the client starts waiting so the prediction is as
+ * fresh as one made by the predict_frame call.
+ */
+static void
+serve_frame_timing_requests(struct ipc_server *s)
+{
+	uint32_t indices[IPC_MAX_CLIENTS];
+	uint32_t count = 0;
+
+	// Only look up the clients under the global lock, the predictions can take a while.
+	os_mutex_lock(&s->global_state.lock);
+	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+		if (s->threads[i].ics.server_thread_index >= 0) {
+			indices[count++] = i;
+		}
+	}
+	os_mutex_unlock(&s->global_state.lock);
+
+	for (uint32_t i = 0; i < count; i++) {
+		os_thread_helper_lock(&s->frame_timing.oth);
+		serve_frame_timing_request_locked(s, &s->threads[indices[i]].ics);
+		os_thread_helper_unlock(&s->frame_timing.oth);
+	}
+}
+
+//! Sleep until a client has enabled frame timing, returns false if the thread should stop.
+static bool
+wait_for_frame_timing_clients(struct ipc_server *s)
+{
+	struct os_thread_helper *oth = &s->frame_timing.oth;
+
+	os_thread_helper_lock(oth);
+	while (os_thread_helper_is_running_locked(oth) && s->frame_timing.client_count == 0) {
+		os_thread_helper_wait_locked(oth);
+	}
+	bool running = os_thread_helper_is_running_locked(oth);
+	os_thread_helper_unlock(oth);
+
+	return running;
+}
+
+static void *
+frame_timing_thread(void *ptr)
+{
+	struct ipc_server *s = (struct ipc_server *)ptr;
+	xrt_atomic_s32_t *doorbell = &s->ism->frame_timing_doorbell;
+
+	U_TRACE_SET_THREAD_NAME("IPC Frame Timing");
+	os_thread_helper_name(&s->frame_timing.oth, "IPC Frame Timing");
+
+	while (wait_for_frame_timing_clients(s)) {
+		// Read before serving so no ring is missed.
+		int32_t seen = xrt_atomic_s32_cmpxchg(doorbell, 0, 0);
+
+		serve_frame_timing_requests(s);
+
+		ipc_shared_frame_timing_wait_doorbell(doorbell, seen, FRAME_TIMING_IDLE_TIMEOUT_NS);
+	}
+
+	return NULL;
+}
+
+static int
+init_frame_timing(struct ipc_server *s)
+{
+	int ret = os_thread_helper_init(&s->frame_timing.oth);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return os_thread_helper_start(&s->frame_timing.oth, frame_timing_thread, s);
+}
+
+static void
+teardown_frame_timing(struct ipc_server *s)
+{
+	if (!s->frame_timing.oth.initialized) {
+		return;
+	}
+
+	// Wake the thread up so it sees that it should stop.
+	os_thread_helper_signal_stop(&s->frame_timing.oth);
+	ipc_shared_frame_timing_ring_doorbell(&s->ism->frame_timing_doorbell);
+
+	os_thread_helper_destroy(&s->frame_timing.oth);
+}
+
+
+/*
+ *
+ * Call stats functions.
+ *
+ */
+
+static void
+get_total_call_stats(struct ipc_server *s, struct ipc_call_stats *out_stats)
+{
+	// Clients retire their stats under the global lock, so none are counted twice.
+	os_mutex_lock(&s->global_state.lock);
+
+	os_mutex_lock(&s->call_stats.lock);
+	*out_stats = s->call_stats.retired;
+	os_mutex_unlock(&s->call_stats.lock);
+
+	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+		volatile struct ipc_client_state *ics = &s->threads[i].ics;
+		if (ics->server_thread_index < 0) {
+			continue;
+		}
+
+		for (uint32_t k = 0; k < IPC_CALL_STATS_MAX_COMMANDS; k++) {
+			// Might be torn while the client is running, good enough for stats.
+			const struct ipc_call_stat *stat = (struct ipc_call_stat *)&ics->call_stats.calls[k];
+			ipc_call_stat_accumulate(&out_stats->calls[k], stat);
+		}
+	}
+
+	os_mutex_unlock(&s->global_state.lock);
+}
+
+static void
+update_call_stats_snapshot(void *ptr)
+{
+	struct ipc_server *s = (struct ipc_server *)ptr;
+
+	get_total_call_stats(s, &s->call_stats.totals);
+
+	for (uint32_t i = 0; i < IPC_CALL_STATS_MAX_COMMANDS; i++) {
+		const struct ipc_call_stat *stat = &s->call_stats.totals.calls[i];
+
+		s->call_stats.percentiles[i].p50_ns = ipc_call_stat_percentile_ns(stat, 0.5);
+		s->call_stats.percentiles[i].p99_ns = ipc_call_stat_percentile_ns(stat, 0.99);
+	}
+}
+
+static int
+init_call_stats(struct ipc_server *s)
+{
+	int ret = os_mutex_init(&s->call_stats.lock);
+	if (ret < 0) {
+		return ret;
+	}
+
+	s->call_stats.update_btn.cb = update_call_stats_snapshot;
+	s->call_stats.update_btn.ptr = s;
+
+	u_var_add_root(&s->call_stats, "IPC Call Stats", false);
+	u_var_add_button(&s->call_stats, &s->call_stats.update_btn, "Update");
+
+	for (uint32_t i = 1; i < IPC_COMMAND_COUNT; i++) {
+		struct ipc_call_stat *stat = &s->call_stats.totals.calls[i];
+
+		u_var_add_gui_header(&s->call_stats, NULL, ipc_cmd_to_str((ipc_command_t)i));
+		u_var_add_ro_u64(&s->call_stats, &stat->count, "Count");
+		u_var_add_ro_u64(&s->call_stats, &stat->bytes, "Bytes");
+		u_var_add_ro_u64(&s->call_stats, &s->call_stats.percentiles[i].p50_ns, "p50 (ns)");
+		u_var_add_ro_u64(&s->call_stats, &s->call_stats.percentiles[i].p99_ns, "p99 (ns)");
+		u_var_add_ro_u64(&s->call_stats, &stat->max_ns, "Max (ns)");
+	}
+
+	return 0;
+}
+
+static void
+teardown_call_stats(struct ipc_server *s)
+{
+	u_var_remove_root(&s->call_stats);
+	os_mutex_destroy(&s->call_stats.lock);
+}
+
+
+/*
+ *
+ * Worker pool functions.
+ *
+ */
+
+static int
+init_worker_pool(struct ipc_server *s)
+{
+	uint32_t thread_count = (uint32_t)debug_get_num_option_worker_threads();
+	if (thread_count == 0) {
+		// One thread per client.
+		return 0;
+	}
+
+#ifndef XRT_OS_WINDOWS
+	int ret = ipc_server_worker_pool_create( //
+	    thread_count,                        //
+	    ipc_server_client_handle_message,    //
+	    ipc_server_client_removed,           //
+	    &s->worker_pool);                    //
+	if (ret < 0) {
+		return ret;
+	}
+
+	IPC_INFO(s, "Servicing clients with %u worker threads.", thread_count);
+#else
+	IPC_WARN(s, "IPC_WORKER_THREADS is not supported on this platform, using one thread per client.");
+#endif
+
+	return 0;
+}
+
+
 /*
  *
  * Static functions.
@@ -129,6 +581,19 @@ teardown_all(struct ipc_server *s)
 {
 	u_var_remove_root(s);
 
+	// Samples devices, stop before they go away.
+	if (s->pose_publisher.oth.initialized) {
+		os_thread_helper_destroy(&s->pose_publisher.oth);
+	}
+
+	// Calls into the compositors, stop before they go away.
+	teardown_frame_timing(s);
+
+#ifndef XRT_OS_WINDOWS
+	// Calls into the compositor, stop before it goes away.
+	ipc_server_worker_pool_destroy(&s->worker_pool);
+#endif
+
 	xrt_syscomp_destroy(&s->xsysc);
 
 	teardown_idevs(s);
@@ -142,9 +607,11 @@ teardown_all(struct ipc_server *s)
 
 	u_process_destroy(s->process);
 
+	teardown_call_stats(s);
+
 	os_mutex_destroy(&s->global_state.lock);
 
-	ipc_shmem_destroy(&s->ism_handle, (void **)&s->ism, sizeof(struct ipc_shared_memory));
+	ipc_shmem_destroy(&s->ism_handle, (void **)&s->ism, s->ism_size);
 }
 
 static int
@@ -189,7 +656,7 @@ handle_binding(struct ipc_shared_memory *ism,
 	// Copy the initial state and also count the number in input_pairs.
 	uint32_t input_pair_start = input_pair_index;
 	for (size_t k = 0; k < xbp->input_count; k++) {
-		ism->input_pairs[input_pair_index++] = xbp->inputs[k];
+		*ipc_shared_input_pair(ism, input_pair_index++) = xbp->inputs[k];
 	}
 
 	// Setup the 'offsets' and number of input_pairs.
@@ -201,7 +668,7 @@ handle_binding(struct ipc_shared_memory *ism,
 	// Copy the initial state and also count the number in outputs.
 	uint32_t output_pair_start = output_pair_index;
 	for (size_t k = 0; k < xbp->output_count; k++) {
-		ism->output_pairs[output_pair_index++] = xbp->outputs[k];
+		*ipc_shared_output_pair(ism, output_pair_index++) = xbp->outputs[k];
 	}
 
 	// Setup the 'offsets' and number of output_pairs.
@@ -214,10 +681,52 @@ handle_binding(struct ipc_shared_memory *ism,
 	*output_pair_index_ptr = output_pair_index;
 }
 
+static void
+count_shm_sections(struct ipc_server *s, uint32_t counts[IPC_SHARED_SECTION_COUNT])
+{
+	for (size_t i = 0; i < XRT_SYSTEM_MAX_DEVICES; i++) {
+		if (s->xtracks[i] != NULL) {
+			counts[IPC_SHARED_SECTION_ITRACKS]++;
+		}
+	}
+
+	for (size_t i = 0; i < XRT_SYSTEM_MAX_DEVICES; i++) {
+		struct xrt_device *xdev = s->idevs[i].xdev;
+		if (xdev == NULL) {
+			continue;
+		}
+
+		counts[IPC_SHARED_SECTION_ISDEVS]++;
+		counts[IPC_SHARED_SECTION_INPUT_GENERATIONS]++;
+		counts[IPC_SHARED_SECTION_BINDING_PROFILES] += (uint32_t)xdev->binding_profile_count;
+		counts[IPC_SHARED_SECTION_INPUTS] += (uint32_t)xdev->input_count;
+		counts[IPC_SHARED_SECTION_OUTPUTS] += (uint32_t)xdev->output_count;
+
+		for (size_t k = 0; k < xdev->binding_profile_count; k++) {
+			counts[IPC_SHARED_SECTION_INPUT_PAIRS] += (uint32_t)xdev->binding_profiles[k].input_count;
+			counts[IPC_SHARED_SECTION_OUTPUT_PAIRS] += (uint32_t)xdev->binding_profiles[k].output_count;
+		}
+
+		for (size_t k = 0; k < xdev->input_count; k++) {
+			if (XRT_GET_INPUT_TYPE(xdev->inputs[k].name) == XRT_INPUT_TYPE_POSE) {
+				counts[IPC_SHARED_SECTION_POSE_HISTORIES]++;
+			}
+		}
+	}
+
+	counts[IPC_SHARED_SECTION_SLOTS] = IPC_MAX_SLOTS;
+	counts[IPC_SHARED_SECTION_FRAME_TIMINGS] = IPC_MAX_CLIENTS;
+}
+
 static int
 init_shm(struct ipc_server *s)
 {
-	const size_t size = sizeof(struct ipc_shared_memory);
+	// Size everything to the actual system.
+	uint32_t counts[IPC_SHARED_SECTION_COUNT] = {0};
+	struct ipc_shared_toc_entry toc[IPC_SHARED_SECTION_COUNT];
+	count_shm_sections(s, counts);
+
+	const size_t size = ipc_shared_layout_compute(counts, toc);
 	xrt_shmem_handle_t handle;
 	xrt_result_t result = ipc_shmem_create(size, &handle, (void **)&s->ism);
 	if (result != XRT_SUCCESS) {
@@ -226,6 +735,10 @@ init_shm(struct ipc_server *s)
 
 	// we have a filehandle, we will pass this to our client
 	s->ism_handle = handle;
+	s->ism_size = size;
+
+	IPC_INFO(s, "Shared memory is %zu bytes, %u device(s) with %u input(s).", size,
+	         counts[IPC_SHARED_SECTION_ISDEVS], counts[IPC_SHARED_SECTION_INPUTS]);
 
 
 	/*
@@ -237,6 +750,10 @@ init_shm(struct ipc_server *s)
 	uint32_t count = 0;
 	struct ipc_shared_memory *ism = s->ism;
 
+	ism->layout_version = IPC_SHARED_MEMORY_LAYOUT_VERSION;
+	ism->total_size = size;
+	memcpy(ism->toc, toc, sizeof(ism->toc));
+
 	ism->startup_timestamp = os_monotonic_get_ns();
 
 	// Setup the tracking origins.
@@ -251,7 +768,7 @@ init_shm(struct ipc_server *s)
 		// server's memory.
 		assert(i < XRT_SYSTEM_MAX_DEVICES);
 
-		struct ipc_shared_tracking_origin *itrack = &ism->itracks[count++];
+		struct ipc_shared_tracking_origin *itrack = ipc_shared_itrack(ism, count++);
 		memcpy(itrack->name, xtrack->name, sizeof(itrack->name));
 		itrack->type = xtrack->type;
 		itrack->offset = xtrack->offset;
@@ -272,7 +789,7 @@ init_shm(struct ipc_server *s)
 			continue;
 		}
 
-		struct ipc_shared_device *isdev = &ism->isdevs[count++];
+		struct ipc_shared_device *isdev = ipc_shared_isdev(ism, count++);
 
 		isdev->name = xdev->name;
 		memcpy(isdev->str, xdev->str, sizeof(isdev->str));
@@ -320,7 +837,7 @@ init_shm(struct ipc_server *s)
 		// Bindings
 		uint32_t binding_start = binding_index;
 		for (size_t k = 0; k < xdev->binding_profile_count; k++) {
-			handle_binding(ism, &xdev->binding_profiles[k], &ism->binding_profiles[binding_index++],
+			handle_binding(ism, &xdev->binding_profiles[k], ipc_shared_binding_profile(ism, binding_index++),
 			               &input_pair_index, &output_pair_index);
 		}
 
@@ -333,7 +850,7 @@ init_shm(struct ipc_server *s)
 		// Copy the initial state and also count the number in inputs.
 		uint32_t input_start = input_index;
 		for (size_t k = 0; k < xdev->input_count; k++) {
-			ism->inputs[input_index++] = xdev->inputs[k];
+			*ipc_shared_input(ism, input_index++) = xdev->inputs[k];
 		}
 
 		// Setup the 'offsets' and number of inputs.
@@ -345,7 +862,7 @@ init_shm(struct ipc_server *s)
 		// Copy the initial state and also count the number in outputs.
 		uint32_t output_start = output_index;
 		for (size_t k = 0; k < xdev->output_count; k++) {
-			ism->outputs[output_index++] = xdev->outputs[k];
+			*ipc_shared_output(ism, output_index++) = xdev->outputs[k];
 		}
 
 		// Setup the 'offsets' and number of outputs.
@@ -353,8 +870,21 @@ init_shm(struct ipc_server *s)
 			isdev->output_count = output_index - output_start;
 			isdev->first_output_index = output_start;
 		}
+
+		// Pose histories for all pose inputs, filled in by the pose publisher.
+		for (size_t k = 0; k < xdev->input_count; k++) {
+			enum xrt_input_name name = xdev->inputs[k].name;
+			if (XRT_GET_INPUT_TYPE(name) != XRT_INPUT_TYPE_POSE) {
+				continue;
+			}
+
+			struct ipc_shared_pose_history *isph = ipc_shared_pose_history(ism, ism->poses.history_count++);
+			ipc_shared_pose_history_init(isph, (uint32_t)i, name);
+		}
 	}
 
+	ism->poses.max_prediction_ns = debug_get_num_option_shared_poses_max_prediction_ms() * U_TIME_1MS_IN_NS;
+
 	// Finally tell the client how many devices we have.
 	s->ism->isdev_count = count;
 
@@ -395,10 +925,12 @@ ipc_server_handle_client_connected(struct ipc_server *vs, xrt_ipc_handle_t ipc_h
 	os_mutex_lock(&vs->global_state.lock);
 
 	// find the next free thread in our array (server_thread_index is -1)
-	// and have it handle this connection
+	// and have it handle this connection, skipping slots whose client is
+	// still being torn down
 	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
 		volatile struct ipc_client_state *_cs = &vs->threads[i].ics;
-		if (_cs->server_thread_index < 0) {
+		enum ipc_thread_state state = vs->threads[i].state;
+		if (_cs->server_thread_index < 0 && (state == IPC_THREAD_READY || state == IPC_THREAD_STOPPING)) {
 			ics = _cs;
 			cs_index = i;
 			break;
@@ -448,6 +980,26 @@ ipc_server_handle_client_connected(struct ipc_server *vs, xrt_ipc_handle_t ipc_h
 	ics->server_thread_index = cs_index;
 	ics->io_active = true;
 
+#ifndef XRT_OS_WINDOWS
+	if (vs->worker_pool != NULL) {
+		// No thread of its own, the slot is returned to ready on removal.
+		it->state = IPC_THREAD_RUNNING;
+
+		int ret = ipc_server_worker_pool_add(vs->worker_pool, ipc_handle, (void *)ics);
+		if (ret < 0) {
+			xrt_ipc_handle_close(ipc_handle);
+			ics->imc.ipc_handle = XRT_IPC_HANDLE_INVALID;
+			ics->server_thread_index = -1;
+			it->state = IPC_THREAD_READY;
+			U_LOG_E("Failed to add client to worker pool!");
+		}
+
+		// Unlock when we are done.
+		os_mutex_unlock(&vs->global_state.lock);
+		return;
+	}
+#endif
+
 	os_thread_start(&it->thread, ipc_server_client_thread, (void *)ics);
 
 	// Unlock when we are done.
@@ -467,6 +1019,13 @@ init_all(struct ipc_server *s)
 		return ret;
 	}
 
+	ret = init_call_stats(s);
+	if (ret < 0) {
+		IPC_ERROR(s, "Call stats lock mutex failed to init!");
+		teardown_all(s);
+		return ret;
+	}
+
 	s->process = u_process_create_if_not_running();
 
 	if (!s->process) {
@@ -478,6 +1037,7 @@ init_all(struct ipc_server *s)
 	// Yes we should be running.
 	s->running = true;
 	s->exit_on_disconnect = debug_get_bool_option_exit_on_disconnect();
+	s->blocking_receive = debug_get_bool_option_blocking_receive();
 	s->log_level = debug_get_log_option_ipc_log();
 
 	xret = xrt_instance_create(NULL, &s->xinst);
@@ -522,10 +1082,33 @@ init_all(struct ipc_server *s)
 		return ret;
 	}
 
+	ret = init_pose_publisher(s);
+	if (ret < 0) {
+		IPC_ERROR(s, "Failed to init pose publisher!");
+		teardown_all(s);
+		return ret;
+	}
+
+	ret = init_frame_timing(s);
+	if (ret < 0) {
+		IPC_ERROR(s, "Failed to init frame timing thread!");
+		teardown_all(s);
+		return ret;
+	}
+
+	ret = init_worker_pool(s);
+	if (ret < 0) {
+		IPC_ERROR(s, "Failed to init worker pool!");
+		teardown_all(s);
+		return ret;
+	}
+
 	u_var_add_root(s, "IPC Server", false);
 	u_var_add_log_level(s, &s->log_level, "Log level");
 	u_var_add_bool(s, &s->exit_on_disconnect, "exit_on_disconnect");
 	u_var_add_bool(s, (bool *)&s->running, "running");
+	u_var_add_ro_i32(s, (int32_t *)&s->ism->poses.enabled, "Pose histories enabled");
+	u_var_add_ro_i32(s, (int32_t *)&s->ism->input_state.published, "Inputs published");
 
 	return 0;
 }
@@ -792,10 +1375,40 @@ toggle_io_client_locked(struct ipc_server *s, uint32_t client_id)
 	}
 
 	ics->io_active = !ics->io_active;
+	if (!ics->io_active) {
+		stop_sharing_locked(s);
+	}
 
 	return XRT_SUCCESS;
 }
 
+static void
+activate_session_locked(volatile struct ipc_client_state *ics)
+{
+	struct ipc_server *s = ics->server;
+
+	// Already active, noop.
+	if (ics->client_state.session_active) {
+		return;
+	}
+
+	ics->client_state.session_active = true;
+
+	if (ics->client_state.session_overlay) {
+		// For new active overlay sessions only update this session.
+		handle_focused_client_events(ics, s->global_state.active_client_index,
+		                             s->global_state.last_active_client_index);
+		handle_overlay_client_events(ics, s->global_state.active_client_index,
+		                             s->global_state.last_active_client_index);
+	} else {
+		// Update active client
+		set_active_client_locked(s, ics->client_state.id);
+
+		// For new active regular sessions update all clients.
+		update_server_state_locked(s);
+	}
+}
+
 
 /*
  *
@@ -814,6 +1427,61 @@ ipc_server_get_client_app_state(struct ipc_server *s, uint32_t client_id, struct
 	return xret;
 }
 
+void
+ipc_server_record_call(volatile struct ipc_client_state *ics, uint32_t command, uint64_t bytes, uint64_t start_ns)
+{
+	if (command >= IPC_CALL_STATS_MAX_COMMANDS) {
+		return;
+	}
+
+	uint64_t duration_ns = os_monotonic_get_ns() - start_ns;
+
+	// Only this thread writes these, no lock needed, cast away volatile.
+	ipc_call_stat_record((struct ipc_call_stat *)&ics->call_stats.calls[command], bytes, duration_ns);
+}
+
+xrt_result_t
+ipc_server_get_client_call_stats(struct ipc_server *s, uint32_t client_id, struct ipc_call_stats *out_stats)
+{
+	if (client_id == 0) {
+		get_total_call_stats(s, out_stats);
+
+		return XRT_SUCCESS;
+	}
+
+	os_mutex_lock(&s->global_state.lock);
+
+	volatile struct ipc_client_state *ics = find_client_locked(s, client_id);
+	if (ics == NULL) {
+		os_mutex_unlock(&s->global_state.lock);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	// Might be torn while the client is running, good enough for stats.
+	*out_stats = *(struct ipc_call_stats *)&ics->call_stats;
+
+	os_mutex_unlock(&s->global_state.lock);
+
+	return XRT_SUCCESS;
+}
+
+void
+ipc_server_retire_client_call_stats_locked(volatile struct ipc_client_state *ics)
+{
+	struct ipc_server *s = ics->server;
+
+	os_mutex_lock(&s->call_stats.lock);
+
+	for (uint32_t i = 0; i < IPC_CALL_STATS_MAX_COMMANDS; i++) {
+		const struct ipc_call_stat *stat = (struct ipc_call_stat *)&ics->call_stats.calls[i];
+		ipc_call_stat_accumulate(&s->call_stats.retired.calls[i], stat);
+	}
+
+	os_mutex_unlock(&s->call_stats.lock);
+
+	memset((void *)&ics->call_stats, 0, sizeof(struct ipc_call_stats));
+}
+
 xrt_result_t
 ipc_server_set_active_client(struct ipc_server *s, uint32_t client_id)
 {
@@ -834,6 +1502,27 @@ ipc_server_toggle_io_client(struct ipc_server *s, uint32_t client_id)
 	return xret;
 }
 
+xrt_result_t
+ipc_server_toggle_io_device(struct ipc_server *s, uint32_t device_id)
+{
+	if (device_id >= IPC_MAX_DEVICES) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	struct ipc_device *idev = &s->idevs[device_id];
+
+	os_mutex_lock(&s->global_state.lock);
+
+	idev->io_active = !idev->io_active;
+	if (!idev->io_active) {
+		stop_sharing_locked(s);
+	}
+
+	os_mutex_unlock(&s->global_state.lock);
+
+	return XRT_SUCCESS;
+}
+
 void
 ipc_server_activate_session(volatile struct ipc_client_state *ics)
 {
@@ -849,21 +1538,7 @@ ipc_server_activate_session(volatile struct ipc_client_state *ics)
 	// Multiple threads could call this at the same time.
 	os_mutex_lock(&s->global_state.lock);
 
-	ics->client_state.session_active = true;
-
-	if (ics->client_state.session_overlay) {
-		// For new active overlay sessions only update this session.
-		handle_focused_client_events(ics, s->global_state.active_client_index,
-		                             s->global_state.last_active_client_index);
-		handle_overlay_client_events(ics, s->global_state.active_client_index,
-		                             s->global_state.last_active_client_index);
-	} else {
-		// Update active client
-		set_active_client_locked(s, ics->client_state.id);
-
-		// For new active regular sessions update all clients.
-		update_server_state_locked(s);
-	}
+	activate_session_locked(ics);
 
 	os_mutex_unlock(&s->global_state.lock);
 }
@@ -894,6 +1569,66 @@ ipc_server_update_state(struct ipc_server *s)
 	os_mutex_unlock(&s->global_state.lock);
 }
 
+void
+ipc_server_update_device_inputs(struct ipc_server *s, uint32_t device_index, bool io_active)
+{
+	struct ipc_shared_memory *ism = s->ism;
+	struct ipc_device *idev = &s->idevs[device_index];
+	struct ipc_shared_device *isdev = ipc_shared_isdev(ism, device_index);
+
+	// The inputs are also read while copying, so both are under the lock.
+	os_mutex_lock(&idev->inputs_lock);
+
+	xrt_device_update_inputs(idev->xdev);
+
+	// Only written if something changed.
+	if (isdev->input_count > 0) {
+		ipc_shared_inputs_update(                            //
+		    ipc_shared_input_generation(ism, device_index),  //
+		    ipc_shared_input(ism, isdev->first_input_index), //
+		    idev->xdev->inputs,                              //
+		    isdev->input_count,                              //
+		    io_active);                                      //
+	}
+
+	os_mutex_unlock(&idev->inputs_lock);
+}
+
+void
+ipc_server_enable_frame_timing(struct ipc_server *s, volatile struct ipc_client_state *ics, uint32_t index)
+{
+	struct os_thread_helper *oth = &s->frame_timing.oth;
+
+	os_thread_helper_lock(oth);
+
+	if (!ics->frame_timing.enabled) {
+		ics->frame_timing.index = index;
+		ics->frame_timing.enabled = true;
+		s->frame_timing.client_count++;
+
+		// Wake the thread up if it was idle.
+		os_thread_helper_signal_locked(oth);
+	}
+
+	os_thread_helper_unlock(oth);
+}
+
+void
+ipc_server_disable_frame_timing(struct ipc_server *s, volatile struct ipc_client_state *ics)
+{
+	struct os_thread_helper *oth = &s->frame_timing.oth;
+
+	// Waits for any prediction in flight for this client.
+	os_thread_helper_lock(oth);
+
+	if (ics->frame_timing.enabled) {
+		ics->frame_timing.enabled = false;
+		s->frame_timing.client_count--;
+	}
+
+	os_thread_helper_unlock(oth);
+}
+
 #ifndef XRT_OS_ANDROID
 int
 ipc_server_main(int argc, char **argv)
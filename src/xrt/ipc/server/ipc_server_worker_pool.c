@@ -0,0 +1,369 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Pool of worker threads servicing client sockets from one epoll set.
+ * @ingroup ipc_server
+ */
+
+#include "os/os_threading.h"
+
+#include "util/u_misc.h"
+#include "util/u_logging.h"
+#include "util/u_trace_marker.h"
+
+#include "server/ipc_server_worker_pool.h"
+
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+
+/*
+ *
+ * Structs.
+ *
+ */
+
+/*!
+ * One fd in the pool, used as the epoll data.
+ */
+struct pool_entry
+{
+	int fd;
+	void *ptr;
+
+	//! All entries in the pool, so they can be removed on destroy.
+	struct pool_entry *prev;
+	struct pool_entry *next;
+};
+
+struct ipc_server_worker_pool
+{
+	int epoll_fd;
+
+	//! Signalled on destroy, never read so all threads see it.
+	int stop_fd;
+
+	ipc_server_worker_pool_handle_func_t handle_func;
+	ipc_server_worker_pool_remove_func_t remove_func;
+
+	//! Protects all of the fields below.
+	struct os_mutex lock;
+
+	//! List of all entries in the pool.
+	struct pool_entry *entries;
+
+	//! Number of threads in the handle function.
+	uint32_t busy_count;
+
+	//! Set on destroy, no new threads are started after this.
+	bool stopping;
+
+	uint32_t thread_count;
+	struct os_thread threads[IPC_SERVER_WORKER_POOL_MAX_THREADS];
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static void
+unlink_entry_locked(struct ipc_server_worker_pool *pool, struct pool_entry *entry)
+{
+	if (entry->prev != NULL) {
+		entry->prev->next = entry->next;
+	} else {
+		pool->entries = entry->next;
+	}
+	if (entry->next != NULL) {
+		entry->next->prev = entry->prev;
+	}
+
+	entry->prev = NULL;
+	entry->next = NULL;
+}
+
+static void
+remove_entry(struct ipc_server_worker_pool *pool, struct pool_entry *entry)
+{
+	os_mutex_lock(&pool->lock);
+	unlink_entry_locked(pool, entry);
+	os_mutex_unlock(&pool->lock);
+
+	epoll_ctl(pool->epoll_fd, EPOLL_CTL_DEL, entry->fd, NULL);
+
+	pool->remove_func(entry->ptr);
+
+	free(entry);
+}
+
+static bool
+rearm_entry(struct ipc_server_worker_pool *pool, struct pool_entry *entry)
+{
+	struct epoll_event ev = XRT_STRUCT_INIT;
+	ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+	ev.data.ptr = entry;
+
+	int ret = epoll_ctl(pool->epoll_fd, EPOLL_CTL_MOD, entry->fd, &ev);
+	if (ret < 0) {
+		U_LOG_E("epoll_ctl(EPOLL_CTL_MOD) failed '%i'", errno);
+		return false;
+	}
+
+	return true;
+}
+
+static void *
+worker_thread(void *ptr)
+{
+	struct ipc_server_worker_pool *pool = (struct ipc_server_worker_pool *)ptr;
+
+	U_TRACE_SET_THREAD_NAME("IPC Worker");
+
+	while (true) {
+		struct epoll_event event = XRT_STRUCT_INIT;
+
+		int ret = epoll_wait(pool->epoll_fd, &event, 1, -1);
+		if (ret < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ret < 0) {
+			U_LOG_E("epoll_wait failed '%i', stopping worker.", errno);
+			break;
+		}
+		if (ret == 0) {
+			continue;
+		}
+
+		struct pool_entry *entry = (struct pool_entry *)event.data.ptr;
+
+		// The stop fd, level triggered so every thread gets it.
+		if (entry == NULL) {
+			break;
+		}
+
+		os_mutex_lock(&pool->lock);
+		pool->busy_count++;
+		os_mutex_unlock(&pool->lock);
+
+		/*
+		 * The entry is disarmed now (one shot), no other thread will get
+		 * it until we re-arm it, this is what keeps ordering per client.
+		 */
+		bool keep = (event.events & EPOLLIN) != 0 && pool->handle_func(entry->ptr);
+
+		os_mutex_lock(&pool->lock);
+		pool->busy_count--;
+		os_mutex_unlock(&pool->lock);
+
+		/*
+		 * Hang ups with data still pending are handled on the next
+		 * round, the receive will fail once the data has been read.
+		 */
+		if (!keep || !rearm_entry(pool, entry)) {
+			remove_entry(pool, entry);
+		}
+	}
+
+	return NULL;
+}
+
+static int
+start_thread_locked(struct ipc_server_worker_pool *pool)
+{
+	uint32_t i = pool->thread_count;
+
+	os_thread_init(&pool->threads[i]);
+	if (os_thread_start(&pool->threads[i], worker_thread, pool) != 0) {
+		U_LOG_E("Failed to start worker thread %u", i);
+		os_thread_destroy(&pool->threads[i]);
+		return -1;
+	}
+
+	char name[16];
+	(void)snprintf(name, sizeof(name), "IPC Worker %u", i);
+	os_thread_name(&pool->threads[i], name);
+
+	pool->thread_count++;
+
+	return 0;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+ipc_server_worker_pool_create(uint32_t thread_count,
+                              ipc_server_worker_pool_handle_func_t handle_func,
+                              ipc_server_worker_pool_remove_func_t remove_func,
+                              struct ipc_server_worker_pool **out_pool)
+{
+	if (thread_count == 0 || thread_count > IPC_SERVER_WORKER_POOL_MAX_THREADS) {
+		U_LOG_E("Invalid thread count %u (max %u)", thread_count, IPC_SERVER_WORKER_POOL_MAX_THREADS);
+		return -1;
+	}
+
+	struct ipc_server_worker_pool *pool = U_TYPED_CALLOC(struct ipc_server_worker_pool);
+	pool->handle_func = handle_func;
+	pool->remove_func = remove_func;
+	pool->stop_fd = -1;
+
+	if (os_mutex_init(&pool->lock) < 0) {
+		U_LOG_E("Failed to init mutex");
+		free(pool);
+		return -1;
+	}
+
+	pool->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (pool->epoll_fd < 0) {
+		U_LOG_E("epoll_create1 failed '%i'", errno);
+		os_mutex_destroy(&pool->lock);
+		free(pool);
+		return -1;
+	}
+
+	pool->stop_fd = eventfd(0, EFD_CLOEXEC);
+	if (pool->stop_fd < 0) {
+		U_LOG_E("eventfd failed '%i'", errno);
+		ipc_server_worker_pool_destroy(&pool);
+		return -1;
+	}
+
+	struct epoll_event ev = XRT_STRUCT_INIT;
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	if (epoll_ctl(pool->epoll_fd, EPOLL_CTL_ADD, pool->stop_fd, &ev) < 0) {
+		U_LOG_E("epoll_ctl(stop_fd) failed '%i'", errno);
+		ipc_server_worker_pool_destroy(&pool);
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < thread_count; i++) {
+		os_mutex_lock(&pool->lock);
+		int ret = start_thread_locked(pool);
+		os_mutex_unlock(&pool->lock);
+
+		if (ret < 0) {
+			ipc_server_worker_pool_destroy(&pool);
+			return -1;
+		}
+	}
+
+	*out_pool = pool;
+
+	return 0;
+}
+
+int
+ipc_server_worker_pool_add(struct ipc_server_worker_pool *pool, int fd, void *ptr)
+{
+	struct pool_entry *entry = U_TYPED_CALLOC(struct pool_entry);
+	entry->fd = fd;
+	entry->ptr = ptr;
+
+	// Linked before it is armed, a worker may remove it straight away.
+	os_mutex_lock(&pool->lock);
+	entry->next = pool->entries;
+	if (pool->entries != NULL) {
+		pool->entries->prev = entry;
+	}
+	pool->entries = entry;
+	os_mutex_unlock(&pool->lock);
+
+	struct epoll_event ev = XRT_STRUCT_INIT;
+	ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+	ev.data.ptr = entry;
+
+	int ret = epoll_ctl(pool->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+	if (ret < 0) {
+		U_LOG_E("epoll_ctl(EPOLL_CTL_ADD) failed '%i'", errno);
+
+		os_mutex_lock(&pool->lock);
+		unlink_entry_locked(pool, entry);
+		os_mutex_unlock(&pool->lock);
+
+		free(entry);
+		return ret;
+	}
+
+	return 0;
+}
+
+void
+ipc_server_worker_pool_will_block(struct ipc_server_worker_pool *pool)
+{
+	os_mutex_lock(&pool->lock);
+
+	// The caller counts as busy, make sure somebody is left for the others.
+	if (!pool->stopping && pool->busy_count >= pool->thread_count &&
+	    pool->thread_count < IPC_SERVER_WORKER_POOL_MAX_THREADS) {
+		if (start_thread_locked(pool) == 0) {
+			U_LOG_I("All workers busy, grew the pool to %u threads.", pool->thread_count);
+		}
+	}
+
+	os_mutex_unlock(&pool->lock);
+}
+
+uint32_t
+ipc_server_worker_pool_get_thread_count(struct ipc_server_worker_pool *pool)
+{
+	os_mutex_lock(&pool->lock);
+	uint32_t thread_count = pool->thread_count;
+	os_mutex_unlock(&pool->lock);
+
+	return thread_count;
+}
+
+void
+ipc_server_worker_pool_destroy(struct ipc_server_worker_pool **pool_ptr)
+{
+	struct ipc_server_worker_pool *pool = *pool_ptr;
+	if (pool == NULL) {
+		return;
+	}
+
+	// No threads are started after this, so thread_count is stable.
+	os_mutex_lock(&pool->lock);
+	pool->stopping = true;
+	os_mutex_unlock(&pool->lock);
+
+	if (pool->stop_fd >= 0) {
+		uint64_t one = 1;
+		if (write(pool->stop_fd, &one, sizeof(one)) < 0) {
+			U_LOG_E("Failed to signal worker threads '%i'", errno);
+		}
+	}
+
+	for (uint32_t i = 0; i < pool->thread_count; i++) {
+		os_thread_join(&pool->threads[i]);
+		os_thread_destroy(&pool->threads[i]);
+	}
+
+	// All threads are gone, remove whoever is still connected.
+	while (pool->entries != NULL) {
+		remove_entry(pool, pool->entries);
+	}
+
+	if (pool->stop_fd >= 0) {
+		close(pool->stop_fd);
+	}
+	if (pool->epoll_fd >= 0) {
+		close(pool->epoll_fd);
+	}
+
+	os_mutex_destroy(&pool->lock);
+
+	free(pool);
+	*pool_ptr = NULL;
+}
@@ -0,0 +1,105 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Pool of worker threads servicing client sockets from one epoll set.
+ * @ingroup ipc_server
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * Max number of threads in a @ref ipc_server_worker_pool.
+ *
+ * @ingroup ipc_server
+ */
+#define IPC_SERVER_WORKER_POOL_MAX_THREADS 16
+
+/*!
+ * Called on a worker thread when the fd is readable, should handle exactly
+ * one message. Return false to have the fd removed from the pool, in which
+ * case @ref ipc_server_worker_pool_remove_func_t is called afterwards.
+ *
+ * @ingroup ipc_server
+ */
+typedef bool (*ipc_server_worker_pool_handle_func_t)(void *ptr);
+
+/*!
+ * Called on a worker thread once the fd has been removed from the pool, on
+ * hang up or when the handle function returned false. The fd is not touched
+ * by the pool after this, so this is where it should be closed.
+ *
+ * @ingroup ipc_server
+ */
+typedef void (*ipc_server_worker_pool_remove_func_t)(void *ptr);
+
+/*!
+ * A small set of threads servicing many sockets, each fd is only ever handled
+ * by one thread at a time so messages from one client are handled in order. A
+ * handler that blocks holds up its thread, handlers that may block for long
+ * should call @ref ipc_server_worker_pool_will_block first so the other
+ * clients still get serviced.
+ *
+ * @ingroup ipc_server
+ */
+struct ipc_server_worker_pool;
+
+/*!
+ * Create the pool and start @p thread_count threads.
+ *
+ * @public @memberof ipc_server_worker_pool
+ */
+int
+ipc_server_worker_pool_create(uint32_t thread_count,
+                              ipc_server_worker_pool_handle_func_t handle_func,
+                              ipc_server_worker_pool_remove_func_t remove_func,
+                              struct ipc_server_worker_pool **out_pool);
+
+/*!
+ * Start servicing @p fd, @p ptr is passed to the callbacks.
+ *
+ * @public @memberof ipc_server_worker_pool
+ */
+int
+ipc_server_worker_pool_add(struct ipc_server_worker_pool *pool, int fd, void *ptr);
+
+/*!
+ * Called from a handler that is about to block, for example waiting on a
+ * swapchain image. Starts another thread if all of them are busy, up to
+ * @ref IPC_SERVER_WORKER_POOL_MAX_THREADS. Each client has at most one
+ * message being handled, so the pool grows to at most one thread per blocked
+ * client plus one.
+ *
+ * @public @memberof ipc_server_worker_pool
+ */
+void
+ipc_server_worker_pool_will_block(struct ipc_server_worker_pool *pool);
+
+/*!
+ * Number of threads currently in the pool.
+ *
+ * @public @memberof ipc_server_worker_pool
+ */
+uint32_t
+ipc_server_worker_pool_get_thread_count(struct ipc_server_worker_pool *pool);
+
+/*!
+ * Stop and join all threads, then remove the fds still in the pool. The
+ * remove function is called for each of them on the calling thread.
+ *
+ * @public @memberof ipc_server_worker_pool
+ */
+void
+ipc_server_worker_pool_destroy(struct ipc_server_worker_pool **pool_ptr);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,136 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Helpers for recording and reading IPC call stats.
+ * @ingroup ipc_shared
+ */
+
+#include "shared/ipc_call_stats.h"
+
+
+uint32_t
+ipc_call_stats_bucket_for(uint64_t duration_ns)
+{
+	uint64_t us = duration_ns / 1000;
+
+	uint32_t bucket = 0;
+	while (us > 0 && bucket < IPC_CALL_STATS_BUCKET_COUNT - 1) {
+		us >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+uint64_t
+ipc_call_stats_bucket_upper_ns(uint32_t bucket)
+{
+	if (bucket >= IPC_CALL_STATS_BUCKET_COUNT - 1) {
+		return UINT64_MAX;
+	}
+
+	// In nanoseconds, bucket zero ends at one microsecond.
+	return (1000ull << bucket);
+}
+
+void
+ipc_call_stat_record(struct ipc_call_stat *stat, uint64_t bytes, uint64_t duration_ns)
+{
+	stat->count++;
+	stat->bytes += bytes;
+	stat->total_ns += duration_ns;
+	if (duration_ns > stat->max_ns) {
+		stat->max_ns = duration_ns;
+	}
+	stat->buckets[ipc_call_stats_bucket_for(duration_ns)]++;
+}
+
+void
+ipc_call_stat_accumulate(struct ipc_call_stat *dst, const struct ipc_call_stat *src)
+{
+	dst->count += src->count;
+	dst->bytes += src->bytes;
+	dst->total_ns += src->total_ns;
+	if (src->max_ns > dst->max_ns) {
+		dst->max_ns = src->max_ns;
+	}
+	for (uint32_t i = 0; i < IPC_CALL_STATS_BUCKET_COUNT; i++) {
+		dst->buckets[i] += src->buckets[i];
+	}
+}
+
+uint64_t
+ipc_call_stat_percentile_ns(const struct ipc_call_stat *stat, double fraction)
+{
+	uint64_t total = 0;
+	for (uint32_t i = 0; i < IPC_CALL_STATS_BUCKET_COUNT; i++) {
+		total += stat->buckets[i];
+	}
+	if (total == 0) {
+		return 0;
+	}
+
+	// Rank of the sample we are after, at least the first one.
+	uint64_t rank = (uint64_t)(fraction * (double)total + 0.5);
+	if (rank == 0) {
+		rank = 1;
+	}
+
+	uint64_t seen = 0;
+	for (uint32_t i = 0; i < IPC_CALL_STATS_BUCKET_COUNT; i++) {
+		seen += stat->buckets[i];
+		if (seen >= rank) {
+			uint64_t upper = ipc_call_stats_bucket_upper_ns(i);
+			return upper < stat->max_ns ? upper : stat->max_ns;
+		}
+	}
+
+	return stat->max_ns;
+}
+
+void
+ipc_call_stats_get_page(const struct ipc_call_stats *stats,
+                        uint32_t first_command,
+                        struct ipc_call_stats_page *out_page)
+{
+	struct ipc_call_stats_page page = {0};
+
+	uint32_t command = first_command;
+	for (; command < IPC_CALL_STATS_MAX_COMMANDS; command++) {
+		if (stats->calls[command].count == 0) {
+			continue;
+		}
+		if (page.count >= IPC_CALL_STATS_PAGE_SIZE) {
+			break;
+		}
+
+		page.commands[page.count] = command;
+		page.calls[page.count] = stats->calls[command];
+		page.count++;
+	}
+
+	// Zero is never a valid command, so it doubles as done.
+	page.next_command = command < IPC_CALL_STATS_MAX_COMMANDS ? command : 0;
+
+	*out_page = page;
+}
+
+bool
+ipc_call_stats_put_page(struct ipc_call_stats *stats, const struct ipc_call_stats_page *page)
+{
+	if (page->count > IPC_CALL_STATS_PAGE_SIZE) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < page->count; i++) {
+		uint32_t command = page->commands[i];
+		if (command >= IPC_CALL_STATS_MAX_COMMANDS) {
+			return false;
+		}
+
+		stats->calls[command] = page->calls[i];
+	}
+
+	return true;
+}
@@ -0,0 +1,85 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Helpers for recording and reading IPC call stats.
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "shared/ipc_protocol.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * Bucket that a call taking @p duration_ns goes into, bucket zero is below one
+ * microsecond and every bucket after that doubles, the last one is open ended.
+ *
+ * @ingroup ipc_shared
+ */
+uint32_t
+ipc_call_stats_bucket_for(uint64_t duration_ns);
+
+/*!
+ * Upper bound of the given bucket, the last bucket has no bound and returns
+ * UINT64_MAX.
+ *
+ * @ingroup ipc_shared
+ */
+uint64_t
+ipc_call_stats_bucket_upper_ns(uint32_t bucket);
+
+/*!
+ * Record one call, not thread safe, each stat should only have one writer.
+ *
+ * @public @memberof ipc_call_stat
+ */
+void
+ipc_call_stat_record(struct ipc_call_stat *stat, uint64_t bytes, uint64_t duration_ns);
+
+/*!
+ * Add all of @p src into @p dst.
+ *
+ * @public @memberof ipc_call_stat
+ */
+void
+ipc_call_stat_accumulate(struct ipc_call_stat *dst, const struct ipc_call_stat *src);
+
+/*!
+ * Estimate the latency at the given fraction (0.5 for p50) from the
+ * histogram, this is the upper bound of the bucket it falls in, capped to the
+ * max seen latency.
+ *
+ * @public @memberof ipc_call_stat
+ */
+uint64_t
+ipc_call_stat_percentile_ns(const struct ipc_call_stat *stat, double fraction);
+
+/*!
+ * Fill in @p out_page with the stats of the commands that have been called,
+ * starting at @p first_command.
+ *
+ * @public @memberof ipc_call_stats
+ */
+void
+ipc_call_stats_get_page(const struct ipc_call_stats *stats,
+                        uint32_t first_command,
+                        struct ipc_call_stats_page *out_page);
+
+/*!
+ * Copy the stats in @p page into @p stats, returns false if the page is
+ * malformed.
+ *
+ * @public @memberof ipc_call_stats
+ */
+bool
+ipc_call_stats_put_page(struct ipc_call_stats *stats, const struct ipc_call_stats_page *page);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -33,11 +33,22 @@
 #define IPC_MAX_LAYERS 16
 #define IPC_MAX_SLOTS 128
 #define IPC_MAX_CLIENTS 8
+#define IPC_MAX_LOCATE_SPACES 8 // max spaces located in one call, keeps the reply within IPC_BUF_SIZE
 #define IPC_EVENT_QUEUE_SIZE 32
 
-#define IPC_SHARED_MAX_INPUTS 1024
-#define IPC_SHARED_MAX_OUTPUTS 128
-#define IPC_SHARED_MAX_BINDINGS 64
+#define IPC_SHARED_POSE_HISTORY_LEN 16
+
+/*!
+ * Bumped whenever the layout of @ref ipc_shared_memory or any of its sections
+ * changes, clients can't use the shared memory at all if this doesn't match.
+ */
+#define IPC_SHARED_MEMORY_LAYOUT_VERSION 3
+
+/*!
+ * All sections start on this alignment, as do the elements of sections that
+ * are written by different parties, to keep them on separate cache lines.
+ */
+#define IPC_SHARED_MEMORY_ALIGNMENT 64
 
 // example: v21.0.0-560-g586d33b5
 #define IPC_VERSION_NAME_LEN 64
@@ -132,6 +143,98 @@ struct ipc_shared_device
 	bool form_factor_check_supported;
 };
 
+/*!
+ * A single sampled pose in a @ref ipc_shared_pose_history.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_pose_history_entry
+{
+	uint64_t timestamp_ns;
+	struct xrt_space_relation relation;
+};
+
+/*!
+ * A ring of recently sampled poses of one pose input on one device, written
+ * by the server and read by the clients without any IPC call. Protected by a
+ * sequence lock, the server makes @ref seq odd while writing and even again
+ * once done, readers retry if the value changed under them.
+ *
+ * @see ipc_shared_pose_history_push
+ * @see ipc_shared_pose_history_get
+ * @ingroup ipc
+ */
+struct ipc_shared_pose_history
+{
+	//! Sequence lock counter, odd while the server is writing.
+	xrt_atomic_s32_t seq;
+
+	//! Id of the device, same as used in the device IPC calls.
+	uint32_t device_index;
+
+	//! Which pose input on the device this history is for.
+	enum xrt_input_name name;
+
+	//! Number of valid entries, up to @ref IPC_SHARED_POSE_HISTORY_LEN.
+	uint32_t entry_count;
+
+	//! Where the next entry will be written.
+	uint32_t next_index;
+
+	struct ipc_shared_pose_history_entry entries[IPC_SHARED_POSE_HISTORY_LEN];
+};
+
+/*!
+ * The values returned by a frame prediction, the same as the
+ * @ref ipc_call_compositor_predict_frame call returns.
+ *
+ * @ingroup ipc
+ */
+struct ipc_frame_prediction
+{
+	int64_t frame_id;
+	uint64_t wake_up_time_ns;
+	uint64_t predicted_display_time_ns;
+	uint64_t predicted_display_period_ns;
+};
+
+#define IPC_SHARED_FRAME_TIMING_EMPTY 0
+#define IPC_SHARED_FRAME_TIMING_REQUESTED 1
+#define IPC_SHARED_FRAME_TIMING_PUBLISHED 2
+
+/*!
+ * Per client frame timing slot, lets a client wait for its next frame without
+ * the predict_frame and wait_woke calls. When the client waits for a frame it
+ * moves @ref state to requested and rings
+ * @ref ipc_shared_memory::frame_timing_doorbell, the server then predicts the
+ * frame and publishes it here, waking the client blocked on the @ref state
+ * futex. Once it has woken up the client writes the wake up time back here for
+ * the server to pick up in begin_frame.
+ *
+ * The futexes are Linux only, other platforms poll the words instead.
+ *
+ * @see ipc_shared_frame_timing_request
+ * @see ipc_shared_frame_timing_publish
+ * @ingroup ipc
+ */
+struct ipc_shared_frame_timing
+{
+	//! Futex word, one of the IPC_SHARED_FRAME_TIMING_* values.
+	xrt_atomic_s32_t state;
+
+	//! Only written by the server while @ref state is requested.
+	struct ipc_frame_prediction prediction;
+
+	//! Sequence lock for the woke fields, odd while the client writes them.
+	xrt_atomic_s32_t woke_seq;
+
+	//! Frame the client last woke up for without telling the server.
+	int64_t woke_frame_id;
+
+	//! When the client woke up for @ref woke_frame_id.
+	uint64_t woke_time_ns;
+};
+
 /*!
  * Data for a single composition layer.
  *
@@ -158,63 +261,147 @@ struct ipc_layer_entry
 	struct xrt_layer_data data;
 };
 
+/*!
+ * The parts of a layer that normally change every frame, this is all that is
+ * written for a layer if nothing else about it changed since the last frame.
+ *
+ * @ingroup ipc
+ */
+struct ipc_layer_update
+{
+	//! See @ref xrt_layer_data::timestamp.
+	uint64_t timestamp;
+
+	//! Image index of each swapchain in @ref ipc_layer_entry::swapchain_ids.
+	uint32_t image_indices[4];
+
+	//! Left and right view for projection layers, other layers only use the first.
+	struct xrt_pose poses[2];
+
+	//! Only used by projection layers.
+	struct xrt_fov fovs[2];
+};
+
 /*!
  * Render state for a single client, including all layers.
  *
+ * Slots are handed out round robin over all clients, so the layers in a
+ * slot are deltas against what the client sent the frame before, not
+ * against what was in the slot.
+ *
  * @ingroup ipc
  */
 struct ipc_layer_slot
 {
 	struct xrt_layer_frame_data data;
 	uint32_t layer_count;
+
+	/*!
+	 * Bit i set means @p layers[i] was written in full, otherwise only
+	 * @p updates[i] was and the rest of the layer is the same as what was
+	 * at index i the frame before.
+	 */
+	uint32_t full_mask;
+
+	struct ipc_layer_update updates[IPC_MAX_LAYERS];
 	struct ipc_layer_entry layers[IPC_MAX_LAYERS];
 };
 
 /*!
- * A big struct that contains all data that is shared to a client, no pointers
- * allowed in this. To get the inputs of a device you go:
+ * The arrays that follow the @ref ipc_shared_memory header, the cold ones that
+ * are only read when setting up come first, then the hot ones.
+ *
+ * @ingroup ipc
+ */
+enum ipc_shared_section
+{
+	//! @ref ipc_shared_tracking_origin
+	IPC_SHARED_SECTION_ITRACKS,
+	//! @ref ipc_shared_device
+	IPC_SHARED_SECTION_ISDEVS,
+	//! @ref ipc_shared_binding_profile
+	IPC_SHARED_SECTION_BINDING_PROFILES,
+	//! @ref xrt_binding_input_pair
+	IPC_SHARED_SECTION_INPUT_PAIRS,
+	//! @ref xrt_binding_output_pair
+	IPC_SHARED_SECTION_OUTPUT_PAIRS,
+	//! @ref xrt_output
+	IPC_SHARED_SECTION_OUTPUTS,
+	//! @ref xrt_input
+	IPC_SHARED_SECTION_INPUTS,
+	//! xrt_atomic_s32_t, one per device, see @ref ipc_shared_inputs_update.
+	IPC_SHARED_SECTION_INPUT_GENERATIONS,
+	//! @ref ipc_shared_pose_history
+	IPC_SHARED_SECTION_POSE_HISTORIES,
+	//! @ref ipc_layer_slot
+	IPC_SHARED_SECTION_SLOTS,
+	//! @ref ipc_shared_frame_timing, one per client.
+	IPC_SHARED_SECTION_FRAME_TIMINGS,
+
+	IPC_SHARED_SECTION_COUNT,
+};
+
+/*!
+ * Where a section lives in the shared memory.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_toc_entry
+{
+	//! From the start of @ref ipc_shared_memory, aligned to @ref IPC_SHARED_MEMORY_ALIGNMENT.
+	uint64_t offset;
+
+	//! Distance between elements, at least the size of the element.
+	uint32_t stride;
+
+	//! Number of elements, all of them are valid.
+	uint32_t count;
+};
+
+/*!
+ * The header of the shared memory area, no pointers allowed in this. It is
+ * followed by the sections listed in @ref toc, sized to the actual system.
+ * To get the inputs of a device you go:
  *
  * ```C++
  * struct xrt_input *
  * helper(struct ipc_shared_memory *ism, uint32_t device_id, uint32_t input)
  * {
- * 	uint32_t index = ism->isdevs[device_id]->first_input_index + input;
- * 	return &ism->inputs[index];
+ * 	uint32_t index = ipc_shared_isdev(ism, device_id)->first_input_index + input;
+ * 	return ipc_shared_input(ism, index);
  * }
  * ```
  *
+ * @see ipc_shared_layout.h
  * @ingroup ipc
  */
 struct ipc_shared_memory
 {
 	/*!
-	 * The git revision of the service, used by clients to detect version mismatches.
+	 * Must be first and never move, @ref IPC_SHARED_MEMORY_LAYOUT_VERSION.
 	 */
-	char u_git_tag[IPC_VERSION_NAME_LEN];
+	uint32_t layout_version;
 
-	/*!
-	 * Number of elements in @ref itracks that are populated/valid.
-	 */
-	uint32_t itrack_count;
+	//! Size of the whole area, header and all sections.
+	uint64_t total_size;
+
+	//! Table of contents, indexed by @ref ipc_shared_section.
+	struct ipc_shared_toc_entry toc[IPC_SHARED_SECTION_COUNT];
 
 	/*!
-	 * @brief Array of shared tracking origin data.
-	 *
-	 * Only @ref itrack_count elements are populated/valid.
+	 * The git revision of the service, used by clients to detect version mismatches.
 	 */
-	struct ipc_shared_tracking_origin itracks[XRT_SYSTEM_MAX_DEVICES];
+	char u_git_tag[IPC_VERSION_NAME_LEN];
 
 	/*!
-	 * Number of elements in @ref isdevs that are populated/valid.
+	 * Number of tracking origins in @ref IPC_SHARED_SECTION_ITRACKS.
 	 */
-	uint32_t isdev_count;
+	uint32_t itrack_count;
 
 	/*!
-	 * @brief Array of shared data per device.
-	 *
-	 * Only @ref isdev_count elements are populated/valid.
+	 * Number of devices in @ref IPC_SHARED_SECTION_ISDEVS.
 	 */
-	struct ipc_shared_device isdevs[XRT_SYSTEM_MAX_DEVICES];
+	uint32_t isdev_count;
 
 	/*!
 	 * Various roles for the devices.
@@ -261,17 +448,58 @@ struct ipc_shared_memory
 		uint32_t blend_mode_count;
 	} hmd;
 
-	struct xrt_input inputs[IPC_SHARED_MAX_INPUTS];
-
-	struct xrt_output outputs[IPC_SHARED_MAX_OUTPUTS];
+	uint64_t startup_timestamp;
 
-	struct ipc_shared_binding_profile binding_profiles[IPC_SHARED_MAX_BINDINGS];
-	struct xrt_binding_input_pair input_pairs[IPC_SHARED_MAX_INPUTS];
-	struct xrt_binding_output_pair output_pairs[IPC_SHARED_MAX_OUTPUTS];
+	/*!
+	 * Pose histories published by the server, lets clients get tracked
+	 * poses without doing a IPC call. The histories themselves are in
+	 * @ref IPC_SHARED_SECTION_POSE_HISTORIES.
+	 */
+	struct
+	{
+		/*!
+		 * Non-zero when clients may use the histories, the server
+		 * clears this when publishing is off or when any client or
+		 * device has its IO disabled, as those need the server side
+		 * checks done in @ref ipc_handle_device_get_tracked_pose.
+		 * Cleared as soon as IO is disabled, but only set again at
+		 * the next publish.
+		 */
+		xrt_atomic_s32_t enabled;
+
+		/*!
+		 * How far past the newest entry a client may extrapolate
+		 * before it has to fall back to asking the server, which
+		 * lets the driver do the prediction. Kept short since the
+		 * extrapolation only follows the velocities of the newest
+		 * entry.
+		 */
+		uint64_t max_prediction_ns;
+
+		//! Number of histories published.
+		uint32_t history_count;
+	} poses;
 
-	struct ipc_layer_slot slots[IPC_MAX_SLOTS];
+	/*!
+	 * Change tracking of the inputs, lets clients skip the
+	 * device_update_input call. The per device generations are in
+	 * @ref IPC_SHARED_SECTION_INPUT_GENERATIONS.
+	 */
+	struct
+	{
+		/*!
+		 * Non-zero when the server keeps the inputs up to date on its
+		 * own, clients may then skip the call. Cleared under the same
+		 * conditions as @ref poses.
+		 */
+		xrt_atomic_s32_t published;
+	} input_state;
 
-	uint64_t startup_timestamp;
+	/*!
+	 * Futex word bumped by clients that have requested a frame in their
+	 * @ref ipc_shared_frame_timing slot, the server waits on it.
+	 */
+	xrt_atomic_s32_t frame_timing_doorbell;
 };
 
 /*!
@@ -289,6 +517,136 @@ struct ipc_client_list
 	uint32_t id_count;
 };
 
+/*!
+ * Max number of commands that call stats are kept for, indexed by command.
+ */
+#define IPC_CALL_STATS_MAX_COMMANDS 64
+
+/*!
+ * Number of latency buckets, see @ref ipc_call_stats_bucket_upper_ns.
+ */
+#define IPC_CALL_STATS_BUCKET_COUNT 16
+
+/*!
+ * Stats for one IPC command, latency is measured from the start of dispatch
+ * until the reply has been sent.
+ */
+struct ipc_call_stat
+{
+	uint64_t count;
+
+	//! Bytes of message and reply, not counting handles.
+	uint64_t bytes;
+
+	uint64_t total_ns;
+	uint64_t max_ns;
+
+	//! Power of two histogram of the latency.
+	uint32_t buckets[IPC_CALL_STATS_BUCKET_COUNT];
+};
+
+/*!
+ * Call stats for all commands, indexed by @ref ipc_command.
+ */
+struct ipc_call_stats
+{
+	struct ipc_call_stat calls[IPC_CALL_STATS_MAX_COMMANDS];
+};
+
+/*!
+ * Max number of command stats in one @ref ipc_call_stats_page, keeps the
+ * reply within @ref IPC_BUF_SIZE.
+ */
+#define IPC_CALL_STATS_PAGE_SIZE 4
+
+/*!
+ * Part of a @ref ipc_call_stats, only commands that have been called are
+ * included. Fetch pages starting at @ref next_command until it is zero.
+ */
+struct ipc_call_stats_page
+{
+	//! First command to ask for in the next page, zero when done.
+	uint32_t next_command;
+
+	uint32_t count;
+	uint32_t commands[IPC_CALL_STATS_PAGE_SIZE];
+	struct ipc_call_stat calls[IPC_CALL_STATS_PAGE_SIZE];
+};
+
+/*!
+ * Max number of compositor frame timing records returned by one
+ * @ref ipc_call_system_get_compositor_timings call, the reply must fit in
+ * @ref IPC_BUF_SIZE.
+ */
+#define IPC_MAX_COMPOSITOR_TIMINGS 5
+
+/*!
+ * Flags for @ref ipc_frame_timing_record.
+ */
+enum ipc_frame_timing_flags
+{
+	//! The actual present and display times come from the display.
+	IPC_FRAME_TIMING_PRESENT_INFO = (1u << 0u),
+	//! The frame was presented after the desired present time.
+	IPC_FRAME_TIMING_MISSED = (1u << 1u),
+};
+
+/*!
+ * Timing of one compositor frame, times that are not known are zero.
+ */
+struct ipc_frame_timing_record
+{
+	int64_t frame_id;
+
+	//! Bitmask of @ref ipc_frame_timing_flags.
+	uint32_t flags;
+	uint32_t _padding;
+
+	uint64_t desired_present_time_ns;
+	uint64_t predicted_display_time_ns;
+
+	uint64_t when_woke_ns;
+	uint64_t when_began_ns;
+	uint64_t when_submitted_ns;
+
+	uint64_t gpu_start_ns;
+	uint64_t gpu_end_ns;
+
+	uint64_t actual_present_time_ns;
+	uint64_t actual_display_time_ns;
+};
+
+/*!
+ * Settled compositor frame timing records, in frame id order.
+ */
+struct ipc_compositor_timings
+{
+	struct ipc_frame_timing_record records[IPC_MAX_COMPOSITOR_TIMINGS];
+	uint32_t record_count;
+
+	//! Frame id to ask for on the next call.
+	int64_t next_frame_id;
+};
+
+/*!
+ * Spaces to be located in one @ref ipc_call_space_locate_spaces call.
+ */
+struct ipc_space_locate_list
+{
+	uint32_t space_ids[IPC_MAX_LOCATE_SPACES];
+	struct xrt_pose offsets[IPC_MAX_LOCATE_SPACES];
+	uint32_t space_count;
+};
+
+/*!
+ * Result of a @ref ipc_call_space_locate_spaces call, in the same order as the
+ * spaces in the @ref ipc_space_locate_list.
+ */
+struct ipc_space_relation_list
+{
+	struct xrt_space_relation relations[IPC_MAX_LOCATE_SPACES];
+};
+
 /*!
  * State for a connected application.
  *
@@ -0,0 +1,243 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Helpers for the frame timing slots in the shared memory area.
+ * @ingroup ipc_shared
+ */
+
+#include "xrt/xrt_compiler.h"
+#include "xrt/xrt_config_os.h"
+
+#include "os/os_time.h"
+
+#include "util/u_misc.h"
+#include "util/u_time.h"
+
+#include "shared/ipc_shared_frame_timing.h"
+
+#ifdef XRT_OS_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#endif
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static inline int32_t
+load_s32(xrt_atomic_s32_t *word)
+{
+	// Full barrier, never changes the value.
+	return xrt_atomic_s32_cmpxchg(word, 0, 0);
+}
+
+#ifdef XRT_OS_LINUX
+/*
+ * Not private futexes, the words live in memory shared between processes.
+ */
+
+static void
+wake_all(xrt_atomic_s32_t *word)
+{
+	syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+static void
+wait_on(xrt_atomic_s32_t *word, int32_t expected, uint64_t timeout_ns)
+{
+	struct timespec ts = {
+	    .tv_sec = (time_t)(timeout_ns / U_TIME_1S_IN_NS),
+	    .tv_nsec = (long)(timeout_ns % U_TIME_1S_IN_NS),
+	};
+
+	// Returns straight away if the value isn't the expected one.
+	syscall(SYS_futex, word, FUTEX_WAIT, expected, &ts, NULL, 0);
+}
+#else
+/*
+ * No futex, fall back to polling the word, all callers loop until the value
+ * has changed or their deadline has passed.
+ */
+
+static void
+wake_all(xrt_atomic_s32_t *word)
+{
+	(void)word;
+}
+
+static void
+wait_on(xrt_atomic_s32_t *word, int32_t expected, uint64_t timeout_ns)
+{
+	if (load_s32(word) != expected) {
+		return;
+	}
+
+	os_nanosleep((int64_t)MIN(timeout_ns, U_TIME_1MS_IN_NS));
+}
+#endif
+
+static bool
+take_published(struct ipc_shared_frame_timing *isft, struct ipc_frame_prediction *out_prediction)
+{
+	int32_t old = xrt_atomic_s32_cmpxchg(  //
+	    &isft->state,                      //
+	    IPC_SHARED_FRAME_TIMING_PUBLISHED, //
+	    IPC_SHARED_FRAME_TIMING_EMPTY);    //
+	if (old != IPC_SHARED_FRAME_TIMING_PUBLISHED) {
+		return false;
+	}
+
+	// The server only writes while requested, which only we can set.
+	*out_prediction = isft->prediction;
+
+	return true;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+ipc_shared_frame_timing_init(struct ipc_shared_frame_timing *isft)
+{
+	U_ZERO(isft);
+	isft->state = IPC_SHARED_FRAME_TIMING_EMPTY;
+	isft->prediction.frame_id = -1;
+	isft->woke_frame_id = -1;
+}
+
+bool
+ipc_shared_frame_timing_request(struct ipc_shared_frame_timing *isft, xrt_atomic_s32_t *doorbell)
+{
+	int32_t old = xrt_atomic_s32_cmpxchg(   //
+	    &isft->state,                       //
+	    IPC_SHARED_FRAME_TIMING_EMPTY,      //
+	    IPC_SHARED_FRAME_TIMING_REQUESTED); //
+	if (old != IPC_SHARED_FRAME_TIMING_EMPTY) {
+		return false;
+	}
+
+	ipc_shared_frame_timing_ring_doorbell(doorbell);
+
+	return true;
+}
+
+bool
+ipc_shared_frame_timing_wait(struct ipc_shared_frame_timing *isft,
+                             uint64_t timeout_ns,
+                             struct ipc_frame_prediction *out_prediction)
+{
+	uint64_t deadline_ns = os_monotonic_get_ns() + timeout_ns;
+
+	while (load_s32(&isft->state) == IPC_SHARED_FRAME_TIMING_REQUESTED) {
+		uint64_t now_ns = os_monotonic_get_ns();
+		if (now_ns >= deadline_ns) {
+			break;
+		}
+
+		wait_on(&isft->state, IPC_SHARED_FRAME_TIMING_REQUESTED, deadline_ns - now_ns);
+	}
+
+	if (take_published(isft, out_prediction)) {
+		return true;
+	}
+
+	// Withdraw the request, the server may have published just now.
+	int32_t old = xrt_atomic_s32_cmpxchg(  //
+	    &isft->state,                      //
+	    IPC_SHARED_FRAME_TIMING_REQUESTED, //
+	    IPC_SHARED_FRAME_TIMING_EMPTY);    //
+	if (old == IPC_SHARED_FRAME_TIMING_PUBLISHED) {
+		return take_published(isft, out_prediction);
+	}
+
+	return false;
+}
+
+void
+ipc_shared_frame_timing_write_woke(struct ipc_shared_frame_timing *isft, int64_t frame_id, uint64_t woke_time_ns)
+{
+	// Odd while writing, full barriers on both sides.
+	xrt_atomic_s32_inc_return(&isft->woke_seq);
+
+	isft->woke_frame_id = frame_id;
+	isft->woke_time_ns = woke_time_ns;
+
+	xrt_atomic_s32_inc_return(&isft->woke_seq);
+}
+
+bool
+ipc_shared_frame_timing_is_requested(struct ipc_shared_frame_timing *isft)
+{
+	return load_s32(&isft->state) == IPC_SHARED_FRAME_TIMING_REQUESTED;
+}
+
+bool
+ipc_shared_frame_timing_publish(struct ipc_shared_frame_timing *isft, const struct ipc_frame_prediction *prediction)
+{
+	if (!ipc_shared_frame_timing_is_requested(isft)) {
+		return false;
+	}
+
+	// The client doesn't read this until it has been published.
+	isft->prediction = *prediction;
+
+	// Full barrier, makes the prediction visible before the state.
+	int32_t old = xrt_atomic_s32_cmpxchg(   //
+	    &isft->state,                       //
+	    IPC_SHARED_FRAME_TIMING_REQUESTED,  //
+	    IPC_SHARED_FRAME_TIMING_PUBLISHED); //
+	if (old != IPC_SHARED_FRAME_TIMING_REQUESTED) {
+		return false;
+	}
+
+	wake_all(&isft->state);
+
+	return true;
+}
+
+bool
+ipc_shared_frame_timing_read_woke(struct ipc_shared_frame_timing *isft,
+                                  int64_t *out_frame_id,
+                                  uint64_t *out_woke_time_ns)
+{
+	int32_t seq = load_s32(&isft->woke_seq);
+	if ((seq & 1) != 0) {
+		return false;
+	}
+
+	int64_t frame_id = isft->woke_frame_id;
+	uint64_t woke_time_ns = isft->woke_time_ns;
+
+	if (load_s32(&isft->woke_seq) != seq) {
+		return false;
+	}
+
+	*out_frame_id = frame_id;
+	*out_woke_time_ns = woke_time_ns;
+
+	return true;
+}
+
+void
+ipc_shared_frame_timing_wait_doorbell(xrt_atomic_s32_t *doorbell, int32_t seen, uint64_t timeout_ns)
+{
+	wait_on(doorbell, seen, timeout_ns);
+}
+
+void
+ipc_shared_frame_timing_ring_doorbell(xrt_atomic_s32_t *doorbell)
+{
+	xrt_atomic_s32_inc_return(doorbell);
+	wake_all(doorbell);
+}
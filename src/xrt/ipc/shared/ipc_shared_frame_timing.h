@@ -0,0 +1,123 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Helpers for the frame timing slots in the shared memory area.
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "shared/ipc_protocol.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * Reset the slot, only to be called by the server before handing the slot out
+ * to a client.
+ *
+ * @public @memberof ipc_shared_frame_timing
+ */
+void
+ipc_shared_frame_timing_init(struct ipc_shared_frame_timing *isft);
+
+
+/*
+ *
+ * Client side.
+ *
+ */
+
+/*!
+ * Ask the server for a new frame and ring the doorbell.
+ *
+ * @return false if there already is a request outstanding, the caller should
+ *         then fall back to the predict_frame call.
+ *
+ * @public @memberof ipc_shared_frame_timing
+ */
+bool
+ipc_shared_frame_timing_request(struct ipc_shared_frame_timing *isft, xrt_atomic_s32_t *doorbell);
+
+/*!
+ * Wait for the server to answer the request made with
+ * @ref ipc_shared_frame_timing_request, for at most @p timeout_ns. On timeout
+ * the request is withdrawn, unless the server published the frame just then.
+ * Uses a futex on Linux, on other platforms polls the slot every millisecond.
+ *
+ * @return true if a prediction was taken, false if the request was withdrawn.
+ *
+ * @public @memberof ipc_shared_frame_timing
+ */
+bool
+ipc_shared_frame_timing_wait(struct ipc_shared_frame_timing *isft,
+                             uint64_t timeout_ns,
+                             struct ipc_frame_prediction *out_prediction);
+
+/*!
+ * Record when the client woke up for a frame, uses the sequence lock so the
+ * server never sees a half written pair.
+ *
+ * @public @memberof ipc_shared_frame_timing
+ */
+void
+ipc_shared_frame_timing_write_woke(struct ipc_shared_frame_timing *isft, int64_t frame_id, uint64_t woke_time_ns);
+
+
+/*
+ *
+ * Server side.
+ *
+ */
+
+/*!
+ * Is the client waiting for a frame to be published.
+ *
+ * @public @memberof ipc_shared_frame_timing
+ */
+bool
+ipc_shared_frame_timing_is_requested(struct ipc_shared_frame_timing *isft);
+
+/*!
+ * Publish a prediction for an outstanding request and wake up the client.
+ *
+ * @return false if the client has withdrawn the request, the caller is then
+ *         responsible for retiring the frame.
+ *
+ * @public @memberof ipc_shared_frame_timing
+ */
+bool
+ipc_shared_frame_timing_publish(struct ipc_shared_frame_timing *isft, const struct ipc_frame_prediction *prediction);
+
+/*!
+ * Read the woke mark written by @ref ipc_shared_frame_timing_write_woke.
+ *
+ * @return false if the client kept writing while we tried to read.
+ *
+ * @public @memberof ipc_shared_frame_timing
+ */
+bool
+ipc_shared_frame_timing_read_woke(struct ipc_shared_frame_timing *isft,
+                                  int64_t *out_frame_id,
+                                  uint64_t *out_woke_time_ns);
+
+/*!
+ * Block until the doorbell has changed from @p seen or @p timeout_ns has
+ * passed, spurious wake ups are possible.
+ */
+void
+ipc_shared_frame_timing_wait_doorbell(xrt_atomic_s32_t *doorbell, int32_t seen, uint64_t timeout_ns);
+
+/*!
+ * Wake up anybody waiting on the doorbell.
+ */
+void
+ipc_shared_frame_timing_ring_doorbell(xrt_atomic_s32_t *doorbell);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,99 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Helpers for the device inputs in the shared memory area.
+ * @ingroup ipc_shared
+ */
+
+#include "util/u_misc.h"
+
+#include "shared/ipc_shared_input.h"
+
+#include <string.h>
+
+
+bool
+ipc_shared_inputs_update(xrt_atomic_s32_t *generation,
+                         struct xrt_input *dst,
+                         const struct xrt_input *src,
+                         uint32_t count,
+                         bool io_active)
+{
+	bool changed = false;
+
+	for (uint32_t i = 0; i < count; i++) {
+		struct xrt_input input;
+
+		// Byte copies, so padding compares the same every time.
+		if (io_active) {
+			memcpy(&input, &src[i], sizeof(input));
+		} else {
+			U_ZERO(&input);
+			input.name = src[i].name;
+
+			// Special case the rotation of the head.
+			if (input.name == XRT_INPUT_GENERIC_HEAD_POSE) {
+				input.active = src[i].active;
+			}
+		}
+
+		if (memcmp(&dst[i], &input, sizeof(input)) == 0) {
+			continue;
+		}
+
+		if (!changed) {
+			// Odd while writing, full barrier before the first write.
+			xrt_atomic_s32_inc_return(generation);
+			changed = true;
+		}
+
+		memcpy(&dst[i], &input, sizeof(input));
+	}
+
+	if (changed) {
+		// Full barrier, the inputs are visible before the even generation.
+		xrt_atomic_s32_inc_return(generation);
+	}
+
+	return changed;
+}
+
+bool
+ipc_shared_inputs_read(xrt_atomic_s32_t *generation,
+                       int32_t *inout_generation,
+                       struct xrt_input *dst,
+                       const struct xrt_input *src,
+                       uint32_t count)
+{
+	for (uint32_t tries = 0; tries < IPC_SHARED_INPUTS_READ_TRIES; tries++) {
+		int32_t gen = ipc_shared_inputs_get_generation(generation);
+
+		// The server is writing, try again.
+		if ((gen & 1) != 0) {
+			continue;
+		}
+
+		// Nothing has changed since the last copy.
+		if (gen == *inout_generation) {
+			return true;
+		}
+
+		memcpy(dst, src, sizeof(*dst) * count);
+
+		// Full barrier, the copy is done before checking again.
+		if (ipc_shared_inputs_get_generation(generation) == gen) {
+			*inout_generation = gen;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int32_t
+ipc_shared_inputs_get_generation(xrt_atomic_s32_t *generation)
+{
+	// Full barrier, never changes the value.
+	return xrt_atomic_s32_cmpxchg(generation, 0, 0);
+}
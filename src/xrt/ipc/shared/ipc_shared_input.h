@@ -0,0 +1,74 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Helpers for the device inputs in the shared memory area.
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "xrt/xrt_defines.h"
+#include "xrt/xrt_device.h"
+
+#include "shared/ipc_protocol.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * Number of times @ref ipc_shared_inputs_read tries to get a consistent copy
+ * before giving up.
+ *
+ * @ingroup ipc_shared
+ */
+#define IPC_SHARED_INPUTS_READ_TRIES 16
+
+/*!
+ * Mirror the inputs of a device into the shared memory, only inputs that
+ * differ are written. The @p generation works as a seqlock, it is odd while
+ * inputs are being written and is left at a new even value if any changed.
+ * With @p io_active false everything but the name is cleared, except for the
+ * active state of the head pose. There must only be one writer at a time for
+ * each @p generation, the caller has to serialize them.
+ *
+ * @return true if any input changed.
+ *
+ * @ingroup ipc_shared
+ */
+bool
+ipc_shared_inputs_update(xrt_atomic_s32_t *generation,
+                         struct xrt_input *dst,
+                         const struct xrt_input *src,
+                         uint32_t count,
+                         bool io_active);
+
+/*!
+ * Read the current generation of a device's inputs.
+ *
+ * @ingroup ipc_shared
+ */
+int32_t
+ipc_shared_inputs_get_generation(xrt_atomic_s32_t *generation);
+
+/*!
+ * Copy the inputs of a device out of the shared memory, skips the copy if
+ * @p generation is still the @p inout_generation of the last copy. Retries if
+ * the server writes while copying, returns false if it never got a consistent
+ * copy. Start @p inout_generation at -1 to always copy the first time.
+ *
+ * @ingroup ipc_shared
+ */
+bool
+ipc_shared_inputs_read(xrt_atomic_s32_t *generation,
+                       int32_t *inout_generation,
+                       struct xrt_input *dst,
+                       const struct xrt_input *src,
+                       uint32_t count);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,140 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Helpers for the delta encoded layers in the layer slots.
+ * @ingroup ipc_shared
+ */
+
+#include "shared/ipc_shared_layer.h"
+
+#include <string.h>
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+//! All of the single swapchain layers have the same per frame fields.
+static struct xrt_sub_image *
+single_sub(struct xrt_layer_data *data, struct xrt_pose **out_pose)
+{
+	switch (data->type) {
+	case XRT_LAYER_QUAD:
+		*out_pose = &data->quad.pose;
+		return &data->quad.sub;
+	case XRT_LAYER_CUBE:
+		*out_pose = &data->cube.pose;
+		return &data->cube.sub;
+	case XRT_LAYER_CYLINDER:
+		*out_pose = &data->cylinder.pose;
+		return &data->cylinder.sub;
+	case XRT_LAYER_EQUIRECT1:
+		*out_pose = &data->equirect1.pose;
+		return &data->equirect1.sub;
+	case XRT_LAYER_EQUIRECT2:
+		*out_pose = &data->equirect2.pose;
+		return &data->equirect2.sub;
+	default:
+		*out_pose = NULL;
+		return NULL;
+	}
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+ipc_shared_layer_get_update(const struct ipc_layer_entry *entry, struct ipc_layer_update *out_update)
+{
+	// Only reads, the cast is just to share the switch.
+	struct xrt_layer_data *data = (struct xrt_layer_data *)&entry->data;
+	struct ipc_layer_update u = {0};
+
+	u.timestamp = data->timestamp;
+
+	switch (data->type) {
+	case XRT_LAYER_STEREO_PROJECTION:
+	case XRT_LAYER_STEREO_PROJECTION_DEPTH:
+		// The depth layer starts with the same views.
+		u.image_indices[0] = data->stereo.l.sub.image_index;
+		u.image_indices[1] = data->stereo.r.sub.image_index;
+		u.poses[0] = data->stereo.l.pose;
+		u.poses[1] = data->stereo.r.pose;
+		u.fovs[0] = data->stereo.l.fov;
+		u.fovs[1] = data->stereo.r.fov;
+
+		if (data->type == XRT_LAYER_STEREO_PROJECTION_DEPTH) {
+			u.image_indices[2] = data->stereo_depth.l_d.sub.image_index;
+			u.image_indices[3] = data->stereo_depth.r_d.sub.image_index;
+		}
+		break;
+	default: {
+		struct xrt_pose *pose = NULL;
+		struct xrt_sub_image *sub = single_sub(data, &pose);
+		if (sub != NULL) {
+			u.image_indices[0] = sub->image_index;
+			u.poses[0] = *pose;
+		}
+	} break;
+	}
+
+	*out_update = u;
+}
+
+void
+ipc_shared_layer_apply_update(struct ipc_layer_entry *entry, const struct ipc_layer_update *update)
+{
+	struct xrt_layer_data *data = &entry->data;
+
+	data->timestamp = update->timestamp;
+
+	switch (data->type) {
+	case XRT_LAYER_STEREO_PROJECTION:
+	case XRT_LAYER_STEREO_PROJECTION_DEPTH:
+		// The depth layer starts with the same views.
+		data->stereo.l.sub.image_index = update->image_indices[0];
+		data->stereo.r.sub.image_index = update->image_indices[1];
+		data->stereo.l.pose = update->poses[0];
+		data->stereo.r.pose = update->poses[1];
+		data->stereo.l.fov = update->fovs[0];
+		data->stereo.r.fov = update->fovs[1];
+
+		if (data->type == XRT_LAYER_STEREO_PROJECTION_DEPTH) {
+			data->stereo_depth.l_d.sub.image_index = update->image_indices[2];
+			data->stereo_depth.r_d.sub.image_index = update->image_indices[3];
+		}
+		break;
+	default: {
+		struct xrt_pose *pose = NULL;
+		struct xrt_sub_image *sub = single_sub(data, &pose);
+		if (sub != NULL) {
+			sub->image_index = update->image_indices[0];
+			*pose = update->poses[0];
+		}
+	} break;
+	}
+}
+
+bool
+ipc_shared_layer_try_update(struct ipc_layer_entry *sent,
+                            const struct ipc_layer_entry *entry,
+                            const struct ipc_layer_update *update)
+{
+	ipc_shared_layer_apply_update(sent, update);
+
+	// Byte compare, padding that differs only costs a full write.
+	if (memcmp(sent, entry, sizeof(*sent)) == 0) {
+		return true;
+	}
+
+	memcpy(sent, entry, sizeof(*sent));
+
+	return false;
+}
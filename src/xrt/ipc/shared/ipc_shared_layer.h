@@ -0,0 +1,54 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Helpers for the delta encoded layers in the layer slots.
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#include "shared/ipc_protocol.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * Pull the per frame parts out of @p entry, which fields are used depends on
+ * the layer type.
+ *
+ * @ingroup ipc_shared
+ */
+void
+ipc_shared_layer_get_update(const struct ipc_layer_entry *entry, struct ipc_layer_update *out_update);
+
+/*!
+ * Write the per frame parts in @p update into @p entry, the layer type of
+ * @p entry decides which fields are used.
+ *
+ * @ingroup ipc_shared
+ */
+void
+ipc_shared_layer_apply_update(struct ipc_layer_entry *entry, const struct ipc_layer_update *update);
+
+/*!
+ * Try to bring @p sent up to date with @p entry using only @p update, which
+ * was taken from @p entry. If that is not enough @p sent is set to @p entry
+ * and the whole entry needs to be sent.
+ *
+ * @return true if @p update is all that needs to be sent.
+ *
+ * @ingroup ipc_shared
+ */
+bool
+ipc_shared_layer_try_update(struct ipc_layer_entry *sent,
+                            const struct ipc_layer_entry *entry,
+                            const struct ipc_layer_update *update);
+
+#ifdef __cplusplus
+}
+#endif
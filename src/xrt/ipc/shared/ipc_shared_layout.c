@@ -0,0 +1,119 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Layout of the sections of the shared memory area.
+ * @ingroup ipc_shared
+ */
+
+#include "util/u_logging.h"
+
+#include "shared/ipc_shared_layout.h"
+
+#include <inttypes.h>
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+struct section_info
+{
+	uint32_t element_size;
+
+	/*!
+	 * Elements are written by different parties, server and different
+	 * clients, so give each its own cache lines.
+	 */
+	bool pad_elements;
+};
+
+static const struct section_info section_infos[IPC_SHARED_SECTION_COUNT] = {
+    [IPC_SHARED_SECTION_ITRACKS] = {sizeof(struct ipc_shared_tracking_origin), false},
+    [IPC_SHARED_SECTION_ISDEVS] = {sizeof(struct ipc_shared_device), false},
+    [IPC_SHARED_SECTION_BINDING_PROFILES] = {sizeof(struct ipc_shared_binding_profile), false},
+    [IPC_SHARED_SECTION_INPUT_PAIRS] = {sizeof(struct xrt_binding_input_pair), false},
+    [IPC_SHARED_SECTION_OUTPUT_PAIRS] = {sizeof(struct xrt_binding_output_pair), false},
+    [IPC_SHARED_SECTION_OUTPUTS] = {sizeof(struct xrt_output), false},
+    [IPC_SHARED_SECTION_INPUTS] = {sizeof(struct xrt_input), false},
+    [IPC_SHARED_SECTION_INPUT_GENERATIONS] = {sizeof(xrt_atomic_s32_t), false},
+    [IPC_SHARED_SECTION_POSE_HISTORIES] = {sizeof(struct ipc_shared_pose_history), true},
+    [IPC_SHARED_SECTION_SLOTS] = {sizeof(struct ipc_layer_slot), true},
+    [IPC_SHARED_SECTION_FRAME_TIMINGS] = {sizeof(struct ipc_shared_frame_timing), true},
+};
+
+static inline uint64_t
+align_up(uint64_t value)
+{
+	return (value + IPC_SHARED_MEMORY_ALIGNMENT - 1) & ~(uint64_t)(IPC_SHARED_MEMORY_ALIGNMENT - 1);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+size_t
+ipc_shared_layout_compute(const uint32_t counts[IPC_SHARED_SECTION_COUNT],
+                          struct ipc_shared_toc_entry out_toc[IPC_SHARED_SECTION_COUNT])
+{
+	uint64_t offset = align_up(sizeof(struct ipc_shared_memory));
+
+	// The enum is ordered cold to hot, so just go through it in order.
+	for (uint32_t i = 0; i < IPC_SHARED_SECTION_COUNT; i++) {
+		const struct section_info *info = &section_infos[i];
+		uint32_t stride = info->pad_elements ? (uint32_t)align_up(info->element_size) : info->element_size;
+
+		out_toc[i].offset = offset;
+		out_toc[i].stride = stride;
+		out_toc[i].count = counts[i];
+
+		offset = align_up(offset + (uint64_t)stride * counts[i]);
+	}
+
+	return (size_t)offset;
+}
+
+bool
+ipc_shared_layout_validate(const struct ipc_shared_memory *ism, size_t mapped_size)
+{
+	if (mapped_size < sizeof(struct ipc_shared_memory)) {
+		U_LOG_E("Shared memory too small for the header: %zu", mapped_size);
+		return false;
+	}
+
+	if (ism->layout_version != IPC_SHARED_MEMORY_LAYOUT_VERSION) {
+		U_LOG_E("Shared memory layout version %u, expected %u", ism->layout_version,
+		        IPC_SHARED_MEMORY_LAYOUT_VERSION);
+		return false;
+	}
+
+	if (ism->total_size > mapped_size) {
+		U_LOG_E("Shared memory is %" PRIu64 " bytes, only %zu mapped", ism->total_size, mapped_size);
+		return false;
+	}
+
+	for (uint32_t i = 0; i < IPC_SHARED_SECTION_COUNT; i++) {
+		const struct ipc_shared_toc_entry *entry = &ism->toc[i];
+		const struct section_info *info = &section_infos[i];
+
+		// Sections that are used as arrays need to be contiguous.
+		bool bad_stride = info->pad_elements ? entry->stride < info->element_size //
+		                                     : entry->stride != info->element_size;
+		bool bad_offset = entry->offset < sizeof(struct ipc_shared_memory) || //
+		                  entry->offset % IPC_SHARED_MEMORY_ALIGNMENT != 0;
+		bool bad_size = entry->offset + (uint64_t)entry->stride * entry->count > ism->total_size;
+
+		if (bad_stride || bad_offset || bad_size) {
+			U_LOG_E("Shared memory section %u is invalid: offset %" PRIu64 ", stride %u, count %u", i,
+			        entry->offset, entry->stride, entry->count);
+			return false;
+		}
+	}
+
+	return true;
+}
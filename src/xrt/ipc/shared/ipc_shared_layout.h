@@ -0,0 +1,146 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Layout of, and accessors for, the sections of the shared memory area.
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "shared/ipc_protocol.h"
+
+#include <assert.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * Lay out the sections after the header, @p counts gives the number of
+ * elements of each section, indexed by @ref ipc_shared_section.
+ *
+ * @return The total size of the shared memory area.
+ *
+ * @ingroup ipc_shared
+ */
+size_t
+ipc_shared_layout_compute(const uint32_t counts[IPC_SHARED_SECTION_COUNT],
+                          struct ipc_shared_toc_entry out_toc[IPC_SHARED_SECTION_COUNT]);
+
+/*!
+ * Check that the header of a mapped shared memory area is of the layout
+ * version we know and that all sections fit within @p mapped_size.
+ *
+ * @ingroup ipc_shared
+ */
+bool
+ipc_shared_layout_validate(const struct ipc_shared_memory *ism, size_t mapped_size);
+
+/*!
+ * Get element @p index of a section.
+ *
+ * @ingroup ipc_shared
+ */
+static inline void *
+ipc_shared_section_element(struct ipc_shared_memory *ism, enum ipc_shared_section section, uint32_t index)
+{
+	const struct ipc_shared_toc_entry *entry = &ism->toc[section];
+	assert(index < entry->count);
+
+	return (uint8_t *)ism + entry->offset + (size_t)entry->stride * index;
+}
+
+/*!
+ * Number of elements in a section.
+ *
+ * @ingroup ipc_shared
+ */
+static inline uint32_t
+ipc_shared_section_count(const struct ipc_shared_memory *ism, enum ipc_shared_section section)
+{
+	return ism->toc[section].count;
+}
+
+static inline struct ipc_shared_tracking_origin *
+ipc_shared_itrack(struct ipc_shared_memory *ism, uint32_t index)
+{
+	return (struct ipc_shared_tracking_origin *)ipc_shared_section_element(ism, IPC_SHARED_SECTION_ITRACKS,
+	                                                                        index);
+}
+
+static inline struct ipc_shared_device *
+ipc_shared_isdev(struct ipc_shared_memory *ism, uint32_t index)
+{
+	return (struct ipc_shared_device *)ipc_shared_section_element(ism, IPC_SHARED_SECTION_ISDEVS, index);
+}
+
+static inline struct ipc_shared_binding_profile *
+ipc_shared_binding_profile(struct ipc_shared_memory *ism, uint32_t index)
+{
+	return (struct ipc_shared_binding_profile *)ipc_shared_section_element(
+	    ism, IPC_SHARED_SECTION_BINDING_PROFILES, index);
+}
+
+//! Elements are contiguous, may be used as an array.
+static inline struct xrt_binding_input_pair *
+ipc_shared_input_pair(struct ipc_shared_memory *ism, uint32_t index)
+{
+	return (struct xrt_binding_input_pair *)ipc_shared_section_element(ism, IPC_SHARED_SECTION_INPUT_PAIRS,
+	                                                                    index);
+}
+
+//! Elements are contiguous, may be used as an array.
+static inline struct xrt_binding_output_pair *
+ipc_shared_output_pair(struct ipc_shared_memory *ism, uint32_t index)
+{
+	return (struct xrt_binding_output_pair *)ipc_shared_section_element(ism, IPC_SHARED_SECTION_OUTPUT_PAIRS,
+	                                                                     index);
+}
+
+//! Elements are contiguous, may be used as an array.
+static inline struct xrt_output *
+ipc_shared_output(struct ipc_shared_memory *ism, uint32_t index)
+{
+	return (struct xrt_output *)ipc_shared_section_element(ism, IPC_SHARED_SECTION_OUTPUTS, index);
+}
+
+//! Elements are contiguous, may be used as an array.
+static inline struct xrt_input *
+ipc_shared_input(struct ipc_shared_memory *ism, uint32_t index)
+{
+	return (struct xrt_input *)ipc_shared_section_element(ism, IPC_SHARED_SECTION_INPUTS, index);
+}
+
+static inline xrt_atomic_s32_t *
+ipc_shared_input_generation(struct ipc_shared_memory *ism, uint32_t device_index)
+{
+	return (xrt_atomic_s32_t *)ipc_shared_section_element(ism, IPC_SHARED_SECTION_INPUT_GENERATIONS,
+	                                                       device_index);
+}
+
+static inline struct ipc_shared_pose_history *
+ipc_shared_pose_history(struct ipc_shared_memory *ism, uint32_t index)
+{
+	return (struct ipc_shared_pose_history *)ipc_shared_section_element(ism, IPC_SHARED_SECTION_POSE_HISTORIES,
+	                                                                     index);
+}
+
+static inline struct ipc_layer_slot *
+ipc_shared_slot(struct ipc_shared_memory *ism, uint32_t index)
+{
+	return (struct ipc_layer_slot *)ipc_shared_section_element(ism, IPC_SHARED_SECTION_SLOTS, index);
+}
+
+static inline struct ipc_shared_frame_timing *
+ipc_shared_frame_timing(struct ipc_shared_memory *ism, uint32_t index)
+{
+	return (struct ipc_shared_frame_timing *)ipc_shared_section_element(ism, IPC_SHARED_SECTION_FRAME_TIMINGS,
+	                                                                     index);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,186 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Helpers for the pose histories in the shared memory area.
+ * @ingroup ipc_shared
+ */
+
+#include "xrt/xrt_compiler.h"
+
+#include "math/m_space.h"
+#include "math/m_predict.h"
+
+#include "util/u_misc.h"
+#include "util/u_time.h"
+
+#include "shared/ipc_shared_pose.h"
+
+#include <string.h>
+
+
+/*
+ *
+ * Defines and helpers.
+ *
+ */
+
+/*!
+ * How many times a reader tries to get a consistent copy before giving up,
+ * the server only holds the lock for a single entry copy so this is plenty.
+ */
+#define MAX_READ_TRIES 8
+
+static inline int32_t
+seq_load_acquire(const xrt_atomic_s32_t *p)
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#else
+	// Full barrier, never changes the value.
+	return xrt_atomic_s32_cmpxchg((xrt_atomic_s32_t *)p, 0, 0);
+#endif
+}
+
+static inline void
+fence_acquire(void)
+{
+#if defined(__GNUC__)
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+	MemoryBarrier();
+#else
+#error "compiler not supported"
+#endif
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+ipc_shared_pose_history_init(struct ipc_shared_pose_history *isph, uint32_t device_index, enum xrt_input_name name)
+{
+	U_ZERO(isph);
+	isph->device_index = device_index;
+	isph->name = name;
+}
+
+bool
+ipc_shared_pose_history_push(struct ipc_shared_pose_history *isph,
+                             const struct xrt_space_relation *relation,
+                             uint64_t timestamp_ns)
+{
+	if (isph->entry_count > 0) {
+		uint32_t last = (isph->next_index + IPC_SHARED_POSE_HISTORY_LEN - 1) % IPC_SHARED_POSE_HISTORY_LEN;
+
+		// Everything explodes if the timestamps aren't monotonically increasing.
+		if (timestamp_ns <= isph->entries[last].timestamp_ns) {
+			return false;
+		}
+	}
+
+	// Both increments are full barriers, odd while writing.
+	xrt_atomic_s32_inc_return(&isph->seq);
+
+	struct ipc_shared_pose_history_entry *entry = &isph->entries[isph->next_index];
+	entry->timestamp_ns = timestamp_ns;
+	entry->relation = *relation;
+
+	isph->next_index = (isph->next_index + 1) % IPC_SHARED_POSE_HISTORY_LEN;
+	if (isph->entry_count < IPC_SHARED_POSE_HISTORY_LEN) {
+		isph->entry_count++;
+	}
+
+	xrt_atomic_s32_inc_return(&isph->seq);
+
+	return true;
+}
+
+bool
+ipc_shared_pose_history_get(const struct ipc_shared_pose_history *isph,
+                            uint64_t at_timestamp_ns,
+                            uint64_t max_prediction_ns,
+                            struct xrt_space_relation *out_relation)
+{
+	struct ipc_shared_pose_history_entry entries[IPC_SHARED_POSE_HISTORY_LEN];
+	uint32_t entry_count = 0;
+	uint32_t next_index = 0;
+	bool consistent = false;
+
+	for (uint32_t tries = 0; tries < MAX_READ_TRIES && !consistent; tries++) {
+		int32_t before = seq_load_acquire(&isph->seq);
+		if ((before & 1) != 0) {
+			continue; // Server is writing.
+		}
+
+		entry_count = isph->entry_count;
+		next_index = isph->next_index;
+		memcpy(entries, isph->entries, sizeof(entries));
+
+		fence_acquire();
+
+		consistent = before == seq_load_acquire(&isph->seq);
+	}
+
+	if (!consistent || at_timestamp_ns == 0 || entry_count == 0) {
+		return false;
+	}
+
+	// Don't trust the other process blindly.
+	if (entry_count > IPC_SHARED_POSE_HISTORY_LEN || next_index >= IPC_SHARED_POSE_HISTORY_LEN) {
+		return false;
+	}
+
+	uint32_t oldest = (next_index + IPC_SHARED_POSE_HISTORY_LEN - entry_count) % IPC_SHARED_POSE_HISTORY_LEN;
+#define ENTRY(i) (&entries[(oldest + (i)) % IPC_SHARED_POSE_HISTORY_LEN])
+
+	struct ipc_shared_pose_history_entry *newest = ENTRY(entry_count - 1);
+	if (at_timestamp_ns > newest->timestamp_ns) {
+		uint64_t diff_prediction_ns = at_timestamp_ns - newest->timestamp_ns;
+		if (diff_prediction_ns > max_prediction_ns) {
+			return false;
+		}
+
+		m_predict_relation(&newest->relation, time_ns_to_s((time_duration_ns)diff_prediction_ns), out_relation);
+		return true;
+	}
+
+	// Too old, let the server deal with it.
+	if (at_timestamp_ns < ENTRY(0)->timestamp_ns) {
+		return false;
+	}
+
+	// Find the first entry not older than the timestamp, the ring is small.
+	uint32_t i = 0;
+	while (ENTRY(i)->timestamp_ns < at_timestamp_ns) {
+		i++;
+	}
+
+	struct ipc_shared_pose_history_entry *successor = ENTRY(i);
+	if (successor->timestamp_ns == at_timestamp_ns) {
+		*out_relation = successor->relation;
+		return true;
+	}
+
+	// Not an exact match so i > 0, as the oldest entry is not newer.
+	struct ipc_shared_pose_history_entry *predecessor = ENTRY(i - 1);
+
+#undef ENTRY
+
+	uint64_t diff_before = at_timestamp_ns - predecessor->timestamp_ns;
+	uint64_t diff_after = successor->timestamp_ns - at_timestamp_ns;
+	float amount_to_lerp = (float)diff_before / (float)(diff_before + diff_after);
+
+	enum xrt_space_relation_flags flags = (enum xrt_space_relation_flags)(
+	    predecessor->relation.relation_flags & successor->relation.relation_flags);
+
+	struct xrt_space_relation result = XRT_SPACE_RELATION_ZERO;
+	m_space_relation_interpolate(&predecessor->relation, &successor->relation, amount_to_lerp, flags, &result);
+	*out_relation = result;
+
+	return true;
+}
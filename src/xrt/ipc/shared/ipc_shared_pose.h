@@ -0,0 +1,63 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Helpers for the pose histories in the shared memory area.
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "xrt/xrt_defines.h"
+
+#include "shared/ipc_protocol.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * Reset the history and set which device input it is for, only to be called
+ * by the server before any client can see the history.
+ *
+ * @public @memberof ipc_shared_pose_history
+ */
+void
+ipc_shared_pose_history_init(struct ipc_shared_pose_history *isph, uint32_t device_index, enum xrt_input_name name);
+
+/*!
+ * Add a new sample to the history, older samples are overwritten once the
+ * ring is full. Samples with a timestamp not newer than the latest entry are
+ * dropped, just like @ref m_relation_history_push does. Only the server may
+ * call this and only from a single thread.
+ *
+ * @return false if the sample was dropped.
+ *
+ * @public @memberof ipc_shared_pose_history
+ */
+bool
+ipc_shared_pose_history_push(struct ipc_shared_pose_history *isph,
+                             const struct xrt_space_relation *relation,
+                             uint64_t timestamp_ns);
+
+/*!
+ * Interpolate or predict a relation at the given time from the history,
+ * using the same math as @ref m_relation_history_get. Fails if the history is
+ * empty, if the time is older than the oldest entry, if the time is more than
+ * @p max_prediction_ns past the newest entry, or if a consistent copy could
+ * not be made because the server kept writing to it. On failure the caller
+ * is expected to ask the server instead.
+ *
+ * @public @memberof ipc_shared_pose_history
+ */
+bool
+ipc_shared_pose_history_get(const struct ipc_shared_pose_history *isph,
+                            uint64_t at_timestamp_ns,
+                            uint64_t max_prediction_ns,
+                            struct xrt_space_relation *out_relation);
+
+
+#ifdef __cplusplus
+}
+#endif
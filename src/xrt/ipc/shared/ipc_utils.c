@@ -158,6 +158,92 @@ ipc_receive_fds(struct ipc_message_channel *imc, void *out_data, size_t size, in
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_receive_with_fds(struct ipc_message_channel *imc,
+                     void *out_data,
+                     size_t size,
+                     size_t *out_size,
+                     int *out_handles,
+                     uint32_t max_handles,
+                     uint32_t *out_handle_count)
+{
+	assert(imc != NULL);
+	assert(out_data != NULL);
+	assert(size != 0);
+	assert(out_size != NULL);
+	assert(out_handles != NULL || max_handles == 0);
+	assert(out_handle_count != NULL);
+	union imcontrol_buf u;
+	const size_t cmsg_size = CMSG_SPACE(sizeof(int) * max_handles);
+	assert(cmsg_size <= sizeof(u.buf));
+	memset(u.buf, 0, cmsg_size);
+
+	*out_size = 0;
+	*out_handle_count = 0;
+
+	struct iovec iov = {0};
+	iov.iov_base = out_data;
+	iov.iov_len = size;
+
+	struct msghdr msg = {0};
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = u.buf;
+	msg.msg_controllen = cmsg_size;
+
+	ssize_t len = recvmsg(imc->ipc_handle, &msg, MSG_NOSIGNAL | MSG_CMSG_CLOEXEC);
+	if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+		// Receive timeout set on the socket.
+		return XRT_TIMEOUT;
+	}
+
+	if (len < 0) {
+		IPC_ERROR(imc, "recvmsg failed with error: '%s'!", strerror(errno));
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	if (len == 0) {
+		// Other side closed the connection, not an error as such.
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	uint32_t handle_count = 0;
+	bool too_many = (msg.msg_flags & MSG_CTRUNC) != 0;
+	for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+			continue;
+		}
+
+		uint32_t count = (uint32_t)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+		const int *fds = (const int *)CMSG_DATA(cmsg);
+		for (uint32_t i = 0; i < count; i++) {
+			int fd = -1;
+			memcpy(&fd, &fds[i], sizeof(int));
+
+			// The control buffer might have room for more than asked for.
+			if (handle_count < max_handles) {
+				out_handles[handle_count++] = fd;
+			} else {
+				close(fd);
+				too_many = true;
+			}
+		}
+	}
+
+	if (too_many) {
+		IPC_ERROR(imc, "recvmsg failed with error: too many handles sent with message!");
+		for (uint32_t i = 0; i < handle_count; i++) {
+			close(out_handles[i]);
+		}
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	*out_size = (size_t)len;
+	*out_handle_count = handle_count;
+
+	return XRT_SUCCESS;
+}
+
 xrt_result_t
 ipc_send_fds(struct ipc_message_channel *imc, const void *data, size_t size, const int *handles, uint32_t handle_count)
 {
@@ -94,6 +94,37 @@ ipc_receive(struct ipc_message_channel *imc, void *out_data, size_t size);
 xrt_result_t
 ipc_receive_fds(struct ipc_message_channel *imc, void *out_data, size_t size, int *out_handles, uint32_t handle_count);
 
+/*!
+ * Receive a single message along with any file descriptors that were sent
+ * with it. Unlike @ref ipc_receive_fds the number of file descriptors is not
+ * known ahead of time, this is used by the server to receive commands that
+ * carry their handles inline.
+ *
+ * @param imc Message channel to use
+ * @param[out] out_data Pointer to the buffer to fill with data. Must not be
+ * null.
+ * @param[in] size Maximum size to read, must be greater than 0
+ * @param[out] out_size Number of bytes actually read.
+ * @param[out] out_handles Array of file descriptors to populate, may be null
+ * if @p max_handles is 0.
+ * @param[in] max_handles Number of elements in @p out_handles, receiving more
+ * than this is an error and all of the received file descriptors are closed.
+ * @param[out] out_handle_count Number of file descriptors received.
+ *
+ * @return XRT_TIMEOUT if a receive timeout is set on the socket and it
+ * expired, XRT_ERROR_IPC_FAILURE on errors or if the other side hung up.
+ *
+ * @public @memberof ipc_message_channel
+ */
+xrt_result_t
+ipc_receive_with_fds(struct ipc_message_channel *imc,
+                     void *out_data,
+                     size_t size,
+                     size_t *out_size,
+                     int *out_handles,
+                     uint32_t max_handles,
+                     uint32_t *out_handle_count);
+
 /*!
  * Send a message along with file descriptors over the IPC channel.
  *
@@ -133,6 +133,7 @@ class HandleType:
         self.typename = match.group(0)
         self.stem = match.group(1)
         self.argstem = 'handles'
+        self.is_fd_define = "XRT_%s_HANDLE_IS_FD" % self.stem.upper()
 
     def __str__(self):
         """Convert to string by returning the type name."""
@@ -6,7 +6,8 @@
 import argparse
 
 from ipcproto.common import (Proto, write_decl, write_invocation,
-                             write_result_handler, write_cpp_header_guard_start,
+                             write_with_wrapped_args, write_result_handler,
+                             write_cpp_header_guard_start,
                              write_cpp_header_guard_end)
 
 header = '''// Copyright 2020, Collabora, Ltd.
@@ -43,6 +44,9 @@ typedef enum ipc_command
         f.write("\n\t" + call.id + ",")
     f.write("\n} ipc_command_t;\n")
 
+    f.write("\n//! Number of commands, including @ref IPC_ERR.\n")
+    f.write("#define IPC_COMMAND_COUNT %d\n" % (len(p.calls) + 1))
+
     f.write('''
 struct ipc_command_msg
 {
@@ -80,6 +84,7 @@ ipc_cmd_to_str(ipc_command_t id)
             if call.in_handles:
                 f.write("\t%s %s;\n" % (call.in_handles.count_arg_type,
                                         call.in_handles.count_arg_name))
+                f.write("\tbool handles_inline;\n")
             f.write("};\n")
         # Should we emit a reply struct.
         if call.out_args:
@@ -143,11 +148,46 @@ def generate_client_c(file, p):
 """)
         cleanup = "os_mutex_unlock(&ipc_c->mutex);"
 
+        f.write("\n\txrt_result_t ret;\n")
+
+        if call.in_handles:
+            f.write("\n#ifdef %s\n" % call.in_handles.is_fd_define)
+            f.write("\tif (ipc_c->inline_handles) {\n")
+            f.write("\t\t// Send our request and handles in one go\n")
+            f.write("\t\t_msg.handles_inline = true;\n")
+            f.write("\t\tif (%s > 0) {" % call.in_handles.count_arg_name)
+            write_invocation(
+                f,
+                'ret',
+                'ipc_send_fds',
+                (
+                    '&ipc_c->imc',
+                    '&_msg',
+                    'sizeof(_msg)',
+                    call.in_handles.arg_name,
+                    call.in_handles.count_arg_name
+                ),
+                indent="\t\t\t"
+            )
+            f.write(';\n\t\t} else {')
+            write_invocation(
+                f,
+                'ret',
+                'ipc_send',
+                ('&ipc_c->imc', '&_msg', 'sizeof(_msg)'),
+                indent="\t\t\t"
+            )
+            f.write(';\n\t\t}')
+            write_result_handler(f, 'ret', cleanup, indent="\t\t")
+            f.write("\t\tgoto receive_reply;\n")
+            f.write("\t}\n")
+            f.write("#endif\n")
+
         # Prepare initial sending
         func = 'ipc_send'
         args = ['&ipc_c->imc', '&_msg', 'sizeof(_msg)']
         f.write("\n\t// Send our request")
-        write_invocation(f, 'xrt_result_t ret', func, args, indent="\t")
+        write_invocation(f, 'ret', func, args, indent="\t")
         f.write(';')
         write_result_handler(f, 'ret', cleanup, indent="\t")
 
@@ -191,6 +231,11 @@ def generate_client_c(file, p):
             f.write(';')
             write_result_handler(f, 'ret', cleanup, indent="\t")
 
+        if call.in_handles:
+            f.write("\n#ifdef %s\n" % call.in_handles.is_fd_define)
+            f.write("receive_reply:\n")
+            f.write("#endif\n")
+
         f.write("\n\t// Await the reply")
         func = 'ipc_receive'
         args = ['&ipc_c->imc', '&_reply', 'sizeof(_reply)']
@@ -242,6 +287,8 @@ def generate_server_c(file, p):
     f.write('''
 #include "xrt/xrt_limits.h"
 
+#include "os/os_time.h"
+
 #include "shared/ipc_protocol.h"
 #include "shared/ipc_utils.h"
 
@@ -249,12 +296,20 @@ def generate_server_c(file, p):
 
 #include "ipc_server_generated.h"
 
+#include <assert.h>
+
+
+static_assert(IPC_COMMAND_COUNT <= IPC_CALL_STATS_MAX_COMMANDS, "Too many commands for the call stats");
+
 ''')
 
     f.write('''
 xrt_result_t
 ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
 {
+\t// For the call stats, covers the handler and sending the reply.
+\tuint64_t start_ns = os_monotonic_get_ns();
+
 \tswitch (*ipc_command) {
 ''')
 
@@ -292,6 +347,25 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
             f.write("\t\t\treturn XRT_ERROR_IPC_FAILURE;\n")
             f.write("\t\t}\n")
 
+            # The handles might have been sent along with the message.
+            f.write("\t\tif (msg->handles_inline) {\n")
+            f.write("#ifdef %s\n" % call.in_handles.is_fd_define)
+            f.write("\t\t\tif (msg->%s != ics->inline_handle_count) {\n" %
+                    call.in_handles.count_arg_name)
+            f.write("\t\t\t\treturn XRT_ERROR_IPC_FAILURE;\n")
+            f.write("\t\t\t}\n")
+            f.write("\t\t\tfor (uint32_t i = 0; i < ics->inline_handle_count; i++) {\n")
+            f.write("\t\t\t\tin_%s[i] = ics->inline_handles[i];\n" %
+                    call.in_handles.arg_name)
+            f.write("\t\t\t}\n")
+            f.write("\t\t\t// Now owned by the handler.\n")
+            f.write("\t\t\tics->inline_handle_count = 0;\n")
+            f.write("\t\t\tgoto call_handler_%s;\n" % call.name)
+            f.write("#else\n")
+            f.write("\t\t\treturn XRT_ERROR_IPC_FAILURE;\n")
+            f.write("#endif\n")
+            f.write("\t\t}\n")
+
             # Let the client know we are ready to receive the handles.
             write_invocation(
                 f,
@@ -327,6 +401,11 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
             f.write("\t\t\treturn XRT_ERROR_IPC_FAILURE;\n")
             f.write("\t\t}\n")
 
+        if call.in_handles:
+            f.write("\n#ifdef %s\n" % call.in_handles.is_fd_define)
+            f.write("\tcall_handler_%s:\n" % call.name)
+            f.write("#endif\n")
+
         # Write call to ipc_handle_CALLNAME
         args = ["ics"]
         for arg in call.in_args:
@@ -357,6 +436,15 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
             func += '_handles_' + call.out_handles.stem
             args.extend(call.out_handles.arg_names)
         write_invocation(f, 'xrt_result_t ret', func, args, indent="\t\t")
+        f.write(";\n")
+        if call.needs_msg_struct:
+            msg_size = "sizeof(*msg)"
+        else:
+            msg_size = "sizeof(struct ipc_command_msg)"
+        write_with_wrapped_args(f, "ipc_server_record_call(",
+                                ("ics", call.id,
+                                 msg_size + " + sizeof(reply)", "start_ns"),
+                                indent="\t\t")
         f.write(";")
         f.write("\n\t\treturn ret;\n")
         f.write("\t}\n")
@@ -1578,6 +1578,9 @@ oxr_action_sync_data(struct oxr_logger *log,
 		oxr_xdev_update(sess->sys->xsysd->xdevs[i]);
 	}
 
+	// Newer tracking data and maybe new action spaces, locate them again.
+	oxr_space_locate_batch_invalidate(sess);
+
 	// Reset all action set attachments.
 	for (size_t i = 0; i < sess->action_set_attachment_count; ++i) {
 		act_set_attached = &sess->act_set_attachments[i];
@@ -123,6 +123,7 @@ struct oxr_hand_tracker;
 
 #define XRT_MAX_HANDLE_CHILDREN 256
 #define OXR_MAX_BINDINGS_PER_ACTION 16
+#define OXR_MAX_LOCATE_BATCH 16
 
 struct time_state;
 
@@ -796,6 +797,25 @@ oxr_space_locate_device(struct oxr_logger *log,
                         XrTime time,
                         struct xrt_space_relation *out_relation);
 
+/*!
+ * Drops all spaces remembered for batched locating, see
+ * @ref oxr_session::locate_batch.
+ *
+ * @public @memberof oxr_session
+ */
+void
+oxr_space_locate_batch_clear(struct oxr_session *sess);
+
+/*!
+ * Makes the next locate of every space remembered for batched locating ask
+ * the space overseer again, called when newer tracking data may be there.
+ * Also drops the spaces the app has stopped locating.
+ *
+ * @public @memberof oxr_session
+ */
+void
+oxr_space_locate_batch_invalidate(struct oxr_session *sess);
+
 
 /*
  *
@@ -1414,6 +1434,29 @@ struct oxr_instance
 #endif
 };
 
+/*!
+ * A space the app has located recently, see @ref oxr_session::locate_batch.
+ */
+struct oxr_locate_batch_entry
+{
+	//! Space being located and its offset, holds a reference.
+	struct xrt_space *xspace;
+	struct xrt_pose offset;
+
+	//! Base space it was located in and its offset, holds a reference.
+	struct xrt_space *xbase;
+	struct xrt_pose base_offset;
+
+	//! Last time the app asked for this space, used to drop unused spaces.
+	uint64_t requested_ns;
+
+	//! When @p relation is from, only valid if @p located is set.
+	uint64_t located_ns;
+	bool located;
+
+	struct xrt_space_relation relation;
+};
+
 /*!
  * Object that client program interact with.
  *
@@ -1540,6 +1583,20 @@ struct oxr_session
 	 * Used as reference for local space.  */
 	struct xrt_space_relation local_space_pure_relation;
 
+	/*!
+	 * Apps locate their spaces one by one, so the first time a space is
+	 * located at a new time all spaces recently located in the same base
+	 * space are located together with a single call to
+	 * @ref xrt_space_overseer_locate_spaces, the following locates at the
+	 * same time then use those results. The results are only used until
+	 * the next xrWaitFrame or xrSyncActions.
+	 */
+	struct
+	{
+		struct os_mutex mutex;
+		struct oxr_locate_batch_entry entries[OXR_MAX_LOCATE_BATCH];
+	} locate_batch;
+
 	bool has_lost;
 };
 
@@ -51,6 +51,7 @@
 DEBUG_GET_ONCE_NUM_OPTION(ipd, "OXR_DEBUG_IPD_MM", 63)
 DEBUG_GET_ONCE_NUM_OPTION(wait_frame_sleep, "OXR_DEBUG_WAIT_FRAME_EXTRA_SLEEP_MS", 0)
 DEBUG_GET_ONCE_BOOL_OPTION(frame_timing_spew, "OXR_FRAME_TIMING_SPEW", false)
+DEBUG_GET_ONCE_BOOL_OPTION(depth_reprojection, "OXR_DEPTH_REPROJECTION", false)
 
 static bool
 should_render(XrSessionState state)
@@ -520,6 +521,9 @@ oxr_session_frame_wait(struct oxr_logger *log, struct oxr_session *sess, XrFrame
 	//! more than one session per instance.
 	XRT_MAYBE_UNUSED timepoint_ns now = time_state_get_now_and_update(sess->sys->inst->timekeeping);
 
+	// A new frame, don't hand out locations from the last one.
+	oxr_space_locate_batch_invalidate(sess);
+
 	struct xrt_compositor *xc = sess->compositor;
 	if (xc == NULL) {
 		frameState->shouldRender = XR_FALSE;
@@ -672,6 +676,9 @@ oxr_session_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 	os_semaphore_destroy(&sess->sem);
 	os_mutex_destroy(&sess->active_wait_frames_lock);
 
+	oxr_space_locate_batch_clear(sess);
+	os_mutex_destroy(&sess->locate_batch.mutex);
+
 	free(sess);
 
 	return ret;
@@ -695,6 +702,8 @@ oxr_session_allocate_and_init(struct oxr_logger *log, struct oxr_system *sys, st
 	sess->active_wait_frames = 0;
 	os_mutex_init(&sess->active_wait_frames_lock);
 
+	os_mutex_init(&sess->locate_batch.mutex);
+
 	// Debug and user options.
 	sess->ipd_meters = debug_get_num_option_ipd() / 1000.0f;
 	sess->frame_timing_spew = debug_get_bool_option_frame_timing_spew();
@@ -949,6 +958,7 @@ oxr_session_create(struct oxr_logger *log,
 		xsi.flags = overlay_info->createFlags;
 		xsi.z_order = overlay_info->sessionLayersPlacement;
 	}
+	xsi.depth_reprojection = debug_get_bool_option_depth_reprojection();
 
 	/* Try allocating and populating. */
 	XrResult ret = oxr_session_create_impl(log, sys, createInfo, &xsi, &sess);
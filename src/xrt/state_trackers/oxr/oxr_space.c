@@ -15,6 +15,7 @@
 
 #include "util/u_debug.h"
 #include "util/u_misc.h"
+#include "util/u_time.h"
 
 #include "oxr_objects.h"
 #include "oxr_logger.h"
@@ -35,6 +36,15 @@
  *
  */
 
+//! Spaces not located for this long are left out of new batches.
+#define LOCATE_BATCH_WINDOW_NS (100 * U_TIME_1MS_IN_NS)
+
+static inline bool
+pose_equal(const struct xrt_pose *a, const struct xrt_pose *b)
+{
+	return memcmp(a, b, sizeof(*a)) == 0;
+}
+
 static XrResult
 check_reference_space_type(struct oxr_logger *log, XrReferenceSpaceType type)
 {
@@ -56,6 +66,184 @@ check_reference_space_type(struct oxr_logger *log, XrReferenceSpaceType type)
 }
 
 
+/*
+ *
+ * Batched locating.
+ *
+ */
+
+static void
+locate_batch_entry_clear(struct oxr_locate_batch_entry *e)
+{
+	xrt_space_reference(&e->xspace, NULL);
+	xrt_space_reference(&e->xbase, NULL);
+	U_ZERO(e);
+}
+
+static bool
+locate_batch_entry_is_same_base(const struct oxr_locate_batch_entry *e,
+                                struct xrt_space *xbase,
+                                const struct xrt_pose *base_offset)
+{
+	return e->xspace != NULL && e->xbase == xbase && pose_equal(&e->base_offset, base_offset);
+}
+
+/*!
+ * Returns the entry for the space, replacing the space that was the longest
+ * ago asked for if it is not there.
+ */
+static struct oxr_locate_batch_entry *
+locate_batch_get_entry_locked(struct oxr_session *sess,
+                              struct xrt_space *xbase,
+                              const struct xrt_pose *base_offset,
+                              struct xrt_space *xspace,
+                              const struct xrt_pose *offset)
+{
+	struct oxr_locate_batch_entry *replace = NULL;
+
+	for (uint32_t i = 0; i < OXR_MAX_LOCATE_BATCH; i++) {
+		struct oxr_locate_batch_entry *e = &sess->locate_batch.entries[i];
+
+		if (locate_batch_entry_is_same_base(e, xbase, base_offset) && e->xspace == xspace &&
+		    pose_equal(&e->offset, offset)) {
+			return e;
+		}
+
+		if (replace == NULL || e->xspace == NULL ||
+		    (replace->xspace != NULL && e->requested_ns < replace->requested_ns)) {
+			replace = e;
+		}
+	}
+
+	locate_batch_entry_clear(replace);
+	xrt_space_reference(&replace->xspace, xspace);
+	xrt_space_reference(&replace->xbase, xbase);
+	replace->offset = *offset;
+	replace->base_offset = *base_offset;
+
+	return replace;
+}
+
+static void
+locate_space_batched(struct oxr_session *sess,
+                     struct xrt_space *xbase,
+                     const struct xrt_pose *base_offset,
+                     uint64_t at_timestamp_ns,
+                     struct xrt_space *xspace,
+                     const struct xrt_pose *offset,
+                     struct xrt_space_relation *out_relation)
+{
+	os_mutex_lock(&sess->locate_batch.mutex);
+
+	struct oxr_locate_batch_entry *e = locate_batch_get_entry_locked(sess, xbase, base_offset, xspace, offset);
+	e->requested_ns = at_timestamp_ns;
+
+	if (!e->located || e->located_ns != at_timestamp_ns) {
+		struct oxr_locate_batch_entry *batch[OXR_MAX_LOCATE_BATCH];
+		struct xrt_space *xspaces[OXR_MAX_LOCATE_BATCH];
+		struct xrt_pose offsets[OXR_MAX_LOCATE_BATCH];
+		struct xrt_space_relation relations[OXR_MAX_LOCATE_BATCH];
+		uint32_t count = 0;
+
+		// Also locate the other spaces the app has been locating in this base space.
+		for (uint32_t i = 0; i < OXR_MAX_LOCATE_BATCH; i++) {
+			struct oxr_locate_batch_entry *f = &sess->locate_batch.entries[i];
+			if (!locate_batch_entry_is_same_base(f, xbase, base_offset) ||
+			    (f->located && f->located_ns == at_timestamp_ns) ||
+			    (f != e && f->requested_ns + LOCATE_BATCH_WINDOW_NS < at_timestamp_ns)) {
+				continue;
+			}
+
+			batch[count] = f;
+			xspaces[count] = f->xspace;
+			offsets[count] = f->offset;
+			relations[count] = (struct xrt_space_relation)XRT_SPACE_RELATION_ZERO;
+			count++;
+		}
+
+		xrt_result_t xret = xrt_space_overseer_locate_spaces( //
+		    sess->sys->xso,                                   //
+		    xbase,                                            //
+		    base_offset,                                      //
+		    at_timestamp_ns,                                  //
+		    xspaces,                                          //
+		    count,                                            //
+		    offsets,                                          //
+		    relations);                                       //
+
+		for (uint32_t i = 0; i < count; i++) {
+			batch[i]->relation = relations[i];
+			batch[i]->located = xret == XRT_SUCCESS;
+			batch[i]->located_ns = at_timestamp_ns;
+		}
+	}
+
+	*out_relation = e->relation;
+
+	os_mutex_unlock(&sess->locate_batch.mutex);
+}
+
+/*!
+ * Drops the entries that locate the space, or locate other spaces in it.
+ */
+static void
+locate_batch_forget(struct oxr_session *sess, struct xrt_space *xspace, const struct xrt_pose *offset)
+{
+	os_mutex_lock(&sess->locate_batch.mutex);
+
+	for (uint32_t i = 0; i < OXR_MAX_LOCATE_BATCH; i++) {
+		struct oxr_locate_batch_entry *e = &sess->locate_batch.entries[i];
+
+		if ((e->xspace == xspace && pose_equal(&e->offset, offset)) ||
+		    (e->xbase == xspace && pose_equal(&e->base_offset, offset))) {
+			locate_batch_entry_clear(e);
+		}
+	}
+
+	os_mutex_unlock(&sess->locate_batch.mutex);
+}
+
+void
+oxr_space_locate_batch_clear(struct oxr_session *sess)
+{
+	os_mutex_lock(&sess->locate_batch.mutex);
+
+	for (uint32_t i = 0; i < OXR_MAX_LOCATE_BATCH; i++) {
+		locate_batch_entry_clear(&sess->locate_batch.entries[i]);
+	}
+
+	os_mutex_unlock(&sess->locate_batch.mutex);
+}
+
+void
+oxr_space_locate_batch_invalidate(struct oxr_session *sess)
+{
+	os_mutex_lock(&sess->locate_batch.mutex);
+
+	uint64_t newest_ns = 0;
+	for (uint32_t i = 0; i < OXR_MAX_LOCATE_BATCH; i++) {
+		struct oxr_locate_batch_entry *e = &sess->locate_batch.entries[i];
+		if (e->xspace != NULL && e->requested_ns > newest_ns) {
+			newest_ns = e->requested_ns;
+		}
+	}
+
+	for (uint32_t i = 0; i < OXR_MAX_LOCATE_BATCH; i++) {
+		struct oxr_locate_batch_entry *e = &sess->locate_batch.entries[i];
+
+		// Release the spaces that would be left out of new batches anyway.
+		if (e->xspace != NULL && e->requested_ns + LOCATE_BATCH_WINDOW_NS < newest_ns) {
+			locate_batch_entry_clear(e);
+			continue;
+		}
+
+		e->located = false;
+	}
+
+	os_mutex_unlock(&sess->locate_batch.mutex);
+}
+
+
 /*
  *
  * To xrt_space functions.
@@ -88,6 +276,9 @@ get_xrt_space_action(struct oxr_logger *log, struct oxr_space *spc, struct xrt_s
 	assert(name != 0);
 
 	if (xdev != spc->action.xdev || name != spc->action.name) {
+		if (spc->action.xs != NULL) {
+			locate_batch_forget(spc->sess, spc->action.xs, &spc->pose);
+		}
 		xrt_space_reference(&spc->action.xs, NULL);
 
 		xrt_result_t xret = xrt_space_overseer_create_pose_space( //
@@ -108,23 +299,37 @@ get_xrt_space_action(struct oxr_logger *log, struct oxr_space *spc, struct xrt_s
 	return XR_SUCCESS;
 }
 
+/*!
+ * The semantic space of a reference space, NULL for action spaces and
+ * reference spaces that don't have one.
+ */
+static struct xrt_space *
+get_xrt_space_reference(struct oxr_space *spc)
+{
+	switch (spc->space_type) {
+	case OXR_SPACE_TYPE_ACTION: return NULL;
+	case OXR_SPACE_TYPE_REFERENCE_VIEW: return spc->sess->sys->xso->semantic.view;
+	case OXR_SPACE_TYPE_REFERENCE_LOCAL: return spc->sess->sys->xso->semantic.local;
+	case OXR_SPACE_TYPE_REFERENCE_LOCAL_FLOOR: return NULL;
+	case OXR_SPACE_TYPE_REFERENCE_STAGE: return spc->sess->sys->xso->semantic.stage;
+	case OXR_SPACE_TYPE_REFERENCE_UNBOUNDED_MSFT: return spc->sess->sys->xso->semantic.unbounded;
+	case OXR_SPACE_TYPE_REFERENCE_COMBINED_EYE_VARJO: return NULL;
+	}
+
+	return NULL;
+}
+
 static XrResult
 get_xrt_space(struct oxr_logger *log, struct oxr_space *spc, struct xrt_space **out_xspace)
 {
 	assert(out_xspace != NULL);
 	assert(*out_xspace == NULL);
 
-	struct xrt_space *xspace = NULL;
-	switch (spc->space_type) {
-	case OXR_SPACE_TYPE_ACTION: return get_xrt_space_action(log, spc, out_xspace);
-	case OXR_SPACE_TYPE_REFERENCE_VIEW: xspace = spc->sess->sys->xso->semantic.view; break;
-	case OXR_SPACE_TYPE_REFERENCE_LOCAL: xspace = spc->sess->sys->xso->semantic.local; break;
-	case OXR_SPACE_TYPE_REFERENCE_LOCAL_FLOOR: xspace = NULL; break;
-	case OXR_SPACE_TYPE_REFERENCE_STAGE: xspace = spc->sess->sys->xso->semantic.stage; break;
-	case OXR_SPACE_TYPE_REFERENCE_UNBOUNDED_MSFT: xspace = spc->sess->sys->xso->semantic.unbounded; break;
-	case OXR_SPACE_TYPE_REFERENCE_COMBINED_EYE_VARJO: xspace = NULL; break;
+	if (spc->space_type == OXR_SPACE_TYPE_ACTION) {
+		return get_xrt_space_action(log, spc, out_xspace);
 	}
 
+	struct xrt_space *xspace = get_xrt_space_reference(spc);
 	if (xspace == NULL) {
 		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Reference space without internal semantic space!");
 	}
@@ -146,6 +351,15 @@ oxr_space_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 {
 	struct oxr_space *spc = (struct oxr_space *)hb;
 
+	// Release any batch entries of this space.
+	struct xrt_space *xspace = spc->action.xs;
+	if (spc->space_type != OXR_SPACE_TYPE_ACTION) {
+		xspace = get_xrt_space_reference(spc);
+	}
+	if (xspace != NULL) {
+		locate_batch_forget(spc->sess, xspace, &spc->pose);
+	}
+
 	xrt_space_reference(&spc->action.xs, NULL);
 	spc->action.xdev = NULL;
 	spc->action.name = 0;
@@ -257,15 +471,15 @@ oxr_space_locate(
 		// Convert at_time to monotonic and give to device.
 		uint64_t at_timestamp_ns = time_state_ts_to_monotonic_ns(sys->inst->timekeeping, time);
 
-		// Ask the space overseer to locate the spaces.
-		xrt_space_overseer_locate_space( //
-		    sys->xso,                    //
-		    xbase,                       //
-		    &baseSpc->pose,              //
-		    at_timestamp_ns,             //
-		    xtarget,                     //
-		    &spc->pose,                  //
-		    &result);                    //
+		// Ask the space overseer to locate the spaces, batched with other spaces.
+		locate_space_batched( //
+		    spc->sess,        //
+		    xbase,            //
+		    &baseSpc->pose,   //
+		    at_timestamp_ns,  //
+		    xtarget,          //
+		    &spc->pose,       //
+		    &result);         //
 	}
 
 
@@ -7,7 +7,13 @@
  * @ingroup ipc
  */
 
+#include "os/os_time.h"
+
 #include "util/u_file.h"
+#include "util/u_time.h"
+
+#include "shared/ipc_call_stats.h"
+#include "shared/ipc_shared_layout.h"
 
 #include "client/ipc_client.h"
 #include "client/ipc_client_connection.h"
@@ -15,6 +21,8 @@
 #include "ipc_client_generated.h"
 
 #include <ctype.h>
+#include <inttypes.h>
+#include <math.h>
 
 
 #define P(...) fprintf(stdout, __VA_ARGS__)
@@ -26,6 +34,8 @@ typedef enum op_mode
 	MODE_SET_PRIMARY,
 	MODE_SET_FOCUSED,
 	MODE_TOGGLE_IO,
+	MODE_CALL_STATS,
+	MODE_FRAME_TIMINGS,
 } op_mode_t;
 
 
@@ -75,7 +85,7 @@ get_mode(struct ipc_connection *ipc_c)
 
 	P("\nDevices:\n");
 	for (uint32_t i = 0; i < ipc_c->ism->isdev_count; i++) {
-		struct ipc_shared_device *isdev = &ipc_c->ism->isdevs[i];
+		struct ipc_shared_device *isdev = ipc_shared_isdev(ipc_c->ism, i);
 		P("\tid: %d"
 		  "\tname: %d"
 		  "\t\"%s\"\n",
@@ -129,6 +139,106 @@ toggle_io(struct ipc_connection *ipc_c, int client_id)
 	return 0;
 }
 
+int
+call_stats(struct ipc_connection *ipc_c, int client_id)
+{
+	struct ipc_call_stats stats;
+	xrt_result_t r;
+
+	r = ipc_client_connection_get_call_stats(ipc_c, client_id, &stats);
+	if (r != XRT_SUCCESS) {
+		PE("Failed to get call stats for client %d.\n", client_id);
+		return 1;
+	}
+
+	P("%-45s %10s %12s %10s %10s %10s %10s\n", "Command", "Count", "Bytes", "Avg (us)", "p50 (us)", "p99 (us)",
+	  "Max (us)");
+	for (uint32_t i = 1; i < IPC_COMMAND_COUNT; i++) {
+		const struct ipc_call_stat *stat = &stats.calls[i];
+		if (stat->count == 0) {
+			continue;
+		}
+
+		P("%-45s %10" PRIu64 " %12" PRIu64 " %10.1f %10.1f %10.1f %10.1f\n", //
+		  ipc_cmd_to_str((ipc_command_t)i),                                   //
+		  stat->count,                                                        //
+		  stat->bytes,                                                        //
+		  (double)stat->total_ns / (double)stat->count / 1000.0,              //
+		  (double)ipc_call_stat_percentile_ns(stat, 0.5) / 1000.0,            //
+		  (double)ipc_call_stat_percentile_ns(stat, 0.99) / 1000.0,           //
+		  (double)stat->max_ns / 1000.0);                                     //
+	}
+
+	return 0;
+}
+
+//! Difference in milliseconds, NAN if either time is not known.
+static double
+diff_ms(uint64_t a_ns, uint64_t b_ns)
+{
+	if (a_ns == 0 || b_ns == 0) {
+		return NAN;
+	}
+
+	return time_ns_to_ms_f((time_duration_ns)(a_ns - b_ns));
+}
+
+static void
+print_frame_timing(const struct ipc_frame_timing_record *rec)
+{
+	bool missed = (rec->flags & IPC_FRAME_TIMING_MISSED) != 0;
+
+	// Only known if the display told us when the frame was presented.
+	double late_ms = NAN;
+	if ((rec->flags & IPC_FRAME_TIMING_PRESENT_INFO) != 0) {
+		late_ms = diff_ms(rec->actual_present_time_ns, rec->desired_present_time_ns);
+	}
+
+	P("%10" PRId64 " %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f %s\n", //
+	  rec->frame_id,                                                  //
+	  diff_ms(rec->when_began_ns, rec->when_woke_ns),                 //
+	  diff_ms(rec->when_submitted_ns, rec->when_began_ns),            //
+	  diff_ms(rec->gpu_start_ns, rec->when_submitted_ns),             //
+	  diff_ms(rec->gpu_end_ns, rec->gpu_start_ns),                    //
+	  diff_ms(rec->desired_present_time_ns, rec->gpu_end_ns),         //
+	  late_ms,                                                        //
+	  missed ? "missed" : "");                                        //
+}
+
+int
+frame_timings(struct ipc_connection *ipc_c)
+{
+	struct ipc_compositor_timings timings;
+	int64_t from_frame_id = 0;
+	xrt_result_t r;
+
+	P("%10s %10s %10s %10s %10s %10s %10s\n", "Frame", "Wait (ms)", "CPU (ms)", "Queue (ms)", "GPU (ms)",
+	  "Slack (ms)", "Late (ms)");
+
+	// Stream until killed.
+	while (true) {
+		r = ipc_call_system_get_compositor_timings(ipc_c, from_frame_id, &timings);
+		if (r != XRT_SUCCESS) {
+			PE("Failed to get compositor frame timings.\n");
+			return 1;
+		}
+
+		for (uint32_t i = 0; i < timings.record_count; i++) {
+			print_frame_timing(&timings.records[i]);
+		}
+		fflush(stdout);
+
+		from_frame_id = timings.next_frame_id;
+
+		// Catch up straight away if there was more to get.
+		if (timings.record_count < IPC_MAX_COMPOSITOR_TIMINGS) {
+			os_nanosleep(U_TIME_1MS_IN_NS * 100);
+		}
+	}
+
+	return 0;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -139,7 +249,7 @@ main(int argc, char *argv[])
 	int s_val = 0;
 
 	opterr = 0;
-	while ((c = getopt(argc, argv, "p:f:i:")) != -1) {
+	while ((c = getopt(argc, argv, "p:f:i:s:t")) != -1) {
 		switch (c) {
 		case 'p':
 			s_val = atoi(optarg);
@@ -153,6 +263,11 @@ main(int argc, char *argv[])
 			s_val = atoi(optarg);
 			op_mode = MODE_TOGGLE_IO;
 			break;
+		case 's':
+			s_val = atoi(optarg);
+			op_mode = MODE_CALL_STATS;
+			break;
+		case 't': op_mode = MODE_FRAME_TIMINGS; break;
 		case '?':
 			if (optopt == 's') {
 				PE("Option -s requires an id to set.\n");
@@ -161,6 +276,8 @@ main(int argc, char *argv[])
 				PE("    -f <id>: Set focused client\n");
 				PE("    -p <id>: Set primary client\n");
 				PE("    -i <id>: Toggle whether client receives input\n");
+				PE("    -s <id>: Print IPC call stats of client, 0 for all clients\n");
+				PE("    -t: Stream compositor frame timings\n");
 			} else {
 				PE("Option `\\x%x' unknown.\n", optopt);
 			}
@@ -187,6 +304,8 @@ main(int argc, char *argv[])
 	case MODE_SET_PRIMARY: exit(set_primary(&ipc_c, s_val)); break;
 	case MODE_SET_FOCUSED: exit(set_focused(&ipc_c, s_val)); break;
 	case MODE_TOGGLE_IO: exit(toggle_io(&ipc_c, s_val)); break;
+	case MODE_CALL_STATS: exit(call_stats(&ipc_c, s_val)); break;
+	case MODE_FRAME_TIMINGS: exit(frame_timings(&ipc_c)); break;
 	default: P("Unrecognised operation mode.\n"); exit(1);
 	}
 
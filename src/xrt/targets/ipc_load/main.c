@@ -0,0 +1,581 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Load generator for the IPC layer, drives synthetic clients and
+ *         reports throughput, latency and CPU time per client.
+ * @ingroup ipc
+ */
+
+#include "xrt/xrt_config_build.h"
+#include "xrt/xrt_device.h"
+#include "xrt/xrt_instance.h"
+#include "xrt/xrt_compositor.h"
+#include "xrt/xrt_space.h"
+#include "xrt/xrt_system.h"
+
+#include "os/os_time.h"
+#include "os/os_threading.h"
+
+#include "util/u_misc.h"
+#include "util/u_logging.h"
+
+#include "shared/ipc_protocol.h"
+#include "client/ipc_client_interface.h"
+
+#ifdef XRT_MODULE_COMPOSITOR_NULL
+#include "server/ipc_server_interface.h"
+#endif
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define P(...) fprintf(stdout, __VA_ARGS__)
+#define PE(...) fprintf(stderr, __VA_ARGS__)
+
+//! How long to wait for a in-process server to start listening.
+#define SERVER_START_TIMEOUT_MS (10000)
+
+
+/*
+ *
+ * Structs.
+ *
+ */
+
+/*!
+ * The operations done every frame, timed separately.
+ */
+enum load_op
+{
+	LOAD_OP_WAIT_FRAME,
+	LOAD_OP_BEGIN,
+	LOAD_OP_POSES,
+	LOAD_OP_SYNC_ACTIONS,
+	LOAD_OP_LAYER_COMMIT,
+	LOAD_OP_FRAME,
+	LOAD_OP_COUNT,
+};
+
+static const char *load_op_names[LOAD_OP_COUNT] = {
+    "wait_frame",              //
+    "begin_frame",             //
+    "poses",                   //
+    "sync_actions",            //
+    "layer_commit",            //
+    "frame (all but waiting)", //
+};
+
+struct load_settings
+{
+	uint32_t client_count;
+	uint32_t frame_count;
+
+	//! Start a server with the null compositor in this process.
+	bool in_process;
+};
+
+/*!
+ * One synthetic client, goes through the same objects as the OpenXR state
+ * tracker does so the client side shared memory paths are exercised too.
+ */
+struct load_client
+{
+	const struct load_settings *settings;
+
+	struct xrt_instance *xinst;
+	struct xrt_system_devices *xsysd;
+	struct xrt_space_overseer *xso;
+	struct xrt_system_compositor *xsysc;
+	struct xrt_compositor_native *xcn;
+
+	struct os_thread thread;
+	bool thread_started;
+
+	//! One sample per frame and operation, in nanoseconds.
+	uint64_t *samples[LOAD_OP_COUNT];
+
+	//! Frames actually done, less than asked for on errors.
+	uint32_t frames_done;
+
+	uint64_t wall_ns;
+	uint64_t cpu_ns;
+
+	xrt_result_t xret;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static uint64_t
+thread_cpu_time_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (uint64_t)ts.tv_sec * U_TIME_1S_IN_NS + (uint64_t)ts.tv_nsec;
+}
+
+static int
+compare_u64(const void *a, const void *b)
+{
+	uint64_t va = *(const uint64_t *)a;
+	uint64_t vb = *(const uint64_t *)b;
+	return va < vb ? -1 : va > vb ? 1 : 0;
+}
+
+//! @p samples needs to be sorted.
+static uint64_t
+percentile(const uint64_t *samples, uint32_t count, double fraction)
+{
+	if (count == 0) {
+		return 0;
+	}
+
+	uint32_t index = (uint32_t)(fraction * (double)(count - 1) + 0.5);
+	return samples[index];
+}
+
+static double
+to_us(uint64_t ns)
+{
+	return (double)ns / 1000.0;
+}
+
+//! Locate the first pose input of every device, like a app locating its action spaces.
+static xrt_result_t
+do_poses(struct load_client *lc, uint64_t at_timestamp_ns)
+{
+	struct xrt_system_devices *xsysd = lc->xsysd;
+
+	for (uint32_t i = 0; i < xsysd->xdev_count; i++) {
+		struct xrt_device *xdev = xsysd->xdevs[i];
+
+		for (uint32_t k = 0; k < xdev->input_count; k++) {
+			enum xrt_input_name name = xdev->inputs[k].name;
+			if (XRT_GET_INPUT_TYPE(name) != XRT_INPUT_TYPE_POSE) {
+				continue;
+			}
+
+			struct xrt_space_relation relation;
+			xrt_device_get_tracked_pose(xdev, name, at_timestamp_ns, &relation);
+			break;
+		}
+	}
+
+	return XRT_SUCCESS;
+}
+
+//! Same as the state tracker does on xrSyncActions.
+static xrt_result_t
+do_sync_actions(struct load_client *lc)
+{
+	struct xrt_system_devices *xsysd = lc->xsysd;
+
+	for (uint32_t i = 0; i < xsysd->xdev_count; i++) {
+		xrt_device_update_inputs(xsysd->xdevs[i]);
+	}
+
+	return XRT_SUCCESS;
+}
+
+static xrt_result_t
+do_layer_commit(struct load_client *lc, int64_t frame_id, uint64_t display_time_ns)
+{
+	struct xrt_compositor *xc = &lc->xcn->base;
+
+	// No layers, the null compositor has nothing to render anyways.
+	struct xrt_layer_frame_data data = {
+	    .frame_id = frame_id,
+	    .display_time_ns = display_time_ns,
+	    .env_blend_mode = XRT_BLEND_MODE_OPAQUE,
+	};
+
+	xrt_result_t xret = xrt_comp_layer_begin(xc, &data);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	return xrt_comp_layer_commit(xc, XRT_GRAPHICS_SYNC_HANDLE_INVALID);
+}
+
+static xrt_result_t
+do_frame(struct load_client *lc, uint64_t durations[LOAD_OP_COUNT])
+{
+	struct xrt_compositor *xc = &lc->xcn->base;
+	int64_t frame_id = -1;
+	uint64_t predicted_display_time_ns = 0;
+	uint64_t predicted_display_period_ns = 0;
+	xrt_result_t xret;
+	uint64_t t0, t1;
+
+#define TIMED(OP, CALL)                                                                                                \
+	do {                                                                                                           \
+		t0 = os_monotonic_get_ns();                                                                            \
+		xret = CALL;                                                                                           \
+		t1 = os_monotonic_get_ns();                                                                            \
+		durations[OP] = t1 - t0;                                                                               \
+		if (OP != LOAD_OP_WAIT_FRAME) {                                                                        \
+			durations[LOAD_OP_FRAME] += t1 - t0;                                                           \
+		}                                                                                                      \
+		if (xret != XRT_SUCCESS) {                                                                             \
+			return xret;                                                                                   \
+		}                                                                                                      \
+	} while (false)
+
+	// Includes sleeping until the wake up time, so not counted in the frame.
+	TIMED(LOAD_OP_WAIT_FRAME,
+	      xrt_comp_wait_frame(xc, &frame_id, &predicted_display_time_ns, &predicted_display_period_ns));
+	TIMED(LOAD_OP_BEGIN, xrt_comp_begin_frame(xc, frame_id));
+	TIMED(LOAD_OP_POSES, do_poses(lc, predicted_display_time_ns));
+	TIMED(LOAD_OP_SYNC_ACTIONS, do_sync_actions(lc));
+	TIMED(LOAD_OP_LAYER_COMMIT, do_layer_commit(lc, frame_id, predicted_display_time_ns));
+
+#undef TIMED
+
+	return XRT_SUCCESS;
+}
+
+static void *
+client_thread(void *ptr)
+{
+	struct load_client *lc = (struct load_client *)ptr;
+
+	struct xrt_session_info xsi = XRT_STRUCT_INIT;
+	lc->xret = xrt_syscomp_create_native_compositor(lc->xsysc, &xsi, &lc->xcn);
+	if (lc->xret != XRT_SUCCESS) {
+		return NULL;
+	}
+
+	struct xrt_begin_session_info begin_info = {
+	    .view_type = XRT_VIEW_TYPE_STEREO,
+	};
+	lc->xret = xrt_comp_begin_session(&lc->xcn->base, &begin_info);
+	if (lc->xret != XRT_SUCCESS) {
+		return NULL;
+	}
+
+	uint64_t start_ns = os_monotonic_get_ns();
+	uint64_t start_cpu_ns = thread_cpu_time_ns();
+
+	for (uint32_t i = 0; i < lc->settings->frame_count; i++) {
+		uint64_t durations[LOAD_OP_COUNT] = {0};
+
+		lc->xret = do_frame(lc, durations);
+		if (lc->xret != XRT_SUCCESS) {
+			break;
+		}
+
+		for (uint32_t op = 0; op < LOAD_OP_COUNT; op++) {
+			lc->samples[op][i] = durations[op];
+		}
+		lc->frames_done++;
+	}
+
+	lc->cpu_ns = thread_cpu_time_ns() - start_cpu_ns;
+	lc->wall_ns = os_monotonic_get_ns() - start_ns;
+
+	xrt_comp_end_session(&lc->xcn->base);
+
+	return NULL;
+}
+
+
+/*
+ *
+ * In-process server.
+ *
+ */
+
+#ifdef XRT_MODULE_COMPOSITOR_NULL
+static struct os_thread server_thread;
+
+static void *
+run_server(void *ptr)
+{
+	char *argv[] = {"monado-ipc-load", NULL};
+	ipc_server_main(1, argv);
+	return NULL;
+}
+
+static int
+start_server(void)
+{
+	// Read by the server when it starts, no GPU or display needed.
+	setenv("XRT_COMPOSITOR_NULL", "1", 1);
+	// Makes the server exit once the load clients disconnect.
+	setenv("IPC_EXIT_ON_DISCONNECT", "1", 1);
+
+	os_thread_init(&server_thread);
+	return os_thread_start(&server_thread, run_server, NULL);
+}
+
+static void
+stop_server(void)
+{
+	// Stops once the clients have disconnected.
+	os_thread_join(&server_thread);
+	os_thread_destroy(&server_thread);
+}
+#endif
+
+static xrt_result_t
+connect_client(struct load_client *lc, uint32_t index, bool wait_for_server)
+{
+	struct xrt_instance_info info = {0};
+	snprintf(info.application_name, sizeof(info.application_name), "monado-ipc-load-%u", index);
+
+	xrt_result_t xret = ipc_instance_create(&info, &lc->xinst);
+
+	// Keep trying while the server is starting up.
+	for (uint32_t ms = 0; wait_for_server && xret != XRT_SUCCESS && ms < SERVER_START_TIMEOUT_MS; ms += 10) {
+		os_nanosleep(10 * U_TIME_1MS_IN_NS);
+		xret = ipc_instance_create(&info, &lc->xinst);
+	}
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	return xrt_instance_create_system(lc->xinst, &lc->xsysd, &lc->xso, &lc->xsysc);
+}
+
+static void
+disconnect_client(struct load_client *lc)
+{
+	xrt_comp_native_destroy(&lc->xcn);
+	xrt_syscomp_destroy(&lc->xsysc);
+	xrt_space_overseer_destroy(&lc->xso);
+	xrt_system_devices_destroy(&lc->xsysd);
+
+	// Closes the connection.
+	xrt_instance_destroy(&lc->xinst);
+}
+
+
+/*
+ *
+ * Reporting.
+ *
+ */
+
+static void
+print_report(struct load_client *clients, const struct load_settings *settings)
+{
+	uint32_t total_frames = 0;
+	uint64_t max_wall_ns = 0;
+
+	P("\nPer client:\n");
+	P("%6s %8s %10s %10s %10s %10s %12s %12s %14s\n", "Client", "Frames", "Frames/s", "p50 (us)", "p99 (us)",
+	  "p99.9 (us)", "Max (us)", "CPU (ms)", "CPU/frame (us)");
+
+	for (uint32_t i = 0; i < settings->client_count; i++) {
+		struct load_client *lc = &clients[i];
+		uint32_t count = lc->frames_done;
+		uint64_t *frame = lc->samples[LOAD_OP_FRAME];
+
+		for (uint32_t op = 0; op < LOAD_OP_COUNT; op++) {
+			qsort(lc->samples[op], count, sizeof(uint64_t), compare_u64);
+		}
+
+		double seconds = (double)lc->wall_ns / (double)U_TIME_1S_IN_NS;
+		P("%6u %8u %10.1f %10.1f %10.1f %10.1f %12.1f %12.1f %14.1f\n", //
+		  i,                                                              //
+		  count,                                                          //
+		  seconds > 0.0 ? (double)count / seconds : 0.0,                  //
+		  to_us(percentile(frame, count, 0.5)),                           //
+		  to_us(percentile(frame, count, 0.99)),                          //
+		  to_us(percentile(frame, count, 0.999)),                         //
+		  to_us(count > 0 ? frame[count - 1] : 0),                        //
+		  (double)lc->cpu_ns / (double)U_TIME_1MS_IN_NS,                  //
+		  count > 0 ? to_us(lc->cpu_ns / count) : 0.0);                   //
+
+		if (lc->xret != XRT_SUCCESS) {
+			PE("\tclient %u stopped early: %d\n", i, lc->xret);
+		}
+
+		total_frames += count;
+		if (lc->wall_ns > max_wall_ns) {
+			max_wall_ns = lc->wall_ns;
+		}
+	}
+
+	// All clients merged, per operation.
+	uint64_t *merged = U_TYPED_ARRAY_CALLOC(uint64_t, total_frames > 0 ? total_frames : 1);
+
+	P("\nAll clients:\n");
+	P("%-22s %10s %10s %10s %10s %12s\n", "Operation", "Avg (us)", "p50 (us)", "p99 (us)", "p99.9 (us)",
+	  "Max (us)");
+
+	for (uint32_t op = 0; op < LOAD_OP_COUNT; op++) {
+		uint32_t count = 0;
+		uint64_t sum = 0;
+		for (uint32_t i = 0; i < settings->client_count; i++) {
+			for (uint32_t k = 0; k < clients[i].frames_done; k++) {
+				merged[count++] = clients[i].samples[op][k];
+				sum += clients[i].samples[op][k];
+			}
+		}
+
+		qsort(merged, count, sizeof(uint64_t), compare_u64);
+
+		P("%-22s %10.1f %10.1f %10.1f %10.1f %12.1f\n",        //
+		  load_op_names[op],                                     //
+		  count > 0 ? to_us(sum / count) : 0.0,                  //
+		  to_us(percentile(merged, count, 0.5)),                 //
+		  to_us(percentile(merged, count, 0.99)),                //
+		  to_us(percentile(merged, count, 0.999)),               //
+		  to_us(count > 0 ? merged[count - 1] : 0));             //
+	}
+
+	free(merged);
+
+	double seconds = (double)max_wall_ns / (double)U_TIME_1S_IN_NS;
+	P("\nTotal: %u frames in %.2fs, %.1f frames/s\n", total_frames, seconds,
+	  seconds > 0.0 ? (double)total_frames / seconds : 0.0);
+}
+
+
+/*
+ *
+ * Main.
+ *
+ */
+
+static void
+print_usage(void)
+{
+	PE("Usage: monado-ipc-load [options]\n");
+	PE("    -c <count>: Number of clients, default 1, max %u\n", IPC_MAX_CLIENTS);
+	PE("    -n <count>: Frames per client, default 1000\n");
+#ifdef XRT_MODULE_COMPOSITOR_NULL
+	PE("    -i: Start a server with the null compositor in this process\n");
+#endif
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct load_settings settings = {
+	    .client_count = 1,
+	    .frame_count = 1000,
+	};
+
+	// parse arguments
+	int c;
+
+	opterr = 0;
+	while ((c = getopt(argc, argv, "c:n:ih")) != -1) {
+		switch (c) {
+		case 'c': settings.client_count = (uint32_t)atoi(optarg); break;
+		case 'n': settings.frame_count = (uint32_t)atoi(optarg); break;
+		case 'i': settings.in_process = true; break;
+		case 'h': print_usage(); exit(0);
+		case '?':
+			if (optopt == 'c' || optopt == 'n') {
+				PE("Option -%c requires a count.\n", optopt);
+			} else if (isprint(optopt)) {
+				PE("Option `-%c' unknown.\n", optopt);
+				print_usage();
+			} else {
+				PE("Option `\\x%x' unknown.\n", optopt);
+			}
+			exit(1);
+		default: exit(0);
+		}
+	}
+
+	if (settings.client_count == 0 || settings.client_count > IPC_MAX_CLIENTS || settings.frame_count == 0) {
+		print_usage();
+		exit(1);
+	}
+
+#ifdef XRT_MODULE_COMPOSITOR_NULL
+	if (settings.in_process && start_server() != 0) {
+		PE("Failed to start the in-process server.\n");
+		exit(1);
+	}
+#else
+	if (settings.in_process) {
+		PE("The null compositor is not compiled in, can't start a in-process server.\n");
+		exit(1);
+	}
+#endif
+
+	struct load_client *clients = U_TYPED_ARRAY_CALLOC(struct load_client, settings.client_count);
+
+	int ret = 0;
+	uint32_t connected = 0;
+	for (uint32_t i = 0; i < settings.client_count; i++) {
+		struct load_client *lc = &clients[i];
+		lc->settings = &settings;
+
+		for (uint32_t op = 0; op < LOAD_OP_COUNT; op++) {
+			lc->samples[op] = U_TYPED_ARRAY_CALLOC(uint64_t, settings.frame_count);
+		}
+
+		xrt_result_t xret = connect_client(lc, i, settings.in_process && i == 0);
+		if (xret != XRT_SUCCESS) {
+			PE("Failed to connect client %u: %d\n", i, xret);
+			disconnect_client(lc);
+			ret = 1;
+			break;
+		}
+
+		connected++;
+	}
+
+	if (ret == 0) {
+		P("Running %u client(s) for %u frame(s).\n", settings.client_count, settings.frame_count);
+
+		// Start everybody before joining so the load overlaps.
+		for (uint32_t i = 0; i < settings.client_count; i++) {
+			os_thread_init(&clients[i].thread);
+			if (os_thread_start(&clients[i].thread, client_thread, &clients[i]) != 0) {
+				PE("Failed to start the thread of client %u.\n", i);
+				os_thread_destroy(&clients[i].thread);
+				ret = 1;
+				break;
+			}
+			clients[i].thread_started = true;
+		}
+		for (uint32_t i = 0; i < settings.client_count; i++) {
+			if (!clients[i].thread_started) {
+				continue;
+			}
+			os_thread_join(&clients[i].thread);
+			os_thread_destroy(&clients[i].thread);
+		}
+
+		if (ret == 0) {
+			print_report(clients, &settings);
+		}
+	}
+
+	// Only disconnect once everybody is done, the in-process server stops on disconnect.
+	for (uint32_t i = 0; i < connected; i++) {
+		disconnect_client(&clients[i]);
+	}
+
+#ifdef XRT_MODULE_COMPOSITOR_NULL
+	if (settings.in_process) {
+		stop_server();
+	}
+#endif
+
+	for (uint32_t i = 0; i < settings.client_count; i++) {
+		for (uint32_t op = 0; op < LOAD_OP_COUNT; op++) {
+			free(clients[i].samples[op]);
+		}
+	}
+	free(clients);
+
+	return ret;
+}
@@ -17,6 +17,8 @@
 #include "util/u_logging.h"
 
 #include "shared/ipc_protocol.h"
+#include "shared/ipc_call_stats.h"
+#include "shared/ipc_shared_layout.h"
 
 #include "client/ipc_client_connection.h"
 #include "client/ipc_client.h"
@@ -36,6 +38,12 @@ struct mnd_root
 
 	/// State of most recent app asked about
 	struct ipc_app_state app_state;
+
+	//! Call stats of the most recent client asked about.
+	struct ipc_call_stats call_stats;
+
+	//! Most recently fetched compositor frame timings.
+	struct ipc_compositor_timings frame_timings;
 };
 
 #define P(...) fprintf(stdout, __VA_ARGS__)
@@ -295,7 +303,7 @@ mnd_root_get_device_info(mnd_root_t *root, uint32_t device_index, uint32_t *out_
 		return MND_ERROR_INVALID_VALUE;
 	}
 
-	const struct ipc_shared_device *shared_device = &root->ipc_c.ism->isdevs[device_index];
+	const struct ipc_shared_device *shared_device = ipc_shared_isdev(root->ipc_c.ism, device_index);
 	*out_device_id = shared_device->name;
 	*out_dev_name = shared_device->str;
 
@@ -334,3 +342,130 @@ mnd_root_get_device_from_role(mnd_root_t *root, const char *role_name, int32_t *
 	PE("Invalid role name (%s)", role_name);
 	return MND_ERROR_INVALID_VALUE;
 }
+
+mnd_result_t
+mnd_root_update_call_stats(mnd_root_t *root, uint32_t client_id)
+{
+	CHECK_NOT_NULL(root);
+
+	xrt_result_t r = ipc_client_connection_get_call_stats(&root->ipc_c, client_id, &root->call_stats);
+	if (r != XRT_SUCCESS) {
+		PE("Failed to get call stats for client id: %u.\n", client_id);
+		return MND_ERROR_OPERATION_FAILED;
+	}
+
+	return MND_SUCCESS;
+}
+
+mnd_result_t
+mnd_root_get_call_stats_count(mnd_root_t *root, uint32_t *out_count)
+{
+	CHECK_NOT_NULL(root);
+	CHECK_NOT_NULL(out_count);
+
+	// Skip IPC_ERR.
+	*out_count = IPC_COMMAND_COUNT - 1;
+
+	return MND_SUCCESS;
+}
+
+mnd_result_t
+mnd_root_get_call_stats(mnd_root_t *root,
+                        uint32_t index,
+                        const char **out_name,
+                        uint64_t *out_count,
+                        uint64_t *out_bytes,
+                        uint64_t *out_p50_ns,
+                        uint64_t *out_p99_ns,
+                        uint64_t *out_max_ns)
+{
+	CHECK_NOT_NULL(root);
+	CHECK_NOT_NULL(out_name);
+	CHECK_NOT_NULL(out_count);
+	CHECK_NOT_NULL(out_bytes);
+	CHECK_NOT_NULL(out_p50_ns);
+	CHECK_NOT_NULL(out_p99_ns);
+	CHECK_NOT_NULL(out_max_ns);
+
+	if (index >= IPC_COMMAND_COUNT - 1) {
+		PE("Invalid call stats index (%u)", index);
+		return MND_ERROR_INVALID_VALUE;
+	}
+
+	// Skip IPC_ERR.
+	uint32_t command = index + 1;
+	const struct ipc_call_stat *stat = &root->call_stats.calls[command];
+
+	*out_name = ipc_cmd_to_str((ipc_command_t)command);
+	*out_count = stat->count;
+	*out_bytes = stat->bytes;
+	*out_p50_ns = ipc_call_stat_percentile_ns(stat, 0.5);
+	*out_p99_ns = ipc_call_stat_percentile_ns(stat, 0.99);
+	*out_max_ns = stat->max_ns;
+
+	return MND_SUCCESS;
+}
+
+mnd_result_t
+mnd_root_update_frame_timings(mnd_root_t *root, int64_t from_frame_id, int64_t *out_next_frame_id)
+{
+	CHECK_NOT_NULL(root);
+	CHECK_NOT_NULL(out_next_frame_id);
+
+	xrt_result_t r = ipc_call_system_get_compositor_timings(&root->ipc_c, from_frame_id, &root->frame_timings);
+	if (r != XRT_SUCCESS) {
+		PE("Failed to get compositor frame timings.\n");
+		return MND_ERROR_OPERATION_FAILED;
+	}
+
+	*out_next_frame_id = root->frame_timings.next_frame_id;
+
+	return MND_SUCCESS;
+}
+
+mnd_result_t
+mnd_root_get_frame_timing_count(mnd_root_t *root, uint32_t *out_count)
+{
+	CHECK_NOT_NULL(root);
+	CHECK_NOT_NULL(out_count);
+
+	*out_count = root->frame_timings.record_count;
+
+	return MND_SUCCESS;
+}
+
+mnd_result_t
+mnd_root_get_frame_timing(mnd_root_t *root, uint32_t index, mnd_frame_timing_t *out_timing)
+{
+	CHECK_NOT_NULL(root);
+	CHECK_NOT_NULL(out_timing);
+
+	if (index >= root->frame_timings.record_count) {
+		PE("Invalid frame timing index (%u)", index);
+		return MND_ERROR_INVALID_VALUE;
+	}
+
+	const struct ipc_frame_timing_record *rec = &root->frame_timings.records[index];
+
+	uint32_t flags = 0;
+	if ((rec->flags & IPC_FRAME_TIMING_PRESENT_INFO) != 0) {
+		flags |= MND_FRAME_TIMING_PRESENT_INFO;
+	}
+	if ((rec->flags & IPC_FRAME_TIMING_MISSED) != 0) {
+		flags |= MND_FRAME_TIMING_MISSED;
+	}
+
+	out_timing->frame_id = rec->frame_id;
+	out_timing->flags = flags;
+	out_timing->desired_present_time_ns = rec->desired_present_time_ns;
+	out_timing->predicted_display_time_ns = rec->predicted_display_time_ns;
+	out_timing->when_woke_ns = rec->when_woke_ns;
+	out_timing->when_began_ns = rec->when_began_ns;
+	out_timing->when_submitted_ns = rec->when_submitted_ns;
+	out_timing->gpu_start_ns = rec->gpu_start_ns;
+	out_timing->gpu_end_ns = rec->gpu_end_ns;
+	out_timing->actual_present_time_ns = rec->actual_present_time_ns;
+	out_timing->actual_display_time_ns = rec->actual_display_time_ns;
+
+	return MND_SUCCESS;
+}
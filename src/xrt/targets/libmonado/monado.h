@@ -24,7 +24,7 @@ extern "C" {
 //! Major version of the API.
 #define MND_API_VERSION_MAJOR 1
 //! Minor version of the API.
-#define MND_API_VERSION_MINOR 0
+#define MND_API_VERSION_MINOR 2
 //! Patch version of the API.
 #define MND_API_VERSION_PATCH 0
 
@@ -54,6 +54,37 @@ typedef enum mnd_client_flags
 	MND_CLIENT_IO_ACTIVE = (1u << 5u),
 } mnd_client_flags_t;
 
+/*!
+ * Bitflags for compositor frame timings.
+ */
+typedef enum mnd_frame_timing_flags
+{
+	//! The actual present and display times come from the display.
+	MND_FRAME_TIMING_PRESENT_INFO = (1u << 0u),
+	//! The frame was presented after the desired present time.
+	MND_FRAME_TIMING_MISSED = (1u << 1u),
+} mnd_frame_timing_flags_t;
+
+/*!
+ * Timing of one compositor frame, all times are in nanoseconds on the
+ * monotonic clock of the service, times that are not known are zero.
+ */
+typedef struct mnd_frame_timing
+{
+	int64_t frame_id;
+	//! Bitmask of @ref mnd_frame_timing_flags.
+	uint32_t flags;
+	uint64_t desired_present_time_ns;
+	uint64_t predicted_display_time_ns;
+	uint64_t when_woke_ns;
+	uint64_t when_began_ns;
+	uint64_t when_submitted_ns;
+	uint64_t gpu_start_ns;
+	uint64_t gpu_end_ns;
+	uint64_t actual_present_time_ns;
+	uint64_t actual_display_time_ns;
+} mnd_frame_timing_t;
+
 /*!
  * Opaque type for libmonado state
  */
@@ -241,6 +272,108 @@ mnd_root_get_device_info(mnd_root_t *root, uint32_t device_index, uint32_t *out_
 mnd_result_t
 mnd_root_get_device_from_role(mnd_root_t *root, const char *role_name, int32_t *out_device_id);
 
+/*!
+ * Update our local cached copy of the IPC call stats of a client.
+ *
+ * @param root      The libmonado state.
+ * @param client_id ID of the client to get the stats of, zero for all
+ *                  clients together since the service started.
+ *
+ * @return MND_SUCCESS on success
+ */
+mnd_result_t
+mnd_root_update_call_stats(mnd_root_t *root, uint32_t client_id);
+
+/*!
+ * Get the number of IPC commands that there are call stats for, not all of
+ * them might have been called.
+ *
+ * @param root           The libmonado state.
+ * @param[out] out_count Pointer to value to populate with the number of commands.
+ *
+ * @return MND_SUCCESS on success
+ */
+mnd_result_t
+mnd_root_get_call_stats_count(mnd_root_t *root, uint32_t *out_count);
+
+/*!
+ * Get the call stats of the IPC command at the given index, latencies are
+ * estimated from a power of two histogram, the max is exact.
+ *
+ * This result only changes on calls to @ref mnd_root_update_call_stats
+ *
+ * @param root            The libmonado state.
+ * @param index           Index of the command, less than the count.
+ * @param[out] out_name   Pointer to populate with the command name.
+ * @param[out] out_count  Pointer to populate with the number of calls.
+ * @param[out] out_bytes  Pointer to populate with the bytes sent and received.
+ * @param[out] out_p50_ns Pointer to populate with the median latency.
+ * @param[out] out_p99_ns Pointer to populate with the 99th percentile latency.
+ * @param[out] out_max_ns Pointer to populate with the max latency.
+ *
+ * @pre Called @ref mnd_root_update_call_stats at least once
+ *
+ * @return MND_SUCCESS on success
+ */
+mnd_result_t
+mnd_root_get_call_stats(mnd_root_t *root,
+                        uint32_t index,
+                        const char **out_name,
+                        uint64_t *out_count,
+                        uint64_t *out_bytes,
+                        uint64_t *out_p50_ns,
+                        uint64_t *out_p99_ns,
+                        uint64_t *out_max_ns);
+
+
+/*!
+ * Update our local cached copy of the compositor frame timings, gets the
+ * timings of frames with a frame id of at least @p from_frame_id. Only frames
+ * that the service considers settled are returned, and only a limited number
+ * at a time, so to stream the timings keep calling this function with the
+ * frame id from @p out_next_frame_id.
+ *
+ * @param root                   The libmonado state.
+ * @param from_frame_id          First frame id to get, zero for the oldest
+ *                               frame still kept by the service.
+ * @param[out] out_next_frame_id Pointer to populate with the frame id to pass
+ *                               in on the next call.
+ *
+ * @return MND_SUCCESS on success
+ */
+mnd_result_t
+mnd_root_update_frame_timings(mnd_root_t *root, int64_t from_frame_id, int64_t *out_next_frame_id);
+
+/*!
+ * Get the number of frame timings in our local cached copy.
+ *
+ * @param root           The libmonado state.
+ * @param[out] out_count Pointer to value to populate with the number of frame timings.
+ *
+ * @pre Called @ref mnd_root_update_frame_timings at least once
+ *
+ * @return MND_SUCCESS on success
+ */
+mnd_result_t
+mnd_root_get_frame_timing_count(mnd_root_t *root, uint32_t *out_count);
+
+/*!
+ * Get the frame timing at the given index of our local cached copy, the
+ * frame timings are in frame id order.
+ *
+ * This result only changes on calls to @ref mnd_root_update_frame_timings
+ *
+ * @param root            The libmonado state.
+ * @param index           Index of the frame timing, less than the count.
+ * @param[out] out_timing Pointer to populate with the frame timing.
+ *
+ * @pre Called @ref mnd_root_update_frame_timings at least once
+ *
+ * @return MND_SUCCESS on success
+ */
+mnd_result_t
+mnd_root_get_frame_timing(mnd_root_t *root, uint32_t index, mnd_frame_timing_t *out_timing);
+
 
 #ifdef __cplusplus
 }
@@ -583,6 +583,9 @@ sdl_compositor_init(struct sdl_program *sp)
 	c->base.base.base.create_swapchain = sdl_swapchain_create;
 	c->base.base.base.import_swapchain = sdl_swapchain_import;
 
+	// Our swapchains aren't keyed by owner, make everything use the above.
+	c->base.base.create_owned_swapchain = NULL;
+
 
 	/*
 	 * Main init sequence.
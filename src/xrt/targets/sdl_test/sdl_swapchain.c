@@ -101,6 +101,7 @@ sdl_swapchain_create(struct xrt_compositor *xc,
 	    really_destroy,                //
 	    &sp->c.base.vk,                //
 	    &sp->c.base.cscs,              //
+	    0,                             //
 	    info,                          //
 	    &xsccp);                       //
 	if (xret != XRT_SUCCESS) {
@@ -0,0 +1,290 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Distortion mesh tests, batched distortion against the single point functions.
+ */
+
+#include "util/u_distortion_mesh.h"
+
+#include "catch/catch.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+// Not a multiple of the lane count, so the tail is tested too.
+constexpr uint32_t kPointCount = 13 * 13;
+
+std::vector<xrt_vec2>
+make_points()
+{
+	std::vector<xrt_vec2> uvs;
+	for (uint32_t y = 0; y < 13; y++) {
+		for (uint32_t x = 0; x < 13; x++) {
+			uvs.push_back({x / 12.0f, y / 12.0f});
+		}
+	}
+	return uvs;
+}
+
+void
+check_triplet(const xrt_uv_triplet &a, const xrt_uv_triplet &b)
+{
+	CHECK(a.r.x == Approx(b.r.x).margin(1e-6));
+	CHECK(a.r.y == Approx(b.r.y).margin(1e-6));
+	CHECK(a.g.x == Approx(b.g.x).margin(1e-6));
+	CHECK(a.g.y == Approx(b.g.y).margin(1e-6));
+	CHECK(a.b.x == Approx(b.b.x).margin(1e-6));
+	CHECK(a.b.y == Approx(b.b.y).margin(1e-6));
+}
+
+u_vive_values
+make_vive_values()
+{
+	u_vive_values values = {};
+	values.aspect_x_over_y = 0.9f;
+	values.grow_for_undistort = 0.5f;
+	values.undistort_r2_cutoff = 1.1f;
+	for (int i = 0; i < 3; i++) {
+		values.center[i] = {0.02f * i, -0.01f * i};
+		values.coefficients[i][0] = 0.2f + 0.01f * i;
+		values.coefficients[i][1] = 0.05f;
+		values.coefficients[i][2] = -0.01f;
+		values.coefficients[i][3] = 0.001f * i;
+	}
+	return values;
+}
+
+u_panotools_values
+make_panotools_values()
+{
+	u_panotools_values values = {};
+	values.distortion_k[0] = 1.0f;
+	values.distortion_k[1] = 0.02f;
+	values.distortion_k[2] = 0.2f;
+	values.distortion_k[3] = -0.05f;
+	values.distortion_k[4] = 0.01f;
+	values.aberration_k[0] = 0.99f;
+	values.aberration_k[1] = 1.0f;
+	values.aberration_k[2] = 1.01f;
+	values.scale = 0.06f;
+	values.lens_center = {0.06f, 0.035f};
+	values.viewport_size = {0.12f, 0.07f};
+	return values;
+}
+
+u_cardboard_distortion_values
+make_cardboard_values()
+{
+	u_cardboard_distortion_values values = {};
+	values.distortion_k[0] = 0.3f;
+	values.distortion_k[1] = 0.1f;
+	values.screen.size = {1.2f, 1.4f};
+	values.screen.offset = {0.6f, 0.7f};
+	values.texture.size = {1.5f, 1.7f};
+	values.texture.offset = {0.75f, 0.85f};
+	return values;
+}
+
+/*!
+ * Checks every count up to three batches, so the last batch is partial for
+ * all but the multiples of the lane count. Results past the count must not
+ * be written.
+ */
+template <typename Values, typename Single, typename Batch>
+void
+check_partial_batches(Values values, Single single, Batch batch)
+{
+	const std::vector<xrt_vec2> uvs = make_points();
+	const xrt_uv_triplet sentinel = {{-7.0f, -7.0f}, {-7.0f, -7.0f}, {-7.0f, -7.0f}};
+
+	for (uint32_t count = 1; count <= 3 * U_DISTORTION_BATCH_LANES; count++) {
+		CAPTURE(count);
+
+		std::vector<xrt_uv_triplet> results(count + U_DISTORTION_BATCH_LANES, sentinel);
+		REQUIRE(batch(&values, count, uvs.data(), results.data()));
+
+		xrt_uv_triplet expected = {};
+		for (uint32_t i = 0; i < count; i++) {
+			single(&values, uvs[i].x, uvs[i].y, &expected);
+			check_triplet(results[i], expected);
+		}
+		for (uint32_t i = count; i < results.size(); i++) {
+			check_triplet(results[i], sentinel);
+		}
+	}
+}
+
+struct FakeHmd
+{
+	xrt_device xdev = {};
+	xrt_hmd_parts hmd = {};
+	u_vive_values values = make_vive_values();
+
+	//! Fail for any point with u larger than this.
+	float fail_above_u = 2.0f;
+
+	std::atomic<int> in_flight{0};
+	std::atomic<int> max_in_flight{0};
+
+	FakeHmd()
+	{
+		xdev.hmd = &hmd;
+		xdev.compute_distortion = compute_distortion;
+	}
+
+	~FakeHmd()
+	{
+		free(hmd.distortion.mesh.vertices);
+		free(hmd.distortion.mesh.indices);
+	}
+
+	static FakeHmd *
+	from(xrt_device *xdev)
+	{
+		return reinterpret_cast<FakeHmd *>(xdev);
+	}
+
+	static bool
+	compute_distortion(xrt_device *xdev, uint32_t view, float u, float v, xrt_uv_triplet *result)
+	{
+		FakeHmd *f = from(xdev);
+
+		int current = ++f->in_flight;
+		int max = f->max_in_flight;
+		while (current > max && !f->max_in_flight.compare_exchange_weak(max, current)) {
+		}
+
+		// Give other threads a chance to overlap with this call.
+		std::this_thread::yield();
+		f->in_flight--;
+
+		if (u > f->fail_above_u) {
+			return false;
+		}
+		return u_compute_distortion_vive(&f->values, u, v, result);
+	}
+
+	static bool
+	compute_distortion_batch(
+	    xrt_device *xdev, uint32_t view, uint32_t count, const xrt_vec2 *uvs, xrt_uv_triplet *results)
+	{
+		return u_compute_distortion_vive_batch(&from(xdev)->values, count, uvs, results);
+	}
+};
+
+} // namespace
+
+
+TEST_CASE("u_compute_distortion_batch")
+{
+	std::vector<xrt_vec2> uvs = make_points();
+	std::vector<xrt_uv_triplet> results(kPointCount);
+	xrt_uv_triplet expected = {};
+
+	SECTION("Vive")
+	{
+		u_vive_values values = make_vive_values();
+		REQUIRE(u_compute_distortion_vive_batch(&values, kPointCount, uvs.data(), results.data()));
+		for (uint32_t i = 0; i < kPointCount; i++) {
+			u_compute_distortion_vive(&values, uvs[i].x, uvs[i].y, &expected);
+			check_triplet(results[i], expected);
+		}
+	}
+
+	SECTION("Panotools")
+	{
+		u_panotools_values values = make_panotools_values();
+		REQUIRE(u_compute_distortion_panotools_batch(&values, kPointCount, uvs.data(), results.data()));
+		for (uint32_t i = 0; i < kPointCount; i++) {
+			u_compute_distortion_panotools(&values, uvs[i].x, uvs[i].y, &expected);
+			check_triplet(results[i], expected);
+		}
+	}
+
+	SECTION("Cardboard")
+	{
+		u_cardboard_distortion_values values = make_cardboard_values();
+		REQUIRE(u_compute_distortion_cardboard_batch(&values, kPointCount, uvs.data(), results.data()));
+		for (uint32_t i = 0; i < kPointCount; i++) {
+			u_compute_distortion_cardboard(&values, uvs[i].x, uvs[i].y, &expected);
+			check_triplet(results[i], expected);
+		}
+	}
+}
+
+TEST_CASE("u_compute_distortion_batch partial last batch")
+{
+	SECTION("Vive")
+	{
+		check_partial_batches(make_vive_values(), u_compute_distortion_vive, u_compute_distortion_vive_batch);
+	}
+
+	SECTION("Panotools")
+	{
+		check_partial_batches(make_panotools_values(), u_compute_distortion_panotools,
+		                      u_compute_distortion_panotools_batch);
+	}
+
+	SECTION("Cardboard")
+	{
+		check_partial_batches(make_cardboard_values(), u_compute_distortion_cardboard,
+		                      u_compute_distortion_cardboard_batch);
+	}
+}
+
+TEST_CASE("u_distortion_mesh_fill_in_compute")
+{
+	FakeHmd single;
+	u_distortion_mesh_fill_in_compute(&single.xdev);
+
+	// Not marked as thread safe, so never called from several threads at once.
+	CHECK(single.max_in_flight == 1);
+
+	const auto &mesh = single.hmd.distortion.mesh;
+	REQUIRE(mesh.vertices != nullptr);
+	REQUIRE(mesh.indices != nullptr);
+	CHECK((single.hmd.distortion.models & XRT_DISTORTION_MODEL_MESHUV) != 0);
+
+	SECTION("Batched matches single points")
+	{
+		// Evaluated on the worker threads.
+		FakeHmd batched;
+		batched.xdev.compute_distortion_batch = FakeHmd::compute_distortion_batch;
+		batched.xdev.compute_distortion_thread_safe = true;
+		u_distortion_mesh_fill_in_compute(&batched.xdev);
+
+		const auto &other = batched.hmd.distortion.mesh;
+		REQUIRE(other.vertex_count == mesh.vertex_count);
+		REQUIRE(other.index_count_total == mesh.index_count_total);
+
+		uint32_t float_count = mesh.vertex_count * mesh.stride / sizeof(float);
+		for (uint32_t i = 0; i < float_count; i++) {
+			CHECK(other.vertices[i] == Approx(mesh.vertices[i]).margin(1e-6));
+		}
+		for (uint32_t i = 0; i < mesh.index_count_total; i++) {
+			CHECK(other.indices[i] == mesh.indices[i]);
+		}
+	}
+
+	SECTION("Failure falls back to no distortion")
+	{
+		FakeHmd failing;
+		failing.fail_above_u = 0.5f;
+		u_distortion_mesh_fill_in_compute(&failing.xdev);
+
+		const auto &other = failing.hmd.distortion.mesh;
+		REQUIRE(other.vertices != nullptr);
+		CHECK(other.vertex_count == 2 * 2 * 2);
+		CHECK((failing.hmd.distortion.models & XRT_DISTORTION_MODEL_NONE) != 0);
+
+		// Compute distortion matches the mesh.
+		CHECK(failing.xdev.compute_distortion == u_distortion_mesh_none);
+		CHECK(failing.xdev.compute_distortion_batch == nullptr);
+	}
+}
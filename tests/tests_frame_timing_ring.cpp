@@ -0,0 +1,233 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Compositor frame timing ring tests.
+ */
+
+#include "util/u_time.h"
+#include "util/u_frame_timing_ring.h"
+
+#include "catch/catch.hpp"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+constexpr uint64_t kPeriodNs = U_TIME_1MS_IN_NS * 10;
+
+uint64_t
+desired_present(int64_t frame_id)
+{
+	return (uint64_t)(frame_id + 1) * kPeriodNs;
+}
+
+//! Same order as the compositor does it.
+void
+write_frame(u_frame_timing_ring *ring, int64_t frame_id, uint64_t late_ns = 0)
+{
+	uint64_t present_ns = desired_present(frame_id);
+	uint64_t wake_ns = present_ns - kPeriodNs / 2;
+
+	u_frame_timing_ring_predicted(ring, frame_id, present_ns, present_ns + U_TIME_1MS_IN_NS);
+	u_frame_timing_ring_mark_point(ring, U_TIMING_POINT_WAKE_UP, frame_id, wake_ns);
+	u_frame_timing_ring_mark_point(ring, U_TIMING_POINT_BEGIN, frame_id, wake_ns + 1);
+	u_frame_timing_ring_mark_point(ring, U_TIMING_POINT_SUBMIT, frame_id, wake_ns + 2);
+	u_frame_timing_ring_gpu(ring, frame_id, wake_ns + 3, wake_ns + 4);
+	u_frame_timing_ring_present(ring, frame_id, present_ns + late_ns, present_ns + late_ns + U_TIME_1MS_IN_NS);
+}
+
+std::vector<u_frame_timing_record>
+read_all(u_frame_timing_ring *ring, int64_t from_frame_id, int64_t *out_next_frame_id)
+{
+	std::vector<u_frame_timing_record> records(U_FRAME_TIMING_RING_SIZE);
+	uint32_t count = u_frame_timing_ring_read(ring, from_frame_id, records.data(), (uint32_t)records.size(),
+	                                          out_next_frame_id);
+	records.resize(count);
+	return records;
+}
+
+} // namespace
+
+
+TEST_CASE("u_frame_timing_ring")
+{
+	// Too big for the stack, and must start out zeroed.
+	std::unique_ptr<u_frame_timing_ring> ring(new u_frame_timing_ring());
+	int64_t next = -1;
+
+	SECTION("Empty")
+	{
+		CHECK(read_all(ring.get(), 0, &next).empty());
+		CHECK(next == 0);
+	}
+
+	SECTION("Only settled frames are returned")
+	{
+		for (int64_t i = 0; i < 20; i++) {
+			write_frame(ring.get(), i);
+		}
+
+		auto records = read_all(ring.get(), 0, &next);
+		REQUIRE(records.size() == 20 - U_FRAME_TIMING_RING_SETTLE_FRAMES);
+		CHECK(next == 20 - U_FRAME_TIMING_RING_SETTLE_FRAMES);
+
+		for (size_t i = 0; i < records.size(); i++) {
+			const u_frame_timing_record &rec = records[i];
+			CHECK(rec.frame_id == (int64_t)i);
+			CHECK(rec.desired_present_time_ns == desired_present(rec.frame_id));
+			CHECK(rec.when_began_ns == rec.when_woke_ns + 1);
+			CHECK(rec.when_submitted_ns == rec.when_woke_ns + 2);
+			CHECK(rec.gpu_end_ns == rec.when_woke_ns + 4);
+			CHECK(rec.actual_present_time_ns == rec.desired_present_time_ns);
+			CHECK(rec.flags == U_FRAME_TIMING_PRESENT_INFO);
+		}
+
+		// Nothing new until more frames settle.
+		CHECK(read_all(ring.get(), next, &next).empty());
+		write_frame(ring.get(), 20);
+		records = read_all(ring.get(), next, &next);
+		REQUIRE(records.size() == 1);
+		CHECK(records[0].frame_id == 20 - U_FRAME_TIMING_RING_SETTLE_FRAMES);
+	}
+
+	SECTION("Limited count continues where it stopped")
+	{
+		for (int64_t i = 0; i < 40; i++) {
+			write_frame(ring.get(), i);
+		}
+
+		u_frame_timing_record records[10];
+		CHECK(u_frame_timing_ring_read(ring.get(), 0, records, 10, &next) == 10);
+		CHECK(records[9].frame_id == 9);
+		CHECK(next == 10);
+		CHECK(u_frame_timing_ring_read(ring.get(), next, records, 10, &next) == 10);
+		CHECK(records[0].frame_id == 10);
+	}
+
+	SECTION("Missed frames are flagged")
+	{
+		for (int64_t i = 0; i < 20; i++) {
+			write_frame(ring.get(), i, i == 3 ? kPeriodNs : 0);
+		}
+
+		auto records = read_all(ring.get(), 0, &next);
+		REQUIRE(records.size() > 3);
+		CHECK((records[2].flags & U_FRAME_TIMING_MISSED) == 0);
+		CHECK((records[3].flags & U_FRAME_TIMING_MISSED) != 0);
+	}
+
+	SECTION("Overwritten frames are skipped")
+	{
+		const int64_t count = U_FRAME_TIMING_RING_SIZE * 2 + 5;
+		for (int64_t i = 0; i < count; i++) {
+			write_frame(ring.get(), i);
+		}
+
+		// Info for an overwritten frame is dropped.
+		u_frame_timing_ring_gpu(ring.get(), 3, 1, 2);
+
+		auto records = read_all(ring.get(), 0, &next);
+		REQUIRE(records.size() == U_FRAME_TIMING_RING_SIZE - U_FRAME_TIMING_RING_SETTLE_FRAMES);
+		CHECK(records.front().frame_id == count - U_FRAME_TIMING_RING_SIZE);
+		CHECK(records.back().frame_id == count - 1 - U_FRAME_TIMING_RING_SETTLE_FRAMES);
+	}
+
+	SECTION("Reset")
+	{
+		for (int64_t i = 0; i < 100; i++) {
+			write_frame(ring.get(), i);
+		}
+
+		u_frame_timing_ring_reset(ring.get());
+		CHECK(read_all(ring.get(), 0, &next).empty());
+
+		for (int64_t i = 0; i < 20; i++) {
+			write_frame(ring.get(), i);
+		}
+		CHECK(read_all(ring.get(), 0, &next).size() == 20 - U_FRAME_TIMING_RING_SETTLE_FRAMES);
+	}
+
+	SECTION("Reader restarts after reset")
+	{
+		for (int64_t i = 0; i < 100; i++) {
+			write_frame(ring.get(), i);
+		}
+		CHECK(read_all(ring.get(), 0, &next).size() == 100 - U_FRAME_TIMING_RING_SETTLE_FRAMES);
+
+		// Nothing to read right after, and the reader is sent back to the start.
+		u_frame_timing_ring_reset(ring.get());
+		CHECK(read_all(ring.get(), next, &next).empty());
+		CHECK(next == 0);
+
+		for (int64_t i = 0; i < 20; i++) {
+			write_frame(ring.get(), i);
+		}
+
+		auto records = read_all(ring.get(), next, &next);
+		REQUIRE(records.size() == 20 - U_FRAME_TIMING_RING_SETTLE_FRAMES);
+		CHECK(records.front().frame_id == 0);
+		CHECK(next == 20 - U_FRAME_TIMING_RING_SETTLE_FRAMES);
+	}
+
+	SECTION("Reader restarts when ids go backwards")
+	{
+		for (int64_t i = 0; i < 100; i++) {
+			write_frame(ring.get(), i);
+		}
+		read_all(ring.get(), 0, &next);
+
+		// The new pacer got some frames in before the reader came back.
+		u_frame_timing_ring_reset(ring.get());
+		for (int64_t i = 0; i < 20; i++) {
+			write_frame(ring.get(), i);
+		}
+
+		auto records = read_all(ring.get(), next, &next);
+		REQUIRE(records.size() == 20 - U_FRAME_TIMING_RING_SETTLE_FRAMES);
+		CHECK(records.front().frame_id == 0);
+	}
+}
+
+TEST_CASE("u_frame_timing_ring_concurrent")
+{
+	std::unique_ptr<u_frame_timing_ring> ring(new u_frame_timing_ring());
+	std::atomic<bool> torn{false};
+	std::atomic<bool> out_of_order{false};
+	std::atomic<bool> done{false};
+
+	std::thread reader([&] {
+		u_frame_timing_record records[32];
+		int64_t next = 0;
+		int64_t last = -1;
+		while (!done) {
+			uint32_t count = u_frame_timing_ring_read(ring.get(), next, records, 32, &next);
+			for (uint32_t i = 0; i < count; i++) {
+				const u_frame_timing_record &rec = records[i];
+				if (rec.frame_id <= last) {
+					out_of_order = true;
+				}
+				last = rec.frame_id;
+
+				// Every part of the record is written from the frame id.
+				if (rec.desired_present_time_ns != desired_present(rec.frame_id) ||
+				    rec.gpu_end_ns != rec.when_woke_ns + 4) {
+					torn = true;
+				}
+			}
+		}
+	});
+
+	for (int64_t i = 0; i < 200000; i++) {
+		write_frame(ring.get(), i);
+	}
+	done = true;
+	reader.join();
+
+	CHECK_FALSE(torn);
+	CHECK_FALSE(out_of_order);
+}
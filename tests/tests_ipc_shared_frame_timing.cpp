@@ -0,0 +1,99 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Shared memory frame timing slot tests.
+ */
+
+#include "shared/ipc_shared_frame_timing.h"
+
+#include "catch/catch.hpp"
+
+#include <thread>
+
+
+TEST_CASE("ipc_shared_frame_timing")
+{
+	struct ipc_shared_frame_timing isft;
+	ipc_shared_frame_timing_init(&isft);
+	xrt_atomic_s32_t doorbell = 0;
+
+	struct ipc_frame_prediction prediction = {};
+	prediction.frame_id = 7;
+	prediction.wake_up_time_ns = 1000;
+	prediction.predicted_display_time_ns = 2000;
+	prediction.predicted_display_period_ns = 11;
+
+	struct ipc_frame_prediction got = {};
+
+	SECTION("Nothing is published without a request")
+	{
+		CHECK_FALSE(ipc_shared_frame_timing_is_requested(&isft));
+		CHECK_FALSE(ipc_shared_frame_timing_publish(&isft, &prediction));
+	}
+
+	SECTION("Request is answered")
+	{
+		REQUIRE(ipc_shared_frame_timing_request(&isft, &doorbell));
+		CHECK(doorbell == 1);
+
+		// Only one request at a time.
+		CHECK_FALSE(ipc_shared_frame_timing_request(&isft, &doorbell));
+
+		REQUIRE(ipc_shared_frame_timing_is_requested(&isft));
+		REQUIRE(ipc_shared_frame_timing_publish(&isft, &prediction));
+
+		REQUIRE(ipc_shared_frame_timing_wait(&isft, 0, &got));
+		CHECK(got.frame_id == 7);
+		CHECK(got.predicted_display_time_ns == 2000);
+
+		// The slot can be used again.
+		CHECK(ipc_shared_frame_timing_request(&isft, &doorbell));
+	}
+
+	SECTION("Answered from another thread")
+	{
+		REQUIRE(ipc_shared_frame_timing_request(&isft, &doorbell));
+
+		std::thread server([&] {
+			while (!ipc_shared_frame_timing_is_requested(&isft)) {
+				std::this_thread::yield();
+			}
+			ipc_shared_frame_timing_publish(&isft, &prediction);
+		});
+
+		bool taken = ipc_shared_frame_timing_wait(&isft, 5ull * 1000 * 1000 * 1000, &got);
+		server.join();
+
+		REQUIRE(taken);
+		CHECK(got.frame_id == 7);
+	}
+
+	SECTION("Timed out request is withdrawn")
+	{
+		REQUIRE(ipc_shared_frame_timing_request(&isft, &doorbell));
+		CHECK_FALSE(ipc_shared_frame_timing_wait(&isft, 1000, &got));
+
+		// Too late, the server has to retire the frame.
+		CHECK_FALSE(ipc_shared_frame_timing_publish(&isft, &prediction));
+		CHECK(ipc_shared_frame_timing_request(&isft, &doorbell));
+	}
+
+	SECTION("Woke mark")
+	{
+		int64_t frame_id = 0;
+		uint64_t woke_time_ns = 0;
+
+		REQUIRE(ipc_shared_frame_timing_read_woke(&isft, &frame_id, &woke_time_ns));
+		CHECK(frame_id == -1);
+
+		ipc_shared_frame_timing_write_woke(&isft, 7, 1234);
+		REQUIRE(ipc_shared_frame_timing_read_woke(&isft, &frame_id, &woke_time_ns));
+		CHECK(frame_id == 7);
+		CHECK(woke_time_ns == 1234);
+
+		// Mid write.
+		isft.woke_seq++;
+		CHECK_FALSE(ipc_shared_frame_timing_read_woke(&isft, &frame_id, &woke_time_ns));
+	}
+}
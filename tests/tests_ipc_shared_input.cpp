@@ -0,0 +1,329 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Shared input mirroring tests, and a benchmark of a simulated action sync.
+ */
+
+#include "shared/ipc_shared_input.h"
+#include "shared/ipc_utils.h"
+
+#include "catch/catch.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+constexpr uint32_t kInputCount = 16;
+
+void
+fill_inputs(xrt_input *inputs, uint32_t count)
+{
+	// Same padding every time, like the device structs.
+	memset(inputs, 0, sizeof(*inputs) * count);
+	for (uint32_t i = 0; i < count; i++) {
+		inputs[i].name = (xrt_input_name)XRT_INPUT_NAME(i + 1, BOOLEAN);
+		inputs[i].active = true;
+	}
+}
+
+} // namespace
+
+TEST_CASE("ipc_shared_inputs_update")
+{
+	xrt_atomic_s32_t generation = 0;
+	xrt_input src[kInputCount];
+	xrt_input dst[kInputCount];
+	fill_inputs(src, kInputCount);
+	memset(dst, 0, sizeof(dst));
+
+	REQUIRE(ipc_shared_inputs_update(&generation, dst, src, kInputCount, true));
+	CHECK(ipc_shared_inputs_get_generation(&generation) == 2);
+	CHECK(memcmp(dst, src, sizeof(src)) == 0);
+
+	SECTION("Nothing changed")
+	{
+		CHECK_FALSE(ipc_shared_inputs_update(&generation, dst, src, kInputCount, true));
+		CHECK(ipc_shared_inputs_get_generation(&generation) == 2);
+	}
+
+	SECTION("Changed input")
+	{
+		src[3].value.boolean = true;
+		src[3].timestamp = 42;
+
+		CHECK(ipc_shared_inputs_update(&generation, dst, src, kInputCount, true));
+		CHECK(ipc_shared_inputs_get_generation(&generation) == 4);
+		CHECK(dst[3].value.boolean);
+		CHECK(dst[3].timestamp == 42);
+		CHECK(memcmp(dst, src, sizeof(src)) == 0);
+	}
+
+	SECTION("Mirror that differs is repaired")
+	{
+		dst[5].timestamp = 1234;
+
+		CHECK(ipc_shared_inputs_update(&generation, dst, src, kInputCount, true));
+		CHECK(ipc_shared_inputs_get_generation(&generation) == 4);
+		CHECK(dst[5].timestamp == 0);
+	}
+
+	SECTION("IO inactive")
+	{
+		src[0].name = XRT_INPUT_GENERIC_HEAD_POSE;
+		src[1].value.boolean = true;
+		src[1].timestamp = 42;
+
+		CHECK(ipc_shared_inputs_update(&generation, dst, src, kInputCount, false));
+		CHECK(dst[0].name == XRT_INPUT_GENERIC_HEAD_POSE);
+		CHECK(dst[0].active);
+		CHECK(dst[1].name == src[1].name);
+		CHECK_FALSE(dst[1].active);
+		CHECK_FALSE(dst[1].value.boolean);
+		CHECK(dst[1].timestamp == 0);
+
+		int32_t gen = ipc_shared_inputs_get_generation(&generation);
+		CHECK_FALSE(ipc_shared_inputs_update(&generation, dst, src, kInputCount, false));
+		CHECK(ipc_shared_inputs_get_generation(&generation) == gen);
+	}
+}
+
+TEST_CASE("ipc_shared_inputs_read")
+{
+	xrt_atomic_s32_t generation = 0;
+	xrt_input src[kInputCount];
+	xrt_input shared[kInputCount];
+	xrt_input dst[kInputCount];
+	fill_inputs(src, kInputCount);
+	memset(shared, 0, sizeof(shared));
+	memset(dst, 0, sizeof(dst));
+
+	REQUIRE(ipc_shared_inputs_update(&generation, shared, src, kInputCount, true));
+
+	int32_t seen = -1;
+	REQUIRE(ipc_shared_inputs_read(&generation, &seen, dst, shared, kInputCount));
+	CHECK(seen == 2);
+	CHECK(memcmp(dst, src, sizeof(src)) == 0);
+
+	SECTION("Unchanged generation skips the copy")
+	{
+		dst[2].timestamp = 1234;
+
+		CHECK(ipc_shared_inputs_read(&generation, &seen, dst, shared, kInputCount));
+		CHECK(dst[2].timestamp == 1234);
+	}
+
+	SECTION("Changed generation copies")
+	{
+		src[2].timestamp = 42;
+		REQUIRE(ipc_shared_inputs_update(&generation, shared, src, kInputCount, true));
+
+		CHECK(ipc_shared_inputs_read(&generation, &seen, dst, shared, kInputCount));
+		CHECK(seen == 4);
+		CHECK(dst[2].timestamp == 42);
+	}
+
+	SECTION("Fails while the server is writing")
+	{
+		// Odd, as if the server stopped half way through an update.
+		xrt_atomic_s32_inc_return(&generation);
+		src[2].timestamp = 42;
+		shared[2].timestamp = 42;
+
+		CHECK_FALSE(ipc_shared_inputs_read(&generation, &seen, dst, shared, kInputCount));
+		CHECK(seen == 2);
+
+		xrt_atomic_s32_inc_return(&generation);
+
+		CHECK(ipc_shared_inputs_read(&generation, &seen, dst, shared, kInputCount));
+		CHECK(seen == 4);
+		CHECK(memcmp(dst, src, sizeof(src)) == 0);
+	}
+}
+
+
+/*
+ *
+ * Action sync benchmark.
+ *
+ */
+
+namespace {
+
+constexpr uint32_t kDeviceCount = 8;
+
+enum class Mode : uint32_t
+{
+	//! One call per device, the server copies every input.
+	CallFullCopy,
+	//! One call per device, the server only writes changed inputs.
+	CallChangedOnly,
+	//! No calls, the server publishes and the client copies on a new generation.
+	SharedGeneration,
+};
+
+struct Msg
+{
+	uint32_t device_id;
+	uint32_t stop;
+};
+
+struct Reply
+{
+	int32_t result;
+};
+
+/*!
+ * Stands in for the server and the shared memory, the "devices" change one
+ * input every @p change_every updates.
+ */
+struct World
+{
+	ipc_message_channel client = {};
+	ipc_message_channel server = {};
+
+	Mode mode;
+	uint32_t change_every;
+	uint32_t update_count = 0;
+
+	xrt_atomic_s32_t generations[kDeviceCount] = {};
+	xrt_input device_inputs[kDeviceCount][kInputCount];
+	xrt_input shared_inputs[kDeviceCount][kInputCount];
+
+	World(Mode m, uint32_t change_every) : mode(m), change_every(change_every)
+	{
+		int fds[2] = {-1, -1};
+		REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+		client.ipc_handle = fds[0];
+		client.log_level = U_LOGGING_WARN;
+		server.ipc_handle = fds[1];
+		server.log_level = U_LOGGING_WARN;
+
+		for (uint32_t i = 0; i < kDeviceCount; i++) {
+			fill_inputs(device_inputs[i], kInputCount);
+			memset(shared_inputs[i], 0, sizeof(shared_inputs[i]));
+		}
+	}
+
+	~World()
+	{
+		ipc_message_channel_close(&client);
+		ipc_message_channel_close(&server);
+	}
+
+	void
+	update_device(uint32_t device_id)
+	{
+		xrt_input *src = device_inputs[device_id];
+		if (change_every != 0 && ++update_count % change_every == 0) {
+			src[0].timestamp++;
+			src[0].value.boolean = !src[0].value.boolean;
+		}
+
+		if (mode == Mode::CallFullCopy) {
+			memcpy(shared_inputs[device_id], src, sizeof(shared_inputs[device_id]));
+		} else {
+			ipc_shared_inputs_update(&generations[device_id], shared_inputs[device_id], src, kInputCount,
+			                         true);
+		}
+	}
+};
+
+void
+server_loop(World *w)
+{
+	while (true) {
+		Msg msg = {};
+		if (ipc_receive(&w->server, &msg, sizeof(msg)) != XRT_SUCCESS || msg.stop != 0) {
+			return;
+		}
+
+		w->update_device(msg.device_id);
+
+		Reply reply = {XRT_SUCCESS};
+		if (ipc_send(&w->server, &reply, sizeof(reply)) != XRT_SUCCESS) {
+			return;
+		}
+	}
+}
+
+//! Returns the average cost of syncing all devices once, in nanoseconds.
+double
+run(Mode mode, uint32_t change_every, uint32_t sync_count)
+{
+	World w(mode, change_every);
+	int32_t seen[kDeviceCount];
+	xrt_input client_inputs[kDeviceCount][kInputCount];
+	for (uint32_t d = 0; d < kDeviceCount; d++) {
+		seen[d] = -1;
+	}
+
+	std::thread server;
+	if (mode != Mode::SharedGeneration) {
+		server = std::thread(server_loop, &w);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t s = 0; s < sync_count; s++) {
+		for (uint32_t d = 0; d < kDeviceCount; d++) {
+			if (mode == Mode::SharedGeneration) {
+				// Done by the publisher thread in the service, off the sync path.
+				w.update_device(d);
+
+				// Only copied if the generation has changed.
+				xrt_input *src = w.shared_inputs[d];
+				xrt_input *dst = client_inputs[d];
+				ipc_shared_inputs_read(&w.generations[d], &seen[d], dst, src, kInputCount);
+				continue;
+			}
+
+			Msg msg = {d, 0};
+			Reply reply = {};
+			REQUIRE(ipc_send(&w.client, &msg, sizeof(msg)) == XRT_SUCCESS);
+			REQUIRE(ipc_receive(&w.client, &reply, sizeof(reply)) == XRT_SUCCESS);
+		}
+	}
+
+	auto end = std::chrono::steady_clock::now();
+
+	if (server.joinable()) {
+		Msg msg = {0, 1};
+		ipc_send(&w.client, &msg, sizeof(msg));
+		server.join();
+	}
+
+	return std::chrono::duration<double, std::nano>(end - start).count() / sync_count;
+}
+
+} // namespace
+
+// Hidden by default, run with: tests_ipc_shared_input "[benchmark]"
+TEST_CASE("ipc_shared_inputs_sync_benchmark", "[.][benchmark]")
+{
+	const uint32_t sync_count = 5000;
+	const uint32_t change_rates[] = {0, 1, 8, 64};
+
+	std::cout << kDeviceCount << " devices, " << kInputCount << " inputs each (ns per sync)" << std::endl;
+	std::cout << "change every, call + full copy, call + changed only, shared generation" << std::endl;
+	for (uint32_t change_every : change_rates) {
+		double full = run(Mode::CallFullCopy, change_every, sync_count);
+		double changed = run(Mode::CallChangedOnly, change_every, sync_count);
+		double shared = run(Mode::SharedGeneration, change_every, sync_count);
+
+		std::cout << change_every << ", " << (uint64_t)full << ", " << (uint64_t)changed << ", "
+		          << (uint64_t)shared << std::endl;
+
+		CHECK(full > 0.0);
+		CHECK(changed > 0.0);
+		CHECK(shared > 0.0);
+	}
+}
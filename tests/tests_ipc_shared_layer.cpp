@@ -0,0 +1,198 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Layer delta encoding tests, and a benchmark against copying the full slot.
+ */
+
+#include "shared/ipc_shared_layer.h"
+
+#include "catch/catch.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+
+namespace {
+
+ipc_layer_entry
+make_quad(uint32_t image_index, float x)
+{
+	ipc_layer_entry entry;
+	memset(&entry, 0, sizeof(entry));
+	entry.swapchain_ids[0] = 3;
+	entry.swapchain_ids[1] = (uint32_t)-1;
+	entry.swapchain_ids[2] = (uint32_t)-1;
+	entry.swapchain_ids[3] = (uint32_t)-1;
+	entry.data.type = XRT_LAYER_QUAD;
+	entry.data.timestamp = 1000 + image_index;
+	entry.data.quad.sub.image_index = image_index;
+	entry.data.quad.pose.orientation.w = 1.0f;
+	entry.data.quad.pose.position.x = x;
+	entry.data.quad.size.x = 1.0f;
+	entry.data.quad.size.y = 1.0f;
+	return entry;
+}
+
+ipc_layer_entry
+make_projection_depth(uint32_t image_index)
+{
+	ipc_layer_entry entry;
+	memset(&entry, 0, sizeof(entry));
+	entry.data.type = XRT_LAYER_STEREO_PROJECTION_DEPTH;
+	entry.data.timestamp = 1000 + image_index;
+	entry.data.stereo_depth.l.sub.image_index = image_index;
+	entry.data.stereo_depth.r.sub.image_index = image_index + 1;
+	entry.data.stereo_depth.l_d.sub.image_index = image_index + 2;
+	entry.data.stereo_depth.r_d.sub.image_index = image_index + 3;
+	entry.data.stereo_depth.l.pose.position.x = -0.03f * image_index;
+	entry.data.stereo_depth.r.pose.position.x = 0.03f * image_index;
+	entry.data.stereo_depth.l.fov.angle_left = -0.1f * image_index;
+	entry.data.stereo_depth.l_d.far_z = 100.0f;
+	return entry;
+}
+
+} // namespace
+
+TEST_CASE("ipc_shared_layer")
+{
+	SECTION("Quad round trip")
+	{
+		ipc_layer_entry prev = make_quad(0, 1.0f);
+		ipc_layer_entry next = make_quad(1, 2.0f);
+
+		ipc_layer_update update;
+		ipc_shared_layer_get_update(&next, &update);
+		CHECK(update.image_indices[0] == 1);
+		CHECK(update.timestamp == 1001);
+
+		CHECK(ipc_shared_layer_try_update(&prev, &next, &update));
+		CHECK(memcmp(&prev, &next, sizeof(prev)) == 0);
+	}
+
+	SECTION("Projection with depth round trip")
+	{
+		ipc_layer_entry prev = make_projection_depth(0);
+		ipc_layer_entry next = make_projection_depth(4);
+
+		ipc_layer_update update;
+		ipc_shared_layer_get_update(&next, &update);
+		CHECK(update.image_indices[3] == 7);
+
+		CHECK(ipc_shared_layer_try_update(&prev, &next, &update));
+		CHECK(memcmp(&prev, &next, sizeof(prev)) == 0);
+	}
+
+	SECTION("Other changes need a full write")
+	{
+		ipc_layer_entry prev = make_quad(0, 1.0f);
+		ipc_layer_update update;
+
+		ipc_layer_entry resized = make_quad(1, 1.0f);
+		resized.data.quad.size.x = 2.0f;
+		ipc_shared_layer_get_update(&resized, &update);
+		CHECK_FALSE(ipc_shared_layer_try_update(&prev, &resized, &update));
+		CHECK(memcmp(&prev, &resized, sizeof(prev)) == 0);
+
+		ipc_layer_entry other_swapchain = make_quad(1, 1.0f);
+		other_swapchain.swapchain_ids[0] = 4;
+		ipc_shared_layer_get_update(&other_swapchain, &update);
+		CHECK_FALSE(ipc_shared_layer_try_update(&prev, &other_swapchain, &update));
+
+		ipc_layer_entry other_type = make_projection_depth(1);
+		ipc_shared_layer_get_update(&other_type, &update);
+		CHECK_FALSE(ipc_shared_layer_try_update(&prev, &other_type, &update));
+		CHECK(memcmp(&prev, &other_type, sizeof(prev)) == 0);
+	}
+}
+
+
+/*
+ *
+ * Layer sync benchmark.
+ *
+ */
+
+namespace {
+
+/*!
+ * Simulates both sides of a layer sync of @p layer_count quads, returns the
+ * average nanoseconds per frame.
+ */
+double
+run(bool delta, uint32_t layer_count, uint32_t frame_count)
+{
+	std::unique_ptr<ipc_layer_slot> slot(new ipc_layer_slot());
+	std::unique_ptr<ipc_layer_entry[]> sent(new ipc_layer_entry[IPC_MAX_LAYERS]());
+	std::unique_ptr<ipc_layer_entry[]> server(new ipc_layer_entry[IPC_MAX_LAYERS]());
+	volatile uint32_t sink = 0;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t f = 0; f < frame_count; f++) {
+		slot->layer_count = layer_count;
+		slot->full_mask = 0;
+
+		// Client, every layer gets a new image and timestamp.
+		for (uint32_t i = 0; i < layer_count; i++) {
+			ipc_layer_entry layer = make_quad(f % 3, (float)i);
+
+			if (!delta) {
+				slot->layers[i] = layer;
+				continue;
+			}
+
+			ipc_layer_update update;
+			ipc_shared_layer_get_update(&layer, &update);
+			if (f > 0 && ipc_shared_layer_try_update(&sent[i], &layer, &update)) {
+				slot->updates[i] = update;
+			} else {
+				sent[i] = layer;
+				slot->layers[i] = layer;
+				slot->full_mask |= 1u << i;
+			}
+		}
+
+		// Server, what it did before was copy the whole slot.
+		if (!delta) {
+			std::unique_ptr<ipc_layer_slot> copy(new ipc_layer_slot(*slot));
+			sink = sink + copy->layers[0].data.quad.sub.image_index;
+			continue;
+		}
+
+		for (uint32_t i = 0; i < slot->layer_count; i++) {
+			if ((slot->full_mask & (1u << i)) != 0) {
+				server[i] = slot->layers[i];
+			} else {
+				ipc_shared_layer_apply_update(&server[i], &slot->updates[i]);
+			}
+		}
+		sink = sink + server[0].data.quad.sub.image_index;
+	}
+
+	auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::nano>(end - start).count() / frame_count;
+}
+
+} // namespace
+
+// Hidden by default, run with: tests_ipc_shared_layer "[benchmark]"
+TEST_CASE("ipc_shared_layer_sync_benchmark", "[.][benchmark]")
+{
+	const uint32_t frame_count = 20000;
+	const uint32_t layer_counts[] = {1, 4, 16};
+
+	std::cout << "layers, full slot copy, delta (ns per frame)" << std::endl;
+	for (uint32_t layer_count : layer_counts) {
+		double full = run(false, layer_count, frame_count);
+		double delta = run(true, layer_count, frame_count);
+
+		std::cout << layer_count << ", " << (uint64_t)full << ", " << (uint64_t)delta << std::endl;
+
+		CHECK(full > 0.0);
+		CHECK(delta > 0.0);
+	}
+}
@@ -0,0 +1,90 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Shared memory layout tests.
+ */
+
+#include "shared/ipc_shared_layout.h"
+
+#include "catch/catch.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+
+TEST_CASE("ipc_shared_layout")
+{
+	uint32_t counts[IPC_SHARED_SECTION_COUNT] = {};
+	for (uint32_t i = 0; i < IPC_SHARED_SECTION_COUNT; i++) {
+		counts[i] = i + 3;
+	}
+
+	struct ipc_shared_toc_entry toc[IPC_SHARED_SECTION_COUNT] = {};
+	size_t size = ipc_shared_layout_compute(counts, toc);
+	REQUIRE(size % IPC_SHARED_MEMORY_ALIGNMENT == 0);
+
+	SECTION("Sections are aligned, ordered and do not overlap")
+	{
+		uint64_t end = sizeof(struct ipc_shared_memory);
+		for (uint32_t i = 0; i < IPC_SHARED_SECTION_COUNT; i++) {
+			CHECK(toc[i].offset % IPC_SHARED_MEMORY_ALIGNMENT == 0);
+			CHECK(toc[i].offset >= end);
+			CHECK(toc[i].count == counts[i]);
+			end = toc[i].offset + (uint64_t)toc[i].stride * toc[i].count;
+		}
+		CHECK(end <= size);
+
+		// Written by different clients, so each gets its own cache lines.
+		CHECK(toc[IPC_SHARED_SECTION_SLOTS].stride % IPC_SHARED_MEMORY_ALIGNMENT == 0);
+		CHECK(toc[IPC_SHARED_SECTION_FRAME_TIMINGS].stride % IPC_SHARED_MEMORY_ALIGNMENT == 0);
+		CHECK(toc[IPC_SHARED_SECTION_INPUTS].stride == sizeof(struct xrt_input));
+	}
+
+	// Aligned like the mmapped memory would be.
+	std::vector<uint64_t> storage(size / sizeof(uint64_t));
+	struct ipc_shared_memory *ism = reinterpret_cast<struct ipc_shared_memory *>(storage.data());
+	ism->layout_version = IPC_SHARED_MEMORY_LAYOUT_VERSION;
+	ism->total_size = size;
+	memcpy(ism->toc, toc, sizeof(toc));
+
+	SECTION("Valid")
+	{
+		CHECK(ipc_shared_layout_validate(ism, size));
+		CHECK(ipc_shared_section_count(ism, IPC_SHARED_SECTION_SLOTS) == counts[IPC_SHARED_SECTION_SLOTS]);
+
+		uint8_t *base = reinterpret_cast<uint8_t *>(ism);
+		uint8_t *slot = reinterpret_cast<uint8_t *>(ipc_shared_slot(ism, 1));
+		CHECK(slot == base + toc[IPC_SHARED_SECTION_SLOTS].offset + toc[IPC_SHARED_SECTION_SLOTS].stride);
+	}
+
+	SECTION("Wrong version")
+	{
+		ism->layout_version++;
+		CHECK_FALSE(ipc_shared_layout_validate(ism, size));
+	}
+
+	SECTION("Not all mapped")
+	{
+		CHECK_FALSE(ipc_shared_layout_validate(ism, size - IPC_SHARED_MEMORY_ALIGNMENT));
+	}
+
+	SECTION("Section out of bounds")
+	{
+		ism->toc[IPC_SHARED_SECTION_FRAME_TIMINGS].count += 1000;
+		CHECK_FALSE(ipc_shared_layout_validate(ism, size));
+	}
+
+	SECTION("Unaligned section")
+	{
+		ism->toc[IPC_SHARED_SECTION_INPUTS].offset += 4;
+		CHECK_FALSE(ipc_shared_layout_validate(ism, size));
+	}
+
+	SECTION("Array section with padded stride")
+	{
+		ism->toc[IPC_SHARED_SECTION_INPUTS].stride += 8;
+		CHECK_FALSE(ipc_shared_layout_validate(ism, size));
+	}
+}
@@ -0,0 +1,265 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief IPC transport tests, and a benchmark of inline handles.
+ */
+
+#include "xrt/xrt_limits.h"
+
+#include "shared/ipc_utils.h"
+
+#include "catch/catch.hpp"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+
+namespace {
+
+struct Msg
+{
+	uint32_t cmd;
+	uint32_t handle_count;
+	bool handles_inline;
+};
+
+struct Reply
+{
+	int32_t result;
+	uint32_t value;
+};
+
+struct Channels
+{
+	ipc_message_channel client = {};
+	ipc_message_channel server = {};
+
+	Channels()
+	{
+		int fds[2] = {-1, -1};
+		REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+		client.ipc_handle = fds[0];
+		client.log_level = U_LOGGING_WARN;
+		server.ipc_handle = fds[1];
+		server.log_level = U_LOGGING_WARN;
+	}
+
+	~Channels()
+	{
+		ipc_message_channel_close(&client);
+		ipc_message_channel_close(&server);
+	}
+};
+
+bool
+fd_is_open(int fd)
+{
+	return fcntl(fd, F_GETFD) != -1;
+}
+
+} // namespace
+
+TEST_CASE("ipc_receive_with_fds")
+{
+	Channels c;
+
+	int pipe_fds[2] = {-1, -1};
+	REQUIRE(pipe(pipe_fds) == 0);
+
+	SECTION("No handles")
+	{
+		Msg msg = {1, 0, true};
+		REQUIRE(ipc_send(&c.client, &msg, sizeof(msg)) == XRT_SUCCESS);
+
+		Msg got = {};
+		size_t size = 0;
+		int handles[4] = {-1, -1, -1, -1};
+		uint32_t handle_count = 42;
+		REQUIRE(ipc_receive_with_fds(&c.server, &got, sizeof(got), &size, handles, 4, &handle_count) ==
+		        XRT_SUCCESS);
+		CHECK(size == sizeof(msg));
+		CHECK(got.cmd == 1);
+		CHECK(handle_count == 0);
+	}
+
+	SECTION("Inline handles")
+	{
+		Msg msg = {2, 2, true};
+		REQUIRE(ipc_send_fds(&c.client, &msg, sizeof(msg), pipe_fds, 2) == XRT_SUCCESS);
+
+		Msg got = {};
+		size_t size = 0;
+		int handles[4] = {-1, -1, -1, -1};
+		uint32_t handle_count = 0;
+		REQUIRE(ipc_receive_with_fds(&c.server, &got, sizeof(got), &size, handles, 4, &handle_count) ==
+		        XRT_SUCCESS);
+		CHECK(size == sizeof(msg));
+		CHECK(got.cmd == 2);
+		REQUIRE(handle_count == 2);
+
+		// The received descriptors are new and refer to the same pipe.
+		CHECK(handles[0] != pipe_fds[0]);
+		CHECK(handles[1] != pipe_fds[1]);
+		char c_out = 'x';
+		char c_in = 0;
+		REQUIRE(write(handles[1], &c_out, 1) == 1);
+		REQUIRE(read(pipe_fds[0], &c_in, 1) == 1);
+		CHECK(c_in == 'x');
+
+		close(handles[0]);
+		close(handles[1]);
+	}
+
+	SECTION("Too many handles")
+	{
+		Msg msg = {3, 2, true};
+		REQUIRE(ipc_send_fds(&c.client, &msg, sizeof(msg), pipe_fds, 2) == XRT_SUCCESS);
+
+		Msg got = {};
+		size_t size = 0;
+		int handles[1] = {-1};
+		uint32_t handle_count = 0;
+		CHECK(ipc_receive_with_fds(&c.server, &got, sizeof(got), &size, handles, 1, &handle_count) ==
+		      XRT_ERROR_IPC_FAILURE);
+		CHECK(handle_count == 0);
+		if (handles[0] >= 0) {
+			// Must have been closed.
+			CHECK_FALSE(fd_is_open(handles[0]));
+		}
+	}
+
+	SECTION("Timeout")
+	{
+		struct timeval tv = {0, 10 * 1000};
+		REQUIRE(setsockopt(c.server.ipc_handle, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == 0);
+
+		Msg got = {};
+		size_t size = 0;
+		uint32_t handle_count = 0;
+		CHECK(ipc_receive_with_fds(&c.server, &got, sizeof(got), &size, nullptr, 0, &handle_count) ==
+		      XRT_TIMEOUT);
+	}
+
+	SECTION("Hang up")
+	{
+		ipc_message_channel_close(&c.client);
+
+		Msg got = {};
+		size_t size = 0;
+		uint32_t handle_count = 0;
+		CHECK(ipc_receive_with_fds(&c.server, &got, sizeof(got), &size, nullptr, 0, &handle_count) ==
+		      XRT_ERROR_IPC_FAILURE);
+	}
+
+	close(pipe_fds[0]);
+	close(pipe_fds[1]);
+}
+
+
+/*
+ *
+ * Benchmark, mirrors what the generated code does for a call with in handles.
+ *
+ */
+
+namespace {
+
+void
+server_loop(ipc_message_channel *imc, uint32_t iterations)
+{
+	for (uint32_t i = 0; i < iterations; i++) {
+		Msg msg = {};
+		size_t size = 0;
+		int handles[XRT_MAX_IPC_HANDLES];
+		uint32_t handle_count = 0;
+		if (ipc_receive_with_fds(imc, &msg, sizeof(msg), &size, handles, XRT_MAX_IPC_HANDLES, &handle_count) !=
+		    XRT_SUCCESS) {
+			return;
+		}
+
+		if (!msg.handles_inline) {
+			Reply sync = {};
+			ipc_send(imc, &sync, sizeof(sync));
+
+			Msg handle_msg = {};
+			ipc_receive_fds(imc, &handle_msg, sizeof(handle_msg), handles, msg.handle_count);
+			handle_count = msg.handle_count;
+		}
+
+		for (uint32_t k = 0; k < handle_count; k++) {
+			close(handles[k]);
+		}
+
+		Reply reply = {0, i};
+		ipc_send(imc, &reply, sizeof(reply));
+	}
+}
+
+void
+client_call(ipc_message_channel *imc, bool inline_handles, const int *handles, uint32_t handle_count)
+{
+	Msg msg = {1, handle_count, inline_handles};
+	Reply reply = {};
+
+	if (inline_handles) {
+		ipc_send_fds(imc, &msg, sizeof(msg), handles, handle_count);
+	} else {
+		Reply sync = {};
+		ipc_send(imc, &msg, sizeof(msg));
+		ipc_receive(imc, &sync, sizeof(sync));
+
+		Msg handle_msg = {1, 0, false};
+		ipc_send_fds(imc, &handle_msg, sizeof(handle_msg), handles, handle_count);
+	}
+
+	ipc_receive(imc, &reply, sizeof(reply));
+}
+
+double
+run(bool inline_handles, uint32_t iterations)
+{
+	Channels c;
+
+	int pipe_fds[2] = {-1, -1};
+	REQUIRE(pipe(pipe_fds) == 0);
+
+	std::thread server(server_loop, &c.server, iterations);
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < iterations; i++) {
+		client_call(&c.client, inline_handles, pipe_fds, 1);
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	server.join();
+
+	close(pipe_fds[0]);
+	close(pipe_fds[1]);
+
+	return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+} // namespace
+
+// Hidden by default, run with: tests_ipc_transport "[benchmark]"
+TEST_CASE("ipc_inline_handles_benchmark", "[.][benchmark]")
+{
+	const uint32_t iterations = 20000;
+
+	double separate_us = run(false, iterations);
+	double inline_us = run(true, iterations);
+
+	std::cout << "Call with one handle, separate: " << separate_us << "us, inline: " << inline_us << "us"
+	          << std::endl;
+
+	CHECK(inline_us > 0.0);
+	CHECK(separate_us > 0.0);
+}
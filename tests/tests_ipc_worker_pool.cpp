@@ -0,0 +1,443 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief IPC server worker pool tests, and a stress benchmark against one thread per client.
+ */
+
+#include "xrt/xrt_limits.h"
+
+#include "shared/ipc_utils.h"
+#include "shared/ipc_protocol.h"
+#include "server/ipc_server_worker_pool.h"
+#include "ipc_protocol_generated.h"
+
+#include "catch/catch.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+struct Client
+{
+	int client_fd = -1;
+	int server_fd = -1;
+
+	//! Next sequence number the server expects.
+	uint32_t expected = 0;
+	std::atomic<bool> out_of_order{false};
+	std::atomic<bool> removed{false};
+
+	//! Only touched by the thread handling the client, checks exclusivity.
+	std::atomic<int> in_handler{0};
+	std::atomic<bool> concurrent{false};
+
+	//! If set the handler tells the pool it will block and waits for this to be cleared.
+	ipc_server_worker_pool *block_pool = nullptr;
+	std::atomic<bool> block{false};
+
+	Client()
+	{
+		int fds[2] = {-1, -1};
+		REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+		client_fd = fds[0];
+		server_fd = fds[1];
+	}
+
+	~Client()
+	{
+		if (client_fd >= 0) {
+			close(client_fd);
+		}
+		if (server_fd >= 0 && !removed) {
+			close(server_fd);
+		}
+	}
+};
+
+bool
+read_all(int fd, void *data, size_t size)
+{
+	uint8_t *ptr = static_cast<uint8_t *>(data);
+	while (size > 0) {
+		ssize_t ret = read(fd, ptr, size);
+		if (ret <= 0) {
+			return false;
+		}
+		ptr += ret;
+		size -= ret;
+	}
+	return true;
+}
+
+bool
+write_all(int fd, const void *data, size_t size)
+{
+	return write(fd, data, size) == (ssize_t)size;
+}
+
+//! Reads one sequence number, checks it and echoes it back.
+bool
+handle_func(void *ptr)
+{
+	Client *c = static_cast<Client *>(ptr);
+
+	if (c->in_handler.fetch_add(1) != 0) {
+		c->concurrent = true;
+	}
+
+	uint32_t seq = 0;
+	bool ok = read_all(c->server_fd, &seq, sizeof(seq));
+	if (ok) {
+		if (seq != c->expected) {
+			c->out_of_order = true;
+		}
+		c->expected = seq + 1;
+
+		if (c->block) {
+			ipc_server_worker_pool_will_block(c->block_pool);
+			while (c->block) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+
+		ok = write_all(c->server_fd, &seq, sizeof(seq));
+	}
+
+	c->in_handler.fetch_sub(1);
+
+	return ok;
+}
+
+void
+remove_func(void *ptr)
+{
+	Client *c = static_cast<Client *>(ptr);
+	close(c->server_fd);
+	c->removed = true;
+}
+
+struct Pool
+{
+	ipc_server_worker_pool *pool = nullptr;
+
+	explicit Pool(uint32_t thread_count)
+	{
+		REQUIRE(ipc_server_worker_pool_create(thread_count, handle_func, remove_func, &pool) == 0);
+	}
+
+	~Pool()
+	{
+		ipc_server_worker_pool_destroy(&pool);
+	}
+};
+
+//! Client side, does @p count round trips.
+void
+ping(Client *c, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t reply = 0;
+		if (!write_all(c->client_fd, &i, sizeof(i)) || !read_all(c->client_fd, &reply, sizeof(reply))) {
+			return;
+		}
+	}
+}
+
+} // namespace
+
+
+TEST_CASE("ipc_server_worker_pool")
+{
+	SECTION("Invalid thread count")
+	{
+		ipc_server_worker_pool *pool = nullptr;
+		CHECK(ipc_server_worker_pool_create(0, handle_func, remove_func, &pool) < 0);
+		CHECK(ipc_server_worker_pool_create(IPC_SERVER_WORKER_POOL_MAX_THREADS + 1, handle_func, remove_func,
+		                                    &pool) < 0);
+		CHECK(pool == nullptr);
+	}
+
+	SECTION("Ordering is kept per client")
+	{
+		const uint32_t client_count = 8;
+		const uint32_t message_count = 500;
+
+		std::vector<std::unique_ptr<Client>> clients;
+		for (uint32_t i = 0; i < client_count; i++) {
+			clients.emplace_back(new Client());
+		}
+
+		{
+			Pool p(3);
+			for (auto &c : clients) {
+				REQUIRE(ipc_server_worker_pool_add(p.pool, c->server_fd, c.get()) == 0);
+			}
+
+			// Send everything up front so several messages are pending at once.
+			std::vector<std::thread> threads;
+			for (auto &c : clients) {
+				threads.emplace_back([&c, message_count] {
+					for (uint32_t i = 0; i < message_count; i++) {
+						write_all(c->client_fd, &i, sizeof(i));
+					}
+					for (uint32_t i = 0; i < message_count; i++) {
+						uint32_t reply = 0;
+						read_all(c->client_fd, &reply, sizeof(reply));
+					}
+				});
+			}
+			for (auto &t : threads) {
+				t.join();
+			}
+		}
+
+		for (auto &c : clients) {
+			CHECK(c->expected == message_count);
+			CHECK_FALSE(c->out_of_order);
+			CHECK_FALSE(c->concurrent);
+		}
+	}
+
+	SECTION("Removed on hang up")
+	{
+		Client c;
+		Pool p(1);
+		REQUIRE(ipc_server_worker_pool_add(p.pool, c.server_fd, &c) == 0);
+
+		ping(&c, 10);
+		close(c.client_fd);
+		c.client_fd = -1;
+
+		for (int i = 0; i < 1000 && !c.removed; i++) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		CHECK(c.removed);
+		CHECK(c.expected == 10);
+	}
+
+	SECTION("Removed on destroy")
+	{
+		Client c;
+		{
+			Pool p(2);
+			REQUIRE(ipc_server_worker_pool_add(p.pool, c.server_fd, &c) == 0);
+			ping(&c, 10);
+		}
+
+		// Still connected, so the destroy tore it down.
+		CHECK(c.removed);
+		CHECK(c.expected == 10);
+	}
+
+	SECTION("Grows when a handler blocks")
+	{
+		Client blocked;
+		Client other;
+
+		Pool p(1);
+		blocked.block_pool = p.pool;
+		blocked.block = true;
+		REQUIRE(ipc_server_worker_pool_add(p.pool, blocked.server_fd, &blocked) == 0);
+		REQUIRE(ipc_server_worker_pool_add(p.pool, other.server_fd, &other) == 0);
+
+		// Takes the only thread.
+		uint32_t seq = 0;
+		REQUIRE(write_all(blocked.client_fd, &seq, sizeof(seq)));
+		for (int i = 0; i < 1000 && blocked.in_handler == 0; i++) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		// Serviced by the new thread.
+		ping(&other, 10);
+		CHECK(other.expected == 10);
+		CHECK(ipc_server_worker_pool_get_thread_count(p.pool) == 2);
+
+		blocked.block = false;
+		uint32_t reply = 0;
+		CHECK(read_all(blocked.client_fd, &reply, sizeof(reply)));
+	}
+}
+
+
+/*
+ *
+ * Stress benchmark.
+ *
+ */
+
+namespace {
+
+/*!
+ * A client connection that talks the IPC protocol, the server side does what
+ * the dispatcher does for a call without arguments: receives into a full
+ * buffer, taking any handles, and sends a reply.
+ */
+struct IpcClient
+{
+	ipc_message_channel client = {};
+	ipc_message_channel server = {};
+	std::atomic<bool> removed{false};
+
+	IpcClient()
+	{
+		int fds[2] = {-1, -1};
+		REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+		client.ipc_handle = fds[0];
+		client.log_level = U_LOGGING_WARN;
+		server.ipc_handle = fds[1];
+		server.log_level = U_LOGGING_WARN;
+	}
+
+	~IpcClient()
+	{
+		ipc_message_channel_close(&client);
+		if (!removed) {
+			ipc_message_channel_close(&server);
+		}
+	}
+};
+
+bool
+ipc_handle_func(void *ptr)
+{
+	IpcClient *c = static_cast<IpcClient *>(ptr);
+
+	uint8_t buf[IPC_BUF_SIZE] = {};
+	size_t len = 0;
+	int handles[XRT_MAX_IPC_HANDLES] = {};
+	uint32_t handle_count = 0;
+
+	xrt_result_t xret = ipc_receive_with_fds( //
+	    &c->server,                           //
+	    buf,                                  //
+	    IPC_BUF_SIZE,                         //
+	    &len,                                 //
+	    handles,                              //
+	    XRT_MAX_IPC_HANDLES,                  //
+	    &handle_count);                       //
+	if (xret != XRT_SUCCESS || len < sizeof(ipc_command_t)) {
+		return false;
+	}
+
+	ipc_compositor_predict_frame_reply reply = {};
+	reply.result = XRT_SUCCESS;
+	reply.frame_id = 1;
+
+	return ipc_send(&c->server, &reply, sizeof(reply)) == XRT_SUCCESS;
+}
+
+void
+ipc_remove_func(void *ptr)
+{
+	IpcClient *c = static_cast<IpcClient *>(ptr);
+	ipc_message_channel_close(&c->server);
+	c->removed = true;
+}
+
+void
+dedicated_thread(IpcClient *c)
+{
+	while (ipc_handle_func(c)) {
+	}
+	ipc_remove_func(c);
+}
+
+//! Client side, does @p count predict_frame round trips the same way the generated client code does.
+void
+ipc_ping(IpcClient *c, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++) {
+		ipc_command_msg msg = {};
+		msg.cmd = IPC_COMPOSITOR_PREDICT_FRAME;
+		ipc_compositor_predict_frame_reply reply = {};
+
+		if (ipc_send(&c->client, &msg, sizeof(msg)) != XRT_SUCCESS ||
+		    ipc_receive(&c->client, &reply, sizeof(reply)) != XRT_SUCCESS) {
+			return;
+		}
+	}
+}
+
+/*!
+ * Runs @p client_count clients doing round trips, returns round trips per
+ * second over all clients. A @p thread_count of zero gives every client its
+ * own thread, like the default server mode.
+ */
+double
+run(uint32_t client_count, uint32_t thread_count, uint32_t round_trips)
+{
+	std::vector<std::unique_ptr<IpcClient>> clients;
+	for (uint32_t i = 0; i < client_count; i++) {
+		clients.emplace_back(new IpcClient());
+	}
+
+	ipc_server_worker_pool *pool = nullptr;
+	std::vector<std::thread> server_threads;
+	if (thread_count > 0) {
+		REQUIRE(ipc_server_worker_pool_create(thread_count, ipc_handle_func, ipc_remove_func, &pool) == 0);
+		for (auto &c : clients) {
+			REQUIRE(ipc_server_worker_pool_add(pool, c->server.ipc_handle, c.get()) == 0);
+		}
+	} else {
+		for (auto &c : clients) {
+			server_threads.emplace_back(dedicated_thread, c.get());
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> client_threads;
+	for (auto &c : clients) {
+		client_threads.emplace_back(ipc_ping, c.get(), round_trips);
+	}
+	for (auto &t : client_threads) {
+		t.join();
+	}
+
+	auto end = std::chrono::steady_clock::now();
+
+	// Hang up, which stops the dedicated threads.
+	for (auto &c : clients) {
+		shutdown(c->client.ipc_handle, SHUT_RDWR);
+	}
+	for (auto &t : server_threads) {
+		t.join();
+	}
+	ipc_server_worker_pool_destroy(&pool);
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+	return (double)client_count * round_trips / seconds;
+}
+
+} // namespace
+
+// Hidden by default, run with: tests_ipc_worker_pool "[benchmark]"
+TEST_CASE("ipc_server_worker_pool_benchmark", "[.][benchmark]")
+{
+	const uint32_t round_trips = 2000;
+	const uint32_t client_counts[] = {1, 2, 4, 8, 16, 32, 64};
+
+	std::cout << "clients, thread per client, pool of 2, pool of 4 (round trips/s)" << std::endl;
+	for (uint32_t client_count : client_counts) {
+		double dedicated = run(client_count, 0, round_trips);
+		double pool_2 = run(client_count, 2, round_trips);
+		double pool_4 = run(client_count, 4, round_trips);
+
+		std::cout << client_count << ", " << (uint64_t)dedicated << ", " << (uint64_t)pool_2 << ", "
+		          << (uint64_t)pool_4 << std::endl;
+
+		CHECK(dedicated > 0.0);
+		CHECK(pool_2 > 0.0);
+		CHECK(pool_4 > 0.0);
+	}
+}
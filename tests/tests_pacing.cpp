@@ -6,6 +6,7 @@
  * @author Ryan Pavlik <ryan.pavlik@collabora.com>
  */
 
+#include <util/u_time.h>
 #include <util/u_pacing.h>
 
 #include "catch/catch.hpp"
@@ -17,6 +18,7 @@
 #include <sstream>
 #include <iomanip>
 #include <queue>
+#include <algorithm>
 
 using namespace std::chrono_literals;
 using namespace std::chrono;
@@ -386,3 +388,147 @@ TEST_CASE("u_pacing_compositor_fake")
 	}
 	u_pc_destroy(&upc);
 }
+
+namespace {
+
+struct AppPredictions
+{
+	int64_t frame_id{0};
+	uint64_t wake_up_time_ns{0};
+	uint64_t predicted_display_time_ns{0};
+	uint64_t predicted_display_period_ns{0};
+};
+
+AppPredictions
+predictApp(u_pacing_app *upa, uint64_t now_ns)
+{
+	AppPredictions p;
+	u_pa_predict(upa, now_ns, &p.frame_id, &p.wake_up_time_ns, &p.predicted_display_time_ns,
+	             &p.predicted_display_period_ns);
+	return p;
+}
+
+//! Delivers the frame right away, and has the GPU complete it at @p gpu_done_ns.
+void
+doAppFrame(u_pacing_app *upa, const AppPredictions &p, uint64_t now_ns, uint64_t gpu_done_ns)
+{
+	u_pa_mark_point(upa, p.frame_id, U_TIMING_POINT_WAKE_UP, now_ns);
+	u_pa_mark_point(upa, p.frame_id, U_TIMING_POINT_BEGIN, now_ns);
+	u_pa_mark_delivered(upa, p.frame_id, now_ns, p.predicted_display_time_ns);
+	u_pa_mark_gpu_done(upa, p.frame_id, gpu_done_ns);
+}
+
+} // namespace
+
+TEST_CASE("u_pacing_app_fair")
+{
+	u_pacing_app_factory *upaf = nullptr;
+	REQUIRE(XRT_SUCCESS == u_pa_factory_create(&upaf));
+	REQUIRE(upaf != nullptr);
+
+	u_pacing_app *primary = nullptr;
+	u_pacing_app *heavy = nullptr;
+	u_pacing_app *light = nullptr;
+	u_paf_create(upaf, &primary);
+	u_paf_create(upaf, &heavy);
+	u_paf_create(upaf, &light);
+	REQUIRE(primary != nullptr);
+	REQUIRE(heavy != nullptr);
+	REQUIRE(light != nullptr);
+
+	u_pa_set_primary(primary, true);
+
+	const uint64_t period_ns = frame_interval_ns.count();
+	uint64_t now_ns = period_ns * 100;
+	uint64_t heavy_period_ns = 0;
+	uint64_t light_period_ns = 0;
+
+	/*
+	 * One frame for every app, they all sleep until the primary app should
+	 * wake up. If late the primary app's GPU work completes just before
+	 * display, eating into its margin.
+	 */
+	auto step = [&](bool primary_late) {
+		for (u_pacing_app *upa : {primary, heavy, light}) {
+			u_pa_info(upa, now_ns + period_ns, period_ns, 0);
+		}
+
+		AppPredictions p = predictApp(primary, now_ns);
+		AppPredictions h = predictApp(heavy, now_ns);
+		AppPredictions l = predictApp(light, now_ns);
+		heavy_period_ns = h.predicted_display_period_ns;
+		light_period_ns = l.predicted_display_period_ns;
+
+		uint64_t wake_ns = std::max(now_ns, p.wake_up_time_ns);
+		uint64_t late_ns = p.predicted_display_time_ns - U_TIME_1MS_IN_NS;
+		doAppFrame(primary, p, wake_ns, primary_late ? late_ns : wake_ns + U_TIME_1MS_IN_NS);
+		doAppFrame(heavy, h, wake_ns, wake_ns + U_TIME_1MS_IN_NS * 8);
+		doAppFrame(light, l, wake_ns, wake_ns + U_TIME_1MS_IN_NS);
+
+		now_ns = wake_ns + period_ns;
+	};
+
+	// Steps until the heavy app is throttled, or gives up.
+	auto step_late_until_throttled = [&]() {
+		for (int i = 0; i < 100 && heavy_period_ns <= period_ns; i++) {
+			step(true);
+		}
+	};
+
+	SECTION("Primary on time")
+	{
+		for (int i = 0; i < 200; i++) {
+			step(false);
+			REQUIRE(heavy_period_ns == period_ns);
+			REQUIRE(light_period_ns == period_ns);
+		}
+	}
+
+	SECTION("Primary late throttles the heaviest app first")
+	{
+		step_late_until_throttled();
+		CHECK(heavy_period_ns == period_ns * 2);
+		CHECK(light_period_ns == period_ns);
+
+		// Keeps on being late, everybody gets throttled.
+		for (int i = 0; i < 100; i++) {
+			step(true);
+		}
+		CHECK(heavy_period_ns > period_ns * 2);
+		CHECK(light_period_ns > period_ns);
+
+		// Back on time, the throttles are slowly released.
+		for (int i = 0; i < 2000; i++) {
+			step(false);
+		}
+		CHECK(heavy_period_ns == period_ns);
+		CHECK(light_period_ns == period_ns);
+	}
+
+	SECTION("No primary releases all")
+	{
+		step_late_until_throttled();
+		REQUIRE(heavy_period_ns > period_ns);
+
+		u_pa_set_primary(primary, false);
+		step(true);
+		CHECK(heavy_period_ns == period_ns);
+	}
+
+	SECTION("Destroying the primary releases all")
+	{
+		step_late_until_throttled();
+		REQUIRE(heavy_period_ns > period_ns);
+
+		u_pa_destroy(&primary);
+
+		u_pa_info(heavy, now_ns + period_ns, period_ns, 0);
+		AppPredictions h = predictApp(heavy, now_ns);
+		CHECK(h.predicted_display_period_ns == period_ns);
+	}
+
+	u_pa_destroy(&light);
+	u_pa_destroy(&heavy);
+	u_pa_destroy(&primary);
+	u_paf_destroy(&upaf);
+}
@@ -0,0 +1,157 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Depth timewarp math tests, the shader is mirrored on the CPU.
+ */
+
+#include "xrt/xrt_compositor.h"
+
+#include "render/render_interface.h"
+
+#include "catch/catch.hpp"
+
+#include <cmath>
+#include <limits>
+
+
+namespace {
+
+constexpr float kWallDistance = 2.0f;
+
+xrt_vec4
+mul(const xrt_matrix_4x4 &m, const xrt_vec4 &p)
+{
+	const float in[4] = {p.x, p.y, p.z, p.w};
+	float out[4] = {};
+	for (int r = 0; r < 4; r++) {
+		for (int c = 0; c < 4; c++) {
+			out[r] += m.v[c * 4 + r] * in[c];
+		}
+	}
+	return {out[0], out[1], out[2], out[3]};
+}
+
+xrt_vec2
+project(const xrt_matrix_4x4 &m, const xrt_vec4 &p)
+{
+	xrt_vec4 v = mul(m, p);
+	return {v.x / v.w * 0.5f + 0.5f, v.y / v.w * 0.5f + 0.5f};
+}
+
+float
+to_distance(const render_depth_params &params, float d)
+{
+	return 1.0f / (params.inv_near + (d * params.scale + params.offset) * params.inv_delta);
+}
+
+//! Same walk along the ray as distortion.comp, against a wall straight ahead of the source view.
+xrt_vec2
+reproject(const xrt_matrix_4x4 &matrix, const xrt_matrix_4x4 &new_to_src, const xrt_vec3 &dir)
+{
+	xrt_vec2 uv = project(matrix, {dir.x, dir.y, dir.z, 0});
+	float t = kWallDistance;
+
+	for (int i = 0; i < 3; i++) {
+		xrt_vec4 point = {dir.x * t, dir.y * t, dir.z * t, 1};
+		float src_z = -mul(new_to_src, point).z;
+
+		uv = project(matrix, point);
+		t = t + kWallDistance - src_z;
+	}
+
+	return uv;
+}
+
+} // namespace
+
+
+TEST_CASE("render_calc_depth_params")
+{
+	xrt_layer_depth_data depth = {};
+	depth.min_depth = 0.0f;
+	depth.max_depth = 1.0f;
+	render_depth_params params = {};
+
+	SECTION("Regular")
+	{
+		depth.near_z = 0.1f;
+		depth.far_z = 100.0f;
+		REQUIRE(render_calc_depth_params(&depth, &params));
+		CHECK(to_distance(params, 0.0f) == Approx(0.1f));
+		CHECK(to_distance(params, 1.0f) == Approx(100.0f));
+	}
+
+	SECTION("Reversed and infinite")
+	{
+		depth.near_z = std::numeric_limits<float>::infinity();
+		depth.far_z = 0.1f;
+		REQUIRE(render_calc_depth_params(&depth, &params));
+		CHECK(to_distance(params, 1.0f) == Approx(0.1f));
+		CHECK(to_distance(params, 0.5f) == Approx(0.2f));
+	}
+
+	SECTION("Sub range")
+	{
+		depth.min_depth = 0.5f;
+		depth.near_z = 1.0f;
+		depth.far_z = 3.0f;
+		REQUIRE(render_calc_depth_params(&depth, &params));
+		CHECK(to_distance(params, 0.5f) == Approx(1.0f));
+		CHECK(to_distance(params, 1.0f) == Approx(3.0f));
+	}
+
+	SECTION("Bad values")
+	{
+		depth.near_z = 1.0f;
+		depth.far_z = 1.0f;
+		CHECK_FALSE(render_calc_depth_params(&depth, &params));
+
+		depth.far_z = 0.0f;
+		CHECK_FALSE(render_calc_depth_params(&depth, &params));
+
+		depth.far_z = 10.0f;
+		depth.max_depth = 0.0f;
+		CHECK_FALSE(render_calc_depth_params(&depth, &params));
+	}
+}
+
+TEST_CASE("render_calc_time_warp_depth_matrices")
+{
+	const xrt_fov fov = {-0.8f, 0.8f, 0.8f, -0.8f};
+	const xrt_pose src_pose = {{0, 0, 0, 1}, {0, 1.6f, 0}};
+	xrt_pose new_pose = src_pose;
+
+	xrt_matrix_4x4 matrix;
+	xrt_matrix_4x4 new_to_src;
+
+	SECTION("Same pose is identity")
+	{
+		render_calc_time_warp_depth_matrices(&src_pose, &fov, &new_pose, &matrix, &new_to_src);
+		xrt_vec4 p = mul(new_to_src, {0.3f, -0.2f, -2.0f, 1});
+		CHECK(p.x == Approx(0.3f));
+		CHECK(p.y == Approx(-0.2f));
+		CHECK(p.z == Approx(-2.0f));
+
+		// Straight ahead is the middle of the source.
+		xrt_vec2 uv = project(matrix, {0, 0, -1, 0});
+		CHECK(uv.x == Approx(0.5f));
+		CHECK(uv.y == Approx(0.5f));
+	}
+
+	SECTION("Moved sideways finds the same point on the wall")
+	{
+		new_pose.position.x += 0.1f;
+		render_calc_time_warp_depth_matrices(&src_pose, &fov, &new_pose, &matrix, &new_to_src);
+
+		// Looking straight ahead from the new pose sees the wall 0.1 to the right.
+		xrt_vec2 uv = reproject(matrix, new_to_src, {0, 0, -1});
+
+		// The same point seen from the source view, no change in rotation so tan angles map linearly.
+		float tan_x = 0.1f / kWallDistance;
+		float tan_left = std::tan(fov.angle_left);
+		float expected_x = (tan_x - tan_left) / (std::tan(fov.angle_right) - tan_left);
+		CHECK(uv.x == Approx(expected_x).margin(1e-4));
+		CHECK(uv.y == Approx(0.5f).margin(1e-4));
+	}
+}
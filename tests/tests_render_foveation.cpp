@@ -0,0 +1,131 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Foveated distortion tile and fovea maths tests.
+ */
+
+#include "render/render_foveation.h"
+
+#include "catch/catch.hpp"
+
+
+namespace {
+
+render_compute_foveation
+make_foveation(uint32_t tile_size, float fraction, float center_x, float center_y)
+{
+	render_compute_foveation foveation = {};
+	foveation.tile_size = tile_size;
+	foveation.full_rate_fraction = fraction;
+	foveation.centers[0] = {center_x, center_y};
+	foveation.centers[1] = {center_x, center_y};
+	return foveation;
+}
+
+} // namespace
+
+
+TEST_CASE("render_foveation_is_enabled")
+{
+	CHECK_FALSE(render_foveation_is_enabled(nullptr));
+
+	render_compute_foveation foveation = make_foveation(8, 0.5f, 0.5f, 0.5f);
+	CHECK(render_foveation_is_enabled(&foveation));
+
+	SECTION("Tile size below two")
+	{
+		foveation.tile_size = 1;
+		CHECK_FALSE(render_foveation_is_enabled(&foveation));
+	}
+
+	SECTION("Whole view at full rate")
+	{
+		foveation.full_rate_fraction = 1.0f;
+		CHECK_FALSE(render_foveation_is_enabled(&foveation));
+	}
+}
+
+TEST_CASE("render_foveation_calc_extent")
+{
+	// 0.4 * 1000 = 400, rounded up to whole tiles of 16.
+	CHECK(render_foveation_calc_extent(1000, 16, 0.4f) == 400);
+	CHECK(render_foveation_calc_extent(1000, 16, 0.41f) == 416);
+
+	// Capped to the view.
+	CHECK(render_foveation_calc_extent(1000, 16, 0.999f) == 1000);
+
+	// Nothing at full rate.
+	CHECK(render_foveation_calc_extent(1000, 16, 0.0f) == 0);
+	CHECK(render_foveation_calc_extent(1000, 16, -1.0f) == 0);
+}
+
+TEST_CASE("render_foveation_calc_offset")
+{
+	const uint32_t view = 1000;
+	const uint32_t tile = 16;
+	const uint32_t extent = render_foveation_calc_extent(view, tile, 0.4f);
+
+	SECTION("Centered, lined up with the tiles")
+	{
+		// 500 - 200 = 300, down to a tile edge.
+		CHECK(render_foveation_calc_offset(view, extent, tile, 0.5f) == 288);
+	}
+
+	SECTION("Clamped to the view edges")
+	{
+		CHECK(render_foveation_calc_offset(view, extent, tile, 0.0f) == 0);
+		CHECK(render_foveation_calc_offset(view, extent, tile, -2.0f) == 0);
+
+		uint32_t right = render_foveation_calc_offset(view, extent, tile, 1.0f);
+		CHECK(right + extent <= view);
+		CHECK(right % tile == 0);
+		CHECK(render_foveation_calc_offset(view, extent, tile, 3.0f) == right);
+	}
+
+	SECTION("Always inside the view and on a tile edge")
+	{
+		for (float center = -0.25f; center <= 1.25f; center += 0.01f) {
+			uint32_t offset = render_foveation_calc_offset(view, extent, tile, center);
+			CHECK(offset + extent <= view);
+			CHECK(offset % tile == 0);
+		}
+	}
+
+	SECTION("Whole view")
+	{
+		CHECK(render_foveation_calc_offset(view, view, tile, 0.3f) == 0);
+	}
+}
+
+TEST_CASE("render_foveation_calc_invocations")
+{
+	SECTION("Fovea is larger than the tile count")
+	{
+		// 1000 / 16 = 63 tiles, fovea is 400 pixels.
+		CHECK(render_foveation_calc_invocations(1000, 16, 0.4f) == 400);
+	}
+
+	SECTION("Tile count is larger than the fovea")
+	{
+		// 1000 / 2 = 500 tiles, fovea is 100 pixels.
+		CHECK(render_foveation_calc_invocations(1000, 2, 0.1f) == 500);
+	}
+
+	SECTION("Covers every tile and every fovea pixel")
+	{
+		const uint32_t extents[] = {1, 15, 16, 17, 1080, 1920, 2160};
+		const uint32_t tiles[] = {2, 4, 8, 16, 32};
+		const float fractions[] = {0.0f, 0.1f, 0.33f, 0.5f, 0.9f};
+
+		for (uint32_t extent : extents) {
+			for (uint32_t tile : tiles) {
+				for (float fraction : fractions) {
+					uint32_t n = render_foveation_calc_invocations(extent, tile, fraction);
+					CHECK(n * tile >= extent);
+					CHECK(n >= render_foveation_calc_extent(extent, tile, fraction));
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,138 @@
+// Copyright 2023, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief u_space_overseer device pose cache tests.
+ */
+
+#include "xrt/xrt_device.h"
+
+#include "os/os_time.h"
+
+#include "util/u_time.h"
+#include "util/u_space_overseer.h"
+
+#include "catch/catch.hpp"
+
+
+namespace {
+
+constexpr xrt_pose kPoseIdentity = XRT_POSE_IDENTITY;
+
+struct FakeDevice
+{
+	xrt_device base;
+	int calls;
+};
+
+//! Puts the timestamp in the position so it can be checked.
+void
+fake_get_tracked_pose(xrt_device *xdev,
+                      xrt_input_name name,
+                      uint64_t at_timestamp_ns,
+                      xrt_space_relation *out_relation)
+{
+	FakeDevice *fd = reinterpret_cast<FakeDevice *>(xdev);
+	fd->calls++;
+
+	*out_relation = {};
+	out_relation->pose = kPoseIdentity;
+	out_relation->pose.position.x = (float)at_timestamp_ns;
+	out_relation->relation_flags = (xrt_space_relation_flags)( //
+	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |             //
+	    XRT_SPACE_RELATION_POSITION_VALID_BIT);                //
+}
+
+xrt_space_relation
+locate(u_space_overseer *uso, xrt_space *xs, uint64_t at_timestamp_ns)
+{
+	xrt_space_overseer *xso = (xrt_space_overseer *)uso;
+	xrt_space_relation rel = {};
+	xrt_space_overseer_locate_space(xso, xso->semantic.root, &kPoseIdentity, at_timestamp_ns, xs,
+	                                &kPoseIdentity, &rel);
+	return rel;
+}
+
+} // namespace
+
+
+TEST_CASE("u_space_overseer_pose_cache")
+{
+	FakeDevice dev = {};
+	dev.base.get_tracked_pose = fake_get_tracked_pose;
+
+	u_space_overseer *uso = u_space_overseer_create();
+	xrt_space_overseer *xso = (xrt_space_overseer *)uso;
+
+	// Plenty of time for the test to run, even on a busy machine.
+	u_space_overseer_set_pose_cache_max_age(uso, 60 * (uint64_t)U_TIME_1S_IN_NS);
+	u_space_overseer_link_space_to_device(uso, xso->semantic.root, &dev.base);
+
+	xrt_space *head = nullptr;
+	xrt_space *grip = nullptr;
+	u_space_overseer_create_pose_space(uso, &dev.base, XRT_INPUT_GENERIC_HEAD_POSE, &head);
+	u_space_overseer_create_pose_space(uso, &dev.base, XRT_INPUT_SIMPLE_GRIP_POSE, &grip);
+
+	SECTION("Same input and timestamp is fetched once")
+	{
+		for (int i = 0; i < 10; i++) {
+			CHECK(locate(uso, head, 1000).pose.position.x == 1000.0f);
+		}
+		CHECK(dev.calls == 1);
+	}
+
+	SECTION("Different inputs and timestamps are fetched")
+	{
+		CHECK(locate(uso, head, 1000).pose.position.x == 1000.0f);
+		CHECK(locate(uso, grip, 1000).pose.position.x == 1000.0f);
+		CHECK(locate(uso, head, 2000).pose.position.x == 2000.0f);
+		CHECK(dev.calls == 3);
+
+		CHECK(locate(uso, head, 1000).pose.position.x == 1000.0f);
+		CHECK(dev.calls == 3);
+	}
+
+	SECTION("Linking a device drops cached poses")
+	{
+		locate(uso, head, 1000);
+		u_space_overseer_link_space_to_device(uso, xso->semantic.root, &dev.base);
+		locate(uso, head, 1000);
+		CHECK(dev.calls == 2);
+	}
+
+	SECTION("Cached poses expire")
+	{
+		u_space_overseer_set_pose_cache_max_age(uso, U_TIME_1MS_IN_NS);
+		locate(uso, head, 1000);
+		os_nanosleep(2 * U_TIME_1MS_IN_NS);
+		locate(uso, head, 1000);
+		CHECK(dev.calls == 2);
+	}
+
+	SECTION("Disabled")
+	{
+		u_space_overseer_set_pose_cache_max_age(uso, 0);
+		locate(uso, head, 1000);
+		locate(uso, head, 1000);
+		CHECK(dev.calls == 2);
+	}
+
+	SECTION("Old entries are replaced")
+	{
+		// More timestamps than fit in the cache.
+		for (uint64_t ts = 1; ts <= 100; ts++) {
+			CHECK(locate(uso, head, ts).pose.position.x == (float)ts);
+		}
+		CHECK(dev.calls == 100);
+
+		// The newest are still there, the oldest are not.
+		locate(uso, head, 100);
+		CHECK(dev.calls == 100);
+		locate(uso, head, 1);
+		CHECK(dev.calls == 101);
+	}
+
+	xrt_space_reference(&grip, nullptr);
+	xrt_space_reference(&head, nullptr);
+	xrt_space_overseer_destroy(&xso);
+}